@@ -0,0 +1,61 @@
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include <allegro5/allegro.h>
+#include <stdbool.h>
+#include "game.h" // For Entity
+
+// Sprite animations are decoded once at startup: every frame is scaled to
+// its drawn size and packed into a few atlas pages, and a clip is a list of
+// sub-bitmaps of those pages. Playing a clip only advances counters in the
+// Entity (clip, current_frame, frame_timer), so there is no allocation or
+// file access while the game runs, and sprites sharing a page go out as one
+// held bitmap batch in the draw list.
+
+typedef enum {
+    ANIM_PLAYER_IDLE,
+    ANIM_PLAYER_RUN,
+    ANIM_PLAYER_JUMP,
+    ANIM_PLAYER_ATTACK,
+    ANIM_PLAYER_SPECIAL,        // Attack at the full combo
+    ANIM_BOSS_IDLE,
+    ANIM_BOSS_ATTACK,
+    ANIM_CLIP_COUNT
+} AnimClipId;
+
+#define ANIM_NO_CLIP -1
+
+typedef struct {
+    ALLEGRO_BITMAP* frames[ANIM_MAX_FRAMES]; // Sub-bitmaps of an atlas page
+    int num_frames;
+    int frame_ticks;            // Updates each frame is shown for
+    bool loop;                  // Otherwise the last frame holds until another clip starts
+    CollisionMask masks[ANIM_MAX_FRAMES]; // Per frame for clips hit by their pixels, else empty
+} AnimClip;
+
+typedef struct AnimationSet {
+    ALLEGRO_BITMAP* pages[ANIM_ATLAS_MAX_PAGES];
+    int num_pages;
+    int shelf_x, shelf_y, shelf_height; // Packing position in the last page
+    AnimClip clips[ANIM_CLIP_COUNT];
+} AnimationSet;
+
+// Queue every clip frame for decoding ahead of load_animations (preload.h)
+void queue_animation_preloads(void);
+// Clips whose frames are missing are left empty and never drawn
+bool load_animations(AnimationSet* set);
+void destroy_animations(AnimationSet* set);
+
+// Start 'clip' on 'entity' unless it is already playing it
+void play_clip(Entity* entity, AnimClipId clip);
+// Advance the entity's clip by one update and set its sprite, sprite_sheet
+// and collision mask
+void update_animation(const AnimationSet* set, Entity* entity);
+// A one-shot clip that has not reached its last frame
+bool is_clip_playing(const AnimationSet* set, const Entity* entity);
+
+// Pick and advance the clips of the player and the bosses for this update
+void animate_player(const AnimationSet* set, Entity* player);
+void animate_boss(const AnimationSet* set, Entity* boss);
+
+#endif /* ANIMATION_H */
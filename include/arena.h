@@ -0,0 +1,43 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Bump allocator owning all memory of one level. Allocations are carved
+// sequentially out of large blocks and are never freed individually;
+// arena_rewind drops everything allocated after a mark and
+// arena_release returns all blocks to the heap in one call.
+
+#define ARENA_ALIGNMENT 16
+
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t size;            // Usable bytes in data[]
+    size_t used;            // Bytes handed out from data[]
+    unsigned char* data;
+} ArenaBlock;
+
+typedef struct {
+    ArenaBlock* first;
+    ArenaBlock* current;    // Block new allocations come from
+    size_t block_size;      // Default size of a block
+    size_t peak;            // Most bytes in use at once
+} Arena;
+
+// Position in an arena to rewind to
+typedef struct {
+    ArenaBlock* block;
+    size_t used;
+} ArenaMark;
+
+bool arena_init(Arena* arena, size_t block_size);
+void* arena_alloc(Arena* arena, size_t size);   // Uninitialized, ARENA_ALIGNMENT aligned
+void* arena_calloc(Arena* arena, size_t count, size_t size);
+char* arena_strdup(Arena* arena, const char* str);
+ArenaMark arena_mark(const Arena* arena);
+void arena_rewind(Arena* arena, ArenaMark mark);  // Blocks are kept for reuse
+void arena_release(Arena* arena);
+size_t arena_used(const Arena* arena);
+
+#endif /* ARENA_H */
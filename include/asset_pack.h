@@ -0,0 +1,49 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <stdbool.h>
+#include <stdint.h>  // For uint32_t, uint64_t
+
+// Every file under resources/ can be packed into ASSET_PACK_FILE: a header,
+// an index of fixed-size entries sorted by path, then the bytes of each
+// file aligned to ASSET_PACK_ALIGN. At startup the pack is mapped into
+// memory and installed as the thread's Allegro file interface, so
+// al_load_bitmap, al_load_sample and the font loaders read packed paths
+// straight from the mapping, whatever the working directory is. Paths that
+// are not packed, and every write, go through the standard file interface.
+//
+//   cancer_cell_game --pack    Build ASSET_PACK_FILE from resources/
+
+#define ASSET_PATH_MAX 120
+
+typedef struct {
+    char magic[4];              // ASSET_PACK_MAGIC
+    uint32_t version;
+    uint32_t count;             // Entries in the index that follows
+    uint32_t reserved;
+} AssetPackHeader;
+
+typedef struct {
+    char path[ASSET_PATH_MAX];  // As the game opens it, '/' separated
+    uint64_t offset;            // From the start of the pack
+    uint64_t size;
+} AssetEntry;
+
+// True if the command line asks for the pack to be built
+bool is_asset_pack_command(int argc, char** argv);
+// Build the pack; returns the process exit code
+int run_asset_pack_command(int argc, char** argv);
+
+// Map the pack, looked for next to the executable, in the resources
+// directory and in the working directory, and route the calling thread's
+// file access through it. False, with nothing changed, when there is none.
+bool open_asset_pack(void);
+void close_asset_pack(void);
+// Route the calling thread's file access through the open pack, if any.
+// The file interface is per thread, so worker threads that load assets
+// call this first.
+void use_asset_pack(void);
+// Whether 'path' is packed or exists on disk
+bool asset_exists(const char* path);
+
+#endif /* ASSET_PACK_H */
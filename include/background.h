@@ -0,0 +1,84 @@
+#ifndef BACKGROUND_H
+#define BACKGROUND_H
+
+#include <allegro5/allegro.h>
+#include <stdbool.h>
+#include <stddef.h>  // For size_t
+#include "arena.h"
+#include "draw_list.h"
+
+// Level backgrounds are cut into square tiles once, when they are first
+// loaded, and written to a cache on disk. While playing, only the tiles
+// near the camera are loaded as bitmaps; the rest are evicted least
+// recently used first, so memory use does not grow with the level width.
+//
+// Streaming never decodes on the drawing thread: tiles entering the
+// prefetch margin are queued, decoded into memory bitmaps by a task that
+// runs beside the recording tasks, and uploaded when the next frame is
+// streamed. Frames only draw tiles that are already resident.
+
+typedef struct {
+    float x, y;                 // Position in level space
+    int width, height;          // Edge tiles may be smaller than BACKGROUND_TILE_SIZE
+    char* path;                 // Baked tile file, NULL if it could not be written
+    ALLEGRO_BITMAP* source;     // Memory bitmap copy used when there is no tile file
+    ALLEGRO_BITMAP* bitmap;     // Loaded tile, NULL while not resident
+    ALLEGRO_BITMAP* decoded;    // Memory bitmap waiting to be uploaded
+    bool queued;                // In the set's pending list
+    bool opaque;                // Every pixel has full alpha, checked on first load
+    bool opaque_checked;
+    unsigned int last_used;     // Frame the tile was last needed, for LRU eviction
+} BackgroundTile;
+
+typedef struct {
+    BackgroundTile* tiles;      // Sorted by x, then y
+    int num_tiles;
+    int capacity;
+    Arena* arena;               // Tile array and paths are allocated here
+    int budget;                 // Most tiles kept resident; the window itself is never evicted
+    unsigned int frame;         // Incremented on each stream call
+    int* pending;               // Tiles to decode, BACKGROUND_TILE_DECODES at most
+    int num_pending;
+
+    // Statistics
+    int resident;               // Tiles currently loaded
+    int resident_peak;
+    int loads;
+    int evictions;
+    int misses;                 // Tiles on screen but not resident when a frame was streamed
+    size_t resident_bytes;      // Pixel memory of the resident tiles
+    size_t resident_bytes_peak;
+    size_t saved_bytes;         // Against 32 bits per pixel, from low-bit texture formats
+    size_t saved_bytes_peak;    // When resident_bytes peaked
+} BackgroundTileSet;
+
+void init_background_tiles(BackgroundTileSet* set, Arena* arena, int budget);
+// Split the image at 'path' into tiles placed at (x, y) in level space,
+// first stretched to fit_width x fit_height unless those are 0. Tiles come
+// from the disk cache when it is newer than the image.
+bool add_background_tiles(BackgroundTileSet* set, const char* path, float x, float y,
+                          int fit_width, int fit_height);
+// Queue the image add_background_tiles will cut, unless its tiles are
+// already baked, for decoding ahead of time (preload.h)
+void queue_background_preload(const char* path, int fit_width, int fit_height);
+// Upload the tiles decoded since the last call, queue the tiles
+// overlapping [left - prefetch, right + prefetch] that are not resident
+// and evict the least recently used tiles over the budget
+void stream_background_tiles(BackgroundTileSet* set, float left, float right, float prefetch);
+// Decode the queued tiles. Only tiles that are not resident are written,
+// which record_background_tiles skips, so it may run while the scene is
+// recorded.
+void decode_background_tiles(BackgroundTileSet* set);
+// Make the tiles overlapping [left, right] resident before returning, for
+// the first frame of a level
+void load_background_tiles(BackgroundTileSet* set, float left, float right);
+// Record the resident tiles overlapping [left, right] at their level
+// position, for a level space layer. When opaque resident tiles leave no
+// gap across [left, right], the rows they all cover are marked opaque.
+void record_background_tiles(const BackgroundTileSet* set, DrawList* list, DrawLayer layer, int depth,
+                             float left, float right);
+void evict_background_tiles(BackgroundTileSet* set);   // Unload every resident tile
+void destroy_background_tiles(BackgroundTileSet* set);
+void report_background_tiles(const BackgroundTileSet* set, const char* name);
+
+#endif /* BACKGROUND_H */
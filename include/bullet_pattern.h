@@ -0,0 +1,53 @@
+#ifndef BULLET_PATTERN_H
+#define BULLET_PATTERN_H
+
+#include "game.h" // For Level, EntityType
+
+// Boss attacks are constant tables of emitters instead of hand-written
+// shots. An emitter fires volleys of bullets on a timer: a ring spreads
+// them round the full circle, a fan across an arc, and either can be aimed
+// at the target or turn a little every volley, which makes rings into
+// spirals. A pattern plays its emitters together and repeats. Volleys go
+// into the projectile pool in one call with no trail particles, so
+// thousands of bullets stay cheap to move.
+
+typedef enum {
+    PATTERN_BOSS_PAUSE,         // Phase one, while the boss stands still
+    PATTERN_BOSS_DESPERATE,     // Phase two, all the time
+    PATTERN_COUNT
+} BulletPatternId;
+
+typedef enum {
+    EMIT_RING,                  // 'count' bullets evenly round the circle
+    EMIT_FAN                    // 'count' bullets across 'spread' radians
+} EmitterShape;
+
+typedef struct {
+    EmitterShape shape;
+    bool aimed;                 // Centred on the target instead of 'angle'
+    int start;                  // Tick of the first volley within the pattern
+    int interval;               // Ticks between volleys
+    int volleys;                // Volleys per repeat; 0 fires until the pattern ends
+    int count;                  // Bullets per volley
+    float angle;                // First direction, radians; the fan's centre
+    float spread;               // Fan width, radians
+    float turn;                 // Added to the direction every volley
+    float speed;                // Pixels per tick
+    bool loud;                  // Volleys play the shot sound
+} BulletEmitter;
+
+typedef struct {
+    const char* name;
+    const BulletEmitter* emitters;
+    int num_emitters;
+    int length;                 // Ticks before the pattern repeats
+} BulletPattern;
+
+const BulletPattern* get_bullet_pattern(BulletPatternId id);
+// Fire the volleys of pattern 'id' that are due 'tick' ticks into it from
+// (x, y), aimed ones at (target_x, target_y). Returns the number of loud
+// volleys, so the caller knows whether to play the shot sound.
+int fire_bullet_pattern(Level* level, BulletPatternId id, int tick, float x, float y,
+                        float target_x, float target_y, EntityType source);
+
+#endif /* BULLET_PATTERN_H */
@@ -0,0 +1,54 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include <allegro5/allegro.h>
+#include <stddef.h> // For size_t
+
+// The camera owns the horizontal scroll and the screen shake. Drawing sets
+// its transform once and then works in level coordinates, and the level's
+// static content is kept sorted by x so the visible part of it is found by
+// binary search instead of testing every object. The camera's scale maps
+// view pixels to target pixels, so a frame can be drawn into a smaller
+// target without touching any coordinates.
+
+// Screen shake effect
+typedef struct {
+    float intensity;     // Current shake intensity
+    int duration;        // Frames remaining
+    float offset_x;      // Current screen offset
+    float offset_y;
+} ScreenShake;
+
+typedef struct {
+    float x;                 // Left edge of the view in level space
+    float width, height;     // Size of the view
+    float scale;             // Target pixels per view pixel, 1 unless drawing at a reduced resolution
+    ScreenShake shake;
+} Camera;
+
+void init_camera(Camera* camera, float width, float height);
+// Back to the start of a level with no shake
+void reset_camera(Camera* camera);
+// Scroll so 'focus_x' sits at SCROLL_X_PLAYER_OFFSET_FACTOR of the view,
+// without showing anything outside [0, level_width]
+void follow_camera(Camera* camera, float focus_x, float level_width);
+
+// Shake unless a stronger shake is still running
+void shake_camera(Camera* camera, float intensity, int duration);
+void update_camera_shake(Camera* camera);
+
+// Make the current target draw level coordinates through the camera,
+// including the shake offset and scale
+void use_camera_transform(const Camera* camera);
+// Screen coordinates for the HUD and menus, at the camera's scale. With
+// NULL, plain target coordinates.
+void use_screen_transform(const Camera* camera);
+
+// Items of an array sorted by x that may overlap [left, right] lie in
+// [*first, *last). 'max_width' is the widest item, so items starting left of
+// the view but reaching into it are included; callers skip the few that end
+// before 'left'. 'x_offset' is the offset of the float x field in each item.
+void find_visible_range(const void* items, int count, size_t stride, size_t x_offset,
+                        float max_width, float left, float right, int* first, int* last);
+
+#endif /* CAMERA_H */
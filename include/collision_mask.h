@@ -0,0 +1,34 @@
+#ifndef COLLISION_MASK_H
+#define COLLISION_MASK_H
+
+#include <allegro5/allegro.h>
+#include <stdbool.h>
+#include <stdint.h>   // For uint64_t
+
+// One bit per pixel of an animation frame, set where the frame is opaque,
+// built once when the frame is loaded. Rows are packed into 64-bit words
+// (bit i of word w is pixel 64 * w + i), and a mirrored copy is kept for
+// frames drawn flipped, so two masks are compared by ANDing the words of
+// the rows they share instead of looking at pixels.
+typedef struct CollisionMask {
+    int width, height;
+    int words_per_row;
+    uint64_t* rows;             // height * words_per_row words
+    uint64_t* flipped_rows;     // The same rows mirrored left to right
+    int pixels;                 // Set bits, 0 for a fully transparent frame
+} CollisionMask;
+
+// Bits are set where 'bitmap' has at least COLLISION_MASK_ALPHA alpha.
+// 'bitmap' must be lockable, e.g. a memory bitmap or a sub-bitmap of one.
+bool build_collision_mask(CollisionMask* mask, ALLEGRO_BITMAP* bitmap);
+void destroy_collision_mask(CollisionMask* mask);
+
+// Masks placed with their top-left pixel at (x, y). The bounding boxes are
+// compared first, so masks that are far apart cost one rectangle test.
+bool masks_overlap(const CollisionMask* a, int ax, int ay, bool flip_a,
+                   const CollisionMask* b, int bx, int by, bool flip_b);
+// Any set bit of the mask inside the rectangle (right and bottom excluded)
+bool mask_overlaps_rect(const CollisionMask* mask, int x, int y, bool flip,
+                        float left, float top, float right, float bottom);
+
+#endif /* COLLISION_MASK_H */
@@ -0,0 +1,175 @@
+#ifndef DRAW_LIST_H
+#define DRAW_LIST_H
+
+#include <allegro5/allegro.h>
+#include <allegro5/allegro_font.h> // For ALLEGRO_FONT
+#include <stdbool.h>
+#include <stdint.h>                // For uint64_t
+#include "camera.h"
+#include "prim_batch.h"        // For PrimBatch
+#include "overdraw.h"          // For OverdrawMap
+#include "pixel_kernels.h"     // For KernelTarget
+
+// A frame is recorded as a list of draw commands and submitted in one go.
+// Each command carries a sort key of
+//
+//   layer | depth | blend mode | primitive type and texture | sequence
+//
+// Layers and depths keep the painter's order where it matters; commands of
+// the same layer and depth may be drawn in any order, so sorting groups
+// them by state and each layer is submitted with as few blend, texture and
+// primitive switches as possible. The sequence keeps the recorded order
+// among commands with identical state. Rectangles and circles are
+// collected into a PrimBatch and a run of them, across depths, costs one
+// draw call.
+//
+// On memory bitmap targets, clears, filled rectangles and circles and
+// unscaled bitmap blits at whole pixels are written with pixel_kernels.h
+// instead of going through Allegro's generic software blender.
+//
+// A layer whose content paints an area with no transparent pixels can say
+// so with mark_opaque_area. When that area covers the whole target, every
+// layer below it, including clears, is skipped at submission.
+//
+// Recording only writes to the list and makes no Allegro calls, so lists
+// can be filled on worker threads; submission happens on the drawing thread.
+
+#define DRAW_TEXT_MAX 64        // Longest text a command carries, including the terminator
+#define DRAW_DEPTH_MAX 255
+
+typedef enum {
+    DRAW_LAYER_SKY,             // Screen space: clears and full-screen backdrops
+    DRAW_LAYER_BACKGROUND,      // Level space: background tiles and platforms
+    DRAW_LAYER_WORLD,           // Level space: platforms, items, enemies, shots, player
+    DRAW_LAYER_HUD,             // Screen space
+    DRAW_LAYER_OVERLAY,         // Screen space: menus, pause and end screens
+    DRAW_LAYER_COUNT
+} DrawLayer;
+
+// While playing, the layers up to this one only change when the camera
+// scrolls, so they can be kept in a ScrollCache (see scroll_cache.h)
+#define DRAW_LAYER_LAST_STATIC DRAW_LAYER_BACKGROUND
+
+typedef enum {
+    DRAW_BLEND_ALPHA,           // Premultiplied alpha, Allegro's default
+    DRAW_BLEND_ADD
+} DrawBlend;
+
+typedef enum {
+    DRAW_CMD_CLEAR,
+    DRAW_CMD_BITMAP,
+    DRAW_CMD_TEXT,
+    DRAW_CMD_FILLED_RECT,
+    DRAW_CMD_RECT,
+    DRAW_CMD_FILLED_CIRCLE,
+    DRAW_CMD_CIRCLE
+} DrawCommandType;
+
+typedef struct {
+    uint64_t key;
+    DrawCommandType type;
+    ALLEGRO_COLOR color;
+    float x1, y1;               // Rectangle corner, circle centre, bitmap or text position
+    float x2, y2;               // Opposite rectangle corner; circle radius in x2; bitmap size (0 = unscaled)
+    float thickness;            // Outlines
+    ALLEGRO_BITMAP* bitmap;
+    const ALLEGRO_FONT* font;
+    int flags;                  // Text alignment, or bitmap flip flags
+    char text[DRAW_TEXT_MAX];
+} DrawCommand;
+
+// Counted per submitted list
+typedef struct {
+    int commands;
+    int draw_calls;
+    int state_switches;         // Transform, blend, primitive type or texture changes
+    int elided;                 // Commands skipped because an opaque layer covers them
+    int kernel_draws;           // Commands written straight into a memory bitmap
+} DrawStats;
+
+typedef struct {
+    bool valid;
+    float x1, y1, x2, y2;       // In the space of the layer it belongs to
+} DrawArea;
+
+typedef struct {
+    DrawCommand* commands;
+    int count;
+    int capacity;
+    DrawBlend blend;            // Blend mode of commands recorded from now on
+    DrawStats stats;            // Of the submissions since the list was cleared
+    PrimBatch batch;            // Vertices of the primitives being submitted
+    DrawArea opaque[DRAW_LAYER_COUNT];  // Area each layer paints opaquely
+} DrawList;
+
+// Parts of a frame timed when draw timings are enabled
+typedef enum {
+    DRAW_SECTION_RECORD,        // Filling the command list
+    DRAW_SECTION_SORT,
+    DRAW_SECTION_SKY,           // Submitting each layer
+    DRAW_SECTION_BACKGROUND,
+    DRAW_SECTION_WORLD,
+    DRAW_SECTION_HUD,
+    DRAW_SECTION_OVERLAY,
+    DRAW_SECTION_UPSCALE,       // Stretching a reduced resolution frame to the target
+    DRAW_SECTION_COUNT
+} DrawSection;
+
+typedef struct {
+    double total[DRAW_SECTION_COUNT];   // Seconds
+    double max[DRAW_SECTION_COUNT];
+    int samples[DRAW_SECTION_COUNT];
+} DrawTimings;
+
+extern const char* const draw_section_names[DRAW_SECTION_COUNT];
+
+// Add the time spent in each section of later frames to 'timings', or stop
+// timing with NULL. Only CPU time is measured, so this is meant for memory
+// bitmap targets (see render_bench.h); display drawing is queued on the GPU.
+void set_draw_timings(DrawTimings* timings);
+// Count the pixels every later submitted command covers into 'map', or stop
+// with NULL. The map is in target pixels.
+void set_draw_overdraw(OverdrawMap* map);
+double begin_draw_section(void);
+void end_draw_section(DrawSection section, double start);
+
+void init_draw_list(DrawList* list);
+void free_draw_list(DrawList* list);
+void clear_draw_list(DrawList* list);   // Also goes back to DRAW_BLEND_ALPHA and forgets opaque areas
+void set_draw_blend(DrawList* list, DrawBlend blend);
+
+void record_clear(DrawList* list, DrawLayer layer, int depth, ALLEGRO_COLOR color);
+// 'width' and 'height' of 0 draw the bitmap at its own size
+void record_bitmap(DrawList* list, DrawLayer layer, int depth, ALLEGRO_BITMAP* bitmap,
+                   float x, float y, float width, float height);
+// At its own size, mirrored left to right with 'flip'. Sub-bitmaps of one
+// atlas share a texture, so their commands sort and batch together.
+void record_sprite(DrawList* list, DrawLayer layer, int depth, ALLEGRO_BITMAP* bitmap,
+                   float x, float y, bool flip);
+void record_text(DrawList* list, DrawLayer layer, int depth, const ALLEGRO_FONT* font,
+                 ALLEGRO_COLOR color, float x, float y, int flags, const char* text);
+void record_filled_rectangle(DrawList* list, DrawLayer layer, int depth,
+                             float x1, float y1, float x2, float y2, ALLEGRO_COLOR color);
+void record_rectangle(DrawList* list, DrawLayer layer, int depth,
+                      float x1, float y1, float x2, float y2, ALLEGRO_COLOR color, float thickness);
+void record_filled_circle(DrawList* list, DrawLayer layer, int depth,
+                          float cx, float cy, float radius, ALLEGRO_COLOR color);
+void record_circle(DrawList* list, DrawLayer layer, int depth,
+                   float cx, float cy, float radius, ALLEGRO_COLOR color, float thickness);
+// Everything inside the area is painted opaquely by 'layer'; only the
+// largest area marked for a layer is kept
+void mark_opaque_area(DrawList* list, DrawLayer layer, float x1, float y1, float x2, float y2);
+
+// Append every command of 'src' after those of 'dst', keeping their order,
+// along with its opaque areas
+void append_draw_list(DrawList* dst, const DrawList* src);
+void sort_draw_list(DrawList* list);
+// Draw a sorted list to the current target, skipping layers hidden under an
+// opaque one. Level space layers go through the camera and every layer is
+// drawn at the camera's scale; the transform and blender are back to their
+// defaults after. Overdraw is counted in view pixels.
+void submit_draw_list(DrawList* list, const Camera* camera);
+// Only the commands of layers 'first' to 'last'
+void submit_draw_layers(DrawList* list, const Camera* camera, DrawLayer first, DrawLayer last);
+
+#endif /* DRAW_LIST_H */
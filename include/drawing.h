@@ -2,19 +2,69 @@
 #define DRAWING_H
 
 #include "game.h" // For Game struct, Menu struct, Level struct, etc.
+#include "render.h" // For RenderSnapshot
 #include <allegro5/allegro_font.h> // For ALLEGRO_FONT if used directly
 #include <allegro5/allegro_primitives.h> // For drawing functions
+#include "draw_list.h" // For DrawList, DrawStats
+#include "jobs.h"      // For the scene recording task graph
+#include "scroll_cache.h" // For ScrollCache
+
+// Parts of the playing scene, each recorded into its own list by a task
+typedef enum {
+    SCENE_PART_BACKGROUND,
+    SCENE_PART_PLATFORMS,       // Platforms and the portal
+    SCENE_PART_ENEMIES,
+    SCENE_PART_PROJECTILES,
+    SCENE_PART_PARTICLES,
+    SCENE_PART_GLUCOSE,
+    SCENE_PART_PLAYER,
+    SCENE_PART_HUD,
+    SCENE_PART_COUNT
+} ScenePart;
+
+struct DrawContext;
+
+typedef struct {
+    struct DrawContext* context;
+    ScenePart part;
+} SceneRecordTask;
+
+// Owned by the drawing thread
+typedef struct DrawContext {
+    DrawList frame;             // Commands of the frame being drawn
+    DrawList parts[SCENE_PART_COUNT];
+    JobSystem jobs;             // Records the scene parts
+    TaskGraph record_graph;
+    SceneRecordTask tasks[SCENE_PART_COUNT];
+    Game* game;                 // What the running graph records
+    const RenderSnapshot* snap;
+
+    unsigned int frames;
+    DrawStats last;             // Of the last frame, including a captured pause frame
+    DrawStats total;
+    DrawStats peak;
+    OverdrawMap overdraw;       // Allocated the first time the overdraw view is shown
+    ALLEGRO_BITMAP* scaled_target;  // Frame below 100% render scale, upscaled to the target
+    ScrollCache scroll_cache;   // Static layers while playing on memory bitmaps
+} DrawContext;
 
 // Function declarations for drawing operations
-void draw_game(Game* game);
-void draw_menu(Game* game, Menu* menu, const char* title);
-void draw_welcome_screen(Game* game);
-void draw_main_menu(Game* game);
-void draw_level_select(Game* game);
-void draw_settings_menu(Game* game);
-void draw_pause_screen(Game* game);
-void draw_star_display(Game* game, float x, float y, int stars_earned, int max_stars);
-void draw_end_screen_stars(Game* game, float center_x, float center_y, int stars_earned, int max_stars, int level);
+// Everything that changes while playing comes from the snapshot; the game
+// only provides fonts, sprites and the display. Without a display (the
+// headless bench) frames are drawn to the target bitmap and not flipped.
+// Each frame is recorded into a draw list, sorted and then submitted, at
+// the snapshot's render scale.
+bool init_drawing(Game* game, int record_threads);
+void cleanup_drawing(Game* game);   // Prints the per-frame draw call and state switch counts
+void draw_game(Game* game, const RenderSnapshot* snap);
+void record_menu(DrawList* list, Game* game, const RenderMenu* menu, const char* title);
+void record_welcome_screen(DrawList* list, Game* game, const RenderSnapshot* snap);
+void record_pause_screen(DrawList* list, Game* game, const RenderSnapshot* snap);
+void record_playing_scene(DrawList* list, Game* game, const RenderSnapshot* snap);
+void record_star_display(DrawList* list, DrawLayer layer, Game* game, float x, float y,
+                         int stars_earned, int max_stars, int level);
+void record_end_screen_stars(DrawList* list, DrawLayer layer, Game* game, float center_x, float center_y,
+                             int stars_earned, int max_stars, int level);
 // Note: Specific drawing for GAME_OVER, VICTORY, LEVEL_COMPLETE are handled within draw_game
 
 #endif /* DRAWING_H */
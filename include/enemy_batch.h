@@ -0,0 +1,48 @@
+#ifndef ENEMY_BATCH_H
+#define ENEMY_BATCH_H
+
+#include <stdbool.h>
+#include "game.h" // For EnemyBatches, Entity
+
+// Enemies are kept in one array ordered by behavior, so the update runs
+// each behavior's code over a contiguous batch instead of switching per
+// enemy. An enemy only changes place when it spawns, is recycled or
+// changes behavior; moving one costs a swap per behavior between the old
+// and the new one.
+//
+// The chase, patrol and retreat batches are gathered into arrays of
+// positions and velocities and stepped by kernels that handle 8 enemies
+// at a time with AVX2 (SIMD_CFLAGS=-mavx2), 4 with SSE2 on x86-64, and
+// one at a time in plain C elsewhere. Kernels only flag transitions;
+// the caller applies them with set_enemy_behavior, which queues the
+// enemy, and rebucket_enemies moves the queued enemies afterwards so no
+// batch changes while it is being updated.
+
+// Room for 'capacity' enemies from 'arena'; false if it is out of memory
+bool init_enemy_batches(EnemyBatches* batches, Arena* arena, int capacity);
+// Forget every enemy, e.g. after the enemy pool was emptied
+void clear_enemy_batches(EnemyBatches* batches);
+// File a new enemy under its behavior; false if the batches are full
+bool add_batched_enemy(EnemyBatches* batches, Entity* enemy);
+void remove_batched_enemy(EnemyBatches* batches, Entity* enemy);
+// Change a filed enemy's behavior and queue it for rebucket_enemies
+void set_enemy_behavior(EnemyBatches* batches, Entity* enemy, EntityBehavior behavior);
+// Move the queued enemies to their new batches, skipping any recycled since
+void rebucket_enemies(EnemyBatches* batches);
+
+// Put the active enemies of 'behavior' that are not knocked back into the
+// lanes; returns how many there are
+int gather_batch(EnemyBatches* batches, EntityBehavior behavior);
+
+// Kernels over the first 'count' lanes, towards the player at (px, py).
+// Velocities are left alone where the player is exactly on the enemy.
+// Chase: dx, dy at ENEMY_CHASE_SPEED towards the player; flags past
+// ENEMY_CHASE_BREAK_RANGE
+void chase_kernel(EnemyBatches* batches, int count, float px, float py);
+// Patrol: dx reversed where this tick's move would reach the level edge it
+// heads for; flags within ENEMY_PATROL_DETECT_RANGE
+void patrol_kernel(EnemyBatches* batches, int count, float px, float py, float level_width);
+// Retreat: dx, dy at ENEMY_CHASE_SPEED away from the player; flags where it moves
+void retreat_kernel(EnemyBatches* batches, int count, float px, float py);
+
+#endif /* ENEMY_BATCH_H */
@@ -5,8 +5,11 @@
 #include <math.h>  // For sqrt in enemy logic if needed directly
 
 // Function declarations for entity management
-void update_enemy(Entity* enemy, Game* game);
+// Every enemy of the current level, a behavior batch at a time
+void update_enemies(Game* game);
+// Boxes, or the opaque pixels of frames that have a collision mask
 bool check_collision(Entity* a, Entity* b);
+bool check_rect_collision(const Entity* e, float x, float y, float width, float height);
 void handle_collisions(Game* game);
 
 #endif /* ENTITY_H */
@@ -9,10 +9,20 @@
 #include <allegro5/allegro_audio.h>
 #include <allegro5/allegro_acodec.h>
 #include <allegro5/keyboard.h> // Changed to keyboard.h based on directory listing
+#include "arena.h"
+#include "pool.h"
+#include "background.h"
+#include "tilemap.h"
+#include "static_chunks.h"
+#include "collision_mask.h"
+#include "triggers.h"
+#include "jobs.h"
+#include "camera.h"
 
 #define SCREEN_WIDTH    1280 
 #define SCREEN_HEIGHT   720
 #define FPS            60.0
+#define MENU_ANIMATION_FPS 15.0 // Redraw rate of animated menus (welcome screen pulse)
 #define PLATFORM_JUMP_TOLERANCE 8.0f // Pixels tolerance for standing on a platform, increased and made float
 #define PORTAL_WIDTH 50
 #define PORTAL_HEIGHT 80
@@ -132,6 +142,11 @@
 
 #define MAX_STEP_UP_HEIGHT 8.0f    // Maximum height the player can automatically step up
 
+// Physics step (physics.c)
+#define PHYSICS_SLEEP_TICKS 30          // Ticks at rest before a body stops being stepped
+#define PLAYER_KNOCKBACK_DECAY 0.9f     // Knockback kept each tick
+#define ENEMY_KNOCKBACK_DECAY 0.8f
+
 // Game Progression
 #define INITIAL_LEVEL 1
 #define LEVEL_COMPLETE_SCORE_BONUS 1000
@@ -140,6 +155,10 @@
 
 // Hazards
 #define DEADLY_PLATFORM_DAMAGE 10
+#define HAZARD_TRIGGER_MARGIN 1.0f // Hazard triggers reach this far past the surface, so standing on one counts
+
+// Trigger volumes (triggers.c)
+#define TRIGGER_MAX_WIDTH 256.0f    // Wider triggers are split, so one can't widen every search
 
 // Enemy Behavior
 #define ENEMY_PATROL_DETECT_RANGE 200.0f
@@ -183,7 +202,7 @@
 #define AI_SURROUND_DISTANCE 120.0f    // Distance for surrounding behavior
 
 // Projectile System
-#define MAX_PROJECTILES 50             // Maximum projectiles on screen
+#define PROJECTILE_POOL_CHUNK 64       // Projectiles added each time the pool grows
 #define PROJECTILE_SPEED 5.0f          // Projectile movement speed
 #define PROJECTILE_DAMAGE 15           // Damage dealt by projectiles
 #define PROJECTILE_LIFETIME 300        // Frames before projectile expires (5 seconds at 60 FPS)
@@ -191,7 +210,7 @@
 #define PROJECTILE_HEIGHT 8.0f
 
 // Particle System
-#define MAX_PARTICLES 100              // Maximum particles on screen
+#define PARTICLE_POOL_CHUNK 256        // Particles added each time the pool grows
 #define PARTICLE_LIFETIME_SHORT 30     // Short particle effect (0.5 seconds)
 #define PARTICLE_LIFETIME_MEDIUM 60    // Medium particle effect (1 second)
 
@@ -200,6 +219,84 @@
 #define ENEMY_DEATH_PARTICLES 15           // Number of particles when enemy dies
 #define PROJECTILE_TRAIL_PARTICLES 2       // Particles per frame for projectile trails
 
+// Per-level pool memory budget (projectiles + particles)
+#define LEVEL_POOL_BUDGET_BYTES (512 * 1024)   // Default budget for a level
+#define LEVEL_POOL_BUDGET_BOSS_BYTES (2 * 1024 * 1024) // Budget for levels with dense bullet patterns
+#define PARTICLE_BUDGET_SHARE 0.25f            // Fraction of the budget particles may claim
+#define PARTICLE_SPAWN_SHARE 0.25f             // Part of that share for spawns deferred during an update
+
+// Enemy pool and waves (spawner.c)
+#define LEVEL_MAX_ENEMIES 512              // Enemies alive at once in a level
+#define ENEMY_POOL_CHUNK 64                // Enemy slots added each time the pool grows
+#define SPAWNER_MAX_WAVES 32               // Waves per level
+#define SPAWN_ROW_LENGTH 8                 // Enemies a wave places side by side before starting a row
+#define ENEMY_WIDTH 40.0f
+#define ENEMY_HEIGHT 40.0f
+#define ENEMY_ATTACK_POWER 10.0f           // Contact damage of spawned enemies
+
+// Size of each block of a level's memory arena
+#define LEVEL_ARENA_BLOCK_BYTES (128 * 1024)
+
+// Worker threads for the update_game task graph and for decoding assets at
+// startup (capped at CPU count - 1). Set to 0 to run every stage on the
+// main thread in a fixed order.
+#define JOB_WORKER_THREADS 3
+
+// Draw on a dedicated render thread that owns the display.
+// Set to 0 to draw on the main thread right after each update.
+#define RENDER_THREAD 1
+
+// Worker threads that record the parts of the playing scene into draw lists
+// (capped at CPU count - 1). Set to 0 to record them on the drawing thread.
+#define DRAW_RECORD_THREADS 2
+
+// Toggles the overdraw heatmap in every state
+#define OVERDRAW_VIEW_KEY ALLEGRO_KEY_F3
+
+// Background tile streaming
+#define BACKGROUND_TILE_SIZE 256           // Width and height of a baked background tile
+#define BACKGROUND_TILE_PREFETCH 256.0f    // Pixels beyond each screen edge kept resident
+#define BACKGROUND_TILE_DECODES 4          // Tiles decoded per frame on the recording threads
+#define STATIC_CHUNK_WIDTH 512             // Width of the bitmaps platforms and tiles are baked into
+#define TILEMAP_TILE_SIZE 32               // Cell size of level tile layers
+#define BACKGROUND_TILE_BUDGET 36          // Resident tiles per level before LRU eviction
+#define BACKGROUND_TILE_CACHE_DIR "cancer_cell_tiles" // Tile cache folder in the temp directory
+
+// Texture formats (texture_format.c)
+#define TEXTURE_OPAQUE_FORMAT ALLEGRO_PIXEL_FORMAT_RGB_565 // GPU format of backgrounds without alpha
+#define SCENE_SCALED_WIDTH 1280            // Width of the "_scaled" scene background variants
+
+// Asset pack (asset_pack.c)
+#define ASSET_PACK_FILE "cancer_cell.pak"  // Built with --pack, looked for next to the executable
+#define ASSET_PACK_MAGIC "CCPK"
+#define ASSET_PACK_VERSION 1
+#define ASSET_PACK_ALIGN 64                // Byte alignment of each packed file
+#define ASSET_SOURCE_DIR "resources"       // Directory packed, as the game names its files
+
+// Startup (preload.c, startup_timeline.c)
+#define PRELOAD_MAX_ASSETS 96               // Images and sounds decoded on worker threads at boot
+#define STARTUP_MAX_PHASES 32               // Phases kept for the startup report
+
+// Headless render benchmark and golden image checks (render_bench.c)
+#define RENDER_BENCH_ITERATIONS 100         // Draws of each scenario when timing
+#define GOLDEN_IMAGE_DIR "resources/golden" // Reference images, one PNG per scenario
+#define GOLDEN_CHANNEL_TOLERANCE 8          // Largest channel difference still counted as equal
+#define GOLDEN_PIXEL_TOLERANCE 0.001        // Fraction of pixels allowed to differ
+#define RENDER_BENCH_SEED 1234              // rand() seed, so scripted scenarios repeat exactly
+#define RENDER_BENCH_CLOCK 0.25             // Seconds used for pulsing effects in bench frames
+#define RENDER_BENCH_UPDATE_TICKS 120       // update_game calls timed after drawing a playing scenario
+#define RENDER_BENCH_BOSSES 6               // Bosses firing patterns in the bullet scenario
+
+// Sprite animation (animation.c)
+#define ANIM_MAX_FRAMES 16                  // Frames per clip
+#define ANIM_ATLAS_SIZE 1024                // Width and height of an atlas page
+#define ANIM_ATLAS_MAX_PAGES 4
+#define ANIM_ATLAS_PADDING 1                // Transparent pixels between packed frames
+#define ANIM_RUN_SPEED 0.5f                 // Horizontal speed above which the run clip plays
+#define PLAYER_SPRITE_SCALE 0.1875f         // Player frames are drawn at this fraction of their size
+#define BOSS_SPRITE_SCALE 0.25f
+#define COLLISION_MASK_ALPHA 128            // Frame pixels at least this opaque can be hit
+
 // Camera/Scrolling
 #define SCROLL_X_PLAYER_OFFSET_FACTOR (1.0f / 3.0f) // Player position on screen before scrolling starts
 
@@ -214,6 +311,12 @@
 #define DIFFICULTY_EASY 1
 #define DIFFICULTY_HARD 3
 
+// Internal render resolution, in percent of SCREEN_WIDTH x SCREEN_HEIGHT.
+// Below 100 the frame is drawn into a smaller bitmap and upscaled once.
+#define RENDER_SCALE_DEFAULT 100
+#define RENDER_SCALE_MIN 50
+#define RENDER_SCALE_STEP 25
+
 
 // Game states
 typedef enum {
@@ -261,6 +364,8 @@ typedef enum {
     BEHAVIOR_SURROUND   // Surround the player
 } EntityBehavior;
 
+#define BEHAVIOR_COUNT (BEHAVIOR_SURROUND + 1)
+
 // Portal structure
 typedef struct {
     float x, y;
@@ -284,6 +389,7 @@ typedef struct {
     int lifetime;         // Frames remaining before expiration
     int damage;           // Damage dealt by projectile
     EntityType source;    // Who fired the projectile
+    bool trail;           // Leaves particles behind; pattern bullets don't
 } Projectile;
 
 // Particle structure for visual effects
@@ -296,6 +402,36 @@ typedef struct {
     bool active;          // Is particle active?
 } Particle;
 
+// Collision layers. Platforms are on TERRAIN or HAZARD; a body is
+// resolved against the platform layers in its mask and touches the bodies
+// whose layer is in its mask.
+typedef enum {
+    PHYS_LAYER_TERRAIN = 1 << 0,    // Solid platforms
+    PHYS_LAYER_HAZARD = 1 << 1,     // Deadly platforms, also solid
+    PHYS_LAYER_PLAYER = 1 << 2,
+    PHYS_LAYER_ENEMY = 1 << 3
+} PhysicsLayer;
+
+// What a body touched during its last step
+typedef enum {
+    PHYS_CONTACT_GROUND = 1 << 0,
+    PHYS_CONTACT_CEILING = 1 << 1,
+    PHYS_CONTACT_WALL_LEFT = 1 << 2,
+    PHYS_CONTACT_WALL_RIGHT = 1 << 3
+} PhysicsContact;
+
+typedef struct {
+    unsigned int layer;   // PhysicsLayer bits the body is on
+    unsigned int mask;    // PhysicsLayer bits it collides with
+    float gravity;        // Added to dy every step; 0 floats
+    float knockback_decay; // Knockback kept each tick
+    bool step_up;         // Climbs ledges up to MAX_STEP_UP_HEIGHT while grounded
+    float move_x, move_y; // Displacement queued for the next step
+    unsigned int contacts; // PhysicsContact bits from the last step
+    int rest_ticks;       // Steps in a row without moving
+    bool asleep;          // Skipped by the step until woken
+} PhysicsBody;
+
 // Structure for game entities (player and enemies)
 typedef struct {
     float x, y;           // Position
@@ -311,10 +447,13 @@ typedef struct {
     float attack_speed;  // Attack rate
     float last_attack;   // Time since last attack (also used for invincibility)
     float last_shot;     // Time since last projectile shot
-    ALLEGRO_BITMAP* sprite;
-    ALLEGRO_BITMAP* sprite_sheet; // For animations
+    ALLEGRO_BITMAP* sprite;       // Current animation frame, NULL to draw a circle
+    ALLEGRO_BITMAP* sprite_sheet; // Atlas page the frame is on
+    const CollisionMask* mask;    // Opaque pixels of the frame, NULL to be hit by the box
+    int clip;            // AnimClipId being played, or ANIM_NO_CLIP
     int current_frame;   // Current animation frame
-    float frame_timer;   // Animation timer
+    float frame_timer;   // Updates the current frame has been shown for
+    bool facing_left;    // Sprites are drawn flipped
     bool is_on_ground;    // True if the entity is on a platform
     bool jump_requested;  // True if jump input was made
     int coyote_time;      // Frames remaining for coyote time jump
@@ -328,6 +467,7 @@ typedef struct {
     float knockback_dx;   // Horizontal knockback velocity
     float knockback_dy;   // Vertical knockback velocity
     int knockback_timer;  // Frames remaining for knockback effect
+    PhysicsBody body;     // Moved and collided by the physics step
     
     // Advanced AI Fields
     float ai_aggression;  // AI aggression multiplier (1.0 = normal)
@@ -344,6 +484,9 @@ typedef struct {
     int retreat_timer;    // Timer for retreat behavior
     EntityBehavior backup_behavior; // Behavior to return to after special actions
     int ai_timer;         // General purpose AI timer
+    int phase_timer;      // Boss chase and pause cycle
+    int pattern_tick;     // Ticks into the boss's phase two bullet pattern
+    int batch_index;      // Position in the level's EnemyBatches order
     int last_damage_time; // Time since last damage taken
 } Entity;
 
@@ -364,38 +507,114 @@ typedef struct {
     int selected_index;
 } Menu;
 
-// Platform structure
+// Counts from one physics step
 typedef struct {
-    float x, y;
-    float width, height;
-    ALLEGRO_COLOR color;
-    bool is_deadly;     // Spikes or other hazards
-} Platform;
+    int stepped;                // Bodies integrated and resolved
+    int sleeping;               // Bodies skipped because they were asleep
+    int platform_tests;         // Platform overlap tests
+    int tile_tests;             // Solid tile cells tested
+    int layer_skips;            // Platforms and tiles skipped by the body's mask
+} PhysicsStats;
+
+// What starts an enemy wave
+typedef enum {
+    SPAWN_AT_X,                 // The player reaches x = 'at'
+    SPAWN_AT_TIME               // 'at' seconds after the level started
+} SpawnTrigger;
+
+typedef struct {
+    float x, y;                 // Where the first enemy of a wave appears
+} SpawnPoint;
+
+// One wave of a level's constant spawn table
+typedef struct {
+    SpawnTrigger trigger;
+    float at;
+    int point;                  // Index into the level's spawn points
+    EntityType type;
+    EntityBehavior behavior;
+    int count;                  // Enemies in the wave
+    int interval;               // Ticks between two enemies, 0 for all at once
+    float spacing;              // Distance between enemies placed in rows
+    float health;
+} SpawnWave;
+
+typedef struct {
+    bool triggered;
+    int spawned;                // Enemies of the wave placed so far
+    int cooldown;               // Ticks until the next one
+} SpawnWaveState;
+
+typedef struct {
+    const SpawnPoint* points;
+    int num_points;
+    const SpawnWave* waves;
+    int num_waves;
+    SpawnWaveState waves_state[SPAWNER_MAX_WAVES];
+    int ticks;                  // Updates since the level started
+
+    // Statistics
+    int spawned;
+    int recycled;               // Dead enemies whose slot went back to the pool
+    int rejected;               // Spawns dropped because the pool was full
+} EnemySpawner;
+
+// A level's enemies ordered by behavior, so each behavior is updated as
+// one batch (enemy_batch.h). The lanes hold the batch being updated as
+// arrays of positions and velocities.
+typedef struct {
+    Entity** order;             // capacity entries
+    int start[BEHAVIOR_COUNT + 1]; // Behavior b is order[start[b]] up to order[start[b + 1]]
+    int capacity;
+
+    Entity** lanes;             // Enemies of the gathered batch
+    float* x;
+    float* y;
+    float* width;
+    float* dx;
+    float* dy;
+    float* flags;               // Non-zero where the kernel asks for a transition
+
+    Entity** pending;           // Enemies whose behavior changed this update
+    int num_pending;
+    bool pending_overflow;      // More changes than capacity; the next rebucket scans all
+
+    int moves;                  // Enemies moved to another behavior by the last update
+} EnemyBatches;
 
 // Level structure
 typedef struct {
-    Platform* platforms;
-    Entity* enemies;
-    GlucoseItem* glucose_items; // Added for glucose items
-    Projectile* projectiles;    // Array of projectiles
-    Particle* particles;        // Array of particles for visual effects
+    Platform* platforms;        // Sorted by x
+    GlucoseItem* glucose_items; // Sorted by x
+    ChunkPool enemies;          // Pool of Entity; dead enemies stay until the spawner recycles them
+    EnemyBatches batches;       // The enemies grouped by behavior
+    EnemySpawner spawner;
+    ChunkPool projectiles;      // Pool of Projectile, grows in chunks
+    ChunkPool particles;        // Pool of Particle for visual effects
+    ChunkPool particle_spawns;  // Particles created while defer_particles is set
+    bool defer_particles;       // Queue new particles until flush_deferred_particles
+    MemoryBudget pool_budget;   // Byte budget shared by the pools above
     int num_platforms;
-    int num_enemies;
     int num_glucose_items; // Added for glucose items
-    int num_projectiles;   // Active projectile count
-    int num_particles;     // Active particle count
     ALLEGRO_BITMAP* background;
     // Multi-background support for level transitions
-    ALLEGRO_BITMAP* backgrounds[4];  // Array of up to 4 backgrounds
     int num_backgrounds;             // Number of backgrounds used
     float* background_positions;     // X positions where each background starts
-    float scroll_x;
+    BackgroundTileSet background_tiles; // Backgrounds split into streamed tiles
+    Tilemap tilemap;                 // Optional tile layer; cells is NULL without one
+    StaticChunkSet static_chunks;    // Platforms and tiles baked by the drawing thread
+    float max_platform_width;   // Widest platform, for camera culling
+    float max_glucose_width;    // Widest glucose item, for camera culling
     float level_width;
     float level_height;   // Height of the level
     char* level_name;
     char* level_description;
     Portal portal;
+    TriggerIndex triggers;     // Glucose items, portal and hazards, rebuilt with the content
     int id; // Added to store the level number (e.g., 1, 2, 3)
+    Arena arena;               // Owns all of the level's memory
+    ArenaMark content_mark;    // Rewind point for reset_level_content; geometry lies before it
+    PhysicsStats physics;      // Counts from the last physics step
 } Level;
 
 // Game settings
@@ -403,6 +622,7 @@ typedef struct {
     int difficulty;      // 1: Easy, 2: Normal, 3: Hard
     bool sound_enabled;
     bool music_enabled;
+    int render_scale;    // Percent, RENDER_SCALE_MIN to 100
 } GameSettings;
 
 // Level star progress tracking
@@ -424,14 +644,6 @@ typedef struct {
     int last_stars_check;       // Last checked star count for adaptation
 } AIGlobalState;
 
-// Screen shake effect
-typedef struct {
-    float intensity;     // Current shake intensity
-    int duration;        // Frames remaining
-    float offset_x;      // Current screen offset
-    float offset_y;
-} ScreenShake;
-
 // Game structure
 typedef struct {
     GameState state;
@@ -442,6 +654,16 @@ typedef struct {
     ALLEGRO_DISPLAY* display;
     ALLEGRO_EVENT_QUEUE* event_queue;
     ALLEGRO_TIMER* timer;
+    ALLEGRO_TIMER* menu_timer;   // Slow timer for menu animations
+    JobSystem jobs;              // Worker threads for the update_game stages
+    TaskGraph update_graph;      // Stages of update_game and their dependencies
+    GameState timer_state;       // State the timers were last set up for
+    ALLEGRO_BITMAP* pause_frame; // Level frame shown under the pause screen
+    bool pause_frame_valid;
+    bool show_overdraw;          // Debug view of per-pixel overdraw, toggled with OVERDRAW_VIEW_KEY
+    struct Renderer* renderer;   // Snapshot triple buffer and render thread
+    struct DrawContext* draw_context; // Draw lists and recording threads
+    struct AnimationSet* animations;  // Decoded sprite clips of the player and bosses
     ALLEGRO_FONT* font;
     ALLEGRO_FONT* title_font;
     ALLEGRO_SAMPLE* jump_sound;
@@ -461,7 +683,7 @@ typedef struct {
     Menu level_menu;
     Menu settings_menu;
     GameSettings settings;
-    ScreenShake screen_shake;    // Screen shake effect
+    Camera camera;               // Scroll position and screen shake
     
     // Star system tracking
     LevelStars current_level_progress;  // Progress for current level
@@ -494,6 +716,10 @@ typedef struct {
 // Projectile system function declarations
 void create_projectile(Level* level, float x, float y, float target_x, float target_y, EntityType source);
 void create_player_projectile(Level* level, float x, float y, float dx, float dy);
+// 'count' bullets from (x, y) at 'speed', the first heading 'angle' radians
+// and each next one 'step' radians further round
+void create_projectile_volley(Level* level, float x, float y, float angle, float step, int count,
+                              float speed, EntityType source);
 void update_projectiles(Level* level, Game* game);
 void check_projectile_collisions(Level* level, Game* game);
 
@@ -502,6 +728,7 @@ void create_particle_burst(Level* level, float x, float y, ALLEGRO_COLOR color,
 void create_enemy_death_effect(Level* level, float x, float y, EntityType enemy_type);
 void create_projectile_trail(Level* level, float x, float y, EntityType source);
 void update_particles(Level* level);
+void flush_deferred_particles(Level* level);
 
 // Screen shake effect function declarations
 void create_screen_shake(Game* game, float intensity, int duration);
@@ -519,7 +746,6 @@ void apply_retreat_behavior(Entity* enemy, Entity* player, Game* game);
 void apply_surround_behavior(Entity* enemy, Entity* player, Game* game, int enemy_index);
 void execute_coordinate_behavior(Game* game, Entity* enemy);
 void execute_ambush_behavior(Game* game, Entity* enemy);
-void execute_retreat_behavior(Game* game, Entity* enemy);
 void execute_surround_behavior(Game* game, Entity* enemy);
 void adapt_ai_difficulty(Game* game, bool player_success);
 float calculate_ai_aggression(Entity* enemy, Game* game);
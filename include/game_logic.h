@@ -6,11 +6,13 @@
 
 // Function declarations for core game logic, initialization, and cleanup
 bool init_game(Game* game);
+bool init_game_headless(Game* game); // Memory bitmaps only, see render_bench.h
 void init_menus(Game* game); // For initializing menu structures
 void update_game(Game* game);
 void cleanup_menus(Game* game);
 void cleanup_game(Game* game);
 void reset_player_and_level(Game* game, int level_idx); // Declaration for reset function
+void update_state_timers(Game* game);
 
 // Star system functions
 void init_star_system(Game* game);
@@ -0,0 +1,88 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <allegro5/allegro.h>
+#include <stdbool.h>
+
+// Work-stealing thread pool that runs a graph of tasks. Each thread owns a
+// queue of ready tasks: it takes work from the back of its own queue and,
+// when that is empty, steals from the front of another thread's queue.
+// The thread calling run_task_graph works too and returns once every task
+// of the graph has finished.
+
+#define JOB_MAX_WORKERS 8          // Worker threads besides the calling thread
+#define TASK_GRAPH_MAX_TASKS 32
+#define TASK_MAX_DEPENDENTS 8
+
+typedef void (*TaskFunc)(void* data);
+
+typedef struct {
+    const char* name;
+    TaskFunc func;
+    void* data;
+    int num_deps;                   // Tasks that must finish before this one
+    int dependents[TASK_MAX_DEPENDENTS];
+    int num_dependents;
+    int pending;                    // Unfinished dependencies in the current run
+
+    // Timing in seconds, written by the thread that ran the task
+    double last_time;
+    double total_time;
+    double max_time;
+    int runs;
+    int last_thread;                // Thread index that last ran the task (0 = caller)
+} Task;
+
+typedef struct {
+    Task tasks[TASK_GRAPH_MAX_TASKS];
+    int num_tasks;
+} TaskGraph;
+
+// Double-ended queue of ready task indices. The owner pushes and pops at
+// the bottom, thieves take from the top.
+typedef struct {
+    int items[TASK_GRAPH_MAX_TASKS];
+    int top;
+    int bottom;
+    ALLEGRO_MUTEX* lock;
+} TaskQueue;
+
+struct JobSystem;
+
+typedef struct {
+    struct JobSystem* system;
+    int index;
+} JobWorker;
+
+typedef struct JobSystem {
+    int num_threads;                // Worker threads; 0 runs graphs serially on the caller
+    ALLEGRO_THREAD* threads[JOB_MAX_WORKERS];
+    JobWorker workers[JOB_MAX_WORKERS + 1];
+    TaskQueue queues[JOB_MAX_WORKERS + 1];  // Queue 0 belongs to the calling thread
+
+    ALLEGRO_MUTEX* lock;            // Guards the fields below
+    ALLEGRO_COND* wake;             // Signalled when tasks are queued or a graph finishes
+    TaskGraph* graph;               // Graph being run, NULL when idle
+    int remaining;                  // Tasks of the graph that have not finished
+    int queued;                     // Ready tasks sitting in queues
+    bool quit;
+
+    int steals;                     // Tasks taken from another thread's queue
+} JobSystem;
+
+// Start 'num_threads' workers (clamped to JOB_MAX_WORKERS). With 0, or if the
+// threads cannot be created, graphs run serially in the order tasks were added.
+bool init_job_system(JobSystem* jobs, int num_threads);
+void cleanup_job_system(JobSystem* jobs);
+
+void init_task_graph(TaskGraph* graph);
+// Returns the task index, or -1 if the graph is full
+int add_task(TaskGraph* graph, const char* name, TaskFunc func, void* data);
+// 'task' may only start once 'dependency' has finished
+bool add_task_dependency(TaskGraph* graph, int task, int dependency);
+
+// Run every task of the graph once and wait for all of them to finish
+void run_task_graph(JobSystem* jobs, TaskGraph* graph);
+void report_task_graph(const JobSystem* jobs, const TaskGraph* graph);
+
+#endif /* JOBS_H */
@@ -11,7 +11,11 @@
 // Function declarations for level management
 void init_level(Level* level, const char* name, const char* description, float width, int id); // Added id parameter
 void init_levels(Game* game);
+void queue_level_preloads(void); // Scene backgrounds init_levels will cut into tiles
 void init_level_content(Level* level, int level_number);
+void reset_level_content(Level* level);
+void set_level_pool_budget(Level* level, size_t bytes);
+void report_level_pools(Level* level);
 void cleanup_level(Level* level);
 void cleanup_levels(Game* game);
 
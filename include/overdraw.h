@@ -0,0 +1,36 @@
+#ifndef OVERDRAW_H
+#define OVERDRAW_H
+
+#include <allegro5/allegro.h>
+#include <stdbool.h>
+
+// Debug view of fill rate: every command a draw list submits adds one to
+// each pixel it covers, and the counts are shown as a heatmap from blue
+// (drawn once) through green and yellow to red (OVERDRAW_HEAT_MAX or more).
+// Coverage is worked out from the command's shape, not read back from the
+// target, so it costs the same on every kind of display.
+
+#define OVERDRAW_HEAT_MAX 6
+
+typedef struct {
+    unsigned char* counts;      // One per pixel, saturating at 255
+    int width, height;
+    ALLEGRO_BITMAP* heatmap;    // Counts turned into colours
+    long long total;            // Pixels written this frame
+    int max;                    // Highest count this frame
+} OverdrawMap;
+
+bool init_overdraw_map(OverdrawMap* map, int width, int height);
+void free_overdraw_map(OverdrawMap* map);
+void clear_overdraw_map(OverdrawMap* map);
+
+// Screen-space shapes, clipped to the map
+void add_overdraw_rect(OverdrawMap* map, float x1, float y1, float x2, float y2);
+// Pixels between 'inner' and 'outer' radius; an inner radius of 0 is a disc
+void add_overdraw_ring(OverdrawMap* map, float cx, float cy, float inner, float outer);
+
+// Draw the heatmap over the whole current target
+void draw_overdraw_heatmap(OverdrawMap* map);
+double get_average_overdraw(const OverdrawMap* map);
+
+#endif /* OVERDRAW_H */
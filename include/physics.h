@@ -0,0 +1,29 @@
+#ifndef PHYSICS_H
+#define PHYSICS_H
+
+#include "game.h" // For Level, Entity, PhysicsBody
+
+// One physics step per update moves every dynamic body and resolves it
+// against the level's platforms. Input and AI don't move entities
+// themselves: they queue a displacement with move_body. The step adds the
+// knockback, applies gravity and pushes the body out of the platforms its
+// mask collides with, recording the contacts for the game logic to react
+// to. Platforms are sorted by x, so each body only tests the few its move
+// can reach, and tiles of the level's tile layer are looked up by cell. A body that stays still for PHYSICS_SLEEP_TICKS falls asleep
+// and is skipped until something moves or knocks it.
+
+// Put 'entity' on 'layer', colliding with the layers in 'mask', awake
+void init_body(Entity* entity, unsigned int layer, unsigned int mask, float gravity,
+               float knockback_decay, bool step_up);
+// Add (dx, dy) to what the next step moves 'entity'; wakes it when non-zero
+void move_body(Entity* entity, float dx, float dy);
+// Knockback of (dx, dy) per tick, decaying over 'ticks'; wakes the body
+void knock_body(Entity* entity, float dx, float dy, int ticks);
+void wake_body(Entity* entity);
+// Whether 'a' reacts to touching 'b'
+bool bodies_interact(const Entity* a, const Entity* b);
+
+// Step the player and the level's active enemies; counts go to level->physics
+void step_physics(Level* level, Entity* player);
+
+#endif /* PHYSICS_H */
@@ -0,0 +1,58 @@
+#ifndef PIXEL_KERNELS_H
+#define PIXEL_KERNELS_H
+
+#include <allegro5/allegro.h>
+#include <stdbool.h>
+#include <stdint.h>   // For uint32_t
+
+// Fills and blends straight into locked memory bitmaps, for software
+// rendering where Allegro blends every pixel through its generic path.
+// Rows are processed with AVX2 when the build enables it (SIMD_CFLAGS=-mavx2),
+// otherwise with SSE2 on x86-64, and with plain C elsewhere; every version
+// produces the same bytes.
+//
+// Blending matches Allegro's default blender (ALLEGRO_ONE,
+// ALLEGRO_INVERSE_ALPHA): dst = src + dst * (255 - src alpha) / 255, per
+// channel and saturating. Only 32-bit formats with alpha in the top byte
+// are handled.
+
+// Kernels on runs of pixels
+void fill_pixels(uint32_t* dst, int count, uint32_t pixel);
+void blend_fill_pixels(uint32_t* dst, int count, uint32_t pixel);
+void copy_pixels(uint32_t* dst, const uint32_t* src, int count);
+void blend_pixels(uint32_t* dst, const uint32_t* src, int count);
+// One pixel of blend_pixels in plain C, which every version matches
+uint32_t blend_pixel(uint32_t dst, uint32_t src);
+const char* get_pixel_kernel_name(void);   // "AVX2", "SSE2" or "scalar"
+
+// 'color' as a pixel of 'format'; false if the kernels don't handle the format
+bool pack_pixel(int format, ALLEGRO_COLOR color, uint32_t* pixel);
+
+// A memory bitmap drawn to with the kernels. It is locked on first use and
+// must be unlocked with end_kernel_drawing before Allegro draws to it again.
+// Everything is clipped to the bitmap's clipping rectangle.
+typedef struct {
+    ALLEGRO_BITMAP* bitmap;
+    int format;
+    ALLEGRO_LOCKED_REGION* region;  // NULL while unlocked
+    int clip_x1, clip_y1, clip_x2, clip_y2;
+} KernelTarget;
+
+// The bench turns the kernels off to time Allegro's own path
+void set_pixel_kernels_enabled(bool enabled);
+
+// False if 'bitmap' is not a memory bitmap the kernels can draw to, or the
+// kernels are turned off
+bool begin_kernel_target(KernelTarget* target, ALLEGRO_BITMAP* bitmap);
+void end_kernel_drawing(KernelTarget* target);
+
+// Pixels whose centres lie inside the shape, like Allegro's rasterizer
+void kernel_clear(KernelTarget* target, ALLEGRO_COLOR color);
+void kernel_filled_rectangle(KernelTarget* target, float x1, float y1, float x2, float y2,
+                             ALLEGRO_COLOR color);
+void kernel_filled_circle(KernelTarget* target, float cx, float cy, float radius, ALLEGRO_COLOR color);
+// Blend (or with 'opaque', copy) 'bitmap' at whole pixel position (x, y).
+// False if 'bitmap' is not a memory bitmap in the target's format.
+bool kernel_draw_bitmap(KernelTarget* target, ALLEGRO_BITMAP* bitmap, int x, int y, bool opaque);
+
+#endif /* PIXEL_KERNELS_H */
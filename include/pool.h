@@ -0,0 +1,95 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "arena.h"
+
+// Growable object pool used for per-level projectiles and particles.
+// Elements live in fixed-size chunks that are never moved or reallocated,
+// so pointers to live elements stay valid while the pool grows.
+
+#define POOL_MAX_CHUNKS 64   // Upper bound on chunks per pool
+#define POOL_SLOT_NONE  -1   // End of a slot list / no slot
+
+// What to do when a pool is full and may not grow any further
+typedef enum {
+    POOL_OVERFLOW_REJECT,       // Refuse the new element (acquire returns NULL)
+    POOL_OVERFLOW_EVICT_OLDEST  // Recycle the longest-lived element
+} PoolOverflowPolicy;
+
+// Byte budget shared by all pools of one level
+typedef struct {
+    size_t limit;   // Maximum bytes the pools may allocate (0 = unlimited)
+    size_t used;    // Bytes currently allocated
+    size_t peak;    // Highest value 'used' has reached
+} MemoryBudget;
+
+// Per-slot bookkeeping: live slots form a list in spawn order,
+// free slots are chained through 'next'
+typedef struct {
+    int prev;
+    int next;
+} PoolLink;
+
+typedef struct {
+    PoolLink* links;        // chunk_capacity links
+    unsigned char* data;    // chunk_capacity elements
+} PoolChunk;
+
+typedef struct {
+    const char* name;           // Used in reports
+    size_t element_size;
+    int chunk_capacity;         // Elements per chunk
+    size_t max_bytes;           // Own cap on top of the budget (0 = budget only)
+    PoolOverflowPolicy policy;
+    MemoryBudget* budget;       // Shared level budget, may be NULL
+    Arena* arena;               // Chunks are carved from here if set, else malloc'd
+
+    PoolChunk chunks[POOL_MAX_CHUNKS];
+    int num_chunks;
+    size_t bytes;               // Bytes allocated by this pool
+
+    int free_head;              // First free slot
+    int live_head;              // Oldest live slot
+    int live_tail;              // Newest live slot
+    int live;                   // Number of live elements
+
+    // Statistics
+    int high_water;             // Most elements live at once
+    int evictions;              // Elements recycled by POOL_OVERFLOW_EVICT_OLDEST
+    int rejections;             // Acquires refused by POOL_OVERFLOW_REJECT
+} ChunkPool;
+
+void pool_init(ChunkPool* pool, const char* name, size_t element_size, int chunk_capacity,
+               size_t max_bytes, PoolOverflowPolicy policy, MemoryBudget* budget, Arena* arena);
+// Drop all chunks. Arena-backed chunks are only forgotten; their memory
+// goes back with the arena's rewind or release.
+void pool_destroy(ChunkPool* pool);
+
+// Returns a zeroed element, growing the pool or applying the overflow policy
+// when no slot is free. Returns NULL only if the element was rejected.
+// Must not be called on a pool that is currently being iterated.
+void* pool_acquire(ChunkPool* pool);
+// Grow the pool up front until it holds 'count' elements; false if the
+// caps stopped it short
+bool pool_reserve(ChunkPool* pool, int count);
+void pool_release(ChunkPool* pool, int slot);
+void pool_clear(ChunkPool* pool);   // Release every element, keep the chunks
+
+int pool_capacity(const ChunkPool* pool);
+void* pool_at(const ChunkPool* pool, int slot);
+
+// Iterate live elements from oldest to newest. Fetch the next slot
+// before releasing the current one.
+static inline int pool_first(const ChunkPool* pool) {
+    return pool->live_head;
+}
+
+static inline int pool_next(const ChunkPool* pool, int slot) {
+    return pool->chunks[slot / pool->chunk_capacity].links[slot % pool->chunk_capacity].next;
+}
+
+void pool_report(const ChunkPool* pool);
+
+#endif /* POOL_H */
@@ -0,0 +1,60 @@
+#ifndef PRELOAD_H
+#define PRELOAD_H
+
+#include <allegro5/allegro.h>
+#include <allegro5/allegro_audio.h>
+#include <stdbool.h>
+#include "jobs.h"
+
+// Images and sounds needed at startup are queued by the modules that use
+// them, then decoded on the job system's threads into memory bitmaps and
+// samples while the main thread creates the display and loads fonts. The
+// loaders take the decoded assets by path, so only converting bitmaps for
+// the display is left on the main thread. A path that was not queued, or
+// failed to decode, returns NULL and is loaded the usual way.
+//
+// Preloading is off unless asked for, since it has not yet been shown to
+// bring the first frame forward; by default every asset loads serially on
+// the main thread.
+//
+//   cancer_cell_game --preload    Decode on the worker threads, to compare
+//                                 its startup timeline with the default
+
+typedef enum {
+    PRELOAD_BITMAP,
+    PRELOAD_SAMPLE
+} PreloadKind;
+
+typedef struct {
+    char path[256];
+    PreloadKind kind;
+    int bitmap_flags;           // Added to ALLEGRO_MEMORY_BITMAP, e.g. linear filtering
+    int fit_width, fit_height;  // Bitmaps are stretched to this size unless 0
+    ALLEGRO_BITMAP* bitmap;
+    ALLEGRO_SAMPLE* sample;
+    double time;                // Seconds spent decoding
+} PreloadAsset;
+
+// Turn queueing on; until then every asset is loaded where it is used
+void enable_preload(void);
+bool is_preload_command(int argc, char** argv);
+
+// Queue a file; false if the queue is full, decoding has started or
+// preloading is off
+bool queue_preload_bitmap(const char* path, int bitmap_flags, int fit_width, int fit_height);
+bool queue_preload_sample(const char* path);
+
+// Start decoding the queue on 'jobs' from a helper thread and return at
+// once. 'jobs' must not run anything else until finish_preload.
+void start_preload(JobSystem* jobs);
+// Wait for decoding to finish and add it to the startup timeline; returns
+// the seconds it ran
+double finish_preload(void);
+
+// The decoded asset for 'path', now owned by the caller, or NULL
+ALLEGRO_BITMAP* take_preloaded_bitmap(const char* path);
+ALLEGRO_SAMPLE* take_preloaded_sample(const char* path);
+// Destroy what was not taken and empty the queue
+void release_preload(void);
+
+#endif /* PRELOAD_H */
@@ -0,0 +1,42 @@
+#ifndef PRIM_BATCH_H
+#define PRIM_BATCH_H
+
+#include <allegro5/allegro.h>
+#include <allegro5/allegro_primitives.h> // For ALLEGRO_VERTEX
+#include <stdbool.h>
+
+// Collects untextured rectangles and circles as indexed triangles so a whole
+// run of them goes out with one al_draw_indexed_prim. Circles are built from
+// unit-circle meshes computed once, with more segments for larger radii.
+// Triangles are drawn in the order they were added, so overlapping shapes
+// keep their painter's order within a batch.
+
+#define PRIM_CIRCLE_LODS 4              // Unit-circle meshes of 8, 16, 32 and 64 segments
+#define PRIM_CIRCLE_MIN_SEGMENTS 8
+#define PRIM_CIRCLE_MAX_SEGMENTS 64
+
+typedef struct {
+    ALLEGRO_VERTEX* vertices;
+    int num_vertices;
+    int vertex_capacity;
+    int* indices;
+    int num_indices;
+    int index_capacity;
+} PrimBatch;
+
+void init_prim_batch(PrimBatch* batch);
+void free_prim_batch(PrimBatch* batch);
+void clear_prim_batch(PrimBatch* batch);
+
+// Same geometry as the al_draw_* call of the same name
+void batch_filled_rectangle(PrimBatch* batch, float x1, float y1, float x2, float y2, ALLEGRO_COLOR color);
+void batch_rectangle(PrimBatch* batch, float x1, float y1, float x2, float y2,
+                     ALLEGRO_COLOR color, float thickness);
+void batch_filled_circle(PrimBatch* batch, float cx, float cy, float radius, ALLEGRO_COLOR color);
+void batch_circle(PrimBatch* batch, float cx, float cy, float radius, ALLEGRO_COLOR color, float thickness);
+
+// Draw the collected triangles to the current target and empty the batch.
+// Returns false if there was nothing to draw.
+bool flush_prim_batch(PrimBatch* batch);
+
+#endif /* PRIM_BATCH_H */
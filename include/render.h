@@ -0,0 +1,121 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include "game.h" // For Game, GameState, Platform, Portal, EntityType, Level, Camera
+#include <allegro5/allegro.h>
+
+// The simulation copies everything drawing needs into a RenderSnapshot once
+// per tick and publishes it through a triple buffer. A render thread that
+// owns the display draws the newest snapshot, so a slow frame never holds up
+// the next update and the simulation never waits for the renderer.
+
+#define RENDER_MENU_ITEMS 8
+#define RENDER_CULL_MARGIN 64.0f  // Pixels beyond the screen edges still captured
+
+typedef struct {
+    float x, y, width, height;
+    EntityType type;
+    float health, max_health;
+    ALLEGRO_BITMAP* sprite;     // Animation frame, NULL for a circle
+    bool facing_left;
+} RenderEnemy;
+
+typedef struct {
+    float x, y, width, height;
+    EntityType source;
+} RenderProjectile;
+
+typedef struct {
+    float x, y;
+    ALLEGRO_COLOR color;
+} RenderParticle;
+
+typedef struct {
+    float x, y, width, height;
+} RenderGlucose;
+
+typedef struct {
+    float x, y, width, height;
+    EntityState state;
+    float last_shot;
+    float last_attack;
+    int combo_count;
+    int combo_timer;
+    float health, max_health;
+    ALLEGRO_BITMAP* sprite;     // Animation frame, NULL for a circle
+    bool facing_left;
+} RenderPlayer;
+
+// Copy of the menu being shown; item text changes while the game runs
+typedef struct {
+    char text[RENDER_MENU_ITEMS][MAX_MENU_TEXT];
+    bool enabled[RENDER_MENU_ITEMS];
+    int num_items;
+    int selected_index;
+} RenderMenu;
+
+typedef struct {
+    unsigned int sequence;      // Number of snapshots published before this one
+    GameState state;
+    double time;                // Clock for pulsing effects, so a snapshot always draws the same
+    bool show_overdraw;         // Draw the overdraw heatmap instead of the frame
+    int render_scale;           // Percent of the screen size the frame is drawn at
+    RenderMenu menu;            // For MAIN_MENU, LEVEL_SELECT and SETTINGS
+
+    // Level scene, for PLAYING and the pause screen drawn over it
+    bool has_scene;
+    Level* level;               // Only its background tiles, static chunks and geometry are used
+    Camera camera;              // Scroll and shake the scene is drawn with
+    Portal portal;
+    RenderPlayer player;
+
+    // Visible objects. The arrays grow as needed and are reused by later
+    // snapshots taken into the same buffer.
+    Platform* platforms;
+    int num_platforms, platform_capacity;
+    RenderEnemy* enemies;
+    int num_enemies, enemy_capacity;
+    RenderProjectile* projectiles;
+    int num_projectiles, projectile_capacity;
+    RenderParticle* particles;
+    int num_particles, particle_capacity;
+    RenderGlucose* glucose_items;
+    int num_glucose_items, glucose_capacity;
+
+    // HUD and end screens
+    int current_level;
+    int total_stars;
+    int level_progress_stars;   // Stars earned so far in the current level
+    int level_stars[TOTAL_LEVELS];
+} RenderSnapshot;
+
+typedef struct Renderer {
+    RenderSnapshot buffers[3];
+    int write_index;            // Filled by the simulation
+    int ready_index;            // Newest published snapshot
+    int read_index;             // Being drawn
+    bool fresh;                 // ready_index has not been picked up yet
+
+    ALLEGRO_MUTEX* lock;        // Guards ready_index, fresh and quit
+    ALLEGRO_COND* published;
+    ALLEGRO_THREAD* thread;     // NULL when drawing on the main thread
+    bool quit;
+
+    Level* drawn_level;         // Level whose background tiles are resident
+
+    // Statistics
+    unsigned int published_count;
+    unsigned int drawn_count;
+} Renderer;
+
+// Start the render thread (if RENDER_THREAD is set) and hand it the display
+bool init_renderer(Game* game);
+// Capture the game into a snapshot and hand it to the renderer. Without a
+// render thread the snapshot is drawn right away.
+void publish_render_snapshot(Game* game);
+// Stop the render thread and give the display back to the calling thread
+void cleanup_renderer(Game* game);
+
+void capture_render_snapshot(const Game* game, RenderSnapshot* snap);
+
+#endif /* RENDER_H */
@@ -0,0 +1,22 @@
+#ifndef RENDER_BENCH_H
+#define RENDER_BENCH_H
+
+#include <stdbool.h>
+
+// Headless rendering for hosts without a display or GPU. Every game state,
+// plus scripted PLAYING scenarios, is drawn with draw_game into a memory
+// bitmap. The bench times each draw section and the golden check compares
+// each frame with a reference PNG in GOLDEN_IMAGE_DIR. A scenario without
+// its PNG fails the check, so it only passes once the goldens have been
+// saved with --golden-update, reviewed and committed.
+//
+//   cancer_cell_game --bench [iterations]   Time every scenario
+//   cancer_cell_game --golden               Compare with the goldens, exit code 1 on a mismatch
+//   cancer_cell_game --golden-update        Save the current frames as the goldens
+
+// True if the command line asks for one of the modes above
+bool is_render_bench_command(int argc, char** argv);
+// Run the requested mode; returns the process exit code
+int run_render_bench(int argc, char** argv);
+
+#endif /* RENDER_BENCH_H */
@@ -0,0 +1,39 @@
+#ifndef SCROLL_CACHE_H
+#define SCROLL_CACHE_H
+
+#include <allegro5/allegro.h>
+#include <stdbool.h>
+#include "draw_list.h"
+
+// Software rendering keeps the static layers of the playing scene (sky,
+// background tiles and platforms) composited in a memory bitmap. When the
+// camera scrolls, last frame's composite is shifted by the scroll delta and
+// only the newly exposed strip is drawn; the composite is then copied to
+// the target, which is far cheaper than blending every background pixel
+// again. Anything the cache cannot reproduce exactly (GPU targets, screen
+// shake, a render scale or fractional scroll) falls back to a full redraw.
+
+typedef struct {
+    ALLEGRO_BITMAP* bitmap;     // Static layers as seen from x
+    const void* owner;          // Level the composite belongs to
+    int x;                      // Camera x the composite was drawn at
+    bool valid;
+
+    // Frames since the start, by how the composite was brought up to date
+    unsigned int full_redraws;
+    unsigned int strip_redraws;
+    unsigned int reuses;        // Camera did not move
+    unsigned int bypasses;      // Cache could not be used
+} ScrollCache;
+
+void init_scroll_cache(ScrollCache* cache);
+void destroy_scroll_cache(ScrollCache* cache);
+void report_scroll_cache(const ScrollCache* cache);
+
+// Bring the composite of the static layers of 'list' up to date for
+// 'camera' and copy it to the current target. 'owner' identifies the static
+// content; a different owner redraws everything. Returns false, with the
+// target untouched, when the static layers have to be submitted normally.
+bool draw_scroll_cache(ScrollCache* cache, DrawList* list, const Camera* camera, const void* owner);
+
+#endif /* SCROLL_CACHE_H */
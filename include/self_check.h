@@ -0,0 +1,19 @@
+#ifndef SELF_CHECK_H
+#define SELF_CHECK_H
+
+#include <stdbool.h>
+
+// Deterministic checks of code whose results can be worked out by hand or
+// by brute force, such as the bit tricks of the collision masks, the
+// enemy batches and their kernels, and the pixel kernels' blending, which
+// is compared with Allegro's own on memory bitmaps. They need no display,
+// assets or timing, so they give the same answer on every machine.
+//
+//   cancer_cell_game --check    Run every check, exit code 1 on a failure
+
+// True if the command line asks for the checks
+bool is_self_check_command(int argc, char** argv);
+// Run them; returns the process exit code
+int run_self_check(int argc, char** argv);
+
+#endif /* SELF_CHECK_H */
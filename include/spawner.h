@@ -0,0 +1,27 @@
+#ifndef SPAWNER_H
+#define SPAWNER_H
+
+#include "game.h" // For Level, EnemySpawner, SpawnWave, Entity
+
+// Enemies live in the level's enemy pool. A level describes its enemies as
+// a constant table of spawn points and waves; each wave starts when the
+// player reaches an x position or after some time, and places its enemies
+// all at once or one every few ticks. Killed enemies only become inactive.
+// The spawner returns their slots to the pool at the start of the next
+// update, so no stage ever sees an enemy vanish while it iterates, and
+// spawning and dying never allocate.
+
+// Use 'waves' (which must outlive the level) for 'level' and reserve pool
+// slots for every enemy they spawn, up to LEVEL_MAX_ENEMIES
+void init_spawner(Level* level, const SpawnPoint* points, int num_points,
+                  const SpawnWave* waves, int num_waves);
+// Recycle dead enemies, then place the enemies of every triggered wave that
+// are due. Runs once per update, before the enemies move.
+void update_spawner(Level* level, float player_x);
+// A new active enemy from the pool, or NULL when the pool is full
+Entity* spawn_enemy(Level* level, EntityType type, EntityBehavior behavior, float x, float y, float health);
+// Whether every wave of the level has placed all of its enemies
+bool all_waves_spawned(const Level* level);
+void report_spawner(const Level* level);
+
+#endif /* SPAWNER_H */
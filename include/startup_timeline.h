@@ -0,0 +1,22 @@
+#ifndef STARTUP_TIMELINE_H
+#define STARTUP_TIMELINE_H
+
+// Timeline of the boot sequence, from just after al_init to the first frame
+// on screen. Each phase keeps its start and end relative to the start of
+// the timeline, so work overlapped on other threads shows up beside the
+// main thread's. The report is printed when the first frame is drawn.
+//
+// Phases are recorded by the main thread while init_game runs. The first
+// frame may be drawn on the render thread, which only starts after that.
+
+// Start the clock; al_get_time is only valid once al_init has run
+void start_startup_timeline(void);
+// Returns the phase to end, or -1 when the timeline is not running or full
+int begin_startup_phase(const char* name);
+void end_startup_phase(int phase);
+// A phase timed elsewhere, with al_get_time values
+void add_startup_phase(const char* name, double start, double end);
+// The first frame is on screen: print the report. Later calls do nothing.
+void finish_startup_timeline(void);
+
+#endif /* STARTUP_TIMELINE_H */
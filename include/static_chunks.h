@@ -0,0 +1,43 @@
+#ifndef STATIC_CHUNKS_H
+#define STATIC_CHUNKS_H
+
+#include <allegro5/allegro.h>
+#include <stdbool.h>
+#include <stddef.h>  // For size_t
+#include "tilemap.h"
+#include "draw_list.h"
+
+// A level's platforms and tiles never change, so the drawing thread
+// renders them once into bitmaps STATIC_CHUNK_WIDTH pixels wide, each cut
+// down to the rows it has content in. A frame then draws the two or three
+// chunks under the camera instead of every platform and tile.
+
+typedef struct {
+    ALLEGRO_BITMAP* bitmap;     // NULL when the chunk has no content
+    float x, y;                 // Level position of the bitmap
+} StaticChunk;
+
+typedef struct {
+    StaticChunk* chunks;        // Left to right, one per STATIC_CHUNK_WIDTH of level width
+    int num_chunks;
+    bool baked;                 // Baking was tried; not retried until destroyed
+    bool complete;              // Every chunk with content got its bitmap
+
+    // Statistics
+    int bakes;
+    double bake_time;           // Seconds spent in the last bake
+    size_t bytes;               // Pixel memory of the baked chunks
+} StaticChunkSet;
+
+void init_static_chunks(StaticChunkSet* set);
+// Draw the platforms and the map into chunks covering [0, width) of the
+// level, as bitmaps of the calling thread's new bitmap flags
+bool bake_static_chunks(StaticChunkSet* set, const Platform* platforms, int num_platforms,
+                        const Tilemap* map, float width);
+// Record the chunks overlapping [left, right] at their level position
+void record_static_chunks(const StaticChunkSet* set, DrawList* list, DrawLayer layer, int depth,
+                          float left, float right);
+void destroy_static_chunks(StaticChunkSet* set);   // Until the next bake
+void report_static_chunks(const StaticChunkSet* set, const char* name);
+
+#endif /* STATIC_CHUNKS_H */
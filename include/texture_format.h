@@ -0,0 +1,40 @@
+#ifndef TEXTURE_FORMAT_H
+#define TEXTURE_FORMAT_H
+
+#include <allegro5/allegro.h>
+#include <stdbool.h>
+#include <stddef.h>  // For size_t
+
+// Load-time pixel format policy. Textures with no transparent pixels (scene
+// backgrounds) are uploaded in a 16-bit format without alpha, halving their
+// memory and upload bandwidth; sprites keep 32-bit premultiplied RGBA so
+// they blend with Allegro's default blender. Memory bitmaps keep the
+// default format, which is the one software targets are drawn in.
+
+typedef enum {
+    TEXTURE_OPAQUE,             // Every pixel has full alpha
+    TEXTURE_SPRITE              // Drawn with alpha blending
+} TextureUse;
+
+// Format a bitmap for 'use' is created in under the current new bitmap flags
+int get_texture_format(TextureUse use);
+// Premultiplied load of 'path' in the format for 'use'. A bitmap preloaded
+// from 'path' is taken and uploaded instead of decoding the file again.
+ALLEGRO_BITMAP* load_texture(const char* path, TextureUse use);
+// A decoded memory bitmap turned into what load_texture returns for 'use'
+// under the calling thread's new bitmap flags
+ALLEGRO_BITMAP* upload_texture(ALLEGRO_BITMAP* bitmap, TextureUse use);
+// 'bitmap' in the format for 'use'. The original is destroyed when it had
+// to be copied; on failure it is returned unchanged.
+ALLEGRO_BITMAP* convert_texture(ALLEGRO_BITMAP* bitmap, TextureUse use);
+// Memory bitmap of 'bitmap' stretched to width x height; the original is
+// destroyed, also on failure, when NULL is returned
+ALLEGRO_BITMAP* resize_texture(ALLEGRO_BITMAP* bitmap, int width, int height);
+size_t get_texture_bytes(ALLEGRO_BITMAP* bitmap);
+
+// Path of the scene image 'name' (without extension) to draw 'width' pixels
+// wide: the pre-scaled "_scaled" variant when it is at least that wide and
+// exists, otherwise the full-size source
+void find_scene_variant(char* path, size_t size, const char* name, int width);
+
+#endif /* TEXTURE_FORMAT_H */
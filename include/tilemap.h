@@ -0,0 +1,66 @@
+#ifndef TILEMAP_H
+#define TILEMAP_H
+
+#include <allegro5/allegro.h>
+#include <stdbool.h>
+#include "arena.h"
+
+// Static level geometry: platforms and an optional tile layer. Neither
+// changes after init_levels, so the drawing thread may read them.
+
+// Platform structure
+typedef struct {
+    float x, y;
+    float width, height;
+    ALLEGRO_COLOR color;
+    bool is_deadly;     // Spikes or other hazards
+} Platform;
+
+// Optional grid of square tiles laid over a level next to its platforms.
+// A cell holds a tile id into the level's tile definitions; each
+// definition names a cell of the tile atlas (or a plain colour) and the
+// physics layers it is on. Finding the tile under a point is one division
+// per axis, so collision costs the same however big the map is.
+
+typedef struct {
+    int atlas_index;            // Tile of the atlas, left to right then down; -1 for 'color'
+    ALLEGRO_COLOR color;        // Drawn when there is no atlas tile
+    unsigned int layer;         // PhysicsLayer bits; 0 only decorates
+} TileDef;
+
+typedef struct {
+    int tile_size;              // Width and height of a cell in pixels
+    int cols, rows;
+    float x, y;                 // Level position of the top left cell
+    unsigned char* cells;       // cols * rows ids; 0 is empty, n uses defs[n - 1]. NULL = no map.
+    const TileDef* defs;
+    int num_defs;
+    ALLEGRO_BITMAP* atlas;      // Tiles of tile_size, may be NULL
+} Tilemap;
+
+// An empty map of cols x rows cells at (x, y), allocated from 'arena'
+bool init_tilemap(Tilemap* map, Arena* arena, int tile_size, float x, float y, int cols, int rows,
+                  const TileDef* defs, int num_defs);
+// Fill rows from strings, one character per cell: a character found at
+// index i of 'legend' is tile i + 1, anything else is empty. The map must
+// already be as large as the strings.
+void set_tilemap_rows(Tilemap* map, const char* const* rows, int num_rows, const char* legend);
+void set_tile(Tilemap* map, int col, int row, int id);
+
+static inline int get_tile(const Tilemap* map, int col, int row) {
+    if (!map->cells || col < 0 || row < 0 || col >= map->cols || row >= map->rows) return 0;
+    return map->cells[row * map->cols + col];
+}
+
+static inline const TileDef* get_tile_def(const Tilemap* map, int id) {
+    return id > 0 && id <= map->num_defs ? &map->defs[id - 1] : NULL;
+}
+
+// Physics layers of the tile under level point (x, y); 0 when empty
+unsigned int get_tile_layer_at(const Tilemap* map, float x, float y);
+// Cells overlapping the level box [left, right) x [top, bottom), clamped to
+// the map; false when the box misses it
+bool find_tile_range(const Tilemap* map, float left, float top, float right, float bottom,
+                     int* col0, int* row0, int* col1, int* row1);
+
+#endif /* TILEMAP_H */
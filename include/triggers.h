@@ -0,0 +1,64 @@
+#ifndef TRIGGERS_H
+#define TRIGGERS_H
+
+#include <stdbool.h>
+#include "arena.h"
+
+// Static trigger volumes of a level (pickups, the portal, hazard zones)
+// in one array sorted by left edge. The player moves a few pixels per
+// update, so instead of searching the array every update a cursor is kept
+// on the first trigger that can reach the player and stepped left or
+// right from where it was; that costs O(1) amortized per update, and only
+// the triggers between the cursor and the player's right edge are tested.
+//
+// The cursor stays the widest trigger's width left of the player, so
+// triggers wider than TRIGGER_MAX_WIDTH are stored as several pieces
+// side by side. A body on the seam of two pieces is handed both, so
+// callers have to tolerate seeing the same item twice.
+
+typedef enum {
+    TRIGGER_GLUCOSE,            // 'item' indexes the level's glucose items
+    TRIGGER_PORTAL,
+    TRIGGER_HAZARD              // Deadly platform or run of hazard tiles
+} TriggerKind;
+
+typedef struct {
+    float x, y;
+    float width, height;
+    TriggerKind kind;
+    int item;
+} Trigger;
+
+typedef struct {
+    Trigger* triggers;          // Sorted by x once sort_triggers ran
+    int count;
+    int capacity;
+    float max_width;            // Widest piece, how far left of the player the cursor stays
+    int cursor;                 // First trigger whose x is at least left - max_width
+
+    // Statistics of the last seek
+    int steps;                  // Triggers the cursor moved over
+    int candidates;             // Triggers handed to the caller
+} TriggerIndex;
+
+// Room for 'capacity' pieces from 'arena'; false if it is out of memory
+bool init_trigger_index(TriggerIndex* index, Arena* arena, int capacity);
+// Pieces add_trigger stores a trigger 'width' wide as
+int count_trigger_pieces(float width);
+// False, with the pieces that fitted added, once the index is full
+bool add_trigger(TriggerIndex* index, TriggerKind kind, int item,
+                 float x, float y, float width, float height);
+// Order the triggers after adding them and put the cursor at the start
+void sort_triggers(TriggerIndex* index);
+
+// Move the cursor to a body spanning [left, right] on x. The triggers that
+// may overlap it are [*first, *last); callers test them with
+// trigger_overlaps.
+void seek_triggers(TriggerIndex* index, float left, float right, int* first, int* last);
+
+static inline bool trigger_overlaps(const Trigger* trigger, float x, float y, float width, float height) {
+    return x < trigger->x + trigger->width && x + width > trigger->x &&
+           y < trigger->y + trigger->height && y + height > trigger->y;
+}
+
+#endif /* TRIGGERS_H */
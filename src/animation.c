@@ -0,0 +1,235 @@
+#include "../include/animation.h"
+#include "../include/texture_format.h" // For get_texture_format
+#include "../include/asset_pack.h" // For asset_exists
+#include "../include/preload.h"    // For queue_preload_bitmap, take_preloaded_bitmap
+#include <allegro5/allegro_image.h> // For al_load_bitmap
+#include <math.h>    // For ceilf, fabsf
+#include <stdio.h>   // For snprintf, printf, fprintf
+#include <string.h>  // For memset
+
+// Frames are numbered files; numbers missing from first..last are skipped
+typedef struct {
+    const char* pattern;        // printf pattern taking the frame number
+    int first, last;
+    int frame_ticks;
+    bool loop;
+    float scale;                // Drawn size relative to the image
+    bool masked;                // Frames get collision masks, for sprites much bigger than their box
+} ClipSource;
+
+static const ClipSource clip_sources[ANIM_CLIP_COUNT] = {
+    [ANIM_PLAYER_IDLE] = { "resources/sprites_action/idle_256x256/idle_%d.png",
+                           1, 4, 10, true, PLAYER_SPRITE_SCALE },
+    [ANIM_PLAYER_RUN] = { "resources/sprites_action/run_384x224/running_right_%d.png",
+                          1, 3, 6, true, PLAYER_SPRITE_SCALE },
+    [ANIM_PLAYER_JUMP] = { "resources/sprites_action/jump_256x336/jump_%d.png",
+                           1, 11, 4, false, PLAYER_SPRITE_SCALE },
+    [ANIM_PLAYER_ATTACK] = { "resources/sprites_action/attack_256x360/attack_%d.png",
+                             1, 4, 4, false, PLAYER_SPRITE_SCALE },
+    [ANIM_PLAYER_SPECIAL] = { "resources/sprites_action/special_attack_1360x416/special_attack_%d.png",
+                              1, 12, 3, false, PLAYER_SPRITE_SCALE },
+    [ANIM_BOSS_IDLE] = { "resources/big_boss/mouth_close_%d.png", 1, 2, 15, true, BOSS_SPRITE_SCALE, true },
+    [ANIM_BOSS_ATTACK] = { "resources/big_boss/mouth_open_attack_%d.png", 1, 6, 5, true, BOSS_SPRITE_SCALE, true },
+};
+
+// A new, fully transparent memory page. Pages are packed in memory and
+// only converted to the display's bitmaps once everything is in them.
+static bool add_page(AnimationSet* set) {
+    if (set->num_pages >= ANIM_ATLAS_MAX_PAGES) return false;
+    int old_flags = al_get_new_bitmap_flags();
+    int old_format = al_get_new_bitmap_format();
+    al_set_new_bitmap_format(get_texture_format(TEXTURE_SPRITE));
+    al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+    ALLEGRO_BITMAP* page = al_create_bitmap(ANIM_ATLAS_SIZE, ANIM_ATLAS_SIZE);
+    al_set_new_bitmap_flags(old_flags);
+    al_set_new_bitmap_format(old_format);
+    if (!page) return false;
+
+    ALLEGRO_BITMAP* old_target = al_get_target_bitmap();
+    al_set_target_bitmap(page);
+    al_clear_to_color(al_map_rgba(0, 0, 0, 0));
+    al_set_target_bitmap(old_target);
+
+    set->pages[set->num_pages++] = page;
+    set->shelf_x = 0;
+    set->shelf_y = 0;
+    set->shelf_height = 0;
+    return true;
+}
+
+// Scale 'image' into the atlas on shelves of rows; returns the frame's
+// sub-bitmap, or NULL when it does not fit
+static ALLEGRO_BITMAP* pack_frame(AnimationSet* set, ALLEGRO_BITMAP* image, float scale) {
+    int width = (int)ceilf(al_get_bitmap_width(image) * scale);
+    int height = (int)ceilf(al_get_bitmap_height(image) * scale);
+    if (width > ANIM_ATLAS_SIZE || height > ANIM_ATLAS_SIZE) return NULL;
+
+    if (set->num_pages > 0 && set->shelf_x + width > ANIM_ATLAS_SIZE) {
+        set->shelf_x = 0;
+        set->shelf_y += set->shelf_height + ANIM_ATLAS_PADDING;
+        set->shelf_height = 0;
+    }
+    if (set->num_pages == 0 || set->shelf_y + height > ANIM_ATLAS_SIZE) {
+        if (!add_page(set)) return NULL;
+    }
+
+    ALLEGRO_BITMAP* page = set->pages[set->num_pages - 1];
+    ALLEGRO_BITMAP* old_target = al_get_target_bitmap();
+    al_set_target_bitmap(page);
+    al_set_blender(ALLEGRO_ADD, ALLEGRO_ONE, ALLEGRO_ZERO);
+    al_draw_scaled_bitmap(image, 0, 0, al_get_bitmap_width(image), al_get_bitmap_height(image),
+                          set->shelf_x, set->shelf_y, width, height, 0);
+    al_set_blender(ALLEGRO_ADD, ALLEGRO_ONE, ALLEGRO_INVERSE_ALPHA);
+    al_set_target_bitmap(old_target);
+
+    ALLEGRO_BITMAP* frame = al_create_sub_bitmap(page, set->shelf_x, set->shelf_y, width, height);
+    set->shelf_x += width + ANIM_ATLAS_PADDING;
+    if (height > set->shelf_height) set->shelf_height = height;
+    return frame;
+}
+
+// Filtered, so the frames are scaled down smoothly
+#define FRAME_LOAD_FLAGS (ALLEGRO_MIN_LINEAR | ALLEGRO_MAG_LINEAR)
+
+void queue_animation_preloads(void) {
+    char path[256];
+    for (int c = 0; c < ANIM_CLIP_COUNT; c++) {
+        const ClipSource* source = &clip_sources[c];
+        for (int i = source->first; i <= source->last && i - source->first < ANIM_MAX_FRAMES; i++) {
+            snprintf(path, sizeof(path), source->pattern, i);
+            if (asset_exists(path)) queue_preload_bitmap(path, FRAME_LOAD_FLAGS, 0, 0);
+        }
+    }
+}
+
+static void load_clip(AnimationSet* set, AnimClip* clip, const ClipSource* source) {
+    char path[256];
+    clip->frame_ticks = source->frame_ticks;
+    clip->loop = source->loop;
+
+    int old_flags = al_get_new_bitmap_flags();
+    al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP | FRAME_LOAD_FLAGS);
+    for (int i = source->first; i <= source->last && clip->num_frames < ANIM_MAX_FRAMES; i++) {
+        snprintf(path, sizeof(path), source->pattern, i);
+        if (!asset_exists(path)) continue;
+        ALLEGRO_BITMAP* image = take_preloaded_bitmap(path);
+        if (!image) image = al_load_bitmap(path);
+        if (!image) {
+            fprintf(stderr, "Failed to load animation frame: %s\n", path);
+            continue;
+        }
+        ALLEGRO_BITMAP* frame = pack_frame(set, image, source->scale);
+        al_destroy_bitmap(image);
+        if (!frame) {
+            fprintf(stderr, "Animation atlas is full, dropped %s\n", path);
+            continue;
+        }
+        // Read back from the memory page before it goes to the display;
+        // a frame without a mask is hit by the entity's box
+        if (source->masked) build_collision_mask(&clip->masks[clip->num_frames], frame);
+        clip->frames[clip->num_frames++] = frame;
+    }
+    al_set_new_bitmap_flags(old_flags);
+}
+
+bool load_animations(AnimationSet* set) {
+    memset(set, 0, sizeof(*set));
+    int frames = 0, masks = 0;
+    for (int i = 0; i < ANIM_CLIP_COUNT; i++) {
+        load_clip(set, &set->clips[i], &clip_sources[i]);
+        frames += set->clips[i].num_frames;
+        for (int j = 0; j < set->clips[i].num_frames; j++) {
+            if (set->clips[i].masks[j].rows) masks++;
+        }
+    }
+
+    // Sub-bitmaps follow their page to the display
+    if (!(al_get_new_bitmap_flags() & ALLEGRO_MEMORY_BITMAP)) {
+        for (int i = 0; i < set->num_pages; i++) {
+            al_convert_bitmap(set->pages[i]);
+        }
+    }
+    printf("Animations: %d clips, %d frames in %d atlas pages, %d collision masks\n",
+           ANIM_CLIP_COUNT, frames, set->num_pages, masks);
+    return frames > 0;
+}
+
+void destroy_animations(AnimationSet* set) {
+    for (int i = 0; i < ANIM_CLIP_COUNT; i++) {
+        for (int j = 0; j < set->clips[i].num_frames; j++) {
+            al_destroy_bitmap(set->clips[i].frames[j]);
+            destroy_collision_mask(&set->clips[i].masks[j]);
+        }
+    }
+    for (int i = 0; i < set->num_pages; i++) {
+        al_destroy_bitmap(set->pages[i]);
+    }
+    memset(set, 0, sizeof(*set));
+}
+
+void play_clip(Entity* entity, AnimClipId clip) {
+    if (entity->clip == (int)clip) return;
+    entity->clip = clip;
+    entity->current_frame = 0;
+    entity->frame_timer = 0;
+}
+
+void update_animation(const AnimationSet* set, Entity* entity) {
+    const AnimClip* clip = entity->clip >= 0 && entity->clip < ANIM_CLIP_COUNT ?
+                           &set->clips[entity->clip] : NULL;
+    if (!clip || clip->num_frames == 0) {
+        entity->sprite = NULL;
+        entity->sprite_sheet = NULL;
+        entity->mask = NULL;
+        return;
+    }
+
+    entity->sprite = clip->frames[entity->current_frame];
+    entity->sprite_sheet = al_get_parent_bitmap(entity->sprite);
+    const CollisionMask* mask = &clip->masks[entity->current_frame];
+    entity->mask = mask->rows ? mask : NULL;
+    entity->frame_timer++;
+    if (entity->frame_timer >= clip->frame_ticks) {
+        entity->frame_timer = 0;
+        if (entity->current_frame + 1 < clip->num_frames) entity->current_frame++;
+        else if (clip->loop) entity->current_frame = 0;
+    }
+}
+
+bool is_clip_playing(const AnimationSet* set, const Entity* entity) {
+    if (entity->clip < 0 || entity->clip >= ANIM_CLIP_COUNT) return false;
+    const AnimClip* clip = &set->clips[entity->clip];
+    return !clip->loop && entity->current_frame + 1 < clip->num_frames;
+}
+
+void animate_player(const AnimationSet* set, Entity* player) {
+    if (player->dx > 0) player->facing_left = false;
+    else if (player->dx < 0) player->facing_left = true;
+
+    bool attacking = player->clip == ANIM_PLAYER_ATTACK || player->clip == ANIM_PLAYER_SPECIAL;
+    if (player->state == ATTACKING) {
+        // Every attack starts its clip over
+        player->clip = ANIM_NO_CLIP;
+        play_clip(player, player->combo_count >= MAX_COMBO_COUNT ? ANIM_PLAYER_SPECIAL : ANIM_PLAYER_ATTACK);
+    } else if (attacking && is_clip_playing(set, player)) {
+        // Let the attack finish
+    } else if (!player->is_on_ground) {
+        play_clip(player, ANIM_PLAYER_JUMP);
+    } else if (fabsf(player->dx) > ANIM_RUN_SPEED) {
+        play_clip(player, ANIM_PLAYER_RUN);
+    } else {
+        play_clip(player, ANIM_PLAYER_IDLE);
+    }
+    update_animation(set, player);
+}
+
+void animate_boss(const AnimationSet* set, Entity* boss) {
+    if (boss->dx > 0) boss->facing_left = false;
+    else if (boss->dx < 0) boss->facing_left = true;
+
+    // Mouth open while it fires: the pause of phase one and all of phase two
+    bool firing = boss->health < boss->max_health * ENEMY_BOSS_PHASE_HEALTH ||
+                  (boss->phase_timer > 0 && boss->phase_timer <= 45);
+    play_clip(boss, firing ? ANIM_BOSS_ATTACK : ANIM_BOSS_IDLE);
+    update_animation(set, boss);
+}
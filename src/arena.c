@@ -0,0 +1,113 @@
+#include "../include/arena.h"
+#include <stdio.h>   // For fprintf
+#include <stdlib.h>  // For malloc, free
+#include <string.h>  // For memset, memcpy, strlen
+
+static size_t align_up(size_t value) {
+    return (value + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+// Block header and data come from a single heap allocation
+static ArenaBlock* create_block(size_t size) {
+    size_t header = align_up(sizeof(ArenaBlock));
+    unsigned char* memory = malloc(header + size);
+    if (!memory) return NULL;
+
+    ArenaBlock* block = (ArenaBlock*)memory;
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    block->data = memory + header;
+    return block;
+}
+
+bool arena_init(Arena* arena, size_t block_size) {
+    arena->block_size = align_up(block_size > 0 ? block_size : ARENA_ALIGNMENT);
+    arena->peak = 0;
+    arena->first = create_block(arena->block_size);
+    arena->current = arena->first;
+    if (!arena->first) {
+        fprintf(stderr, "Failed to allocate arena block of %zu bytes\n", arena->block_size);
+        return false;
+    }
+    return true;
+}
+
+void* arena_alloc(Arena* arena, size_t size) {
+    if (!arena->current) return NULL;
+    size = align_up(size > 0 ? size : 1);
+
+    // Move on to the next block (reusing one left over from a rewind) until one fits
+    while (arena->current->used + size > arena->current->size) {
+        ArenaBlock* next = arena->current->next;
+        if (next && next->size < size) {
+            // Too small for this request: splice in a bigger block in front of it
+            next = NULL;
+        }
+        if (!next) {
+            next = create_block(size > arena->block_size ? align_up(size) : arena->block_size);
+            if (!next) {
+                fprintf(stderr, "Failed to grow arena by %zu bytes\n", size);
+                return NULL;
+            }
+            next->next = arena->current->next;
+            arena->current->next = next;
+        }
+        arena->current = next;
+        arena->current->used = 0;
+    }
+
+    void* ptr = arena->current->data + arena->current->used;
+    arena->current->used += size;
+
+    size_t used = arena_used(arena);
+    if (used > arena->peak) arena->peak = used;
+    return ptr;
+}
+
+void* arena_calloc(Arena* arena, size_t count, size_t size) {
+    void* ptr = arena_alloc(arena, count * size);
+    if (ptr) memset(ptr, 0, count * size);
+    return ptr;
+}
+
+char* arena_strdup(Arena* arena, const char* str) {
+    size_t len = strlen(str) + 1;
+    char* copy = arena_alloc(arena, len);
+    if (copy) memcpy(copy, str, len);
+    return copy;
+}
+
+ArenaMark arena_mark(const Arena* arena) {
+    ArenaMark mark = { arena->current, arena->current ? arena->current->used : 0 };
+    return mark;
+}
+
+void arena_rewind(Arena* arena, ArenaMark mark) {
+    if (!mark.block) return;
+    for (ArenaBlock* block = mark.block->next; block; block = block->next) {
+        block->used = 0;
+    }
+    mark.block->used = mark.used;
+    arena->current = mark.block;
+}
+
+void arena_release(Arena* arena) {
+    ArenaBlock* block = arena->first;
+    while (block) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->first = NULL;
+    arena->current = NULL;
+}
+
+size_t arena_used(const Arena* arena) {
+    size_t used = 0;
+    for (ArenaBlock* block = arena->first; block; block = block->next) {
+        used += block->used;
+        if (block == arena->current) break;
+    }
+    return used;
+}
@@ -0,0 +1,441 @@
+#include "../include/asset_pack.h"
+#include "../include/game.h" // For ASSET_PACK_* and GOLDEN_IMAGE_DIR
+#include <allegro5/allegro.h>
+#include <stdio.h>   // For printf, fprintf, snprintf, FILE
+#include <stdlib.h>  // For malloc, realloc, free, qsort, bsearch
+#include <string.h>  // For memcmp, memcpy, memset, strcmp, strncmp, strchr, strlen
+#ifndef _WIN32               // Windows has no mmap; the pack is read into memory there
+#include <fcntl.h>    // For open
+#include <sys/mman.h> // For mmap, munmap
+#include <sys/stat.h> // For fstat
+#include <unistd.h>   // For close
+#endif
+
+// The pack, mapped read-only, and the interface it replaced
+static const unsigned char* pack_data = NULL;
+static size_t pack_size = 0;
+static const AssetEntry* pack_index = NULL;
+static uint32_t pack_count = 0;
+static const ALLEGRO_FILE_INTERFACE* standard_interface = NULL;
+
+// An open file: a window on the mapping, or a file of the standard interface
+typedef struct {
+    const unsigned char* data;  // NULL when 'fallback' is used
+    int64_t size;
+    int64_t pos;
+    bool eof;
+    ALLEGRO_FILE* fallback;
+} PackFile;
+
+static int compare_entries(const void* a, const void* b) {
+    return strcmp(((const AssetEntry*)a)->path, ((const AssetEntry*)b)->path);
+}
+
+// Paths are packed without a leading "./" and with '/' separators
+static void normalize_path(char* dst, size_t size, const char* path) {
+    if (strncmp(path, "./", 2) == 0) path += 2;
+    snprintf(dst, size, "%s", path);
+    for (char* c = dst; *c; c++) {
+        if (*c == '\\') *c = '/';
+    }
+}
+
+static const AssetEntry* find_entry(const char* path) {
+    if (!pack_index) return NULL;
+    AssetEntry key;
+    normalize_path(key.path, sizeof(key.path), path);
+    return bsearch(&key, pack_index, pack_count, sizeof(AssetEntry), compare_entries);
+}
+
+static uint64_t align_offset(uint64_t offset) {
+    return (offset + ASSET_PACK_ALIGN - 1) / ASSET_PACK_ALIGN * ASSET_PACK_ALIGN;
+}
+
+// File interface over the mapping
+
+static void* pack_fopen(const char* path, const char* mode) {
+    PackFile* file = calloc(1, sizeof(PackFile));
+    if (!file) return NULL;
+    const AssetEntry* entry = strchr(mode, 'r') && !strchr(mode, '+') ? find_entry(path) : NULL;
+    if (entry) {
+        file->data = pack_data + entry->offset;
+        file->size = (int64_t)entry->size;
+        return file;
+    }
+    file->fallback = al_fopen_interface(standard_interface, path, mode);
+    if (!file->fallback) {
+        free(file);
+        return NULL;
+    }
+    return file;
+}
+
+static PackFile* get_pack_file(ALLEGRO_FILE* f) {
+    return al_get_file_userdata(f);
+}
+
+static bool pack_fclose(ALLEGRO_FILE* f) {
+    PackFile* file = get_pack_file(f);
+    bool ok = file->fallback ? al_fclose(file->fallback) : true;
+    free(file);
+    return ok;
+}
+
+static size_t pack_fread(ALLEGRO_FILE* f, void* ptr, size_t size) {
+    PackFile* file = get_pack_file(f);
+    if (file->fallback) return al_fread(file->fallback, ptr, size);
+    int64_t left = file->size - file->pos;
+    if ((int64_t)size > left) {
+        size = (size_t)left;
+        file->eof = true;
+    }
+    memcpy(ptr, file->data + file->pos, size);
+    file->pos += size;
+    return size;
+}
+
+static size_t pack_fwrite(ALLEGRO_FILE* f, const void* ptr, size_t size) {
+    PackFile* file = get_pack_file(f);
+    return file->fallback ? al_fwrite(file->fallback, ptr, size) : 0;
+}
+
+static bool pack_fflush(ALLEGRO_FILE* f) {
+    PackFile* file = get_pack_file(f);
+    return file->fallback ? al_fflush(file->fallback) : true;
+}
+
+static int64_t pack_ftell(ALLEGRO_FILE* f) {
+    PackFile* file = get_pack_file(f);
+    return file->fallback ? al_ftell(file->fallback) : file->pos;
+}
+
+static bool pack_fseek(ALLEGRO_FILE* f, int64_t offset, int whence) {
+    PackFile* file = get_pack_file(f);
+    if (file->fallback) return al_fseek(file->fallback, offset, whence);
+    if (whence == ALLEGRO_SEEK_CUR) offset += file->pos;
+    else if (whence == ALLEGRO_SEEK_END) offset += file->size;
+    if (offset < 0 || offset > file->size) return false;
+    file->pos = offset;
+    file->eof = false;
+    return true;
+}
+
+static bool pack_feof(ALLEGRO_FILE* f) {
+    PackFile* file = get_pack_file(f);
+    return file->fallback ? al_feof(file->fallback) : file->eof;
+}
+
+static int pack_ferror(ALLEGRO_FILE* f) {
+    PackFile* file = get_pack_file(f);
+    return file->fallback ? al_ferror(file->fallback) : 0;
+}
+
+static const char* pack_ferrmsg(ALLEGRO_FILE* f) {
+    PackFile* file = get_pack_file(f);
+    return file->fallback ? al_ferrmsg(file->fallback) : "";
+}
+
+static void pack_fclearerr(ALLEGRO_FILE* f) {
+    PackFile* file = get_pack_file(f);
+    if (file->fallback) al_fclearerr(file->fallback);
+    else file->eof = false;
+}
+
+static int pack_fungetc(ALLEGRO_FILE* f, int c) {
+    PackFile* file = get_pack_file(f);
+    if (file->fallback) return al_fungetc(file->fallback, c);
+    if (file->pos == 0) return -1;
+    file->pos--;
+    file->eof = false;
+    return c;
+}
+
+static off_t pack_fsize(ALLEGRO_FILE* f) {
+    PackFile* file = get_pack_file(f);
+    return file->fallback ? (off_t)al_fsize(file->fallback) : (off_t)file->size;
+}
+
+static const ALLEGRO_FILE_INTERFACE pack_interface = {
+    pack_fopen, pack_fclose, pack_fread, pack_fwrite, pack_fflush, pack_ftell, pack_fseek,
+    pack_feof, pack_ferror, pack_ferrmsg, pack_fclearerr, pack_fungetc, pack_fsize
+};
+
+// Mapping
+
+static bool map_pack(const char* path) {
+#ifdef _WIN32
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    unsigned char* data = size > 0 ? malloc(size) : NULL;
+    bool ok = data && fread(data, 1, size, file) == (size_t)size;
+    fclose(file);
+    if (!ok) {
+        free(data);
+        return false;
+    }
+    pack_data = data;
+    pack_size = (size_t)size;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+    void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping keeps the file open
+    if (data == MAP_FAILED) return false;
+    pack_data = data;
+    pack_size = (size_t)info.st_size;
+#endif
+    return true;
+}
+
+static void unmap_pack(void) {
+    if (!pack_data) return;
+#ifdef _WIN32
+    free((void*)pack_data);
+#else
+    munmap((void*)pack_data, pack_size);
+#endif
+    pack_data = NULL;
+    pack_size = 0;
+}
+
+// Every entry has to lie inside the file, so reads need no further checks
+static bool check_pack(void) {
+    const AssetPackHeader* header = (const AssetPackHeader*)pack_data;
+    if (pack_size < sizeof(AssetPackHeader) || memcmp(header->magic, ASSET_PACK_MAGIC, 4) != 0 ||
+        header->version != ASSET_PACK_VERSION ||
+        header->count > (pack_size - sizeof(AssetPackHeader)) / sizeof(AssetEntry)) {
+        return false;
+    }
+    const AssetEntry* index = (const AssetEntry*)(pack_data + sizeof(AssetPackHeader));
+    for (uint32_t i = 0; i < header->count; i++) {
+        if (index[i].path[ASSET_PATH_MAX - 1] != '\0' || index[i].offset > pack_size ||
+            index[i].size > pack_size - index[i].offset) {
+            return false;
+        }
+    }
+    pack_index = index;
+    pack_count = header->count;
+    return true;
+}
+
+// 'dir' holding ASSET_PACK_FILE, or NULL for the working directory
+static bool try_pack_in(ALLEGRO_PATH* dir, char* found, size_t size) {
+    if (dir) {
+        al_set_path_filename(dir, ASSET_PACK_FILE);
+        snprintf(found, size, "%s", al_path_cstr(dir, ALLEGRO_NATIVE_PATH_SEP));
+        al_destroy_path(dir);
+    } else {
+        snprintf(found, size, "%s", ASSET_PACK_FILE);
+    }
+    return map_pack(found);
+}
+
+bool open_asset_pack(void) {
+    if (pack_data) return true;
+    char path[512];
+    if (!try_pack_in(al_get_standard_path(ALLEGRO_EXENAME_PATH), path, sizeof(path)) &&
+        !try_pack_in(al_get_standard_path(ALLEGRO_RESOURCES_PATH), path, sizeof(path)) &&
+        !try_pack_in(NULL, path, sizeof(path))) {
+        return false;
+    }
+    if (!check_pack()) {
+        fprintf(stderr, "Ignoring invalid asset pack %s, rebuild it with --pack\n", path);
+        unmap_pack();
+        return false;
+    }
+
+    standard_interface = al_get_new_file_interface();
+    al_set_new_file_interface(&pack_interface);
+    printf("Asset pack %s: %u files, %.1f MB mapped\n", path, pack_count, pack_size / (1024.0 * 1024.0));
+    return true;
+}
+
+void close_asset_pack(void) {
+    if (!pack_data) return;
+    al_set_new_file_interface(standard_interface);
+    unmap_pack();
+    pack_index = NULL;
+    pack_count = 0;
+}
+
+void use_asset_pack(void) {
+    if (pack_data) al_set_new_file_interface(&pack_interface);
+}
+
+bool asset_exists(const char* path) {
+    return find_entry(path) != NULL || al_filename_exists(path);
+}
+
+// Building
+
+typedef struct {
+    AssetEntry* entries;
+    int count;
+    int capacity;
+} AssetList;
+
+static AssetEntry* add_asset(AssetList* list) {
+    if (list->count >= list->capacity) {
+        int capacity = list->capacity > 0 ? list->capacity * 2 : 256;
+        AssetEntry* grown = realloc(list->entries, capacity * sizeof(AssetEntry));
+        if (!grown) {
+            fprintf(stderr, "Failed to grow asset list to %d files\n", capacity);
+            return NULL;
+        }
+        list->entries = grown;
+        list->capacity = capacity;
+    }
+    AssetEntry* asset = &list->entries[list->count++];
+    memset(asset, 0, sizeof(*asset));
+    return asset;
+}
+
+// Entries are named as the game opens them: 'prefix', the directory's
+// path under the working directory, then each entry's own name.
+// al_get_fs_entry_name returns absolute paths, so only its last
+// component is used.
+static void add_directory(AssetList* list, ALLEGRO_FS_ENTRY* dir, const char* prefix) {
+    if (!al_open_directory(dir)) return;
+    ALLEGRO_FS_ENTRY* entry;
+    while ((entry = al_read_directory(dir))) {
+        char name[512];
+        char path[512];
+        normalize_path(name, sizeof(name), al_get_fs_entry_name(entry));
+        const char* base = strrchr(name, '/');
+        snprintf(path, sizeof(path), "%s/%s", prefix, base ? base + 1 : name);
+        if (al_get_fs_entry_mode(entry) & ALLEGRO_FILEMODE_ISDIR) {
+            // Golden images are bench output, not game assets
+            if (strcmp(path, GOLDEN_IMAGE_DIR) != 0) add_directory(list, entry, path);
+        } else if (strlen(path) >= ASSET_PATH_MAX) {
+            fprintf(stderr, "Not packing %s: path longer than %d characters\n", path, ASSET_PATH_MAX - 1);
+        } else {
+            AssetEntry* asset = add_asset(list);
+            if (asset) {
+                memcpy(asset->path, path, strlen(path));
+                asset->size = (uint64_t)al_get_fs_entry_size(entry);
+            }
+        }
+        al_destroy_fs_entry(entry);
+    }
+    al_close_directory(dir);
+}
+
+// Append 'size' bytes of the file at 'path' to 'out'
+static bool copy_file(FILE* out, const char* path, uint64_t size) {
+    FILE* in = fopen(path, "rb");
+    if (!in) return false;
+    char buffer[65536];
+    uint64_t left = size;
+    while (left > 0) {
+        size_t chunk = left < sizeof(buffer) ? (size_t)left : sizeof(buffer);
+        if (fread(buffer, 1, chunk, in) != chunk || fwrite(buffer, 1, chunk, out) != chunk) break;
+        left -= chunk;
+    }
+    fclose(in);
+    return left == 0;
+}
+
+// Map the pack just written and look up every packed file by the path
+// the game opens it with
+static bool check_written_pack(const AssetList* list) {
+    if (!map_pack(ASSET_PACK_FILE) || !check_pack()) {
+        fprintf(stderr, "Failed to read back %s\n", ASSET_PACK_FILE);
+        unmap_pack();
+        return false;
+    }
+    int missing = 0;
+    for (int i = 0; i < list->count; i++) {
+        const AssetEntry* entry = find_entry(list->entries[i].path);
+        if (!entry || entry->size != list->entries[i].size) {
+            fprintf(stderr, "Packed file %s cannot be found in %s\n", list->entries[i].path, ASSET_PACK_FILE);
+            missing++;
+        }
+    }
+    unmap_pack();
+    pack_index = NULL;
+    pack_count = 0;
+    return missing == 0;
+}
+
+static bool write_pack(const char* path, AssetList* list) {
+    qsort(list->entries, list->count, sizeof(AssetEntry), compare_entries);
+    uint64_t offset = align_offset(sizeof(AssetPackHeader) + (uint64_t)list->count * sizeof(AssetEntry));
+    for (int i = 0; i < list->count; i++) {
+        list->entries[i].offset = offset;
+        offset = align_offset(offset + list->entries[i].size);
+    }
+
+    FILE* out = fopen(path, "wb");
+    if (!out) {
+        fprintf(stderr, "Failed to create %s\n", path);
+        return false;
+    }
+    AssetPackHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ASSET_PACK_MAGIC, 4);
+    header.version = ASSET_PACK_VERSION;
+    header.count = (uint32_t)list->count;
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1 &&
+              fwrite(list->entries, sizeof(AssetEntry), list->count, out) == (size_t)list->count;
+    for (int i = 0; ok && i < list->count; i++) {
+        // Pad up to the aligned start of the file
+        static const char zeros[ASSET_PACK_ALIGN];
+        long padding = (long)(list->entries[i].offset - (uint64_t)ftell(out));
+        ok = fwrite(zeros, 1, padding, out) == (size_t)padding &&
+             copy_file(out, list->entries[i].path, list->entries[i].size);
+        if (!ok) fprintf(stderr, "Failed to pack %s\n", list->entries[i].path);
+    }
+    if (fclose(out) != 0) ok = false;
+    return ok;
+}
+
+bool is_asset_pack_command(int argc, char** argv) {
+    return argc > 1 && strcmp(argv[1], "--pack") == 0;
+}
+
+int run_asset_pack_command(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    if (!al_init()) {
+        fprintf(stderr, "Failed to initialize Allegro!\n");
+        return 1;
+    }
+
+    AssetList list = { NULL, 0, 0 };
+    ALLEGRO_FS_ENTRY* root = al_create_fs_entry(ASSET_SOURCE_DIR);
+    if (root) {
+        add_directory(&list, root, ASSET_SOURCE_DIR);
+        al_destroy_fs_entry(root);
+    }
+    if (list.count == 0) {
+        fprintf(stderr, "No files found in %s/\n", ASSET_SOURCE_DIR);
+        free(list.entries);
+        return 1;
+    }
+
+    // Written under a temporary name, so a failed build never replaces a good pack
+    char temp_path[256];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", ASSET_PACK_FILE);
+    bool ok = write_pack(temp_path, &list);
+    if (ok) {
+        remove(ASSET_PACK_FILE);
+        ok = rename(temp_path, ASSET_PACK_FILE) == 0 && check_written_pack(&list);
+    } else {
+        remove(temp_path);
+    }
+    if (ok) {
+        uint64_t total = 0;
+        for (int i = 0; i < list.count; i++) total += list.entries[i].size;
+        printf("Packed %d files, %.1f MB, into %s\n", list.count, total / (1024.0 * 1024.0), ASSET_PACK_FILE);
+    }
+    free(list.entries);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,433 @@
+#include "../include/background.h"
+#include "../include/game.h" // For BACKGROUND_TILE_* constants
+#include "../include/texture_format.h" // For load_texture, convert_texture, resize_texture
+#include "../include/preload.h"   // For take_preloaded_bitmap, queue_preload_bitmap
+#include <allegro5/allegro_image.h> // For al_load_bitmap, al_save_bitmap
+#include <stdio.h>   // For snprintf, fprintf, FILE
+#include <stdlib.h>  // For qsort
+#include <string.h>  // For memcpy, memset, strncpy
+
+// Directory tiles are baked into, with a trailing separator.
+// Empty if the cache directory could not be created.
+static char tile_cache_dir[512];
+static bool tile_cache_checked = false;
+
+static const char* get_tile_cache_dir(void) {
+    if (tile_cache_checked) return tile_cache_dir;
+    tile_cache_checked = true;
+
+    ALLEGRO_PATH* dir = al_get_standard_path(ALLEGRO_TEMP_PATH);
+    if (!dir) {
+        fprintf(stderr, "No temp directory for background tiles, keeping them in memory\n");
+        return tile_cache_dir;
+    }
+    al_append_path_component(dir, BACKGROUND_TILE_CACHE_DIR);
+    const char* dir_str = al_path_cstr(dir, ALLEGRO_NATIVE_PATH_SEP);
+    if (al_make_directory(dir_str)) {
+        strncpy(tile_cache_dir, dir_str, sizeof(tile_cache_dir) - 1);
+    } else {
+        fprintf(stderr, "Failed to create background tile cache: %s\n", dir_str);
+    }
+    al_destroy_path(dir);
+    return tile_cache_dir;
+}
+
+static time_t get_file_mtime(const char* path) {
+    ALLEGRO_FS_ENTRY* entry = al_create_fs_entry(path);
+    if (!entry) return 0;
+    time_t mtime = al_fs_entry_exists(entry) ? al_get_fs_entry_mtime(entry) : 0;
+    al_destroy_fs_entry(entry);
+    return mtime;
+}
+
+// The manifest holds the size of the baked image. It is written last, so
+// an interrupted bake is redone on the next start.
+static bool read_tile_manifest(const char* manifest, const char* image, int* width, int* height) {
+    time_t manifest_time = get_file_mtime(manifest);
+    if (manifest_time == 0 || manifest_time < get_file_mtime(image)) return false;
+
+    FILE* file = fopen(manifest, "r");
+    if (!file) return false;
+    bool ok = fscanf(file, "%d %d", width, height) == 2 && *width > 0 && *height > 0;
+    fclose(file);
+    return ok;
+}
+
+static void write_tile_manifest(const char* manifest, int width, int height) {
+    FILE* file = fopen(manifest, "w");
+    if (!file) {
+        fprintf(stderr, "Failed to write background tile manifest: %s\n", manifest);
+        return;
+    }
+    fprintf(file, "%d %d\n", width, height);
+    fclose(file);
+}
+
+static int compare_tiles(const void* a, const void* b) {
+    const BackgroundTile* ta = a;
+    const BackgroundTile* tb = b;
+    if (ta->x != tb->x) return ta->x < tb->x ? -1 : 1;
+    if (ta->y != tb->y) return ta->y < tb->y ? -1 : 1;
+    return 0;
+}
+
+static bool reserve_tiles(BackgroundTileSet* set, int count) {
+    if (set->num_tiles + count <= set->capacity) return true;
+
+    int capacity = set->capacity > 0 ? set->capacity * 2 : 32;
+    while (capacity < set->num_tiles + count) capacity *= 2;
+
+    // The old array stays in the arena until the level is released
+    BackgroundTile* tiles = arena_alloc(set->arena, sizeof(BackgroundTile) * capacity);
+    if (!tiles) return false;
+    if (set->num_tiles > 0) memcpy(tiles, set->tiles, sizeof(BackgroundTile) * set->num_tiles);
+    set->tiles = tiles;
+    set->capacity = capacity;
+    return true;
+}
+
+void init_background_tiles(BackgroundTileSet* set, Arena* arena, int budget) {
+    memset(set, 0, sizeof(*set));
+    set->arena = arena;
+    set->budget = budget;
+    set->pending = arena_alloc(arena, sizeof(int) * BACKGROUND_TILE_DECODES);
+    if (!set->pending) fprintf(stderr, "Failed to allocate the background tile queue\n");
+}
+
+// Whether the tiles of 'path' at the size asked for are in the cache
+static bool is_baked(const char* manifest, const char* path, int fit_width, int fit_height,
+                     int* width, int* height) {
+    return get_tile_cache_dir()[0] != '\0' && read_tile_manifest(manifest, path, width, height) &&
+           (fit_width <= 0 || (*width == fit_width && *height == fit_height));
+}
+
+void queue_background_preload(const char* path, int fit_width, int fit_height) {
+    char manifest[600];
+    ALLEGRO_PATH* image_path = al_create_path(path);
+    snprintf(manifest, sizeof(manifest), "%s%s.tiles", get_tile_cache_dir(),
+             image_path ? al_get_path_basename(image_path) : "background");
+    if (image_path) al_destroy_path(image_path);
+
+    int width, height;
+    if (!is_baked(manifest, path, fit_width, fit_height, &width, &height)) {
+        queue_preload_bitmap(path, 0, fit_width, fit_height);
+    }
+}
+
+bool add_background_tiles(BackgroundTileSet* set, const char* path, float x, float y,
+                          int fit_width, int fit_height) {
+    const char* cache_dir = get_tile_cache_dir();
+    char manifest[600];
+    char tile_path[600];
+
+    ALLEGRO_PATH* image_path = al_create_path(path);
+    const char* base = image_path ? al_get_path_basename(image_path) : "background";
+    snprintf(manifest, sizeof(manifest), "%s%s.tiles", cache_dir, base);
+
+    int width = 0, height = 0;
+    bool cached = is_baked(manifest, path, fit_width, fit_height, &width, &height);
+
+    // Only decode the full image when the tiles have to be (re)baked.
+    // A memory bitmap avoids uploading it to the GPU just to cut it up.
+    // A preloaded image was already decoded and fitted on a worker thread.
+    ALLEGRO_BITMAP* image = cached ? NULL : take_preloaded_bitmap(path);
+    if (!cached && !image) {
+        int old_flags = al_get_new_bitmap_flags();
+        al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+        image = al_load_bitmap(path);
+        al_set_new_bitmap_flags(old_flags);
+        if (!image) {
+            fprintf(stderr, "Failed to load scene background: %s\n", path);
+            if (image_path) al_destroy_path(image_path);
+            return false;
+        }
+        if (fit_width > 0 && (al_get_bitmap_width(image) != fit_width ||
+                              al_get_bitmap_height(image) != fit_height)) {
+            image = resize_texture(image, fit_width, fit_height);
+            if (!image) {
+                fprintf(stderr, "Failed to resize scene background: %s\n", path);
+                if (image_path) al_destroy_path(image_path);
+                return false;
+            }
+        }
+    }
+    if (image) {
+        width = al_get_bitmap_width(image);
+        height = al_get_bitmap_height(image);
+    }
+
+    int columns = (width + BACKGROUND_TILE_SIZE - 1) / BACKGROUND_TILE_SIZE;
+    int rows = (height + BACKGROUND_TILE_SIZE - 1) / BACKGROUND_TILE_SIZE;
+    if (!reserve_tiles(set, columns * rows)) {
+        fprintf(stderr, "Failed to allocate background tiles for %s\n", path);
+        if (image) al_destroy_bitmap(image);
+        if (image_path) al_destroy_path(image_path);
+        return false;
+    }
+
+    bool all_saved = true;
+    for (int col = 0; col < columns; col++) {
+        for (int row = 0; row < rows; row++) {
+            BackgroundTile* tile = &set->tiles[set->num_tiles++];
+            memset(tile, 0, sizeof(*tile));
+            tile->x = x + col * BACKGROUND_TILE_SIZE;
+            tile->y = y + row * BACKGROUND_TILE_SIZE;
+            tile->width = width - col * BACKGROUND_TILE_SIZE;
+            if (tile->width > BACKGROUND_TILE_SIZE) tile->width = BACKGROUND_TILE_SIZE;
+            tile->height = height - row * BACKGROUND_TILE_SIZE;
+            if (tile->height > BACKGROUND_TILE_SIZE) tile->height = BACKGROUND_TILE_SIZE;
+
+            snprintf(tile_path, sizeof(tile_path), "%s%s_%d_%d.bmp", cache_dir, base, col, row);
+            if (cached) {
+                tile->path = arena_strdup(set->arena, tile_path);
+                continue;
+            }
+
+            ALLEGRO_BITMAP* region = al_create_sub_bitmap(image, col * BACKGROUND_TILE_SIZE,
+                                                          row * BACKGROUND_TILE_SIZE,
+                                                          tile->width, tile->height);
+            if (!region) {
+                all_saved = false;
+                continue;
+            }
+            if (cache_dir[0] != '\0' && al_save_bitmap(tile_path, region)) {
+                tile->path = arena_strdup(set->arena, tile_path);
+            } else {
+                // No cache on disk: keep a CPU-side copy to upload on demand
+                int old_flags = al_get_new_bitmap_flags();
+                al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+                tile->source = al_clone_bitmap(region);
+                al_set_new_bitmap_flags(old_flags);
+                all_saved = false;
+            }
+            al_destroy_bitmap(region);
+        }
+    }
+
+    if (image) {
+        if (all_saved) write_tile_manifest(manifest, width, height);
+        al_destroy_bitmap(image);
+    }
+    if (image_path) al_destroy_path(image_path);
+
+    qsort(set->tiles, set->num_tiles, sizeof(BackgroundTile), compare_tiles);
+    return true;
+}
+
+// Index of the first tile that may overlap x >= left
+static int find_first_tile(const BackgroundTileSet* set, float left) {
+    int lo = 0, hi = set->num_tiles;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (set->tiles[mid].x + BACKGROUND_TILE_SIZE <= left) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// Only checked once per tile; the pixels of a baked tile never change
+static bool is_bitmap_opaque(ALLEGRO_BITMAP* bitmap) {
+    ALLEGRO_LOCKED_REGION* region = al_lock_bitmap(bitmap, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE,
+                                                   ALLEGRO_LOCK_READONLY);
+    if (!region) return false;
+    bool opaque = true;
+    int width = al_get_bitmap_width(bitmap);
+    int height = al_get_bitmap_height(bitmap);
+    for (int y = 0; y < height && opaque; y++) {
+        const unsigned char* pixels = (const unsigned char*)region->data + y * region->pitch;
+        for (int x = 0; x < width; x++) {
+            if (pixels[x * 4 + 3] != 255) {
+                opaque = false;
+                break;
+            }
+        }
+    }
+    al_unlock_bitmap(bitmap);
+    return opaque;
+}
+
+// Decode a tile into a memory bitmap. Runs on a recording thread, which
+// has its own new bitmap flags. The first decode of a tile checks whether
+// it is opaque.
+static void decode_tile(BackgroundTile* tile) {
+    int old_flags = al_get_new_bitmap_flags();
+    al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+    if (tile->path) {
+        tile->decoded = al_load_bitmap(tile->path);
+        if (!tile->decoded) {
+            fprintf(stderr, "Failed to load background tile: %s\n", tile->path);
+            tile->path = NULL; // Don't retry every frame
+        }
+    } else if (tile->source) {
+        tile->decoded = al_clone_bitmap(tile->source);
+    }
+    al_set_new_bitmap_flags(old_flags);
+    if (tile->decoded && !tile->opaque_checked) {
+        tile->opaque = is_bitmap_opaque(tile->decoded);
+        tile->opaque_checked = true;
+    }
+}
+
+// Opaque tiles go up in the opaque texture format
+static void upload_tile(BackgroundTileSet* set, BackgroundTile* tile) {
+    tile->bitmap = upload_texture(tile->decoded, tile->opaque ? TEXTURE_OPAQUE : TEXTURE_SPRITE);
+    tile->decoded = NULL;
+    set->resident++;
+    set->loads++;
+    if (set->resident > set->resident_peak) set->resident_peak = set->resident;
+    set->resident_bytes += get_texture_bytes(tile->bitmap);
+    set->saved_bytes += (size_t)tile->width * tile->height * 4 - get_texture_bytes(tile->bitmap);
+    if (set->resident_bytes > set->resident_bytes_peak) {
+        set->resident_bytes_peak = set->resident_bytes;
+        set->saved_bytes_peak = set->saved_bytes;
+    }
+}
+
+static void unload_tile(BackgroundTileSet* set, BackgroundTile* tile) {
+    set->resident_bytes -= get_texture_bytes(tile->bitmap);
+    set->saved_bytes -= (size_t)tile->width * tile->height * 4 - get_texture_bytes(tile->bitmap);
+    al_destroy_bitmap(tile->bitmap);
+    tile->bitmap = NULL;
+    set->resident--;
+}
+
+// Upload what the last frame's decode task left and empty the queue
+static void upload_pending_tiles(BackgroundTileSet* set) {
+    for (int i = 0; i < set->num_pending; i++) {
+        BackgroundTile* tile = &set->tiles[set->pending[i]];
+        if (tile->decoded) upload_tile(set, tile);
+        tile->queued = false;
+    }
+    set->num_pending = 0;
+}
+
+void stream_background_tiles(BackgroundTileSet* set, float left, float right, float prefetch) {
+    set->frame++;
+    upload_pending_tiles(set);
+
+    // Tiles on screen are queued before those in the margins
+    float window_left = left - prefetch;
+    float window_right = right + prefetch;
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = find_first_tile(set, window_left); i < set->num_tiles; i++) {
+            BackgroundTile* tile = &set->tiles[i];
+            if (tile->x >= window_right) break;
+            if (tile->x + tile->width <= window_left) continue;
+            tile->last_used = set->frame;
+
+            bool on_screen = tile->x < right && tile->x + tile->width > left;
+            if (tile->bitmap || on_screen != (pass == 0) || (!tile->path && !tile->source)) continue;
+            if (on_screen) set->misses++;
+            if (!tile->queued && set->pending && set->num_pending < BACKGROUND_TILE_DECODES) {
+                tile->queued = true;
+                set->pending[set->num_pending++] = i;
+            }
+        }
+    }
+
+    // Evict the least recently used tiles outside the window
+    while (set->resident > set->budget) {
+        BackgroundTile* oldest = NULL;
+        for (int i = 0; i < set->num_tiles; i++) {
+            BackgroundTile* tile = &set->tiles[i];
+            if (tile->bitmap && tile->last_used != set->frame &&
+                (!oldest || tile->last_used < oldest->last_used)) {
+                oldest = tile;
+            }
+        }
+        if (!oldest) break; // Everything resident is in the window
+        unload_tile(set, oldest);
+        set->evictions++;
+    }
+}
+
+void decode_background_tiles(BackgroundTileSet* set) {
+    for (int i = 0; i < set->num_pending; i++) {
+        decode_tile(&set->tiles[set->pending[i]]);
+    }
+}
+
+void load_background_tiles(BackgroundTileSet* set, float left, float right) {
+    upload_pending_tiles(set);
+    for (int i = find_first_tile(set, left); i < set->num_tiles; i++) {
+        BackgroundTile* tile = &set->tiles[i];
+        if (tile->x >= right) break;
+        if (tile->bitmap || tile->x + tile->width <= left) continue;
+        decode_tile(tile);
+        if (tile->decoded) upload_tile(set, tile);
+    }
+}
+
+void record_background_tiles(const BackgroundTileSet* set, DrawList* list, DrawLayer layer, int depth,
+                             float left, float right) {
+    for (int i = find_first_tile(set, left); i < set->num_tiles; i++) {
+        const BackgroundTile* tile = &set->tiles[i];
+        if (tile->x >= right) break;
+        if (!tile->bitmap || tile->x + tile->width <= left) continue;
+        record_bitmap(list, layer, depth, tile->bitmap, tile->x, tile->y, 0, 0);
+    }
+
+    // Tiles are sorted by x, then y, so each column's tiles come together.
+    // Columns have to follow each other without gaps and be stacked without
+    // gaps; the opaque rows are those every column covers.
+    float covered_x = left;
+    float top = 0.0f, bottom = 0.0f;
+    bool first_column = true;
+    int i = find_first_tile(set, left);
+    while (i < set->num_tiles && set->tiles[i].x < right) {
+        const BackgroundTile* column = &set->tiles[i];
+        if (column->x + column->width <= left) {
+            i++;
+            continue;
+        }
+        if (column->x > covered_x) return;
+
+        float column_top = column->y;
+        float column_bottom = column->y;
+        for (; i < set->num_tiles && set->tiles[i].x == column->x; i++) {
+            const BackgroundTile* tile = &set->tiles[i];
+            if (!tile->bitmap || !tile->opaque || tile->y != column_bottom) return;
+            column_bottom += tile->height;
+        }
+        if (first_column || column_top > top) top = column_top;
+        if (first_column || column_bottom < bottom) bottom = column_bottom;
+        first_column = false;
+        covered_x = column->x + column->width;
+    }
+    if (!first_column && covered_x >= right) {
+        mark_opaque_area(list, layer, left, top, right, bottom);
+    }
+}
+
+void evict_background_tiles(BackgroundTileSet* set) {
+    for (int i = 0; i < set->num_pending; i++) {
+        BackgroundTile* tile = &set->tiles[set->pending[i]];
+        if (tile->decoded) al_destroy_bitmap(tile->decoded);
+        tile->decoded = NULL;
+        tile->queued = false;
+    }
+    set->num_pending = 0;
+    for (int i = 0; i < set->num_tiles; i++) {
+        if (set->tiles[i].bitmap) unload_tile(set, &set->tiles[i]);
+    }
+}
+
+void destroy_background_tiles(BackgroundTileSet* set) {
+    evict_background_tiles(set);
+    for (int i = 0; i < set->num_tiles; i++) {
+        if (set->tiles[i].source) al_destroy_bitmap(set->tiles[i].source);
+    }
+    // The tile array and paths belong to the arena
+    set->tiles = NULL;
+    set->num_tiles = 0;
+    set->capacity = 0;
+}
+
+void report_background_tiles(const BackgroundTileSet* set, const char* name) {
+    printf("Background tiles %s: %d tiles, %d resident (peak %d, budget %d), %d loads, %d evicted, "
+           "%d on screen before they were resident\n",
+           name, set->num_tiles, set->resident, set->resident_peak, set->budget,
+           set->loads, set->evictions, set->misses);
+    printf("Background memory %s: peak %zu KB, %zu KB saved by texture formats\n",
+           name, set->resident_bytes_peak / 1024, set->saved_bytes_peak / 1024);
+}
@@ -0,0 +1,63 @@
+#include "../include/bullet_pattern.h"
+#include <math.h>    // For atan2f
+
+#define TAU 6.28318531f
+
+// The old triple shot, then three rings while the boss holds still. The
+// rings turn half a gap each volley so the player can weave between them.
+static const BulletEmitter boss_pause_emitters[] = {
+    { EMIT_FAN,  true,  0,  1, 1,  3, 0.0f, 0.6f, 0.0f,         PROJECTILE_SPEED, true  },
+    { EMIT_RING, false, 8,  12, 3, 16, 0.0f, 0.0f, TAU / 32.0f, 3.0f,             false },
+};
+
+// A three-armed spiral that never stops, the old two-shot burst every half
+// second and a wide ring every two seconds
+static const BulletEmitter boss_desperate_emitters[] = {
+    { EMIT_RING, false, 0,  4,  0, 3,  0.0f, 0.0f,  0.35f,      3.5f,             false },
+    { EMIT_FAN,  true,  0,  30, 0, 2,  0.0f, 0.15f, 0.0f,       PROJECTILE_SPEED, true  },
+    { EMIT_RING, false, 60, 1,  1, 24, 0.0f, 0.0f,  0.0f,       2.5f,             false },
+};
+
+#define EMITTERS(table) table, (int)(sizeof(table) / sizeof(table[0]))
+
+static const BulletPattern patterns[PATTERN_COUNT] = {
+    [PATTERN_BOSS_PAUSE] = { "boss pause", EMITTERS(boss_pause_emitters), 45 },
+    [PATTERN_BOSS_DESPERATE] = { "boss desperate", EMITTERS(boss_desperate_emitters), 120 },
+};
+
+const BulletPattern* get_bullet_pattern(BulletPatternId id) {
+    if (id < 0 || id >= PATTERN_COUNT) return NULL;
+    return &patterns[id];
+}
+
+int fire_bullet_pattern(Level* level, BulletPatternId id, int tick, float x, float y,
+                        float target_x, float target_y, EntityType source) {
+    const BulletPattern* pattern = get_bullet_pattern(id);
+    if (!level || !pattern || tick < 0) return 0;
+    tick %= pattern->length;
+
+    int loud = 0;
+    for (int i = 0; i < pattern->num_emitters; i++) {
+        const BulletEmitter* emitter = &pattern->emitters[i];
+        if (tick < emitter->start || emitter->interval <= 0 || emitter->count <= 0) continue;
+        int since = tick - emitter->start;
+        if (since % emitter->interval != 0) continue;
+        int volley = since / emitter->interval;
+        if (emitter->volleys > 0 && volley >= emitter->volleys) continue;
+
+        float angle = emitter->angle + emitter->turn * volley;
+        if (emitter->aimed) angle += atan2f(target_y - y, target_x - x);
+        float step;
+        if (emitter->shape == EMIT_RING) {
+            step = TAU / emitter->count;
+        } else if (emitter->count > 1) {
+            step = emitter->spread / (emitter->count - 1);
+            angle -= emitter->spread / 2;
+        } else {
+            step = 0.0f;
+        }
+        create_projectile_volley(level, x, y, angle, step, emitter->count, emitter->speed, source);
+        if (emitter->loud) loud++;
+    }
+    return loud;
+}
@@ -0,0 +1,101 @@
+#include "../include/camera.h"
+#include "../include/game.h" // For SCREEN_WIDTH, SCROLL_X_PLAYER_OFFSET_FACTOR
+#include <stdlib.h>          // For rand
+
+void init_camera(Camera* camera, float width, float height) {
+    camera->width = width;
+    camera->height = height;
+    camera->scale = 1.0f;
+    reset_camera(camera);
+}
+
+void reset_camera(Camera* camera) {
+    camera->x = 0;
+    camera->shake.intensity = 0;
+    camera->shake.duration = 0;
+    camera->shake.offset_x = 0;
+    camera->shake.offset_y = 0;
+}
+
+void follow_camera(Camera* camera, float focus_x, float level_width) {
+    // Don't scroll if the level fits on screen
+    if (level_width <= camera->width) {
+        camera->x = 0;
+        return;
+    }
+    camera->x = focus_x - camera->width * SCROLL_X_PLAYER_OFFSET_FACTOR;
+    if (camera->x < 0) {
+        camera->x = 0;
+    }
+    if (camera->x > level_width - camera->width) {
+        camera->x = level_width - camera->width;
+    }
+}
+
+void shake_camera(Camera* camera, float intensity, int duration) {
+    // Only apply if new shake is stronger or current shake is ending
+    if (intensity > camera->shake.intensity || camera->shake.duration < 10) {
+        camera->shake.intensity = intensity;
+        camera->shake.duration = duration;
+    }
+}
+
+void update_camera_shake(Camera* camera) {
+    ScreenShake* shake = &camera->shake;
+    if (shake->duration <= 0) return;
+
+    // Calculate random offset based on intensity
+    float max_offset = shake->intensity;
+    shake->offset_x = ((rand() % 200) - 100) / 100.0f * max_offset;
+    shake->offset_y = ((rand() % 200) - 100) / 100.0f * max_offset;
+
+    // Gradually reduce intensity and duration
+    shake->duration--;
+    shake->intensity *= 0.95f; // Gradual fade
+
+    if (shake->duration <= 0) {
+        shake->intensity = 0;
+        shake->offset_x = 0;
+        shake->offset_y = 0;
+    }
+}
+
+void use_camera_transform(const Camera* camera) {
+    ALLEGRO_TRANSFORM transform;
+    al_identity_transform(&transform);
+    al_translate_transform(&transform, -camera->x + camera->shake.offset_x, camera->shake.offset_y);
+    al_scale_transform(&transform, camera->scale, camera->scale);
+    al_use_transform(&transform);
+}
+
+void use_screen_transform(const Camera* camera) {
+    ALLEGRO_TRANSFORM transform;
+    al_identity_transform(&transform);
+    if (camera) al_scale_transform(&transform, camera->scale, camera->scale);
+    al_use_transform(&transform);
+}
+
+static float item_x(const void* items, int index, size_t stride, size_t x_offset) {
+    return *(const float*)((const char*)items + index * stride + x_offset);
+}
+
+void find_visible_range(const void* items, int count, size_t stride, size_t x_offset,
+                        float max_width, float left, float right, int* first, int* last) {
+    // First item that can still reach 'left'
+    int lo = 0, hi = count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (item_x(items, mid, stride, x_offset) + max_width < left) lo = mid + 1;
+        else hi = mid;
+    }
+    *first = lo;
+
+    // First item starting right of the view
+    hi = count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (item_x(items, mid, stride, x_offset) <= right) lo = mid + 1;
+        else hi = mid;
+    }
+    *last = lo;
+}
@@ -0,0 +1,112 @@
+#include "../include/collision_mask.h"
+#include "../include/game.h" // For COLLISION_MASK_ALPHA
+#include <math.h>    // For floorf, ceilf
+#include <stdio.h>   // For fprintf
+#include <stdlib.h>  // For calloc, free
+#include <string.h>  // For memset
+
+bool build_collision_mask(CollisionMask* mask, ALLEGRO_BITMAP* bitmap) {
+    memset(mask, 0, sizeof(*mask));
+    int width = al_get_bitmap_width(bitmap);
+    int height = al_get_bitmap_height(bitmap);
+    int words_per_row = (width + 63) / 64;
+    size_t words = (size_t)words_per_row * height;
+    uint64_t* rows = calloc(words * 2, sizeof(uint64_t));
+    if (!rows) {
+        fprintf(stderr, "Failed to allocate a %dx%d collision mask\n", width, height);
+        return false;
+    }
+    // Read as bytes in R, G, B, A order whatever the bitmap's format
+    ALLEGRO_LOCKED_REGION* region = al_lock_bitmap(bitmap, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE,
+                                                   ALLEGRO_LOCK_READONLY);
+    if (!region) {
+        fprintf(stderr, "Failed to lock a %dx%d frame for its collision mask\n", width, height);
+        free(rows);
+        return false;
+    }
+
+    mask->width = width;
+    mask->height = height;
+    mask->words_per_row = words_per_row;
+    mask->rows = rows;
+    mask->flipped_rows = rows + words;
+    for (int y = 0; y < height; y++) {
+        const uint8_t* pixels = (const uint8_t*)region->data + y * region->pitch;
+        uint64_t* row = mask->rows + y * words_per_row;
+        uint64_t* flipped = mask->flipped_rows + y * words_per_row;
+        for (int x = 0; x < width; x++) {
+            if (pixels[x * 4 + 3] < COLLISION_MASK_ALPHA) continue;
+            int mirrored = width - 1 - x;
+            row[x >> 6] |= 1ull << (x & 63);
+            flipped[mirrored >> 6] |= 1ull << (mirrored & 63);
+            mask->pixels++;
+        }
+    }
+    al_unlock_bitmap(bitmap);
+    return true;
+}
+
+void destroy_collision_mask(CollisionMask* mask) {
+    free(mask->rows);   // flipped_rows shares the allocation
+    memset(mask, 0, sizeof(*mask));
+}
+
+// The 64 pixels of 'row' from column 'start' on, zero past the row's end
+static inline uint64_t row_bits(const uint64_t* row, int words, int start) {
+    int word = start >> 6;
+    int shift = start & 63;
+    if (word >= words) return 0;
+    uint64_t bits = row[word] >> shift;
+    if (shift && word + 1 < words) bits |= row[word + 1] << (64 - shift);
+    return bits;
+}
+
+static const uint64_t* mask_row(const CollisionMask* mask, bool flip, int y) {
+    return (flip ? mask->flipped_rows : mask->rows) + y * mask->words_per_row;
+}
+
+bool masks_overlap(const CollisionMask* a, int ax, int ay, bool flip_a,
+                   const CollisionMask* b, int bx, int by, bool flip_b) {
+    int x0 = ax > bx ? ax : bx;
+    int y0 = ay > by ? ay : by;
+    int x1 = ax + a->width < bx + b->width ? ax + a->width : bx + b->width;
+    int y1 = ay + a->height < by + b->height ? ay + a->height : by + b->height;
+    if (x0 >= x1 || y0 >= y1 || !a->pixels || !b->pixels) return false;
+
+    // Both masks are zero past their own right edge, so words reaching
+    // beyond the shared columns need no trimming
+    for (int y = y0; y < y1; y++) {
+        const uint64_t* row_a = mask_row(a, flip_a, y - ay);
+        const uint64_t* row_b = mask_row(b, flip_b, y - by);
+        for (int x = x0; x < x1; x += 64) {
+            if (row_bits(row_a, a->words_per_row, x - ax) & row_bits(row_b, b->words_per_row, x - bx)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool mask_overlaps_rect(const CollisionMask* mask, int x, int y, bool flip,
+                        float left, float top, float right, float bottom) {
+    // Mask pixels any part of which lies inside the rectangle
+    int col0 = (int)floorf(left) - x;
+    int row0 = (int)floorf(top) - y;
+    int col1 = (int)ceilf(right) - x;
+    int row1 = (int)ceilf(bottom) - y;
+    if (col0 < 0) col0 = 0;
+    if (row0 < 0) row0 = 0;
+    if (col1 > mask->width) col1 = mask->width;
+    if (row1 > mask->height) row1 = mask->height;
+    if (col0 >= col1 || row0 >= row1 || !mask->pixels) return false;
+
+    for (int row = row0; row < row1; row++) {
+        const uint64_t* bits = mask_row(mask, flip, row);
+        for (int col = col0; col < col1; col += 64) {
+            uint64_t word = row_bits(bits, mask->words_per_row, col);
+            if (col1 - col < 64) word &= (1ull << (col1 - col)) - 1;
+            if (word) return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,499 @@
+#include "../include/draw_list.h"
+#include <math.h>    // For floorf
+#include <stdio.h>   // For fprintf
+#include <stdlib.h>  // For realloc, free, qsort
+#include <string.h>  // For memcpy, strncpy
+
+#define KEY_LAYER_SHIFT 61
+#define KEY_DEPTH_SHIFT 53
+#define KEY_BLEND_SHIFT 51
+#define KEY_TYPE_SHIFT 48
+#define KEY_TEXTURE_SHIFT 32
+#define KEY_SEQUENCE_MASK 0xFFFFFFFFull
+
+const char* const draw_section_names[DRAW_SECTION_COUNT] = {
+    "record", "sort", "sky", "background", "world", "hud", "overlay", "upscale"
+};
+
+static DrawTimings* draw_timings = NULL;
+static OverdrawMap* draw_overdraw = NULL;
+
+void set_draw_timings(DrawTimings* timings) {
+    draw_timings = timings;
+}
+
+void set_draw_overdraw(OverdrawMap* map) {
+    draw_overdraw = map;
+}
+
+double begin_draw_section(void) {
+    return draw_timings ? al_get_time() : 0.0;
+}
+
+void end_draw_section(DrawSection section, double start) {
+    if (!draw_timings) return;
+    double elapsed = al_get_time() - start;
+    draw_timings->total[section] += elapsed;
+    if (elapsed > draw_timings->max[section]) draw_timings->max[section] = elapsed;
+    draw_timings->samples[section]++;
+}
+
+void init_draw_list(DrawList* list) {
+    memset(list, 0, sizeof(*list));
+    init_prim_batch(&list->batch);
+}
+
+void free_draw_list(DrawList* list) {
+    free(list->commands);
+    free_prim_batch(&list->batch);
+    init_draw_list(list);
+}
+
+void clear_draw_list(DrawList* list) {
+    list->count = 0;
+    list->blend = DRAW_BLEND_ALPHA;
+    list->stats = (DrawStats){ 0, 0, 0, 0, 0 };
+    for (int i = 0; i < DRAW_LAYER_COUNT; i++) {
+        list->opaque[i].valid = false;
+    }
+}
+
+void set_draw_blend(DrawList* list, DrawBlend blend) {
+    list->blend = blend;
+}
+
+// Sub-bitmaps draw from their parent, so frames of one atlas batch together
+static const void* get_texture(ALLEGRO_BITMAP* bitmap) {
+    ALLEGRO_BITMAP* parent = al_get_parent_bitmap(bitmap);
+    return parent ? parent : bitmap;
+}
+
+// Equal textures give equal bits; different ones may collide, which only
+// costs an extra state switch
+static uint64_t texture_bits(const void* texture) {
+    return ((uintptr_t)texture >> 4) & 0xFFFF;
+}
+
+static DrawCommand* add_command(DrawList* list, DrawLayer layer, int depth,
+                                DrawCommandType type, const void* texture) {
+    if (list->count >= list->capacity) {
+        int capacity = list->capacity > 0 ? list->capacity * 2 : 256;
+        DrawCommand* grown = realloc(list->commands, capacity * sizeof(DrawCommand));
+        if (!grown) {
+            fprintf(stderr, "Failed to grow draw list to %d commands\n", capacity);
+            return NULL;
+        }
+        list->commands = grown;
+        list->capacity = capacity;
+    }
+    if (depth < 0) depth = 0;
+    if (depth > DRAW_DEPTH_MAX) depth = DRAW_DEPTH_MAX;
+
+    DrawCommand* cmd = &list->commands[list->count];
+    cmd->key = ((uint64_t)layer << KEY_LAYER_SHIFT) |
+               ((uint64_t)depth << KEY_DEPTH_SHIFT) |
+               ((uint64_t)list->blend << KEY_BLEND_SHIFT) |
+               ((uint64_t)type << KEY_TYPE_SHIFT) |
+               (texture_bits(texture) << KEY_TEXTURE_SHIFT) |
+               (uint64_t)list->count;
+    cmd->type = type;
+    cmd->bitmap = NULL;
+    cmd->font = NULL;
+    cmd->thickness = 0.0f;
+    cmd->flags = 0;
+    list->count++;
+    return cmd;
+}
+
+void record_clear(DrawList* list, DrawLayer layer, int depth, ALLEGRO_COLOR color) {
+    DrawCommand* cmd = add_command(list, layer, depth, DRAW_CMD_CLEAR, NULL);
+    if (!cmd) return;
+    cmd->color = color;
+}
+
+void record_bitmap(DrawList* list, DrawLayer layer, int depth, ALLEGRO_BITMAP* bitmap,
+                   float x, float y, float width, float height) {
+    if (!bitmap) return;
+    DrawCommand* cmd = add_command(list, layer, depth, DRAW_CMD_BITMAP, get_texture(bitmap));
+    if (!cmd) return;
+    cmd->bitmap = bitmap;
+    cmd->x1 = x;
+    cmd->y1 = y;
+    cmd->x2 = width;
+    cmd->y2 = height;
+}
+
+void record_sprite(DrawList* list, DrawLayer layer, int depth, ALLEGRO_BITMAP* bitmap,
+                   float x, float y, bool flip) {
+    if (!bitmap) return;
+    DrawCommand* cmd = add_command(list, layer, depth, DRAW_CMD_BITMAP, get_texture(bitmap));
+    if (!cmd) return;
+    cmd->bitmap = bitmap;
+    cmd->x1 = x;
+    cmd->y1 = y;
+    cmd->x2 = 0.0f;
+    cmd->y2 = 0.0f;
+    cmd->flags = flip ? ALLEGRO_FLIP_HORIZONTAL : 0;
+}
+
+void record_text(DrawList* list, DrawLayer layer, int depth, const ALLEGRO_FONT* font,
+                 ALLEGRO_COLOR color, float x, float y, int flags, const char* text) {
+    if (!font) return;
+    DrawCommand* cmd = add_command(list, layer, depth, DRAW_CMD_TEXT, font);
+    if (!cmd) return;
+    cmd->font = font;
+    cmd->color = color;
+    cmd->x1 = x;
+    cmd->y1 = y;
+    cmd->flags = flags;
+    strncpy(cmd->text, text, DRAW_TEXT_MAX - 1);
+    cmd->text[DRAW_TEXT_MAX - 1] = '\0';
+}
+
+void record_filled_rectangle(DrawList* list, DrawLayer layer, int depth,
+                             float x1, float y1, float x2, float y2, ALLEGRO_COLOR color) {
+    DrawCommand* cmd = add_command(list, layer, depth, DRAW_CMD_FILLED_RECT, NULL);
+    if (!cmd) return;
+    cmd->x1 = x1;
+    cmd->y1 = y1;
+    cmd->x2 = x2;
+    cmd->y2 = y2;
+    cmd->color = color;
+}
+
+void record_rectangle(DrawList* list, DrawLayer layer, int depth,
+                      float x1, float y1, float x2, float y2, ALLEGRO_COLOR color, float thickness) {
+    DrawCommand* cmd = add_command(list, layer, depth, DRAW_CMD_RECT, NULL);
+    if (!cmd) return;
+    cmd->x1 = x1;
+    cmd->y1 = y1;
+    cmd->x2 = x2;
+    cmd->y2 = y2;
+    cmd->color = color;
+    cmd->thickness = thickness;
+}
+
+void record_filled_circle(DrawList* list, DrawLayer layer, int depth,
+                          float cx, float cy, float radius, ALLEGRO_COLOR color) {
+    DrawCommand* cmd = add_command(list, layer, depth, DRAW_CMD_FILLED_CIRCLE, NULL);
+    if (!cmd) return;
+    cmd->x1 = cx;
+    cmd->y1 = cy;
+    cmd->x2 = radius;
+    cmd->color = color;
+}
+
+void record_circle(DrawList* list, DrawLayer layer, int depth,
+                   float cx, float cy, float radius, ALLEGRO_COLOR color, float thickness) {
+    DrawCommand* cmd = add_command(list, layer, depth, DRAW_CMD_CIRCLE, NULL);
+    if (!cmd) return;
+    cmd->x1 = cx;
+    cmd->y1 = cy;
+    cmd->x2 = radius;
+    cmd->color = color;
+    cmd->thickness = thickness;
+}
+
+static float area_size(const DrawArea* area) {
+    return area->valid ? (area->x2 - area->x1) * (area->y2 - area->y1) : 0.0f;
+}
+
+void mark_opaque_area(DrawList* list, DrawLayer layer, float x1, float y1, float x2, float y2) {
+    DrawArea area = { true, x1, y1, x2, y2 };
+    if (x2 <= x1 || y2 <= y1) return;
+    if (area_size(&area) > area_size(&list->opaque[layer])) list->opaque[layer] = area;
+}
+
+void append_draw_list(DrawList* dst, const DrawList* src) {
+    for (int i = 0; i < DRAW_LAYER_COUNT; i++) {
+        if (area_size(&src->opaque[i]) > area_size(&dst->opaque[i])) dst->opaque[i] = src->opaque[i];
+    }
+
+    int needed = dst->count + src->count;
+    if (needed > dst->capacity) {
+        int capacity = dst->capacity > 0 ? dst->capacity : 256;
+        while (capacity < needed) capacity *= 2;
+        DrawCommand* grown = realloc(dst->commands, capacity * sizeof(DrawCommand));
+        if (!grown) {
+            fprintf(stderr, "Failed to grow draw list to %d commands\n", capacity);
+            return;
+        }
+        dst->commands = grown;
+        dst->capacity = capacity;
+    }
+    memcpy(&dst->commands[dst->count], src->commands, src->count * sizeof(DrawCommand));
+    // Renumber so the appended commands sort after the existing ones
+    for (int i = dst->count; i < needed; i++) {
+        dst->commands[i].key = (dst->commands[i].key & ~KEY_SEQUENCE_MASK) | (uint64_t)i;
+    }
+    dst->count = needed;
+}
+
+static int compare_commands(const void* a, const void* b) {
+    uint64_t ka = ((const DrawCommand*)a)->key;
+    uint64_t kb = ((const DrawCommand*)b)->key;
+    return (ka > kb) - (ka < kb);
+}
+
+void sort_draw_list(DrawList* list) {
+    qsort(list->commands, list->count, sizeof(DrawCommand), compare_commands);
+}
+
+static bool is_level_space(DrawLayer layer) {
+    return layer == DRAW_LAYER_BACKGROUND || layer == DRAW_LAYER_WORLD;
+}
+
+static bool is_held_type(DrawCommandType type) {
+    return type == DRAW_CMD_BITMAP || type == DRAW_CMD_TEXT;
+}
+
+static bool is_batched_type(DrawCommandType type) {
+    return type == DRAW_CMD_FILLED_RECT || type == DRAW_CMD_RECT ||
+           type == DRAW_CMD_FILLED_CIRCLE || type == DRAW_CMD_CIRCLE;
+}
+
+// Lowest layer that is drawn: everything under a layer whose opaque area
+// covers the whole target is hidden
+static int first_visible_layer(const DrawList* list, const Camera* camera, int width, int height) {
+    for (int layer = DRAW_LAYER_COUNT - 1; layer > 0; layer--) {
+        const DrawArea* area = &list->opaque[layer];
+        if (!area->valid) continue;
+        float dx = 0.0f, dy = 0.0f, scale = camera ? camera->scale : 1.0f;
+        if (camera && is_level_space(layer)) {
+            dx = -camera->x + camera->shake.offset_x;
+            dy = camera->shake.offset_y;
+        }
+        if ((area->x1 + dx) * scale <= 0.0f && (area->y1 + dy) * scale <= 0.0f &&
+            (area->x2 + dx) * scale >= width && (area->y2 + dy) * scale >= height) {
+            return layer;
+        }
+    }
+    return 0;
+}
+
+// Add the pixels a command covers to the overdraw map; (dx, dy) moves the
+// command to screen space
+static void count_overdraw(OverdrawMap* map, const DrawCommand* cmd, float dx, float dy) {
+    float x = cmd->x1 + dx;
+    float y = cmd->y1 + dy;
+    float half = (cmd->thickness > 0.0f ? cmd->thickness : 1.0f) / 2.0f;
+    switch (cmd->type) {
+        case DRAW_CMD_CLEAR:
+            add_overdraw_rect(map, 0, 0, map->width, map->height);
+            break;
+        case DRAW_CMD_BITMAP: {
+            float w = cmd->x2 > 0.0f ? cmd->x2 : al_get_bitmap_width(cmd->bitmap);
+            float h = cmd->y2 > 0.0f ? cmd->y2 : al_get_bitmap_height(cmd->bitmap);
+            add_overdraw_rect(map, x, y, x + w, y + h);
+            break;
+        }
+        case DRAW_CMD_TEXT: {
+            float w = al_get_text_width(cmd->font, cmd->text);
+            if (cmd->flags & ALLEGRO_ALIGN_CENTRE) x -= w / 2;
+            else if (cmd->flags & ALLEGRO_ALIGN_RIGHT) x -= w;
+            add_overdraw_rect(map, x, y, x + w, y + al_get_font_line_height(cmd->font));
+            break;
+        }
+        case DRAW_CMD_FILLED_RECT:
+            add_overdraw_rect(map, x, y, cmd->x2 + dx, cmd->y2 + dy);
+            break;
+        case DRAW_CMD_RECT: {
+            float x2 = cmd->x2 + dx, y2 = cmd->y2 + dy;
+            add_overdraw_rect(map, x - half, y - half, x2 + half, y + half);
+            add_overdraw_rect(map, x - half, y2 - half, x2 + half, y2 + half);
+            add_overdraw_rect(map, x - half, y + half, x + half, y2 - half);
+            add_overdraw_rect(map, x2 - half, y + half, x2 + half, y2 - half);
+            break;
+        }
+        case DRAW_CMD_FILLED_CIRCLE:
+            add_overdraw_ring(map, x, y, 0.0f, cmd->x2);
+            break;
+        case DRAW_CMD_CIRCLE:
+            add_overdraw_ring(map, x, y, cmd->x2 > half ? cmd->x2 - half : 0.0f, cmd->x2 + half);
+            break;
+    }
+}
+
+static void set_blend(DrawBlend blend) {
+    if (blend == DRAW_BLEND_ADD) al_set_blender(ALLEGRO_ADD, ALLEGRO_ONE, ALLEGRO_ONE);
+    else al_set_blender(ALLEGRO_ADD, ALLEGRO_ONE, ALLEGRO_INVERSE_ALPHA);
+}
+
+static void execute_command(PrimBatch* batch, const DrawCommand* cmd) {
+    switch (cmd->type) {
+        case DRAW_CMD_CLEAR:
+            al_clear_to_color(cmd->color);
+            break;
+        case DRAW_CMD_BITMAP:
+            if (cmd->x2 > 0.0f && cmd->y2 > 0.0f) {
+                al_draw_scaled_bitmap(cmd->bitmap, 0, 0,
+                    al_get_bitmap_width(cmd->bitmap), al_get_bitmap_height(cmd->bitmap),
+                    cmd->x1, cmd->y1, cmd->x2, cmd->y2, cmd->flags);
+            } else {
+                al_draw_bitmap(cmd->bitmap, cmd->x1, cmd->y1, cmd->flags);
+            }
+            break;
+        case DRAW_CMD_TEXT:
+            al_draw_text(cmd->font, cmd->color, cmd->x1, cmd->y1, cmd->flags, cmd->text);
+            break;
+        case DRAW_CMD_FILLED_RECT:
+            batch_filled_rectangle(batch, cmd->x1, cmd->y1, cmd->x2, cmd->y2, cmd->color);
+            break;
+        case DRAW_CMD_RECT:
+            batch_rectangle(batch, cmd->x1, cmd->y1, cmd->x2, cmd->y2, cmd->color, cmd->thickness);
+            break;
+        case DRAW_CMD_FILLED_CIRCLE:
+            batch_filled_circle(batch, cmd->x1, cmd->y1, cmd->x2, cmd->color);
+            break;
+        case DRAW_CMD_CIRCLE:
+            batch_circle(batch, cmd->x1, cmd->y1, cmd->x2, cmd->color, cmd->thickness);
+            break;
+    }
+}
+
+// Whether 'cmd' can be written with the kernels: alpha blended fills, and
+// bitmaps copied pixel for pixel. (dx, dy) moves it into screen space.
+static bool is_kernel_command(const DrawCommand* cmd, int blend, const Camera* camera, float dx, float dy) {
+    switch (cmd->type) {
+        case DRAW_CMD_CLEAR:
+            return true;
+        case DRAW_CMD_FILLED_RECT:
+        case DRAW_CMD_FILLED_CIRCLE:
+            return blend == DRAW_BLEND_ALPHA;
+        case DRAW_CMD_BITMAP:
+            return blend == DRAW_BLEND_ALPHA && camera->scale == 1.0f && cmd->flags == 0 &&
+                   cmd->x2 <= 0.0f && cmd->y2 <= 0.0f &&
+                   cmd->x1 + dx == floorf(cmd->x1 + dx) && cmd->y1 + dy == floorf(cmd->y1 + dy);
+        default:
+            return false;
+    }
+}
+
+// False if the kernels turned the command down after all
+static bool execute_kernel(KernelTarget* kernels, const DrawCommand* cmd, float scale, float dx, float dy) {
+    float x1 = (cmd->x1 + dx) * scale;
+    float y1 = (cmd->y1 + dy) * scale;
+    switch (cmd->type) {
+        case DRAW_CMD_CLEAR:
+            kernel_clear(kernels, cmd->color);
+            return true;
+        case DRAW_CMD_FILLED_RECT:
+            kernel_filled_rectangle(kernels, x1, y1, (cmd->x2 + dx) * scale, (cmd->y2 + dy) * scale,
+                                    cmd->color);
+            return true;
+        case DRAW_CMD_FILLED_CIRCLE:
+            kernel_filled_circle(kernels, x1, y1, cmd->x2 * scale, cmd->color);
+            return true;
+        case DRAW_CMD_BITMAP:
+            return kernel_draw_bitmap(kernels, cmd->bitmap, (int)x1, (int)y1, false);
+        default:
+            return false;
+    }
+}
+
+void submit_draw_list(DrawList* list, const Camera* camera) {
+    submit_draw_layers(list, camera, 0, DRAW_LAYER_COUNT - 1);
+}
+
+void submit_draw_layers(DrawList* list, const Camera* camera, DrawLayer first, DrawLayer last) {
+    DrawStats stats = { 0, 0, 0, 0, 0 };
+    PrimBatch* batch = &list->batch;
+    ALLEGRO_BITMAP* target = al_get_target_bitmap();
+    int first_layer = first_visible_layer(list, camera, al_get_bitmap_width(target),
+                                          al_get_bitmap_height(target));
+    int layer = -1;
+    int blend = DRAW_BLEND_ALPHA;
+    int state = -1;                 // Command type, or -2 for any batched primitive
+    const void* texture = NULL;
+    bool level_space = false;
+    bool held = false;
+    double start = 0.0;
+    KernelTarget kernels;
+    bool use_kernels = camera && begin_kernel_target(&kernels, target);
+
+    clear_prim_batch(batch);
+    if (camera) use_screen_transform(camera);
+    for (int i = 0; i < list->count; i++) {
+        const DrawCommand* cmd = &list->commands[i];
+        int cmd_layer = (int)(cmd->key >> KEY_LAYER_SHIFT);
+        if (cmd_layer < (int)first || cmd_layer > (int)last) continue;
+        stats.commands++;
+        if (cmd_layer < first_layer) {
+            stats.elided++;
+            continue;
+        }
+        int cmd_blend = (int)((cmd->key >> KEY_BLEND_SHIFT) & 3);
+        bool space = camera && is_level_space(cmd_layer);
+        float dx = space ? -camera->x + camera->shake.offset_x : 0.0f;
+        float dy = space ? camera->shake.offset_y : 0.0f;
+        bool kernel = use_kernels && is_kernel_command(cmd, cmd_blend, camera, dx, dy);
+        bool batched = !kernel && is_batched_type(cmd->type);
+        int cmd_state = batched ? -2 : (int)cmd->type;
+        const void* cmd_texture = cmd->bitmap ? get_texture(cmd->bitmap) : (const void*)cmd->font;
+
+        // Collected primitives go out before anything that changes how
+        // they are drawn or has to be painted over them
+        if (!batched || cmd_layer != layer || cmd_blend != blend || space != level_space) {
+            // Allegro can't draw into the bitmap while the kernels hold it locked
+            if (use_kernels && batch->num_indices > 0) end_kernel_drawing(&kernels);
+            if (flush_prim_batch(batch)) stats.draw_calls++;
+        }
+
+        if (cmd_layer != layer) {
+            if (layer >= 0) end_draw_section(DRAW_SECTION_SKY + layer, start);
+            start = begin_draw_section();
+            layer = cmd_layer;
+        }
+
+        // Held bitmap drawing batches a run of bitmaps and text, but must
+        // not stay on across primitives or transform changes
+        bool needs_hold = !kernel && is_held_type(cmd->type);
+        if (held && (!needs_hold || space != level_space)) {
+            al_hold_bitmap_drawing(false);
+            held = false;
+        }
+        if (space != level_space) {
+            if (space) use_camera_transform(camera);
+            else use_screen_transform(camera);
+            level_space = space;
+            stats.state_switches++;
+        }
+        if (cmd_blend != blend) {
+            set_blend(cmd_blend);
+            blend = cmd_blend;
+            stats.state_switches++;
+        }
+        if (cmd_state != state || cmd_texture != texture) {
+            if (state != -1) stats.state_switches++;
+            // Bitmaps and text of one texture go out as a single batch
+            if (needs_hold) stats.draw_calls++;
+            state = cmd_state;
+            texture = cmd_texture;
+        }
+        if (needs_hold && !held) {
+            al_hold_bitmap_drawing(true);
+            held = true;
+        }
+
+        if (kernel && execute_kernel(&kernels, cmd, camera->scale, dx, dy)) {
+            stats.kernel_draws++;
+        } else {
+            if (use_kernels) end_kernel_drawing(&kernels);
+            if (cmd->type == DRAW_CMD_CLEAR) stats.draw_calls++;
+            execute_command(batch, cmd);
+        }
+        if (draw_overdraw) count_overdraw(draw_overdraw, cmd, dx, dy);
+    }
+
+    if (use_kernels) end_kernel_drawing(&kernels);
+    if (flush_prim_batch(batch)) stats.draw_calls++;
+    if (held) al_hold_bitmap_drawing(false);
+    if (layer >= 0) end_draw_section(DRAW_SECTION_SKY + layer, start);
+    if (camera) use_screen_transform(NULL);
+    if (blend != DRAW_BLEND_ALPHA) set_blend(DRAW_BLEND_ALPHA);
+    list->stats.commands += stats.commands;
+    list->stats.draw_calls += stats.draw_calls;
+    list->stats.state_switches += stats.state_switches;
+    list->stats.elided += stats.elided;
+    list->stats.kernel_draws += stats.kernel_draws;
+}
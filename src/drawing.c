@@ -1,11 +1,50 @@
 #include "../include/drawing.h"
 #include "../include/game.h" // For Game, Level, Menu, Entity, Portal, constants
 #include "../include/game_logic.h" // For star calculation functions
-#include <allegro5/allegro_primitives.h> // For drawing shapes
-#include <allegro5/allegro_font.h>     // For drawing text
-#include <allegro5/allegro_ttf.h>      // For ttf fonts (though game->font is already loaded)
-#include <stdio.h>                   // For sprintf
-#include <math.h>                    // For sin in welcome screen pulse
+#include "../include/render.h"     // For RenderSnapshot
+#include "../include/camera.h"     // For the camera the scene is drawn with
+#include <allegro5/allegro_font.h>     // For text alignment flags
+#include <stdio.h>                   // For sprintf, printf, fprintf
+#include <stdlib.h>                  // For calloc, free
+#include <math.h>                    // For sin in welcome screen pulse, floorf
+
+// Depths of the background layer
+enum {
+    BACKGROUND_DEPTH_TILES,
+    BACKGROUND_DEPTH_PLATFORMS  // Static, so they are kept in the scroll cache with the tiles
+};
+
+// Depths of the world layer, back to front. Commands at one depth may be
+// reordered to group them by state, so anything that has to be painted over
+// something else gets its own depth.
+enum {
+    WORLD_DEPTH_PORTAL,
+    WORLD_DEPTH_PORTAL_BORDER,
+    WORLD_DEPTH_ENEMIES,
+    WORLD_DEPTH_ENEMY_HEALTH,
+    WORLD_DEPTH_PROJECTILES,
+    WORLD_DEPTH_PROJECTILE_BORDERS,
+    WORLD_DEPTH_PARTICLES,
+    WORLD_DEPTH_GLUCOSE,
+    WORLD_DEPTH_GLUCOSE_BORDERS,
+    WORLD_DEPTH_PLAYER_INDICATORS,
+    WORLD_DEPTH_PLAYER_TEXT,
+    WORLD_DEPTH_PLAYER
+};
+
+// Depths of the screen space layers
+enum {
+    SCREEN_DEPTH_BACKDROP,      // Full-screen overlay rectangles
+    SCREEN_DEPTH_CONTENT,       // Text, bars and star sprites
+    SCREEN_DEPTH_OUTLINES       // Outlines of the fallback star circles
+};
+
+typedef void (*ScenePartFunc)(DrawList* list, Game* game, const RenderSnapshot* snap);
+
+// The headless bench draws into a memory bitmap with no display to flip
+static void present_frame(Game* game) {
+    if (game->display) al_flip_display();
+}
 
 // Helper function to get level name
 static const char* get_level_name(int level) {
@@ -17,407 +56,643 @@ static const char* get_level_name(int level) {
 }
 
 // Original draw_menu function from main.c
-void draw_menu(Game* game, Menu* menu, const char* title) {
-    al_clear_to_color(MENU_BACKGROUND_COLOR);
-    
-    al_draw_text(game->title_font, TITLE_TEXT_COLOR,
+void record_menu(DrawList* list, Game* game, const RenderMenu* menu, const char* title) {
+    record_clear(list, DRAW_LAYER_SKY, 0, MENU_BACKGROUND_COLOR);
+
+    record_text(list, DRAW_LAYER_OVERLAY, SCREEN_DEPTH_CONTENT, game->title_font, TITLE_TEXT_COLOR,
                 SCREEN_WIDTH/2, MENU_TITLE_Y,
                 ALLEGRO_ALIGN_CENTRE, title);
 
     for (int i = 0; i < menu->num_items; i++) {
-        ALLEGRO_COLOR color = menu->items[i].enabled ? 
+        ALLEGRO_COLOR color = menu->enabled[i] ?
             (i == menu->selected_index ? MENU_SELECTED_TEXT_COLOR : MENU_TEXT_COLOR) :
             MENU_DISABLED_TEXT_COLOR;
 
-        al_draw_text(game->font, color,
+        record_text(list, DRAW_LAYER_OVERLAY, SCREEN_DEPTH_CONTENT, game->font, color,
                     SCREEN_WIDTH/2, MENU_ITEM_START_Y + i * MENU_ITEM_SPACING,
-                    ALLEGRO_ALIGN_CENTRE, menu->items[i].text);
+                    ALLEGRO_ALIGN_CENTRE, menu->text[i]);
     }
-    al_flip_display();
 }
 
 // Original draw_welcome_screen function from main.c
-void draw_welcome_screen(Game* game) {
-    al_clear_to_color(MENU_BACKGROUND_COLOR);
-    
-    float pulse = (1 + sin(al_get_time() * 2)) * 0.5f; // Pulse factor between 0 and 1
+void record_welcome_screen(DrawList* list, Game* game, const RenderSnapshot* snap) {
+    record_clear(list, DRAW_LAYER_SKY, 0, MENU_BACKGROUND_COLOR);
+
+    float pulse = (1 + sin(snap->time * 2)) * 0.5f; // Pulse factor between 0 and 1
     // Pulsating color for the title, from a darker red to a brighter red
     ALLEGRO_COLOR title_color = al_map_rgb((unsigned char)(150 + pulse * 105), (unsigned char)(pulse * 100), (unsigned char)(pulse * 100));
-    
-    al_draw_text(game->title_font, title_color,
+
+    record_text(list, DRAW_LAYER_OVERLAY, SCREEN_DEPTH_CONTENT, game->title_font, title_color,
                 SCREEN_WIDTH/2, SCREEN_HEIGHT/WELCOME_TITLE_Y_DIVISOR,
                 ALLEGRO_ALIGN_CENTRE, "Cancer Cell Adventure");
-    
-    al_draw_text(game->font, COLOR_LIGHT_GRAY,
+
+    record_text(list, DRAW_LAYER_OVERLAY, SCREEN_DEPTH_CONTENT, game->font, COLOR_LIGHT_GRAY,
                 SCREEN_WIDTH/2, SCREEN_HEIGHT/WELCOME_SUBTEXT_Y_DIVISOR,
                 ALLEGRO_ALIGN_CENTRE, "Press ENTER to start");
-    
-    al_draw_text(game->font, COLOR_MEDIUM_GRAY,
+
+    record_text(list, DRAW_LAYER_OVERLAY, SCREEN_DEPTH_CONTENT, game->font, COLOR_MEDIUM_GRAY,
                 SCREEN_WIDTH/2, SCREEN_HEIGHT - WELCOME_VERSION_OFFSET_Y,
                 ALLEGRO_ALIGN_CENTRE, "Version 1.0");
-    
-    al_flip_display();
 }
 
-// Original draw_main_menu function from main.c
-void draw_main_menu(Game* game) {
-    draw_menu(game, &game->main_menu, "Main Menu");
+static void record_background(DrawList* list, Game* game, const RenderSnapshot* snap) {
+    Level* current = snap->level;
+    const Camera* camera = &snap->camera;
+
+    record_clear(list, DRAW_LAYER_SKY, 0, COLOR_SKY_BLUE);
+    // Draw backgrounds - check if level has multi-backgrounds
+    if (current->background_tiles.num_tiles > 0) {
+        // Tiles were streamed in before recording started
+        record_background_tiles(&current->background_tiles, list, DRAW_LAYER_BACKGROUND, BACKGROUND_DEPTH_TILES,
+                                camera->x, camera->x + camera->width);
+    } else if (current->background) {
+        // Single background system for regular levels
+        record_bitmap(list, DRAW_LAYER_BACKGROUND, BACKGROUND_DEPTH_TILES, current->background, 0, 0, 0, 0);
+    }
+}
+
+static void record_platforms(DrawList* list, Game* game, const RenderSnapshot* snap) {
+    const Camera* camera = &snap->camera;
+    const StaticChunkSet* chunks = &snap->level->static_chunks;
+    if (chunks->complete) {
+        record_static_chunks(chunks, list, DRAW_LAYER_BACKGROUND, BACKGROUND_DEPTH_PLATFORMS,
+                             camera->x, camera->x + camera->width);
+    } else {
+        // Chunks could not be baked: the visible platforms one by one
+        for (int i = 0; i < snap->num_platforms; i++) {
+            const Platform* p = &snap->platforms[i];
+            record_filled_rectangle(list, DRAW_LAYER_BACKGROUND, BACKGROUND_DEPTH_PLATFORMS,
+                                    p->x, p->y, p->x + p->width, p->y + p->height, p->color);
+        }
+    }
+    if (snap->portal.is_active) {
+        const Portal* portal = &snap->portal;
+        if (portal->x + portal->width >= camera->x && portal->x <= camera->x + camera->width) {
+            record_filled_rectangle(list, DRAW_LAYER_WORLD, WORLD_DEPTH_PORTAL, portal->x, portal->y,
+                portal->x + portal->width, portal->y + portal->height,
+                COLOR_PURPLE);
+            record_rectangle(list, DRAW_LAYER_WORLD, WORLD_DEPTH_PORTAL_BORDER, portal->x, portal->y,
+                portal->x + portal->width, portal->y + portal->height,
+                COLOR_WHITE, PORTAL_BORDER_THICKNESS);
+        }
+    }
+}
+
+// Animation frames stand on the bottom of the entity's box, centred on it,
+// at whole pixels so memory targets can copy them with the pixel kernels
+static void record_entity_sprite(DrawList* list, int depth, ALLEGRO_BITMAP* sprite,
+                                 float x, float y, float width, float height, bool flip) {
+    float sprite_x = floorf(x + (width - al_get_bitmap_width(sprite)) / 2);
+    float sprite_y = floorf(y + height - al_get_bitmap_height(sprite));
+    record_sprite(list, DRAW_LAYER_WORLD, depth, sprite, sprite_x, sprite_y, flip);
+}
+
+static void record_enemies(DrawList* list, Game* game, const RenderSnapshot* snap) {
+    for (int i = 0; i < snap->num_enemies; i++) {
+        const RenderEnemy* e = &snap->enemies[i];
+        ALLEGRO_COLOR enemy_color;
+        switch (e->type) {
+            case T_CELL: enemy_color = COLOR_YELLOW; break; // Bright Yellow
+            case MACROPHAGE: enemy_color = al_map_rgb(200, 200, 0); break; // Darker Yellow
+            case B_CELL: enemy_color = al_map_rgb(0, 200, 255); break; // Cyan/Light Blue
+            case NK_CELL: enemy_color = COLOR_RED; break; // Bright Red
+            default: enemy_color = COLOR_WHITE;
+        }
+        if (e->sprite) {
+            record_entity_sprite(list, WORLD_DEPTH_ENEMIES, e->sprite, e->x, e->y, e->width, e->height,
+                                 e->facing_left);
+        } else {
+            record_filled_circle(list, DRAW_LAYER_WORLD, WORLD_DEPTH_ENEMIES,
+                                 e->x + e->width/2, e->y + e->height/2, e->width/2, enemy_color);
+        }
+        if (e->health < e->max_health) {
+            float health_percent = e->health / e->max_health;
+            record_filled_rectangle(list, DRAW_LAYER_WORLD, WORLD_DEPTH_ENEMY_HEALTH,
+                e->x, e->y - ENEMY_HEALTH_BAR_OFFSET_Y,
+                e->x + e->width * health_percent, e->y - ENEMY_HEALTH_BAR_OFFSET_Y + ENEMY_HEALTH_BAR_HEIGHT,
+                al_map_rgb((unsigned char)(255 * (1-health_percent)), (unsigned char)(255 * health_percent), 0)); // Green to Red gradient
+        }
+    }
+}
+
+static void record_projectiles(DrawList* list, Game* game, const RenderSnapshot* snap) {
+    for (int i = 0; i < snap->num_projectiles; i++) {
+        const RenderProjectile* p = &snap->projectiles[i];
+        // Choose color based on source
+        ALLEGRO_COLOR projectile_color;
+        switch (p->source) {
+            case T_CELL:
+            case MACROPHAGE:
+            case B_CELL:
+            case NK_CELL:
+                projectile_color = al_map_rgb(255, 100, 100); // Red-ish for enemy projectiles
+                break;
+            case CANCER_CELL:
+                projectile_color = al_map_rgb(0, 255, 255); // Cyan for player projectiles
+                break;
+            default:
+                projectile_color = COLOR_WHITE;
+        }
+
+        // Draw projectile as a small filled circle
+        record_filled_circle(list, DRAW_LAYER_WORLD, WORLD_DEPTH_PROJECTILES,
+                             p->x + p->width/2, p->y + p->height/2, p->width/2, projectile_color);
+
+        // Add different border colors for better distinction
+        ALLEGRO_COLOR border_color = (p->source == CANCER_CELL) ? al_map_rgb(255, 255, 255) : al_map_rgb(255, 0, 0);
+        record_circle(list, DRAW_LAYER_WORLD, WORLD_DEPTH_PROJECTILE_BORDERS,
+                      p->x + p->width/2, p->y + p->height/2, p->width/2, border_color, 1.5f);
+    }
+}
+
+static void record_particles(DrawList* list, Game* game, const RenderSnapshot* snap) {
+    for (int i = 0; i < snap->num_particles; i++) {
+        const RenderParticle* p = &snap->particles[i];
+        // Draw particle as a small filled circle with fading alpha
+        record_filled_circle(list, DRAW_LAYER_WORLD, WORLD_DEPTH_PARTICLES, p->x, p->y, 2.0f, p->color);
+    }
+}
+
+static void record_glucose(DrawList* list, Game* game, const RenderSnapshot* snap) {
+    // Create pulsing effect
+    float pulse = (1 + sin(snap->time * 4)) * 0.3f + 0.7f; // Pulse between 0.7 and 1.0
+    ALLEGRO_COLOR glucose_color = al_map_rgb(
+        (unsigned char)(255 * pulse),
+        (unsigned char)(105 * pulse),
+        (unsigned char)(180 * pulse)
+    );
+    // Draw with slight size variation for pulsing effect
+    float size_mod = pulse * 2.0f;
+
+    for (int i = 0; i < snap->num_glucose_items; i++) {
+        const RenderGlucose* g = &snap->glucose_items[i];
+        record_filled_rectangle(list, DRAW_LAYER_WORLD, WORLD_DEPTH_GLUCOSE,
+                                g->x - size_mod, g->y - size_mod,
+                                g->x + g->width + size_mod, g->y + g->height + size_mod,
+                                glucose_color);
+
+        // Add a bright border for visibility
+        record_rectangle(list, DRAW_LAYER_WORLD, WORLD_DEPTH_GLUCOSE_BORDERS,
+                         g->x - size_mod, g->y - size_mod,
+                         g->x + g->width + size_mod, g->y + g->height + size_mod,
+                         COLOR_WHITE, 1.0f);
+    }
+}
+
+static void record_player(DrawList* list, Game* game, const RenderSnapshot* snap) {
+    const RenderPlayer* player = &snap->player;
+    float center_x = player->x + player->width/2;
+    float center_y = player->y + player->height/2;
+
+    // Draw attack range indicator when attacking
+    if (player->state == ATTACKING) {
+        record_circle(list, DRAW_LAYER_WORLD, WORLD_DEPTH_PLAYER_INDICATORS,
+                      center_x, center_y, PLAYER_ATTACK_RANGE, COLOR_RED, 2.0f);
+    }
+
+    // Draw shooting readiness indicator
+    if (player->last_shot <= 0) {
+        // Small green circle above player when ready to shoot
+        record_filled_circle(list, DRAW_LAYER_WORLD, WORLD_DEPTH_PLAYER_INDICATORS,
+                             center_x, player->y - 8, 3.0f, al_map_rgb(0, 255, 0));
+    } else {
+        // Red circle showing cooldown
+        float cooldown_ratio = (float)player->last_shot / PLAYER_PROJECTILE_COOLDOWN;
+        record_filled_circle(list, DRAW_LAYER_WORLD, WORLD_DEPTH_PLAYER_INDICATORS,
+                             center_x, player->y - 8, 3.0f * cooldown_ratio, al_map_rgb(255, 0, 0));
+    }
+
+    // Draw combo indicator
+    if (player->combo_count > 0 && player->combo_timer > 0) {
+        // Combo chain indicator - growing glow around player
+        float combo_intensity = (float)player->combo_count / MAX_COMBO_COUNT;
+        ALLEGRO_COLOR combo_color = al_map_rgba(255, 255, 0,
+                                              (unsigned char)(100 + combo_intensity * 155));
+
+        for (int j = 0; j < player->combo_count && j < 5; j++) {
+            record_circle(list, DRAW_LAYER_WORLD, WORLD_DEPTH_PLAYER_INDICATORS, center_x, center_y,
+                          player->width/2 + 5 + j * 3, combo_color, 2.0f);
+        }
+
+        // Combo counter text
+        char combo_text[16];
+        sprintf(combo_text, "x%d COMBO", player->combo_count);
+        record_text(list, DRAW_LAYER_WORLD, WORLD_DEPTH_PLAYER_TEXT, game->font, al_map_rgb(255, 255, 0),
+                    center_x, player->y - 25, ALLEGRO_ALIGN_CENTER, combo_text);
+    }
+
+    // Draw player with state-based coloring
+    bool flashing = player->last_attack > 0 && ((int)player->last_attack % 6) < 3;
+    if (player->sprite) {
+        // Invincibility flashing hides the sprite every few frames
+        if (!flashing) record_entity_sprite(list, WORLD_DEPTH_PLAYER, player->sprite, player->x, player->y,
+                                            player->width, player->height, player->facing_left);
+        return;
+    }
+    ALLEGRO_COLOR player_color = COLOR_PINKISH_RED;
+    if (flashing) {
+        // Invincibility flashing effect
+        player_color = al_map_rgb(255, 150, 150);
+    }
+
+    record_filled_circle(list, DRAW_LAYER_WORLD, WORLD_DEPTH_PLAYER,
+                         center_x, center_y, player->width/2, player_color);
+}
+
+static void record_hud(DrawList* list, Game* game, const RenderSnapshot* snap) {
+    const RenderPlayer* player = &snap->player;
+
+    // Player Health Bar
+    float health_percent = player->health / player->max_health;
+    record_filled_rectangle(list, DRAW_LAYER_HUD, SCREEN_DEPTH_CONTENT,
+                            PLAYER_HUD_HEALTH_X, PLAYER_HUD_HEALTH_Y,
+                            PLAYER_HUD_HEALTH_X + PLAYER_HUD_HEALTH_WIDTH_MAX * health_percent,
+                            PLAYER_HUD_HEALTH_Y + PLAYER_HUD_HEALTH_HEIGHT,
+                            al_map_rgb((unsigned char)(255 * (1-health_percent)), (unsigned char)(255 * health_percent), 0)); // Green to Red gradient
+
+    // HUD Text (Level and Total Stars)
+    char level_text[64];
+    const char* current_level_name = get_level_name(snap->current_level);
+    sprintf(level_text, "Level: %s  Total: %d/%d",
+           current_level_name, snap->total_stars, MAX_STARS_PER_LEVEL * TOTAL_LEVELS);
+    record_text(list, DRAW_LAYER_HUD, SCREEN_DEPTH_CONTENT, game->font, COLOR_WHITE,
+                HUD_TEXT_X, HUD_TEXT_Y, ALLEGRO_ALIGN_LEFT, level_text);
+
+    // Draw visual star display for current level progress (repositioned to top right)
+    record_star_display(list, DRAW_LAYER_HUD, game, SCREEN_WIDTH - 100, 10, snap->level_progress_stars,
+                        MAX_STARS_PER_LEVEL, snap->current_level);
+}
+
+// Each part of the scene is recorded into its own list by a task of the
+// recording graph, then the lists are appended in this order
+static const ScenePartFunc scene_parts[SCENE_PART_COUNT] = {
+    record_background, record_platforms, record_enemies, record_projectiles,
+    record_particles, record_glucose, record_player, record_hud
+};
+static const char* const scene_part_names[SCENE_PART_COUNT] = {
+    "record background", "record platforms", "record enemies", "record projectiles",
+    "record particles", "record glucose", "record player", "record hud"
+};
+
+static void record_scene_part(void* data) {
+    SceneRecordTask* task = data;
+    DrawContext* context = task->context;
+    DrawList* list = &context->parts[task->part];
+    clear_draw_list(list);
+    scene_parts[task->part](list, context->game, context->snap);
+}
+
+// Decodes the tiles streaming queued while the parts are recorded
+static void decode_scene_tiles(void* data) {
+    DrawContext* context = data;
+    decode_background_tiles(&context->snap->level->background_tiles);
 }
 
-// Original draw_level_select function from main.c
-void draw_level_select(Game* game) {
-    draw_menu(game, &game->level_menu, "Select Level");
+// Record the level, entities and HUD. Also used to capture the frame shown
+// under the pause screen.
+void record_playing_scene(DrawList* list, Game* game, const RenderSnapshot* snap) {
+    DrawContext* context = game->draw_context;
+    Level* current = snap->level;
+
+    // Uploading tiles and baking chunks needs the drawing thread, so both
+    // happen here and the recording tasks only look at the results. Tiles
+    // queued here are decoded by the graph's decode task.
+    if (current->background_tiles.num_tiles > 0) {
+        stream_background_tiles(&current->background_tiles, snap->camera.x,
+                                snap->camera.x + snap->camera.width, BACKGROUND_TILE_PREFETCH);
+    }
+    if (!current->static_chunks.baked) {
+        bake_static_chunks(&current->static_chunks, current->platforms, current->num_platforms,
+                           &current->tilemap, current->level_width);
+        // The scroll cache still holds the chunks of the last bake
+        context->scroll_cache.valid = false;
+    }
+
+    context->game = game;
+    context->snap = snap;
+    run_task_graph(&context->jobs, &context->record_graph);
+    for (int i = 0; i < SCENE_PART_COUNT; i++) {
+        append_draw_list(list, &context->parts[i]);
+    }
 }
 
-// Original draw_settings_menu function from main.c
-void draw_settings_menu(Game* game) {
-    draw_menu(game, &game->settings_menu, "Settings");
+// Sort and submit the frame list, then start a new one. With a
+// 'scrolled_level', the static layers come from the scroll cache when it
+// can be used.
+static void submit_frame(DrawContext* context, const Camera* camera, const Level* scrolled_level) {
+    DrawList* frame = &context->frame;
+    double start = begin_draw_section();
+    sort_draw_list(frame);
+    end_draw_section(DRAW_SECTION_SORT, start);
+    if (scrolled_level && draw_scroll_cache(&context->scroll_cache, frame, camera, scrolled_level)) {
+        submit_draw_layers(frame, camera, DRAW_LAYER_LAST_STATIC + 1, DRAW_LAYER_COUNT - 1);
+    } else {
+        submit_draw_list(frame, camera);
+    }
+
+    const DrawStats* stats = &frame->stats;
+    context->last.commands += stats->commands;
+    context->last.draw_calls += stats->draw_calls;
+    context->last.state_switches += stats->state_switches;
+    context->last.elided += stats->elided;
+    context->last.kernel_draws += stats->kernel_draws;
+    clear_draw_list(frame);
 }
 
 // Original draw_pause_screen function from main.c
-void draw_pause_screen(Game* game) {
-    al_draw_filled_rectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT,
-                           al_map_rgba(0, 0, 0, ALPHA_OVERLAY_MEDIUM));
-    
-    al_draw_text(game->title_font, COLOR_WHITE,
+void record_pause_screen(DrawList* list, Game* game, const RenderSnapshot* snap) {
+    // The level is frozen while paused, so render it once into a bitmap
+    // and reuse that on every redraw
+    if (!game->pause_frame_valid && game->pause_frame) {
+        ALLEGRO_BITMAP* target = al_get_target_bitmap();
+        al_set_target_bitmap(game->pause_frame);
+        record_playing_scene(list, game, snap);
+        submit_frame(game->draw_context, &snap->camera, NULL);
+        al_set_target_bitmap(target);
+        game->pause_frame_valid = true;
+    }
+    if (game->pause_frame_valid) {
+        record_bitmap(list, DRAW_LAYER_SKY, 0, game->pause_frame, 0, 0, 0, 0);
+    } else {
+        record_playing_scene(list, game, snap);
+    }
+
+    record_filled_rectangle(list, DRAW_LAYER_OVERLAY, SCREEN_DEPTH_BACKDROP, 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT,
+                            al_map_rgba(0, 0, 0, ALPHA_OVERLAY_MEDIUM));
+
+    record_text(list, DRAW_LAYER_OVERLAY, SCREEN_DEPTH_CONTENT, game->title_font, COLOR_WHITE,
                 SCREEN_WIDTH/2, SCREEN_HEIGHT/PAUSE_TITLE_Y_DIVISOR,
                 ALLEGRO_ALIGN_CENTRE, "PAUSED");
-    
-    al_draw_text(game->font, COLOR_LIGHT_GRAY,
+
+    record_text(list, DRAW_LAYER_OVERLAY, SCREEN_DEPTH_CONTENT, game->font, COLOR_LIGHT_GRAY,
                 SCREEN_WIDTH/2, SCREEN_HEIGHT/PAUSE_TEXT_Y_DIVISOR,
                 ALLEGRO_ALIGN_CENTRE, "Press ESC to resume");
-    al_draw_text(game->font, COLOR_LIGHT_GRAY,
+    record_text(list, DRAW_LAYER_OVERLAY, SCREEN_DEPTH_CONTENT, game->font, COLOR_LIGHT_GRAY,
                 SCREEN_WIDTH/2, SCREEN_HEIGHT/PAUSE_TEXT_Y_DIVISOR + PAUSE_TEXT_SPACING,
                 ALLEGRO_ALIGN_CENTRE, "Press M for Main Menu");
-    
-    al_flip_display();
+}
+
+static void record_game_over(DrawList* list, Game* game, const RenderSnapshot* snap) {
+    record_filled_rectangle(list, DRAW_LAYER_OVERLAY, SCREEN_DEPTH_BACKDROP, 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT,
+                            al_map_rgba(0, 0, 0, ALPHA_OVERLAY_DARK));
+    record_text(list, DRAW_LAYER_OVERLAY, SCREEN_DEPTH_CONTENT, game->title_font, COLOR_RED,
+                SCREEN_WIDTH/2, SCREEN_HEIGHT/GAMEOVER_TITLE_Y_DIVISOR, ALLEGRO_ALIGN_CENTRE, "GAME OVER");
+    char stars_text[64];
+    sprintf(stars_text, "Total Stars: %d/%d", snap->total_stars, MAX_STARS_PER_LEVEL * TOTAL_LEVELS);
+    record_text(list, DRAW_LAYER_OVERLAY, SCREEN_DEPTH_CONTENT, game->font, COLOR_WHITE,
+                SCREEN_WIDTH/2, SCREEN_HEIGHT/GAMEOVER_TEXT_Y_DIVISOR, ALLEGRO_ALIGN_CENTRE, stars_text);
+    record_text(list, DRAW_LAYER_OVERLAY, SCREEN_DEPTH_CONTENT, game->font, COLOR_LIGHT_GRAY,
+                SCREEN_WIDTH/2, SCREEN_HEIGHT/GAMEOVER_TEXT_Y_DIVISOR + GAMEOVER_TEXT_SPACING_1, ALLEGRO_ALIGN_CENTRE, "Press ENTER to return to menu");
+    record_text(list, DRAW_LAYER_OVERLAY, SCREEN_DEPTH_CONTENT, game->font, COLOR_LIGHT_GRAY,
+                SCREEN_WIDTH/2, SCREEN_HEIGHT/GAMEOVER_TEXT_Y_DIVISOR + GAMEOVER_TEXT_SPACING_2, ALLEGRO_ALIGN_CENTRE, "Press R to retry level");
+}
+
+static void record_level_complete(DrawList* list, Game* game, const RenderSnapshot* snap) {
+    record_filled_rectangle(list, DRAW_LAYER_OVERLAY, SCREEN_DEPTH_BACKDROP, 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT,
+                            al_map_rgba(0, 0, 100, ALPHA_OVERLAY_DARK));
+    record_text(list, DRAW_LAYER_OVERLAY, SCREEN_DEPTH_CONTENT, game->title_font, COLOR_WHITE,
+                SCREEN_WIDTH/2, SCREEN_HEIGHT/LEVELCOMPLETE_TITLE_Y_DIVISOR, ALLEGRO_ALIGN_CENTRE, "LEVEL COMPLETE!");
+
+    // Show current level stars and total stars
+    char level_stars_text[64];
+    // Use current level progress for the stars (not yet finalized)
+    int current_level_stars = snap->level_progress_stars;
+    sprintf(level_stars_text, "Level %s Stars Earned:", get_level_name(snap->current_level));
+    record_text(list, DRAW_LAYER_OVERLAY, SCREEN_DEPTH_CONTENT, game->font, COLOR_WHITE,
+                SCREEN_WIDTH/2, SCREEN_HEIGHT/LEVELCOMPLETE_TEXT_Y_DIVISOR + 60, ALLEGRO_ALIGN_CENTRE, level_stars_text);
+
+    // Draw visual stars for current level
+    record_end_screen_stars(list, DRAW_LAYER_OVERLAY, game, SCREEN_WIDTH/2, SCREEN_HEIGHT/LEVELCOMPLETE_TEXT_Y_DIVISOR + 100,
+                            current_level_stars, MAX_STARS_PER_LEVEL, snap->current_level);
+
+    // Check if there are more levels after current one
+    if (snap->current_level < TOTAL_LEVELS) {
+        record_text(list, DRAW_LAYER_OVERLAY, SCREEN_DEPTH_CONTENT, game->font, COLOR_LIGHT_GRAY,
+                    SCREEN_WIDTH/2, SCREEN_HEIGHT/LEVELCOMPLETE_TEXT_Y_DIVISOR + LEVELCOMPLETE_TEXT_SPACING_1 + 80, ALLEGRO_ALIGN_CENTRE, "Press N for Next Level");
+    } else {
+        record_text(list, DRAW_LAYER_OVERLAY, SCREEN_DEPTH_CONTENT, game->font, COLOR_LIGHT_GRAY,
+                    SCREEN_WIDTH/2, SCREEN_HEIGHT/LEVELCOMPLETE_TEXT_Y_DIVISOR + LEVELCOMPLETE_TEXT_SPACING_1 + 80, ALLEGRO_ALIGN_CENTRE, "Press N for Victory Screen");
+    }
+    record_text(list, DRAW_LAYER_OVERLAY, SCREEN_DEPTH_CONTENT, game->font, COLOR_LIGHT_GRAY,
+                SCREEN_WIDTH/2, SCREEN_HEIGHT/LEVELCOMPLETE_TEXT_Y_DIVISOR + LEVELCOMPLETE_TEXT_SPACING_2 + 80, ALLEGRO_ALIGN_CENTRE, "Press M for Main Menu");
+}
+
+static void record_victory(DrawList* list, Game* game, const RenderSnapshot* snap) {
+    record_filled_rectangle(list, DRAW_LAYER_OVERLAY, SCREEN_DEPTH_BACKDROP, 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT,
+                            al_map_rgba(255, 215, 0, ALPHA_OVERLAY_DARK)); // Gold-ish overlay
+    record_text(list, DRAW_LAYER_OVERLAY, SCREEN_DEPTH_CONTENT, game->title_font, COLOR_WHITE,
+                SCREEN_WIDTH/2, SCREEN_HEIGHT/VICTORY_TITLE_Y_DIVISOR, ALLEGRO_ALIGN_CENTRE, "VICTORY!");
+
+    // Show visual star breakdown by level
+    float level_display_y = SCREEN_HEIGHT/VICTORY_TEXT_Y_DIVISOR + 50;
+    float level_spacing = 80.0f;
+
+    for (int level = 0; level < TOTAL_LEVELS; level++) {
+        char level_text[32];
+        sprintf(level_text, "Level %d", level + 1);
+        record_text(list, DRAW_LAYER_OVERLAY, SCREEN_DEPTH_CONTENT, game->font, COLOR_WHITE,
+                    SCREEN_WIDTH/2, level_display_y + level * level_spacing, ALLEGRO_ALIGN_CENTRE, level_text);
+
+        // Draw visual stars for this level
+        record_end_screen_stars(list, DRAW_LAYER_OVERLAY, game, SCREEN_WIDTH/2, level_display_y + level * level_spacing + 35,
+                                snap->level_stars[level], MAX_STARS_PER_LEVEL, level + 1);
+    }
+
+    record_text(list, DRAW_LAYER_OVERLAY, SCREEN_DEPTH_CONTENT, game->font, al_map_rgb(220, 220, 220), // Slightly off-white for variety
+                SCREEN_WIDTH/2, level_display_y + TOTAL_LEVELS * level_spacing + 20, ALLEGRO_ALIGN_CENTRE, "Press ENTER to return to menu");
+}
+
+// Bitmap the frame is drawn into below 100% render scale, NULL at full size
+static ALLEGRO_BITMAP* get_scaled_target(DrawContext* context, int render_scale) {
+    if (render_scale <= 0 || render_scale >= 100) return NULL;
+    int width = SCREEN_WIDTH * render_scale / 100;
+    int height = SCREEN_HEIGHT * render_scale / 100;
+
+    ALLEGRO_BITMAP* target = context->scaled_target;
+    if (target && (al_get_bitmap_width(target) != width || al_get_bitmap_height(target) != height)) {
+        al_destroy_bitmap(target);
+        target = context->scaled_target = NULL;
+    }
+    if (!target) {
+        // Linear filtering makes the upscale a single filtered blit
+        int old_flags = al_get_new_bitmap_flags();
+        al_set_new_bitmap_flags(old_flags | ALLEGRO_MIN_LINEAR | ALLEGRO_MAG_LINEAR);
+        target = context->scaled_target = al_create_bitmap(width, height);
+        al_set_new_bitmap_flags(old_flags);
+        if (!target) {
+            fprintf(stderr, "Failed to create %dx%d render target, drawing at full size\n", width, height);
+        }
+    }
+    return target;
 }
 
 // Original draw_game function from main.c
-void draw_game(Game* game) {
-    switch (game->state) {
+void draw_game(Game* game, const RenderSnapshot* snap) {
+    DrawContext* context = game->draw_context;
+    DrawList* frame = &context->frame;
+
+    // The paused frame is captured again the next time the game is paused
+    if (snap->state != PAUSED) {
+        game->pause_frame_valid = false;
+    }
+    context->last = (DrawStats){ 0, 0, 0, 0, 0 };
+
+    double start = begin_draw_section();
+    switch (snap->state) {
         case WELCOME_SCREEN:
-            draw_welcome_screen(game);
+            record_welcome_screen(frame, game, snap);
             break;
         case MAIN_MENU:
-            draw_main_menu(game);
+            record_menu(frame, game, &snap->menu, "Main Menu");
             break;
         case LEVEL_SELECT:
-            draw_level_select(game);
+            record_menu(frame, game, &snap->menu, "Select Level");
             break;
         case SETTINGS:
-            draw_settings_menu(game);
+            record_menu(frame, game, &snap->menu, "Settings");
             break;
         case PAUSED:
-            draw_pause_screen(game);
+            record_pause_screen(frame, game, snap);
             break;
         case GAME_OVER:
-            al_draw_filled_rectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, al_map_rgba(0, 0, 0, ALPHA_OVERLAY_DARK));
-            al_draw_text(game->title_font, COLOR_RED,
-                        SCREEN_WIDTH/2, SCREEN_HEIGHT/GAMEOVER_TITLE_Y_DIVISOR, ALLEGRO_ALIGN_CENTRE, "GAME OVER");
-            char stars_text[64];
-            sprintf(stars_text, "Total Stars: %d/%d", game->total_stars, MAX_STARS_PER_LEVEL * TOTAL_LEVELS);
-            al_draw_text(game->font, COLOR_WHITE,
-                        SCREEN_WIDTH/2, SCREEN_HEIGHT/GAMEOVER_TEXT_Y_DIVISOR, ALLEGRO_ALIGN_CENTRE, stars_text);
-            al_draw_text(game->font, COLOR_LIGHT_GRAY,
-                        SCREEN_WIDTH/2, SCREEN_HEIGHT/GAMEOVER_TEXT_Y_DIVISOR + GAMEOVER_TEXT_SPACING_1, ALLEGRO_ALIGN_CENTRE, "Press ENTER to return to menu");
-            al_draw_text(game->font, COLOR_LIGHT_GRAY,
-                        SCREEN_WIDTH/2, SCREEN_HEIGHT/GAMEOVER_TEXT_Y_DIVISOR + GAMEOVER_TEXT_SPACING_2, ALLEGRO_ALIGN_CENTRE, "Press R to retry level");
-            al_flip_display();
+            record_game_over(frame, game, snap);
             break;
-        case LEVEL_COMPLETE: 
-            al_draw_filled_rectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, al_map_rgba(0, 0, 100, ALPHA_OVERLAY_DARK)); 
-            al_draw_text(game->title_font, COLOR_WHITE,
-                        SCREEN_WIDTH/2, SCREEN_HEIGHT/LEVELCOMPLETE_TITLE_Y_DIVISOR, ALLEGRO_ALIGN_CENTRE, "LEVEL COMPLETE!");
-            
-            // Show current level stars and total stars
-            char level_stars_text[64];
-            // Use current level progress for the stars (not yet finalized)
-            int current_level_stars = calculate_stars(&game->current_level_progress);
-            sprintf(level_stars_text, "Level %s Stars Earned:", get_level_name(game->current_level));
-            al_draw_text(game->font, COLOR_WHITE,
-                        SCREEN_WIDTH/2, SCREEN_HEIGHT/LEVELCOMPLETE_TEXT_Y_DIVISOR + 60, ALLEGRO_ALIGN_CENTRE, level_stars_text);
-            
-            // Draw visual stars for current level
-            draw_end_screen_stars(game, SCREEN_WIDTH/2, SCREEN_HEIGHT/LEVELCOMPLETE_TEXT_Y_DIVISOR + 100, current_level_stars, MAX_STARS_PER_LEVEL, game->current_level);
-            
-            // Check if there are more levels after current one
-            if (game->current_level < TOTAL_LEVELS) {
-                al_draw_text(game->font, COLOR_LIGHT_GRAY,
-                            SCREEN_WIDTH/2, SCREEN_HEIGHT/LEVELCOMPLETE_TEXT_Y_DIVISOR + LEVELCOMPLETE_TEXT_SPACING_1 + 80, ALLEGRO_ALIGN_CENTRE, "Press N for Next Level");
-            } else {
-                al_draw_text(game->font, COLOR_LIGHT_GRAY,
-                            SCREEN_WIDTH/2, SCREEN_HEIGHT/LEVELCOMPLETE_TEXT_Y_DIVISOR + LEVELCOMPLETE_TEXT_SPACING_1 + 80, ALLEGRO_ALIGN_CENTRE, "Press N for Victory Screen");
-            }
-            al_draw_text(game->font, COLOR_LIGHT_GRAY,
-                        SCREEN_WIDTH/2, SCREEN_HEIGHT/LEVELCOMPLETE_TEXT_Y_DIVISOR + LEVELCOMPLETE_TEXT_SPACING_2 + 80, ALLEGRO_ALIGN_CENTRE, "Press M for Main Menu");
-            al_flip_display();
+        case LEVEL_COMPLETE:
+            record_level_complete(frame, game, snap);
             break;
         case VICTORY:
-            al_draw_filled_rectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, al_map_rgba(255, 215, 0, ALPHA_OVERLAY_DARK)); // Gold-ish overlay
-            al_draw_text(game->title_font, COLOR_WHITE,
-                        SCREEN_WIDTH/2, SCREEN_HEIGHT/VICTORY_TITLE_Y_DIVISOR, ALLEGRO_ALIGN_CENTRE, "VICTORY!");
-            
-            // Show visual star breakdown by level
-            float level_display_y = SCREEN_HEIGHT/VICTORY_TEXT_Y_DIVISOR + 50;
-            float level_spacing = 80.0f;
-            
-            for (int level = 0; level < TOTAL_LEVELS; level++) {
-                char level_text[32];
-                sprintf(level_text, "Level %d", level + 1);
-                al_draw_text(game->font, COLOR_WHITE,
-                            SCREEN_WIDTH/2, level_display_y + level * level_spacing, ALLEGRO_ALIGN_CENTRE, level_text);
-                
-                // Draw visual stars for this level
-                draw_end_screen_stars(game, SCREEN_WIDTH/2, level_display_y + level * level_spacing + 35, 
-                                    game->level_stars[level].stars_earned, MAX_STARS_PER_LEVEL, level + 1);
-            }
-            
-            al_draw_text(game->font, al_map_rgb(220, 220, 220), // Slightly off-white for variety
-                        SCREEN_WIDTH/2, level_display_y + TOTAL_LEVELS * level_spacing + 20, ALLEGRO_ALIGN_CENTRE, "Press ENTER to return to menu");
-            al_flip_display();
+            record_victory(frame, game, snap);
             break;
         case PLAYING:
-            al_clear_to_color(COLOR_SKY_BLUE);
-            Level* current = game->current_level_data;
-            
-            // Apply screen shake offset to camera
-            float shake_offset_x = game->screen_shake.offset_x;
-            float shake_offset_y = game->screen_shake.offset_y;
-            
-            // Draw backgrounds - check if level has multi-backgrounds
-            if (current->num_backgrounds > 0 && current->backgrounds[0] != NULL) {
-                // Multi-background system for level ONE
-                for (int bg = 0; bg < current->num_backgrounds; bg++) {
-                    if (current->backgrounds[bg]) {
-                        float bg_start = current->background_positions[bg];
-                        float bg_end = (bg < current->num_backgrounds - 1) ? 
-                                      current->background_positions[bg + 1] : 
-                                      current->level_width;
-                        
-                        // Check if this background section is visible
-                        if (current->scroll_x < bg_end && current->scroll_x + SCREEN_WIDTH > bg_start) {
-                            float draw_x = bg_start - current->scroll_x + shake_offset_x;
-                            al_draw_bitmap(current->backgrounds[bg], draw_x, shake_offset_y, 0);
-                        }
-                    }
-                }
-            } else if (current->background) {
-                // Single background system for regular levels
-                al_draw_bitmap(current->background, -current->scroll_x + shake_offset_x, shake_offset_y, 0);
-            }
-            for (int i = 0; i < current->num_platforms; i++) {
-                Platform* p = &current->platforms[i];
-                float screen_x = p->x - current->scroll_x + shake_offset_x;
-                float screen_y = p->y + shake_offset_y;
-                if (screen_x + p->width >= 0 && screen_x <= SCREEN_WIDTH) {
-                    al_draw_filled_rectangle(screen_x, screen_y, screen_x + p->width, screen_y + p->height, p->color);
-                }
-            }
-            if (current->portal.is_active) {
-                float portal_screen_x = current->portal.x - current->scroll_x + shake_offset_x;
-                float portal_screen_y = current->portal.y + shake_offset_y;
-                if (portal_screen_x + current->portal.width >= 0 && portal_screen_x <= SCREEN_WIDTH) {
-                    al_draw_filled_rectangle(portal_screen_x, portal_screen_y,
-                        portal_screen_x + current->portal.width, portal_screen_y + current->portal.height,
-                        COLOR_PURPLE);
-                    al_draw_rectangle(portal_screen_x, portal_screen_y,
-                        portal_screen_x + current->portal.width, portal_screen_y + current->portal.height,
-                        COLOR_WHITE, PORTAL_BORDER_THICKNESS);
-                }
-            }
-            for (int i = 0; i < current->num_enemies; i++) {
-                Entity* e = &current->enemies[i];
-                if (!e->active) continue;
-                float screen_x = e->x - current->scroll_x + shake_offset_x;
-                float screen_y = e->y + shake_offset_y;
-                if (screen_x + e->width >= 0 && screen_x <= SCREEN_WIDTH) {
-                    ALLEGRO_COLOR enemy_color;
-                    switch (e->type) {
-                        case T_CELL: enemy_color = COLOR_YELLOW; break; // Bright Yellow
-                        case MACROPHAGE: enemy_color = al_map_rgb(200, 200, 0); break; // Darker Yellow
-                        case B_CELL: enemy_color = al_map_rgb(0, 200, 255); break; // Cyan/Light Blue
-                        case NK_CELL: enemy_color = COLOR_RED; break; // Bright Red
-                        default: enemy_color = COLOR_WHITE;
-                    }
-                    al_draw_filled_circle(screen_x + e->width/2, screen_y + e->height/2, e->width/2, enemy_color);
-                    if (e->health < e->max_health) {
-                        float health_percent = e->health / e->max_health;
-                        al_draw_filled_rectangle(screen_x, screen_y - ENEMY_HEALTH_BAR_OFFSET_Y, 
-                            screen_x + e->width * health_percent, screen_y - ENEMY_HEALTH_BAR_OFFSET_Y + ENEMY_HEALTH_BAR_HEIGHT,
-                            al_map_rgb((unsigned char)(255 * (1-health_percent)), (unsigned char)(255 * health_percent), 0)); // Green to Red gradient
-                    }
-                }
-            }
-
-            // Draw Projectiles
-            for (int i = 0; i < MAX_PROJECTILES; i++) {
-                Projectile* p = &current->projectiles[i];
-                if (!p->active) continue;
-                float screen_x = p->x - current->scroll_x + shake_offset_x;
-                float screen_y = p->y + shake_offset_y;
-                // Check if the projectile is on screen before drawing
-                if (screen_x + p->width >= 0 && screen_x <= SCREEN_WIDTH) {
-                    // Choose color based on source
-                    ALLEGRO_COLOR projectile_color;
-                    switch (p->source) {
-                        case T_CELL: 
-                        case MACROPHAGE: 
-                        case B_CELL: 
-                        case NK_CELL: 
-                            projectile_color = al_map_rgb(255, 100, 100); // Red-ish for enemy projectiles
-                            break;
-                        case CANCER_CELL: 
-                            projectile_color = al_map_rgb(0, 255, 255); // Cyan for player projectiles
-                            break;
-                        default: 
-                            projectile_color = COLOR_WHITE;
-                    }
-                    
-                    // Draw projectile as a small filled circle
-                    al_draw_filled_circle(screen_x + p->width/2, screen_y + p->height/2, p->width/2, projectile_color);
-                    
-                    // Add different border colors for better distinction
-                    ALLEGRO_COLOR border_color = (p->source == CANCER_CELL) ? al_map_rgb(255, 255, 255) : al_map_rgb(255, 0, 0);
-                    al_draw_circle(screen_x + p->width/2, screen_y + p->height/2, p->width/2, border_color, 1.5f);
-                }
-            }
-
-            // Draw Particles
-            for (int i = 0; i < MAX_PARTICLES; i++) {
-                Particle* p = &current->particles[i];
-                if (!p->active) continue;
-                float screen_x = p->x - current->scroll_x + shake_offset_x;
-                float screen_y = p->y + shake_offset_y;
-                // Check if the particle is on screen before drawing
-                if (screen_x >= -10 && screen_x <= SCREEN_WIDTH + 10) {
-                    // Draw particle as a small filled circle with fading alpha
-                    al_draw_filled_circle(screen_x, screen_y, 2.0f, p->color);
-                }
-            }
-
-            // Draw Glucose Items with pulsing effect
-            for (int i = 0; i < current->num_glucose_items; i++) {
-                GlucoseItem* g = &current->glucose_items[i];
-                if (!g->active) continue;
-                float screen_x = g->x - current->scroll_x + shake_offset_x;
-                float screen_y = g->y + shake_offset_y;
-                // Check if the glucose item is on screen before drawing
-                if (screen_x + g->width >= 0 && screen_x <= SCREEN_WIDTH) {
-                    // Create pulsing effect
-                    float pulse = (1 + sin(al_get_time() * 4)) * 0.3f + 0.7f; // Pulse between 0.7 and 1.0
-                    ALLEGRO_COLOR glucose_color = al_map_rgb(
-                        (unsigned char)(255 * pulse), 
-                        (unsigned char)(105 * pulse), 
-                        (unsigned char)(180 * pulse)
-                    );
-                    
-                    // Draw with slight size variation for pulsing effect
-                    float size_mod = pulse * 2.0f;
-                    al_draw_filled_rectangle(screen_x - size_mod, screen_y - size_mod, 
-                                             screen_x + g->width + size_mod, screen_y + g->height + size_mod, 
-                                             glucose_color);
-                    
-                    // Add a bright border for visibility
-                    al_draw_rectangle(screen_x - size_mod, screen_y - size_mod,
-                                     screen_x + g->width + size_mod, screen_y + g->height + size_mod,
-                                     COLOR_WHITE, 1.0f);
-                }
-            }
-
-            float player_screen_x = game->player.x - current->scroll_x + shake_offset_x;
-            float player_screen_y = game->player.y + shake_offset_y;
-            
-            // Draw attack range indicator when attacking
-            if (game->player.state == ATTACKING) {
-                al_draw_circle(player_screen_x + game->player.width/2, 
-                              player_screen_y + game->player.height/2,
-                              PLAYER_ATTACK_RANGE, COLOR_RED, 2.0f);
-            }
-            
-            // Draw shooting readiness indicator
-            if (game->player.last_shot <= 0) {
-                // Small green circle above player when ready to shoot
-                al_draw_filled_circle(player_screen_x + game->player.width/2, 
-                                    player_screen_y - 8, 3.0f, al_map_rgb(0, 255, 0));
-            } else {
-                // Red circle showing cooldown
-                float cooldown_ratio = (float)game->player.last_shot / PLAYER_PROJECTILE_COOLDOWN;
-                al_draw_filled_circle(player_screen_x + game->player.width/2, 
-                                    player_screen_y - 8, 3.0f * cooldown_ratio, al_map_rgb(255, 0, 0));
-            }
-            
-            // Draw combo indicator
-            if (game->player.combo_count > 0 && game->player.combo_timer > 0) {
-                // Combo chain indicator - growing glow around player
-                float combo_intensity = (float)game->player.combo_count / MAX_COMBO_COUNT;
-                ALLEGRO_COLOR combo_color = al_map_rgba(255, 255, 0, 
-                                                      (unsigned char)(100 + combo_intensity * 155));
-                
-                for (int j = 0; j < game->player.combo_count && j < 5; j++) {
-                    al_draw_circle(player_screen_x + game->player.width/2, 
-                                 player_screen_y + game->player.height/2,
-                                 game->player.width/2 + 5 + j * 3, combo_color, 2.0f);
-                }
-                
-                // Combo counter text
-                char combo_text[16];
-                sprintf(combo_text, "x%d COMBO", game->player.combo_count);
-                al_draw_text(game->font, al_map_rgb(255, 255, 0), 
-                           player_screen_x + game->player.width/2, 
-                           player_screen_y - 25, ALLEGRO_ALIGN_CENTER, combo_text);
-            }
-            
-            // Draw player with state-based coloring
-            ALLEGRO_COLOR player_color = COLOR_PINKISH_RED;
-            if (game->player.last_attack > 0 && ((int)game->player.last_attack % 6) < 3) {
-                // Invincibility flashing effect
-                player_color = al_map_rgb(255, 150, 150);
-            }
-            
-            al_draw_filled_circle(player_screen_x + game->player.width/2, 
-                                player_screen_y + game->player.height/2, 
-                                game->player.width/2, player_color);
-            // Player Health Bar
-            float health_percent = game->player.health / game->player.max_health;
-            al_draw_filled_rectangle(PLAYER_HUD_HEALTH_X, PLAYER_HUD_HEALTH_Y, 
-                                     PLAYER_HUD_HEALTH_X + PLAYER_HUD_HEALTH_WIDTH_MAX * health_percent, 
-                                     PLAYER_HUD_HEALTH_Y + PLAYER_HUD_HEALTH_HEIGHT,
-                                     al_map_rgb((unsigned char)(255 * (1-health_percent)), (unsigned char)(255 * health_percent), 0)); // Green to Red gradient
-            
-            // HUD Text (Level and Total Stars)
-            char level_text[64];
-            const char* current_level_name = get_level_name(game->current_level);
-            sprintf(level_text, "Level: %s  Total: %d/%d", 
-                   current_level_name, game->total_stars, MAX_STARS_PER_LEVEL * TOTAL_LEVELS);
-            al_draw_text(game->font, COLOR_WHITE, HUD_TEXT_X, HUD_TEXT_Y, ALLEGRO_ALIGN_LEFT, level_text);
-            
-            // Draw visual star display for current level progress (repositioned to top right)
-            int current_level_progress = calculate_stars(&game->current_level_progress);
-            draw_star_display(game, SCREEN_WIDTH - 100, 10, current_level_progress, MAX_STARS_PER_LEVEL);
-            
-            al_flip_display();
+            record_playing_scene(frame, game, snap);
             break;
         default:
             break;
     }
+    end_draw_section(DRAW_SECTION_RECORD, start);
+
+    // The overdraw view counts this frame's pixels and shows them instead
+    OverdrawMap* overdraw = &context->overdraw;
+    if (snap->show_overdraw && !overdraw->counts) {
+        init_overdraw_map(overdraw, SCREEN_WIDTH, SCREEN_HEIGHT);
+    }
+    bool show_overdraw = snap->show_overdraw && overdraw->counts;
+    if (show_overdraw) {
+        clear_overdraw_map(overdraw);
+        set_draw_overdraw(overdraw);
+    }
+
+    // Menus have no level camera; their screen layers still need the scale
+    Camera view;
+    if (snap->has_scene) {
+        view = snap->camera;
+    } else {
+        init_camera(&view, SCREEN_WIDTH, SCREEN_HEIGHT);
+    }
+
+    // Below 100% the whole frame goes into a smaller bitmap, with the
+    // camera scaling it down, and is stretched onto the target in one blit
+    ALLEGRO_BITMAP* target = al_get_target_bitmap();
+    ALLEGRO_BITMAP* scaled = get_scaled_target(context, snap->render_scale);
+    if (scaled) {
+        view.scale = (float)al_get_bitmap_width(scaled) / SCREEN_WIDTH;
+        al_set_target_bitmap(scaled);
+    }
+    submit_frame(context, &view, snap->state == PLAYING ? snap->level : NULL);
+    if (scaled) {
+        al_set_target_bitmap(target);
+        double upscale_start = begin_draw_section();
+        al_draw_scaled_bitmap(scaled, 0, 0, al_get_bitmap_width(scaled), al_get_bitmap_height(scaled),
+                              0, 0, al_get_bitmap_width(target), al_get_bitmap_height(target), 0);
+        end_draw_section(DRAW_SECTION_UPSCALE, upscale_start);
+        context->last.draw_calls++;
+    }
+    if (show_overdraw) {
+        set_draw_overdraw(NULL);
+        draw_overdraw_heatmap(overdraw);
+        al_draw_textf(game->font, COLOR_WHITE, HUD_TEXT_X, SCREEN_HEIGHT - 40, ALLEGRO_ALIGN_LEFT,
+                      "Overdraw avg %.2f, max %d, %d commands elided",
+                      get_average_overdraw(overdraw), overdraw->max, context->last.elided);
+    }
+    present_frame(game);
+
+    // Per-frame counters
+    context->frames++;
+    context->total.commands += context->last.commands;
+    context->total.draw_calls += context->last.draw_calls;
+    context->total.state_switches += context->last.state_switches;
+    context->total.elided += context->last.elided;
+    context->total.kernel_draws += context->last.kernel_draws;
+    if (context->last.draw_calls > context->peak.draw_calls) context->peak.draw_calls = context->last.draw_calls;
+    if (context->last.state_switches > context->peak.state_switches) context->peak.state_switches = context->last.state_switches;
+    if (context->last.commands > context->peak.commands) context->peak.commands = context->last.commands;
+}
+
+bool init_drawing(Game* game, int record_threads) {
+    DrawContext* context = calloc(1, sizeof(DrawContext));
+    if (!context) {
+        fprintf(stderr, "Failed to allocate draw context!\n");
+        return false;
+    }
+    init_draw_list(&context->frame);
+    init_scroll_cache(&context->scroll_cache);
+    init_task_graph(&context->record_graph);
+    for (int i = 0; i < SCENE_PART_COUNT; i++) {
+        init_draw_list(&context->parts[i]);
+        context->tasks[i].context = context;
+        context->tasks[i].part = i;
+        add_task(&context->record_graph, scene_part_names[i], record_scene_part, &context->tasks[i]);
+    }
+    add_task(&context->record_graph, "decode tiles", decode_scene_tiles, context);
+    init_job_system(&context->jobs, record_threads);
+    game->draw_context = context;
+    return true;
+}
+
+void cleanup_drawing(Game* game) {
+    DrawContext* context = game->draw_context;
+    if (!context) return;
+
+    if (context->frames > 0) {
+        printf("Draw lists: %u frames, per frame avg %.1f commands, %.1f draw calls, %.1f state switches "
+               "(peak %d, %d, %d), %.1f commands elided, %.1f kernel draws\n", context->frames,
+               (double)context->total.commands / context->frames,
+               (double)context->total.draw_calls / context->frames,
+               (double)context->total.state_switches / context->frames,
+               context->peak.commands, context->peak.draw_calls, context->peak.state_switches,
+               (double)context->total.elided / context->frames,
+               (double)context->total.kernel_draws / context->frames);
+    }
+    report_task_graph(&context->jobs, &context->record_graph);
+    cleanup_job_system(&context->jobs);
+    report_scroll_cache(&context->scroll_cache);
+    destroy_scroll_cache(&context->scroll_cache);
+    free_overdraw_map(&context->overdraw);
+    if (context->scaled_target) al_destroy_bitmap(context->scaled_target);
+    free_draw_list(&context->frame);
+    for (int i = 0; i < SCENE_PART_COUNT; i++) {
+        free_draw_list(&context->parts[i]);
+    }
+    free(context);
+    game->draw_context = NULL;
 }
 
 // Visual star display function
-void draw_star_display(Game* game, float x, float y, int stars_earned, int max_stars) {
+void record_star_display(DrawList* list, DrawLayer layer, Game* game, float x, float y,
+                         int stars_earned, int max_stars, int level) {
     if (!game) return;
-    
+
     float star_size = 24.0f; // Size of each star
     float star_spacing = 28.0f; // Spacing between stars
-    
+
     // Use current level's star sprites (convert to 0-based index)
-    int level_index = game->current_level - 1;
+    int level_index = level - 1;
     if (level_index < 0 || level_index >= 3) level_index = 0; // Fallback to level 1 sprites
-    
+
     for (int i = 0; i < max_stars && i < 3; i++) {
         float star_x = x + i * star_spacing;
         float star_y = y;
-        
+
         // Use the same level sprite for all stars in that level
         ALLEGRO_BITMAP* star_bitmap = NULL;
         if (i < stars_earned) {
@@ -427,45 +702,41 @@ void draw_star_display(Game* game, float x, float y, int stars_earned, int max_s
             // Star not earned - use empty sprite for this level
             star_bitmap = game->star_empty[level_index];
         }
-        
+
         if (star_bitmap) {
             // Scale the bitmap to our desired size
-            al_draw_scaled_bitmap(star_bitmap,
-                0, 0, // source start (top-left of image)
-                al_get_bitmap_width(star_bitmap), // original width
-                al_get_bitmap_height(star_bitmap), // original height
-                star_x, star_y, // destination position on screen
-                star_size, star_size, // scaled width and height
-                0 // no special flags
-            );
+            record_bitmap(list, layer, SCREEN_DEPTH_CONTENT, star_bitmap, star_x, star_y, star_size, star_size);
         } else {
             // Fallback to drawing simple colored circles if bitmaps failed to load
             ALLEGRO_COLOR star_color = (i < stars_earned) ? COLOR_YELLOW : COLOR_GRAY;
-            al_draw_filled_circle(star_x + star_size/2, star_y + star_size/2, star_size/2 - 2, star_color);
-            al_draw_circle(star_x + star_size/2, star_y + star_size/2, star_size/2 - 2, COLOR_WHITE, 1.0f);
+            record_filled_circle(list, layer, SCREEN_DEPTH_CONTENT,
+                                 star_x + star_size/2, star_y + star_size/2, star_size/2 - 2, star_color);
+            record_circle(list, layer, SCREEN_DEPTH_OUTLINES,
+                          star_x + star_size/2, star_y + star_size/2, star_size/2 - 2, COLOR_WHITE, 1.0f);
         }
     }
 }
 
 // Visual star display function for end screens (centered)
-void draw_end_screen_stars(Game* game, float center_x, float center_y, int stars_earned, int max_stars, int level) {
+void record_end_screen_stars(DrawList* list, DrawLayer layer, Game* game, float center_x, float center_y,
+                             int stars_earned, int max_stars, int level) {
     if (!game) return;
-    
+
     float star_size = 32.0f; // Larger stars for end screens
     float star_spacing = 40.0f; // More spacing between stars
-    
+
     // Calculate starting position to center the stars
     float total_width = (max_stars - 1) * star_spacing + star_size;
     float start_x = center_x - total_width / 2.0f;
-    
+
     // Use specified level's star sprites (convert to 0-based index)
     int level_index = level - 1;
     if (level_index < 0 || level_index >= 3) level_index = 0; // Fallback to level 1 sprites
-    
+
     for (int i = 0; i < max_stars && i < 3; i++) {
         float star_x = start_x + i * star_spacing;
         float star_y = center_y - star_size / 2.0f;
-        
+
         // Use the same level sprite for all stars in that level
         ALLEGRO_BITMAP* star_bitmap = NULL;
         if (i < stars_earned) {
@@ -475,22 +746,17 @@ void draw_end_screen_stars(Game* game, float center_x, float center_y, int stars
             // Star not earned - use empty sprite for this level
             star_bitmap = game->star_empty[level_index];
         }
-        
+
         if (star_bitmap) {
             // Scale the bitmap to our desired size
-            al_draw_scaled_bitmap(star_bitmap,
-                0, 0, // source start (top-left of image)
-                al_get_bitmap_width(star_bitmap), // original width
-                al_get_bitmap_height(star_bitmap), // original height
-                star_x, star_y, // destination position on screen
-                star_size, star_size, // scaled width and height
-                0 // no special flags
-            );
+            record_bitmap(list, layer, SCREEN_DEPTH_CONTENT, star_bitmap, star_x, star_y, star_size, star_size);
         } else {
             // Fallback to drawing simple colored circles if bitmaps failed to load
             ALLEGRO_COLOR star_color = (i < stars_earned) ? COLOR_YELLOW : COLOR_GRAY;
-            al_draw_filled_circle(star_x + star_size/2, star_y + star_size/2, star_size/2 - 2, star_color);
-            al_draw_circle(star_x + star_size/2, star_y + star_size/2, star_size/2 - 2, COLOR_WHITE, 1.0f);
+            record_filled_circle(list, layer, SCREEN_DEPTH_CONTENT,
+                                 star_x + star_size/2, star_y + star_size/2, star_size/2 - 2, star_color);
+            record_circle(list, layer, SCREEN_DEPTH_OUTLINES,
+                          star_x + star_size/2, star_y + star_size/2, star_size/2 - 2, COLOR_WHITE, 1.0f);
         }
     }
 }
@@ -0,0 +1,270 @@
+#include "../include/enemy_batch.h"
+#include <math.h>    // For sqrtf
+#include <stdio.h>   // For fprintf
+#include <string.h>  // For memset
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BATCH_WIDTH 8
+typedef __m256 vfloat;
+#define vload(p) _mm256_loadu_ps(p)
+#define vstore(p, v) _mm256_storeu_ps(p, v)
+#define vset(f) _mm256_set1_ps(f)
+#define vadd(a, b) _mm256_add_ps(a, b)
+#define vsub(a, b) _mm256_sub_ps(a, b)
+#define vmul(a, b) _mm256_mul_ps(a, b)
+#define vdiv(a, b) _mm256_div_ps(a, b)
+#define vsqrt(a) _mm256_sqrt_ps(a)
+#define vand(a, b) _mm256_and_ps(a, b)
+#define vor(a, b) _mm256_or_ps(a, b)
+#define vgt(a, b) _mm256_cmp_ps(a, b, _CMP_GT_OQ)
+#define vlt(a, b) _mm256_cmp_ps(a, b, _CMP_LT_OQ)
+#define vle(a, b) _mm256_cmp_ps(a, b, _CMP_LE_OQ)
+#define vge(a, b) _mm256_cmp_ps(a, b, _CMP_GE_OQ)
+#define vselect(mask, a, b) _mm256_blendv_ps(b, a, mask)
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define BATCH_WIDTH 4
+typedef __m128 vfloat;
+#define vload(p) _mm_loadu_ps(p)
+#define vstore(p, v) _mm_storeu_ps(p, v)
+#define vset(f) _mm_set1_ps(f)
+#define vadd(a, b) _mm_add_ps(a, b)
+#define vsub(a, b) _mm_sub_ps(a, b)
+#define vmul(a, b) _mm_mul_ps(a, b)
+#define vdiv(a, b) _mm_div_ps(a, b)
+#define vsqrt(a) _mm_sqrt_ps(a)
+#define vand(a, b) _mm_and_ps(a, b)
+#define vor(a, b) _mm_or_ps(a, b)
+#define vgt(a, b) _mm_cmpgt_ps(a, b)
+#define vlt(a, b) _mm_cmplt_ps(a, b)
+#define vle(a, b) _mm_cmple_ps(a, b)
+#define vge(a, b) _mm_cmpge_ps(a, b)
+#define vselect(mask, a, b) _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b))
+#endif
+
+bool init_enemy_batches(EnemyBatches* batches, Arena* arena, int capacity) {
+    memset(batches, 0, sizeof(*batches));
+    batches->order = arena_alloc(arena, sizeof(Entity*) * capacity);
+    batches->lanes = arena_alloc(arena, sizeof(Entity*) * capacity);
+    batches->pending = arena_alloc(arena, sizeof(Entity*) * capacity);
+    float** lanes[] = { &batches->x, &batches->y, &batches->width, &batches->dx, &batches->dy, &batches->flags };
+    bool ok = batches->order && batches->lanes && batches->pending;
+    for (size_t i = 0; i < sizeof(lanes) / sizeof(lanes[0]); i++) {
+        *lanes[i] = arena_alloc(arena, sizeof(float) * capacity);
+        ok = ok && *lanes[i];
+    }
+    if (!ok) {
+        fprintf(stderr, "Failed to allocate enemy batches for %d enemies\n", capacity);
+        memset(batches, 0, sizeof(*batches));
+        return false;
+    }
+    batches->capacity = capacity;
+    return true;
+}
+
+void clear_enemy_batches(EnemyBatches* batches) {
+    memset(batches->start, 0, sizeof(batches->start));
+    batches->num_pending = 0;
+    batches->pending_overflow = false;
+    batches->moves = 0;
+}
+
+static int batch_of(const EnemyBatches* batches, int index) {
+    int behavior = 0;
+    while (index >= batches->start[behavior + 1]) behavior++;
+    return behavior;
+}
+
+static void place(EnemyBatches* batches, Entity* enemy, int index) {
+    batches->order[index] = enemy;
+    enemy->batch_index = index;
+}
+
+// Walk the enemy at 'index' from batch 'from' to batch 'to' by swapping it
+// across the edge of every batch in between
+static void move_batched(EnemyBatches* batches, int index, int from, int to) {
+    Entity* enemy = batches->order[index];
+    for (int b = from; b < to; b++) {
+        int last = batches->start[b + 1] - 1;
+        place(batches, batches->order[last], index);
+        place(batches, enemy, last);
+        index = last;
+        batches->start[b + 1]--;
+    }
+    for (int b = from; b > to; b--) {
+        int first = batches->start[b];
+        place(batches, batches->order[first], index);
+        place(batches, enemy, first);
+        index = first;
+        batches->start[b]++;
+    }
+}
+
+bool add_batched_enemy(EnemyBatches* batches, Entity* enemy) {
+    int end = batches->start[BEHAVIOR_COUNT];
+    if (end >= batches->capacity) return false;
+    // Joins the last batch, then walks to its own
+    place(batches, enemy, end);
+    batches->start[BEHAVIOR_COUNT]++;
+    move_batched(batches, end, BEHAVIOR_COUNT - 1, enemy->behavior);
+    return true;
+}
+
+void remove_batched_enemy(EnemyBatches* batches, Entity* enemy) {
+    int index = enemy->batch_index;
+    if (index < 0 || index >= batches->start[BEHAVIOR_COUNT] || batches->order[index] != enemy) return;
+    move_batched(batches, index, batch_of(batches, index), BEHAVIOR_COUNT - 1);
+    // Now somewhere in the last batch; swap it with the final entry and drop it
+    int end = --batches->start[BEHAVIOR_COUNT];
+    if (enemy->batch_index != end) place(batches, batches->order[end], enemy->batch_index);
+    enemy->batch_index = -1;
+}
+
+void set_enemy_behavior(EnemyBatches* batches, Entity* enemy, EntityBehavior behavior) {
+    if (enemy->behavior == behavior) return;
+    enemy->behavior = behavior;
+    if (batches->num_pending < batches->capacity) {
+        batches->pending[batches->num_pending++] = enemy;
+    } else {
+        batches->pending_overflow = true;
+    }
+}
+
+// Move the filed enemy to its behavior's batch; false if it is already
+// there or was removed since it was queued
+static bool rebucket_enemy(EnemyBatches* batches, Entity* enemy) {
+    int index = enemy->batch_index;
+    if (index < 0 || index >= batches->start[BEHAVIOR_COUNT] || batches->order[index] != enemy) return false;
+    int from = batch_of(batches, index);
+    if (from == (int)enemy->behavior) return false;
+    move_batched(batches, index, from, enemy->behavior);
+    return true;
+}
+
+void rebucket_enemies(EnemyBatches* batches) {
+    int moved = 0;
+    if (batches->pending_overflow) {
+        // Collected first, since moving an enemy reorders the batches
+        int count = 0;
+        for (int b = 0; b < BEHAVIOR_COUNT; b++) {
+            for (int i = batches->start[b]; i < batches->start[b + 1]; i++) {
+                if ((int)batches->order[i]->behavior != b) batches->pending[count++] = batches->order[i];
+            }
+        }
+        batches->num_pending = count;
+    }
+    for (int i = 0; i < batches->num_pending; i++) {
+        if (rebucket_enemy(batches, batches->pending[i])) moved++;
+    }
+    batches->num_pending = 0;
+    batches->pending_overflow = false;
+    batches->moves = moved;
+}
+
+int gather_batch(EnemyBatches* batches, EntityBehavior behavior) {
+    int count = 0;
+    for (int i = batches->start[behavior]; i < batches->start[behavior + 1]; i++) {
+        Entity* enemy = batches->order[i];
+        // The physics step carries knocked back enemies
+        if (!enemy->active || enemy->knockback_timer > 0) continue;
+        batches->lanes[count] = enemy;
+        batches->x[count] = enemy->x;
+        batches->y[count] = enemy->y;
+        batches->width[count] = enemy->width;
+        batches->dx[count] = enemy->dx;
+        batches->dy[count] = enemy->dy;
+        batches->flags[count] = 0.0f;
+        count++;
+    }
+    return count;
+}
+
+// The vector loops below handle whole groups of BATCH_WIDTH lanes and the
+// scalar loops the rest, with the same single precision operations
+
+void chase_kernel(EnemyBatches* batches, int count, float px, float py) {
+    int i = 0;
+#ifdef BATCH_WIDTH
+    vfloat player_x = vset(px), player_y = vset(py), zero = vset(0.0f), one = vset(1.0f);
+    vfloat speed = vset(ENEMY_CHASE_SPEED), range = vset(ENEMY_CHASE_BREAK_RANGE);
+    for (; i + BATCH_WIDTH <= count; i += BATCH_WIDTH) {
+        vfloat to_x = vsub(player_x, vload(batches->x + i));
+        vfloat to_y = vsub(player_y, vload(batches->y + i));
+        vfloat distance = vsqrt(vadd(vmul(to_x, to_x), vmul(to_y, to_y)));
+        vfloat moving = vgt(distance, zero);
+        vstore(batches->dx + i, vselect(moving, vmul(vdiv(to_x, distance), speed), vload(batches->dx + i)));
+        vstore(batches->dy + i, vselect(moving, vmul(vdiv(to_y, distance), speed), vload(batches->dy + i)));
+        vstore(batches->flags + i, vand(vgt(distance, range), one));
+    }
+#endif
+    for (; i < count; i++) {
+        float to_x = px - batches->x[i];
+        float to_y = py - batches->y[i];
+        float distance = sqrtf(to_x * to_x + to_y * to_y);
+        if (distance > 0.0f) {
+            batches->dx[i] = (to_x / distance) * ENEMY_CHASE_SPEED;
+            batches->dy[i] = (to_y / distance) * ENEMY_CHASE_SPEED;
+        }
+        batches->flags[i] = distance > ENEMY_CHASE_BREAK_RANGE;
+    }
+}
+
+void patrol_kernel(EnemyBatches* batches, int count, float px, float py, float level_width) {
+    int i = 0;
+#ifdef BATCH_WIDTH
+    vfloat player_x = vset(px), player_y = vset(py), zero = vset(0.0f), one = vset(1.0f);
+    vfloat flip = vset(-1.0f), right_edge = vset(level_width), range = vset(ENEMY_PATROL_DETECT_RANGE);
+    for (; i + BATCH_WIDTH <= count; i += BATCH_WIDTH) {
+        vfloat x = vload(batches->x + i);
+        vfloat dx = vload(batches->dx + i);
+        vfloat next = vadd(x, dx);
+        vfloat at_edge = vor(vand(vle(next, zero), vlt(dx, zero)),
+                             vand(vge(vadd(next, vload(batches->width + i)), right_edge), vgt(dx, zero)));
+        vstore(batches->dx + i, vselect(at_edge, vmul(dx, flip), dx));
+        vfloat to_x = vsub(player_x, x);
+        vfloat to_y = vsub(player_y, vload(batches->y + i));
+        vfloat distance = vsqrt(vadd(vmul(to_x, to_x), vmul(to_y, to_y)));
+        vstore(batches->flags + i, vand(vlt(distance, range), one));
+    }
+#endif
+    for (; i < count; i++) {
+        float x = batches->x[i];
+        float dx = batches->dx[i];
+        float next = x + dx;
+        if ((next <= 0.0f && dx < 0.0f) || (next + batches->width[i] >= level_width && dx > 0.0f)) {
+            batches->dx[i] = -dx;
+        }
+        float to_x = px - x;
+        float to_y = py - batches->y[i];
+        float distance = sqrtf(to_x * to_x + to_y * to_y);
+        batches->flags[i] = distance < ENEMY_PATROL_DETECT_RANGE;
+    }
+}
+
+void retreat_kernel(EnemyBatches* batches, int count, float px, float py) {
+    int i = 0;
+#ifdef BATCH_WIDTH
+    vfloat player_x = vset(px), player_y = vset(py), zero = vset(0.0f), one = vset(1.0f);
+    vfloat speed = vset(-ENEMY_CHASE_SPEED);
+    for (; i + BATCH_WIDTH <= count; i += BATCH_WIDTH) {
+        vfloat to_x = vsub(player_x, vload(batches->x + i));
+        vfloat to_y = vsub(player_y, vload(batches->y + i));
+        vfloat distance = vsqrt(vadd(vmul(to_x, to_x), vmul(to_y, to_y)));
+        vfloat moving = vgt(distance, zero);
+        vstore(batches->dx + i, vselect(moving, vmul(vdiv(to_x, distance), speed), vload(batches->dx + i)));
+        vstore(batches->dy + i, vselect(moving, vmul(vdiv(to_y, distance), speed), vload(batches->dy + i)));
+        vstore(batches->flags + i, vand(moving, one));
+    }
+#endif
+    for (; i < count; i++) {
+        float to_x = px - batches->x[i];
+        float to_y = py - batches->y[i];
+        float distance = sqrtf(to_x * to_x + to_y * to_y);
+        if (distance > 0.0f) {
+            batches->dx[i] = (to_x / distance) * -ENEMY_CHASE_SPEED;
+            batches->dy[i] = (to_y / distance) * -ENEMY_CHASE_SPEED;
+        }
+        batches->flags[i] = distance > 0.0f;
+    }
+}
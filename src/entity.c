@@ -1,247 +1,270 @@
 #include "../include/entity.h"
 #include "../include/game.h" // For Game, Level, Platform, Entity types
+#include "../include/bullet_pattern.h" // For fire_bullet_pattern
+#include "../include/physics.h" // For move_body, bodies_interact
+#include "../include/enemy_batch.h" // For gather_batch and the behavior kernels
 #include <math.h> // For sqrt
 #include <stdio.h> // For printf in case of debugging, can be removed later
 
-// Original update_enemy function from main.c
-void update_enemy(Entity* enemy, Game* game) {
-    // Handle knockback effects first
-    if (enemy->knockback_timer > 0) {
-        enemy->x += enemy->knockback_dx;
-        enemy->y += enemy->knockback_dy;
-        enemy->knockback_timer--;
-        
-        // Reduce knockback force over time
-        enemy->knockback_dx *= 0.8f;
-        enemy->knockback_dy *= 0.8f;
-        
-        if (enemy->knockback_timer <= 0) {
-            enemy->knockback_dx = 0.0f;
-            enemy->knockback_dy = 0.0f;
-        }
-        return; // Don't process normal AI while being knocked back
-    }
-    
-    // Update combo timer
+// Enemies are updated one behavior at a time (see enemy_batch.h). Each
+// batch runs only the code of its behavior; behavior changes go through
+// set_enemy_behavior and take effect in rebucket_enemies once every batch
+// has run.
+
+static void tick_combo_timer(Entity* enemy) {
     if (enemy->combo_timer > 0) {
         enemy->combo_timer--;
         if (enemy->combo_timer <= 0) {
             enemy->combo_count = 0;
         }
     }
+}
+
+static void update_patrol_batch(Game* game, EnemyBatches* batches, int count) {
+    // Turn around at walls, which stopped the last move
+    for (int i = 0; i < count; i++) {
+        Entity* enemy = batches->lanes[i];
+        if (enemy->body.contacts & PHYS_CONTACT_WALL_LEFT) {
+            enemy->dx = ENEMY_PATROL_SPEED;
+        } else if (enemy->body.contacts & PHYS_CONTACT_WALL_RIGHT) {
+            enemy->dx = -ENEMY_PATROL_SPEED;
+        }
+        batches->dx[i] = enemy->dx;
+    }
+    patrol_kernel(batches, count, game->player.x, game->player.y, game->current_level_data->level_width);
+    for (int i = 0; i < count; i++) {
+        Entity* enemy = batches->lanes[i];
+        enemy->dx = batches->dx[i];
+        move_body(enemy, enemy->dx, 0.0f);
+        if (batches->flags[i]) set_enemy_behavior(batches, enemy, BEHAVIOR_CHASE);
+    }
+}
+
+static void update_chase_batch(Game* game, EnemyBatches* batches, int count) {
+    chase_kernel(batches, count, game->player.x, game->player.y);
+    for (int i = 0; i < count; i++) {
+        Entity* enemy = batches->lanes[i];
+        enemy->dx = batches->dx[i];
+        enemy->dy = batches->dy[i];
+        move_body(enemy, enemy->dx, enemy->dy);
+        if (batches->flags[i]) {
+            set_enemy_behavior(batches, enemy, BEHAVIOR_PATROL);
+            enemy->dy = 0;
+            enemy->dx = (enemy->dx > 0) ? ENEMY_PATROL_SPEED : -ENEMY_PATROL_SPEED;
+        }
+    }
+}
+
+// Move away from the player
+static void update_retreat_batch(Game* game, EnemyBatches* batches, int count) {
+    retreat_kernel(batches, count, game->player.x, game->player.y);
+    for (int i = 0; i < count; i++) {
+        if (!batches->flags[i]) continue;
+        Entity* enemy = batches->lanes[i];
+        enemy->dx = batches->dx[i];
+        enemy->dy = batches->dy[i];
+        move_body(enemy, enemy->dx, enemy->dy);
+    }
+}
+
+static void update_shoot_enemy(Game* game, Entity* enemy) {
+    // Stationary shooting enemy - aims and shoots at player
+    float dx_shoot = game->player.x - enemy->x;
+    float dy_shoot = game->player.y - enemy->y;
+    float distance_to_player = sqrt(dx_shoot * dx_shoot + dy_shoot * dy_shoot);
     
-    switch (enemy->behavior) {
-        case BEHAVIOR_PATROL:
-            enemy->x += enemy->dx;
-            if (enemy->x <= 0 || enemy->x + enemy->width >= game->current_level_data->level_width) {
-                 enemy->dx *= -1;
+    if (distance_to_player <= ENEMY_SHOOT_RANGE) {
+        // Face the player
+        enemy->dx = (dx_shoot > 0) ? 1.0f : -1.0f;
+        
+        // Shoot if cooldown is ready
+        if (enemy->last_attack <= 0) {
+            // Create a projectile aimed at the player
+            create_projectile(game->current_level_data, 
+                            enemy->x + enemy->width/2, 
+                            enemy->y + enemy->height/2,
+                            game->player.x + game->player.width/2, 
+                            game->player.y + game->player.height/2,
+                            enemy->type);
+            enemy->last_attack = ENEMY_SHOOT_COOLDOWN;
+            
+            // Play enemy shooting sound if enabled
+            if (game->settings.sound_enabled && game->shoot_sound) {
+                al_play_sample(game->shoot_sound, 0.4, 0.0, 1.2, ALLEGRO_PLAYMODE_ONCE, NULL);
             }
+        }
+    } else {
+        // Move slowly towards player if out of range
+        if (distance_to_player > 0) {
+            enemy->dx = (dx_shoot / distance_to_player) * 1.0f; // Slower than chase
+            move_body(enemy, enemy->dx, 0.0f);
+        }
+    }
+    
+    // Decrease shoot cooldown
+    if (enemy->last_attack > 0) {
+        enemy->last_attack--;
+    }
+}
+
+static void update_boss_enemy(Game* game, Entity* enemy) {
+    // Complex boss behavior with multiple phases and special abilities
+    float dx_boss = game->player.x - enemy->x;
+    float dy_boss = game->player.y - enemy->y;
+    float distance_to_player = sqrt(dx_boss * dx_boss + dy_boss * dy_boss);
+    float health_percentage = enemy->health / enemy->max_health;
+    
+    if (health_percentage > ENEMY_BOSS_PHASE_HEALTH) {
+        // Phase 1: Aggressive chase with occasional pauses and special attacks
+        if (enemy->phase_timer <= 0) {
+            // Chase phase with enhanced speed
+            if (distance_to_player > 0) {
+                enemy->dx = (dx_boss / distance_to_player) * (ENEMY_CHASE_SPEED + 2.0f);
+                enemy->dy = (dy_boss / distance_to_player) * (ENEMY_CHASE_SPEED + 2.0f);
+            }
+            move_body(enemy, enemy->dx, enemy->dy);
             
-            float dx_patrol = game->player.x - enemy->x;
-            float dy_patrol = game->player.y - enemy->y;
-            float detect_distance_patrol = sqrt(dx_patrol * dx_patrol + dy_patrol * dy_patrol);
+            enemy->phase_timer = 90; // Chase for 1.5 seconds
+        } else if (enemy->phase_timer <= 45) {
+            // Brief pause while the area attack plays out
+            enemy->dx = 0;
+            enemy->dy = 0;
             
-            if (detect_distance_patrol < ENEMY_PATROL_DETECT_RANGE) { // Detection range
-                enemy->behavior = BEHAVIOR_CHASE;
+            int loud = fire_bullet_pattern(game->current_level_data, PATTERN_BOSS_PAUSE,
+                                           45 - enemy->phase_timer,
+                                           enemy->x + enemy->width/2, enemy->y + enemy->height/2,
+                                           game->player.x + game->player.width/2,
+                                           game->player.y + game->player.height/2,
+                                           enemy->type);
+            if (loud > 0 && game->settings.sound_enabled && game->shoot_sound) {
+                al_play_sample(game->shoot_sound, 0.8, 0.0, 0.8, ALLEGRO_PLAYMODE_ONCE, NULL);
             }
-            break;
+        }
+    } else {
+        // Phase 2: Desperate behavior - enhanced abilities and faster movement
+        if (distance_to_player > 120.0f) {
+            // Very fast approach with prediction
+            float pred_x, pred_y;
+            predict_player_movement(game, 30, &pred_x, &pred_y);
             
-        case BEHAVIOR_CHASE:
-            {
-                float dx_chase = game->player.x - enemy->x;
-                float dy_chase = game->player.y - enemy->y;
-                float distance = sqrt(dx_chase * dx_chase + dy_chase * dy_chase);
-                
-                if (distance > 0) {
-                    enemy->dx = (dx_chase / distance) * ENEMY_CHASE_SPEED; // Chase speed
-                    enemy->dy = (dy_chase / distance) * ENEMY_CHASE_SPEED;
-                }
-                
-                enemy->x += enemy->dx;
-                enemy->y += enemy->dy;
-            }
+            float pred_dx = pred_x - enemy->x;
+            float pred_dy = pred_y - enemy->y;
+            float pred_distance = sqrt(pred_dx * pred_dx + pred_dy * pred_dy);
             
-            float dx_return = game->player.x - enemy->x;
-            float dy_return = game->player.y - enemy->y;
-            float current_detect_distance = sqrt(dx_return*dx_return + dy_return*dy_return);
-
-            if (current_detect_distance > ENEMY_CHASE_BREAK_RANGE) {
-                enemy->behavior = BEHAVIOR_PATROL;
-                enemy->dy = 0; 
-                enemy->dx = (enemy->dx > 0) ? ENEMY_PATROL_SPEED : -ENEMY_PATROL_SPEED; 
-            }
-            break;
-        case BEHAVIOR_SHOOT:
-            {
-                // Stationary shooting enemy - aims and shoots at player
-                float dx_shoot = game->player.x - enemy->x;
-                float dy_shoot = game->player.y - enemy->y;
-                float distance_to_player = sqrt(dx_shoot * dx_shoot + dy_shoot * dy_shoot);
-                
-                if (distance_to_player <= ENEMY_SHOOT_RANGE) {
-                    // Face the player
-                    enemy->dx = (dx_shoot > 0) ? 1.0f : -1.0f;
-                    
-                    // Shoot if cooldown is ready
-                    if (enemy->last_attack <= 0) {
-                        // Create a projectile aimed at the player
-                        create_projectile(game->current_level_data, 
-                                        enemy->x + enemy->width/2, 
-                                        enemy->y + enemy->height/2,
-                                        game->player.x + game->player.width/2, 
-                                        game->player.y + game->player.height/2,
-                                        enemy->type);
-                        enemy->last_attack = ENEMY_SHOOT_COOLDOWN;
-                        
-                        // Play enemy shooting sound if enabled
-                        if (game->settings.sound_enabled && game->shoot_sound) {
-                            al_play_sample(game->shoot_sound, 0.4, 0.0, 1.2, ALLEGRO_PLAYMODE_ONCE, NULL);
-                        }
-                    }
-                } else {
-                    // Move slowly towards player if out of range
-                    if (distance_to_player > 0) {
-                        enemy->dx = (dx_shoot / distance_to_player) * 1.0f; // Slower than chase
-                        enemy->x += enemy->dx;
-                    }
-                }
-                
-                // Decrease shoot cooldown
-                if (enemy->last_attack > 0) {
-                    enemy->last_attack--;
-                }
+            if (pred_distance > 0) {
+                enemy->dx = (pred_dx / pred_distance) * (ENEMY_CHASE_SPEED + 3.0f);
+                enemy->dy = (pred_dy / pred_distance) * (ENEMY_CHASE_SPEED + 3.0f);
             }
-            break;
-            
-        case BEHAVIOR_BOSS:
-            {
-                // Complex boss behavior with multiple phases and special abilities
-                float dx_boss = game->player.x - enemy->x;
-                float dy_boss = game->player.y - enemy->y;
-                float distance_to_player = sqrt(dx_boss * dx_boss + dy_boss * dy_boss);
-                float health_percentage = enemy->health / enemy->max_health;
-                
-                if (health_percentage > ENEMY_BOSS_PHASE_HEALTH) {
-                    // Phase 1: Aggressive chase with occasional pauses and special attacks
-                    if (enemy->frame_timer <= 0) {
-                        // Chase phase with enhanced speed
-                        if (distance_to_player > 0) {
-                            enemy->dx = (dx_boss / distance_to_player) * (ENEMY_CHASE_SPEED + 2.0f);
-                            enemy->dy = (dy_boss / distance_to_player) * (ENEMY_CHASE_SPEED + 2.0f);
-                        }
-                        enemy->x += enemy->dx;
-                        enemy->y += enemy->dy;
-                        
-                        enemy->frame_timer = 90; // Chase for 1.5 seconds
-                    } else if (enemy->frame_timer == 45) {
-                        // Brief pause with area attack
-                        enemy->dx = 0;
-                        enemy->dy = 0;
-                        
-                        // Boss special: triple shot spread
-                        if (enemy->last_attack <= 0) {
-                            for (int shot = 0; shot < 3; shot++) {
-                                float angle_offset = (shot - 1) * 0.3f; // -0.3, 0, 0.3 radians
-                                float shot_target_x = game->player.x + cos(angle_offset) * 100.0f;
-                                float shot_target_y = game->player.y + sin(angle_offset) * 100.0f;
-                                
-                                create_projectile(game->current_level_data, 
-                                                enemy->x + enemy->width/2, 
-                                                enemy->y + enemy->height/2,
-                                                shot_target_x, shot_target_y,
-                                                enemy->type);
-                            }
-                            if (game->settings.sound_enabled && game->shoot_sound) {
-                                al_play_sample(game->shoot_sound, 0.8, 0.0, 0.8, ALLEGRO_PLAYMODE_ONCE, NULL);
-                            }
-                            enemy->last_attack = ENEMY_SHOOT_COOLDOWN;
-                            printf("Boss triple shot attack!\n");
-                        }
-                    }
-                } else {
-                    // Phase 2: Desperate behavior - enhanced abilities and faster movement
-                    if (distance_to_player > 120.0f) {
-                        // Very fast approach with prediction
-                        float pred_x, pred_y;
-                        predict_player_movement(game, 30, &pred_x, &pred_y);
-                        
-                        float pred_dx = pred_x - enemy->x;
-                        float pred_dy = pred_y - enemy->y;
-                        float pred_distance = sqrt(pred_dx * pred_dx + pred_dy * pred_dy);
-                        
-                        if (pred_distance > 0) {
-                            enemy->dx = (pred_dx / pred_distance) * (ENEMY_CHASE_SPEED + 3.0f);
-                            enemy->dy = (pred_dy / pred_distance) * (ENEMY_CHASE_SPEED + 3.0f);
-                        }
-                        enemy->x += enemy->dx;
-                        enemy->y += enemy->dy;
-                    } else {
-                        // Close combat - erratic movement pattern
-                        float angle = enemy->frame_timer * 0.15f;
-                        enemy->dx = cos(angle) * 4.0f + cos(angle * 2.3f) * 2.0f; // Complex pattern
-                        enemy->dy = sin(angle) * 3.0f + sin(angle * 1.7f) * 1.5f;
-                        enemy->x += enemy->dx;
-                        enemy->y += enemy->dy;
-                    }
-                    
-                    // Enhanced rapid fire in phase 2
-                    if (enemy->last_attack <= 0 && distance_to_player <= ENEMY_SHOOT_RANGE * 1.5f) {
-                        // Boss special: burst fire
-                        for (int burst = 0; burst < 2; burst++) {
-                            create_projectile(game->current_level_data, 
-                                            enemy->x + enemy->width/2, 
-                                            enemy->y + enemy->height/2,
-                                            game->player.x + game->player.width/2 + (burst * 20 - 10), 
-                                            game->player.y + game->player.height/2,
-                                            enemy->type);
-                        }
-                        // Play enemy shooting sound with higher pitch for rapid fire
-                        if (game->settings.sound_enabled && game->shoot_sound) {
-                            al_play_sample(game->shoot_sound, 0.7, 0.0, 1.3, ALLEGRO_PLAYMODE_ONCE, NULL);
-                        }
-                        enemy->last_attack = ENEMY_SHOOT_COOLDOWN / 3; // Much faster shooting
-                        printf("Boss burst fire!\n");
-                    }
-                }
-                
-                // Update timers
-                if (enemy->frame_timer > 0) enemy->frame_timer--;
-                if (enemy->last_attack > 0) enemy->last_attack--;
+            move_body(enemy, enemy->dx, enemy->dy);
+        } else {
+            // Close combat - erratic movement pattern
+            float angle = enemy->phase_timer * 0.15f;
+            enemy->dx = cos(angle) * 4.0f + cos(angle * 2.3f) * 2.0f; // Complex pattern
+            enemy->dy = sin(angle) * 3.0f + sin(angle * 1.7f) * 1.5f;
+            move_body(enemy, enemy->dx, enemy->dy);
+        }
+        
+        // Phase 2 pattern runs while the player is in range
+        if (distance_to_player <= ENEMY_SHOOT_RANGE * 1.5f) {
+            int loud = fire_bullet_pattern(game->current_level_data, PATTERN_BOSS_DESPERATE,
+                                           enemy->pattern_tick++,
+                                           enemy->x + enemy->width/2, enemy->y + enemy->height/2,
+                                           game->player.x + game->player.width/2,
+                                           game->player.y + game->player.height/2,
+                                           enemy->type);
+            // Play enemy shooting sound with higher pitch for rapid fire
+            if (loud > 0 && game->settings.sound_enabled && game->shoot_sound) {
+                al_play_sample(game->shoot_sound, 0.7, 0.0, 1.3, ALLEGRO_PLAYMODE_ONCE, NULL);
             }
-            break;
-        case BEHAVIOR_NONE:
-            break;
-        case BEHAVIOR_FLANK:
-            apply_flanking_behavior(enemy, &game->player, game);
-            break;
-        case BEHAVIOR_COORDINATE:
-            execute_coordinate_behavior(game, enemy);
-            break;
-        case BEHAVIOR_AMBUSH:
-            execute_ambush_behavior(game, enemy);
-            break;
-        case BEHAVIOR_RETREAT:
-            execute_retreat_behavior(game, enemy);
-            break;
-        case BEHAVIOR_SURROUND:
-            execute_surround_behavior(game, enemy);
-            break;
+        } else {
+            enemy->pattern_tick = 0;
+        }
     }
+    
+    // Update timers
+    if (enemy->phase_timer > 0) enemy->phase_timer--;
+    if (enemy->last_attack > 0) enemy->last_attack--;
 }
 
-// Original check_collision function from main.c
+void update_enemies(Game* game) {
+    EnemyBatches* batches = &game->current_level_data->batches;
+    for (int behavior = 0; behavior < BEHAVIOR_COUNT; behavior++) {
+        int count = gather_batch(batches, behavior);
+        if (count == 0) continue;
+        for (int i = 0; i < count; i++) {
+            tick_combo_timer(batches->lanes[i]);
+        }
+        
+        switch ((EntityBehavior)behavior) {
+            case BEHAVIOR_PATROL:
+                update_patrol_batch(game, batches, count);
+                break;
+            case BEHAVIOR_CHASE:
+                update_chase_batch(game, batches, count);
+                break;
+            case BEHAVIOR_RETREAT:
+                update_retreat_batch(game, batches, count);
+                break;
+            case BEHAVIOR_SHOOT:
+                for (int i = 0; i < count; i++) update_shoot_enemy(game, batches->lanes[i]);
+                break;
+            case BEHAVIOR_BOSS:
+                for (int i = 0; i < count; i++) update_boss_enemy(game, batches->lanes[i]);
+                break;
+            case BEHAVIOR_FLANK:
+                for (int i = 0; i < count; i++) apply_flanking_behavior(batches->lanes[i], &game->player, game);
+                break;
+            case BEHAVIOR_COORDINATE:
+                for (int i = 0; i < count; i++) execute_coordinate_behavior(game, batches->lanes[i]);
+                break;
+            case BEHAVIOR_AMBUSH:
+                for (int i = 0; i < count; i++) execute_ambush_behavior(game, batches->lanes[i]);
+                break;
+            case BEHAVIOR_SURROUND:
+                for (int i = 0; i < count; i++) execute_surround_behavior(game, batches->lanes[i]);
+                break;
+            case BEHAVIOR_NONE:
+                break;
+        }
+    }
+    rebucket_enemies(batches);
+}
+
+// Top-left pixel of the entity's frame, where record_entity_sprite draws it
+static void get_mask_origin(const Entity* e, int* x, int* y) {
+    *x = (int)floorf(e->x + (e->width - e->mask->width) / 2);
+    *y = (int)floorf(e->y + e->height - e->mask->height);
+}
+
+bool check_rect_collision(const Entity* e, float x, float y, float width, float height) {
+    if (!e->mask) {
+        return x < e->x + e->width && x + width > e->x &&
+               y < e->y + e->height && y + height > e->y;
+    }
+    int mask_x, mask_y;
+    get_mask_origin(e, &mask_x, &mask_y);
+    return mask_overlaps_rect(e->mask, mask_x, mask_y, e->facing_left, x, y, x + width, y + height);
+}
+
+// Original check_collision function from main.c, now hitting the frame's
+// opaque pixels instead of the box for entities with a collision mask
 bool check_collision(Entity* a, Entity* b) {
-    return (a->x < b->x + b->width &&
-            a->x + a->width > b->x &&
-            a->y < b->y + b->height &&
-            a->y + a->height > b->y);
+    if (a->mask && b->mask) {
+        int ax, ay, bx, by;
+        get_mask_origin(a, &ax, &ay);
+        get_mask_origin(b, &bx, &by);
+        return masks_overlap(a->mask, ax, ay, a->facing_left, b->mask, bx, by, b->facing_left);
+    }
+    if (b->mask) return check_rect_collision(b, a->x, a->y, a->width, a->height);
+    return check_rect_collision(a, b->x, b->y, b->width, b->height);
 }
 
 // Original handle_collisions function from main.c
 void handle_collisions(Game* game) {
-    for (int i = 0; i < game->current_level_data->num_enemies; i++) {
-        Entity* enemy = &game->current_level_data->enemies[i];
-        if (enemy->active && check_collision(&game->player, enemy)) {
+    ChunkPool* enemies = &game->current_level_data->enemies;
+    for (int i = pool_first(enemies); i != POOL_SLOT_NONE; i = pool_next(enemies, i)) {
+        Entity* enemy = pool_at(enemies, i);
+        if (enemy->active && bodies_interact(&game->player, enemy) && check_collision(&game->player, enemy)) {
             if (game->player.last_attack == 0) {
                 game->player.health -= enemy->attack_power;
                 
@@ -382,8 +405,9 @@ void update_ai_coordination(Game* game) {
         game->ai_state.active_coordinators = 0;
         
         // Count active enemies for coordination
-        for (int i = 0; i < game->current_level_data->num_enemies; i++) {
-            Entity* enemy = &game->current_level_data->enemies[i];
+        ChunkPool* enemies = &game->current_level_data->enemies;
+        for (int i = pool_first(enemies); i != POOL_SLOT_NONE; i = pool_next(enemies, i)) {
+            Entity* enemy = pool_at(enemies, i);
             if (enemy->active && enemy->coordination_id > 0) {
                 game->ai_state.active_coordinators++;
             }
@@ -437,11 +461,10 @@ void execute_flank_behavior(Game* game, Entity* enemy) {
         float speed = ENEMY_CHASE_SPEED * game->ai_state.difficulty_multiplier;
         enemy->dx = (dx / distance) * speed;
         enemy->dy = (dy / distance) * speed;
-        enemy->x += enemy->dx;
-        enemy->y += enemy->dy;
+        move_body(enemy, enemy->dx, enemy->dy);
     } else {
         // In position, switch to coordinated attack
-        enemy->behavior = BEHAVIOR_COORDINATE;
+        set_enemy_behavior(&game->current_level_data->batches, enemy, BEHAVIOR_COORDINATE);
         enemy->ai_timer = AI_COORDINATE_DURATION;
     }
     
@@ -462,11 +485,10 @@ void apply_flanking_behavior(Entity* enemy, Entity* player, Game* game) {
         float speed = ENEMY_CHASE_SPEED * game->ai_state.difficulty_multiplier;
         enemy->dx = (dx / distance) * speed;
         enemy->dy = (dy / distance) * speed;
-        enemy->x += enemy->dx;
-        enemy->y += enemy->dy;
+        move_body(enemy, enemy->dx, enemy->dy);
     } else {
         // In position, switch to coordinated attack
-        enemy->behavior = BEHAVIOR_COORDINATE;
+        set_enemy_behavior(&game->current_level_data->batches, enemy, BEHAVIOR_COORDINATE);
         enemy->ai_timer = AI_COORDINATE_DURATION;
     }
     
@@ -483,8 +505,7 @@ void execute_coordinate_behavior(Game* game, Entity* enemy) {
     if (distance > 0) {
         enemy->dx = (dx / distance) * ENEMY_CHASE_SPEED;
         enemy->dy = (dy / distance) * ENEMY_CHASE_SPEED;
-        enemy->x += enemy->dx;
-        enemy->y += enemy->dy;
+        move_body(enemy, enemy->dx, enemy->dy);
     }
 }
 
@@ -504,27 +525,11 @@ void execute_ambush_behavior(Game* game, Entity* enemy) {
         if (distance > 0) {
             enemy->dx = (dx / distance) * (ENEMY_CHASE_SPEED * 1.5f);
             enemy->dy = (dy / distance) * (ENEMY_CHASE_SPEED * 1.5f);
-            enemy->x += enemy->dx;
-            enemy->y += enemy->dy;
+            move_body(enemy, enemy->dx, enemy->dy);
         }
     }
 }
 
-void execute_retreat_behavior(Game* game, Entity* enemy) {
-    // Basic retreat behavior - move away from player
-    float dx = game->player.x - enemy->x;
-    float dy = game->player.y - enemy->y;
-    float distance = sqrt(dx * dx + dy * dy);
-    
-    if (distance > 0) {
-        // Move away from player
-        enemy->dx = -(dx / distance) * ENEMY_CHASE_SPEED;
-        enemy->dy = -(dy / distance) * ENEMY_CHASE_SPEED;
-        enemy->x += enemy->dx;
-        enemy->y += enemy->dy;
-    }
-}
-
 void execute_surround_behavior(Game* game, Entity* enemy) {
     // Basic surround behavior - circle around player
     float dx = game->player.x - enemy->x;
@@ -544,6 +549,5 @@ void execute_surround_behavior(Game* game, Entity* enemy) {
         enemy->dy = sin(angle) * ENEMY_PATROL_SPEED;
     }
     
-    enemy->x += enemy->dx;
-    enemy->y += enemy->dy;
+    move_body(enemy, enemy->dx, enemy->dy);
 }
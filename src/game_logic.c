@@ -2,8 +2,17 @@
 #include "../include/game.h"      // For Game struct, constants, Allegro headers
 #include "../include/level.h"      // For init_levels, cleanup_levels
 #include "../include/input.h"      // For handle_input (though not directly called by these funcs)
-#include "../include/drawing.h"    // For draw_game (though not directly called by these funcs)
-#include "../include/entity.h"     // For update_enemy, handle_collisions
+#include "../include/drawing.h"    // For init_drawing, cleanup_drawing
+#include "../include/entity.h"     // For update_enemies, handle_collisions
+#include "../include/spawner.h"    // For update_spawner, all_waves_spawned
+#include "../include/physics.h"    // For step_physics, move_body, knock_body
+#include "../include/jobs.h"       // For the update_game task graph
+#include "../include/render.h"     // For init_renderer, cleanup_renderer
+#include "../include/texture_format.h" // For load_texture
+#include "../include/animation.h"  // For load_animations, animate_player, animate_boss
+#include "../include/asset_pack.h" // For open_asset_pack, close_asset_pack
+#include "../include/preload.h"    // For start_preload, finish_preload, release_preload
+#include "../include/startup_timeline.h" // For the startup report
 #include <stdio.h>               // For fprintf, sprintf
 #include <stdlib.h>              // For malloc, free
 #include <allegro5/allegro.h>
@@ -14,43 +23,14 @@
 #include <allegro5/allegro_audio.h>
 #include <allegro5/allegro_acodec.h>
 
-// Original init_game function from main.c
-bool init_game(Game* game) {
-    if (!al_init()) {
-        fprintf(stderr, "Failed to initialize Allegro!\n");
-        return false;
-    }
-
-    // Initialize other Allegro addons and game components as before
-    al_init_primitives_addon();
-    al_install_keyboard();
-    al_install_mouse();
-    al_init_image_addon();
-    al_init_font_addon();
-    al_init_ttf_addon();
-    al_install_audio();
-    al_init_acodec_addon();
-    al_reserve_samples(10); // Reserve some samples
+static void build_update_graph(Game* game);
 
-    game->timer = al_create_timer(1.0 / FPS);
-    if (!game->timer) {
-        fprintf(stderr, "Failed to create timer!\n");
-        return false;
-    }
-
-    game->event_queue = al_create_event_queue();
-    if (!game->event_queue) {
-        fprintf(stderr, "Failed to create event_queue!\n");
-        al_destroy_timer(game->timer);
-        return false;
-    }
-
-    game->display = al_create_display(SCREEN_WIDTH, SCREEN_HEIGHT);
-    if (!game->display) {
-        fprintf(stderr, "Failed to create display!\n");
-        al_destroy_timer(game->timer);
-        al_destroy_event_queue(game->event_queue);
-        return false;
+// Open the asset pack and change to the directory loose assets are under
+static void find_game_assets(void) {
+    // Packed assets are found whatever the working directory; loose files
+    // still need the directory change below
+    if (!open_asset_pack()) {
+        printf("No asset pack found, loading loose files from %s/\n", ASSET_SOURCE_DIR);
     }
 
     // Try to set the working directory to the resources directory
@@ -76,87 +56,72 @@ bool init_game(Game* game) {
     } else {
         fprintf(stderr, "Failed to get standard resources path.\n");
     }
+}
 
-    game->font = al_load_ttf_font(DEFAULT_FONT_PATH, FONT_SIZE_NORMAL, 0);
-    game->title_font = al_load_ttf_font(DEFAULT_FONT_PATH, FONT_SIZE_TITLE, 0);
-    if (!game->font || !game->title_font) {
-        fprintf(stderr, "Failed to load fonts!\n");
-        // al_shutdown_font_addon(); // Consider cleanup on failure
-        return false;
-    }
+static const char* sound_paths[] = {
+    "resources/sounds/jump.wav",
+    "resources/sounds/hit.wav",
+    "resources/sounds/death.wav",
+    "resources/sounds/collect.wav",
+    "resources/sounds/shoot.wav"
+};
 
-    game->timer = al_create_timer(1.0 / FPS);
-    if (!game->timer) {
-        fprintf(stderr, "Failed to create timer!\n");
-        return false;
-    }
+static void star_paths(int level, char* empty_path, char* filled_path, size_t size) {
+    snprintf(empty_path, size, "resources/sprites/star_%d_0.png", level + 1);
+    snprintf(filled_path, size, "resources/sprites/star_%d_1.png", level + 1);
+}
 
-    game->display = al_create_display(SCREEN_WIDTH, SCREEN_HEIGHT);
-    if (!game->display) {
-        fprintf(stderr, "Failed to create display!\n");
-        // al_destroy_timer(game->timer); // Consider cleanup
-        return false;
+// Queue the images and sounds loaded at startup and start decoding them on
+// the job system's threads
+static void start_asset_preload(Game* game, bool sounds) {
+    char empty_path[256];
+    char filled_path[256];
+    for (int level = 0; level < 3; level++) {
+        star_paths(level, empty_path, filled_path, sizeof(empty_path));
+        queue_preload_bitmap(empty_path, 0, 0, 0);
+        queue_preload_bitmap(filled_path, 0, 0, 0);
     }
-
-    game->event_queue = al_create_event_queue();
-    if (!game->event_queue) {
-        fprintf(stderr, "Failed to create event queue!\n");
-        // al_destroy_display(game->display); // Consider cleanup
-        // al_destroy_timer(game->timer);
-        return false;
+    queue_animation_preloads();
+    queue_level_preloads();
+    for (int i = 0; sounds && i < (int)(sizeof(sound_paths) / sizeof(sound_paths[0])); i++) {
+        queue_preload_sample(sound_paths[i]);
     }
+    start_preload(&game->jobs);
+}
 
-    al_register_event_source(game->event_queue, al_get_display_event_source(game->display));
-    al_register_event_source(game->event_queue, al_get_timer_event_source(game->timer));
-    al_register_event_source(game->event_queue, al_get_keyboard_event_source());
-
-    if (!al_install_audio()) {
-        fprintf(stderr, "Failed to initialize audio!\n");
-        return false;
-    }
-    if (!al_init_acodec_addon()) {
-        fprintf(stderr, "Failed to initialize audio codecs!\n");
-        return false;
+// Fonts don't come from the preload, so they load while it decodes.
+// With 'builtin', or when the system font is missing, Allegro's builtin
+// font is used; the headless game always uses it so golden images don't
+// depend on the fonts of the machine they are drawn on.
+static bool load_game_fonts(Game* game, bool builtin) {
+    if (!builtin) {
+        game->font = al_load_ttf_font(DEFAULT_FONT_PATH, FONT_SIZE_NORMAL, 0);
+        game->title_font = al_load_ttf_font(DEFAULT_FONT_PATH, FONT_SIZE_TITLE, 0);
+        if (game->font && game->title_font) return true;
+        fprintf(stderr, "Failed to load %s, using the builtin font\n", DEFAULT_FONT_PATH);
+        if (game->font) al_destroy_font(game->font);
+        if (game->title_font) al_destroy_font(game->title_font);
     }
-    if (!al_reserve_samples(AUDIO_RESERVE_SAMPLES)) {
-        fprintf(stderr, "Failed to reserve audio samples!\n");
+    game->font = al_create_builtin_font();
+    game->title_font = al_create_builtin_font();
+    if (!game->font || !game->title_font) {
+        fprintf(stderr, "Failed to load fonts!\n");
+        // al_shutdown_font_addon(); // Consider cleanup on failure
         return false;
     }
-    // Load sound effects
-    game->jump_sound = al_load_sample("resources/sounds/jump.wav");
-    game->hit_sound = al_load_sample("resources/sounds/hit.wav");
-    game->death_sound = al_load_sample("resources/sounds/death.wav");
-    game->collect_sound = al_load_sample("resources/sounds/collect.wav");
-    game->shoot_sound = al_load_sample("resources/sounds/shoot.wav");
-    
-    // For now, no background music to keep it simple
-    game->music_instance = NULL;
-    
-    if (!game->jump_sound) {
-        fprintf(stderr, "Warning: Failed to load jump.wav\n");
-    }
-    if (!game->hit_sound) {
-        fprintf(stderr, "Warning: Failed to load hit.wav\n"); 
-    }
-    if (!game->death_sound) {
-        fprintf(stderr, "Warning: Failed to load death.wav\n");
-    }
-    if (!game->collect_sound) {
-        fprintf(stderr, "Warning: Failed to load collect.wav\n");
-    }
-    if (!game->shoot_sound) {
-        fprintf(stderr, "Warning: Failed to load shoot.wav\n");
-    }
+    return true;
+}
 
+// Sprites, loaded relative to the resources directory
+static void load_game_sprites(Game* game) {
     // Load star sprites for visual star display for all three levels
     for (int level = 0; level < 3; level++) {
         char empty_path[256];
         char filled_path[256];
-        snprintf(empty_path, sizeof(empty_path), "resources/sprites/star_%d_0.png", level + 1);
-        snprintf(filled_path, sizeof(filled_path), "resources/sprites/star_%d_1.png", level + 1);
-        
-        game->star_empty[level] = al_load_bitmap(empty_path);
-        game->star_filled[level] = al_load_bitmap(filled_path);
+        star_paths(level, empty_path, filled_path, sizeof(empty_path));
+
+        game->star_empty[level] = load_texture(empty_path, TEXTURE_SPRITE);
+        game->star_filled[level] = load_texture(filled_path, TEXTURE_SPRITE);
         
         if (!game->star_empty[level]) {
             fprintf(stderr, "Warning: Failed to load %s\n", empty_path);
@@ -166,6 +131,15 @@ bool init_game(Game* game) {
         }
     }
 
+    // Without frames the player and bosses are drawn as circles
+    game->animations = calloc(1, sizeof(AnimationSet));
+    if (!game->animations || !load_animations(game->animations)) {
+        fprintf(stderr, "Warning: Failed to load sprite animations\n");
+    }
+}
+
+// Player, menus, levels and stars as they are when the game starts
+static void init_game_world(Game* game) {
     game->player.x = SCREEN_WIDTH * PLAYER_INITIAL_X_FACTOR;
     game->player.y = SCREEN_HEIGHT * PLAYER_INITIAL_Y_FACTOR;
     game->player.width = PLAYER_WIDTH;
@@ -201,8 +175,11 @@ bool init_game(Game* game) {
     game->player.last_shot = 0; // Initialize shooting cooldown
     game->player.sprite = NULL;
     game->player.sprite_sheet = NULL;
+    game->player.mask = NULL;
+    game->player.clip = ANIM_NO_CLIP;
     game->player.current_frame = 0;
     game->player.frame_timer = 0;
+    game->player.facing_left = false;
     game->player.is_on_ground = false;
     game->player.jump_requested = false; // Initialize jump_requested
     game->player.coyote_time = 0; // Initialize coyote time
@@ -216,6 +193,8 @@ bool init_game(Game* game) {
     game->player.knockback_dx = 0.0f;
     game->player.knockback_dy = 0.0f;
     game->player.knockback_timer = 0;
+    init_body(&game->player, PHYS_LAYER_PLAYER, PHYS_LAYER_TERRAIN | PHYS_LAYER_HAZARD | PHYS_LAYER_ENEMY,
+              GRAVITY, PLAYER_KNOCKBACK_DECAY, true);
 
     game->state = WELCOME_SCREEN;
     game->running = true;
@@ -225,11 +204,8 @@ bool init_game(Game* game) {
     
     game->current_level = 1; // Start at level ONE
 
-    // Initialize screen shake
-    game->screen_shake.intensity = 0;
-    game->screen_shake.duration = 0;
-    game->screen_shake.offset_x = 0;
-    game->screen_shake.offset_y = 0;
+    // Initialize the camera (scroll and screen shake)
+    init_camera(&game->camera, SCREEN_WIDTH, SCREEN_HEIGHT);
 
     // It's important that init_levels is called *before* reset_player_and_level
     // so that all level data (including original glucose states) is loaded first.
@@ -238,11 +214,211 @@ bool init_game(Game* game) {
 
     // Now, reset player and the current level to its initial state (including glucose items)
     reset_player_and_level(game, 0); // Use index 0 for level ONE 
+}
+
+// Original init_game function from main.c
+bool init_game(Game* game) {
+    if (!al_init()) {
+        fprintf(stderr, "Failed to initialize Allegro!\n");
+        return false;
+    }
+    start_startup_timeline();
+
+    // Decoders first, so workers can decode while the display is created
+    int phase = begin_startup_phase("image and audio addons");
+    al_init_image_addon();
+    if (!al_install_audio()) {
+        fprintf(stderr, "Failed to initialize audio!\n");
+        return false;
+    }
+    if (!al_init_acodec_addon()) {
+        fprintf(stderr, "Failed to initialize audio codecs!\n");
+        return false;
+    }
+    end_startup_phase(phase);
+
+    // Worker threads for asset decoding, then for the update_game stages
+    phase = begin_startup_phase("job system");
+    int job_threads = al_get_cpu_count() - 1;
+    if (job_threads > JOB_WORKER_THREADS) job_threads = JOB_WORKER_THREADS;
+    init_job_system(&game->jobs, job_threads);
+    end_startup_phase(phase);
+
+    phase = begin_startup_phase("asset pack and queue");
+    find_game_assets();
+    start_asset_preload(game, true);
+    end_startup_phase(phase);
+
+    phase = begin_startup_phase("input and font addons");
+    al_init_primitives_addon();
+    al_install_keyboard();
+    al_install_mouse();
+    al_init_font_addon();
+    al_init_ttf_addon();
+    if (!al_reserve_samples(AUDIO_RESERVE_SAMPLES)) {
+        fprintf(stderr, "Failed to reserve audio samples!\n");
+        return false;
+    }
+    end_startup_phase(phase);
 
-    al_start_timer(game->timer);
+    phase = begin_startup_phase("timers and display");
+    game->timer = al_create_timer(1.0 / FPS);
+    if (!game->timer) {
+        fprintf(stderr, "Failed to create timer!\n");
+        return false;
+    }
+    game->menu_timer = al_create_timer(1.0 / MENU_ANIMATION_FPS);
+    if (!game->menu_timer) {
+        fprintf(stderr, "Failed to create menu timer!\n");
+        return false;
+    }
+
+    game->display = al_create_display(SCREEN_WIDTH, SCREEN_HEIGHT);
+    if (!game->display) {
+        fprintf(stderr, "Failed to create display!\n");
+        // al_destroy_timer(game->timer); // Consider cleanup
+        return false;
+    }
+    game->pause_frame = al_create_bitmap(SCREEN_WIDTH, SCREEN_HEIGHT);
+    if (!game->pause_frame) {
+        fprintf(stderr, "Failed to create pause frame bitmap, pause screen will redraw the level\n");
+    }
+    game->pause_frame_valid = false;
+    game->show_overdraw = false;
+
+    game->event_queue = al_create_event_queue();
+    if (!game->event_queue) {
+        fprintf(stderr, "Failed to create event queue!\n");
+        // al_destroy_display(game->display); // Consider cleanup
+        // al_destroy_timer(game->timer);
+        return false;
+    }
+
+    al_register_event_source(game->event_queue, al_get_display_event_source(game->display));
+    al_register_event_source(game->event_queue, al_get_timer_event_source(game->timer));
+    al_register_event_source(game->event_queue, al_get_timer_event_source(game->menu_timer));
+    al_register_event_source(game->event_queue, al_get_keyboard_event_source());
+    end_startup_phase(phase);
+
+    phase = begin_startup_phase("fonts");
+    if (!load_game_fonts(game, false)) {
+        return false;
+    }
+    end_startup_phase(phase);
+
+    // Everything below uses the decoded assets
+    phase = begin_startup_phase("wait for decoding");
+    finish_preload();
+    end_startup_phase(phase);
+
+    phase = begin_startup_phase("stars and animations");
+    load_game_sprites(game);
+    end_startup_phase(phase);
+
+    // Load sound effects
+    phase = begin_startup_phase("sounds");
+    ALLEGRO_SAMPLE** sounds[] = {
+        &game->jump_sound, &game->hit_sound, &game->death_sound, &game->collect_sound, &game->shoot_sound
+    };
+    for (int i = 0; i < (int)(sizeof(sounds) / sizeof(sounds[0])); i++) {
+        *sounds[i] = take_preloaded_sample(sound_paths[i]);
+        if (!*sounds[i]) *sounds[i] = al_load_sample(sound_paths[i]);
+        if (!*sounds[i]) fprintf(stderr, "Warning: Failed to load %s\n", sound_paths[i]);
+    }
+    end_startup_phase(phase);
+
+    // For now, no background music to keep it simple
+    game->music_instance = NULL;
+
+    phase = begin_startup_phase("levels");
+    init_game_world(game);
+    release_preload();
+    build_update_graph(game);
+    end_startup_phase(phase);
+
+    // Threads recording the scene into draw lists
+    phase = begin_startup_phase("drawing and renderer");
+    int record_threads = al_get_cpu_count() - 1;
+    if (record_threads > DRAW_RECORD_THREADS) record_threads = DRAW_RECORD_THREADS;
+    if (!init_drawing(game, record_threads)) {
+        return false;
+    }
+
+    // Hands the display over to the render thread, so this comes last
+    if (!init_renderer(game)) {
+        return false;
+    }
+    end_startup_phase(phase);
+
+    update_state_timers(game);
     return true;
 }
 
+// Same game without a display, audio, input or timers, for render_bench.c.
+// Bitmaps are memory bitmaps and update_game runs its stages serially, so a
+// scripted run always produces the same frames.
+bool init_game_headless(Game* game) {
+    if (!al_init()) {
+        fprintf(stderr, "Failed to initialize Allegro!\n");
+        return false;
+    }
+    al_init_primitives_addon();
+    al_init_image_addon();
+    al_init_font_addon();
+    al_init_ttf_addon();
+    al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+
+    // Without workers the helper thread decodes everything while the fonts load
+    init_job_system(&game->jobs, 0);
+    find_game_assets();
+    start_asset_preload(game, false);
+    if (!load_game_fonts(game, true)) {
+        return false;
+    }
+    finish_preload();
+    load_game_sprites(game);
+    game->pause_frame = al_create_bitmap(SCREEN_WIDTH, SCREEN_HEIGHT);
+    game->pause_frame_valid = false;
+    game->show_overdraw = false;
+
+    init_game_world(game);
+    release_preload();
+    build_update_graph(game);
+
+    int record_threads = al_get_cpu_count() - 1;
+    if (record_threads > DRAW_RECORD_THREADS) record_threads = DRAW_RECORD_THREADS;
+    return init_drawing(game, record_threads);
+}
+
+// Only gameplay needs the 60 Hz timer. The welcome screen pulse runs off the
+// slower menu timer, and the other menus and the pause screen stop both
+// timers so the main loop sleeps until there is input.
+void update_state_timers(Game* game) {
+    bool game_timer = true;
+    bool menu_timer = false;
+    switch (game->state) {
+        case WELCOME_SCREEN:
+            game_timer = false;
+            menu_timer = true;
+            break;
+        case MAIN_MENU:
+        case LEVEL_SELECT:
+        case SETTINGS:
+        case PAUSED:
+            game_timer = false;
+            break;
+        default:
+            break;
+    }
+
+    if (game_timer && !al_get_timer_started(game->timer)) al_start_timer(game->timer);
+    else if (!game_timer && al_get_timer_started(game->timer)) al_stop_timer(game->timer);
+    if (menu_timer && !al_get_timer_started(game->menu_timer)) al_start_timer(game->menu_timer);
+    else if (!menu_timer && al_get_timer_started(game->menu_timer)) al_stop_timer(game->menu_timer);
+
+    game->timer_state = game->state;
+}
+
 // Original init_menus function from main.c
 void init_menus(Game* game) {
     game->main_menu.num_items = 4;
@@ -271,13 +447,14 @@ void init_menus(Game* game) {
         game->level_menu.num_items = 0;
     }
 
-    game->settings_menu.num_items = 4;
+    game->settings_menu.num_items = 5;
     game->settings_menu.items = malloc(sizeof(MenuItem) * game->settings_menu.num_items);
     if(game->settings_menu.items) {
         game->settings_menu.items[0] = (MenuItem){"Difficulty: Normal", true, true};
         game->settings_menu.items[1] = (MenuItem){"Sound: On", true, true};
         game->settings_menu.items[2] = (MenuItem){"Music: On", true, true};
-        game->settings_menu.items[3] = (MenuItem){"Back", true, true};
+        game->settings_menu.items[3] = (MenuItem){"Render Scale: 100%", true, true};
+        game->settings_menu.items[4] = (MenuItem){"Back", true, true};
         game->settings_menu.selected_index = 0;
     } else {
         fprintf(stderr, "Failed to allocate memory for settings menu items!\n");
@@ -287,6 +464,10 @@ void init_menus(Game* game) {
     game->settings.difficulty = DIFFICULTY_NORMAL;
     game->settings.sound_enabled = true;
     game->settings.music_enabled = true;
+    game->settings.render_scale = RENDER_SCALE_DEFAULT;
+    if (game->settings_menu.items) {
+        sprintf(game->settings_menu.items[3].text, "Render Scale: %d%%", game->settings.render_scale);
+    }
 }
 
 // New reset_player_and_level function
@@ -299,6 +480,8 @@ void reset_player_and_level(Game* game, int level_idx) {
     game->player.health = PLAYER_INITIAL_HEALTH;
     game->player.is_on_ground = false;
     game->player.jump_requested = false;
+    game->player.clip = ANIM_NO_CLIP;
+    game->player.facing_left = false;
     game->player.coyote_time = 0; // Reset coyote time
     game->player.jump_buffer = 0; // Reset jump buffer
     game->player.wall_contact_left = 0; // Reset wall contact
@@ -310,6 +493,8 @@ void reset_player_and_level(Game* game, int level_idx) {
     game->player.knockback_dx = 0.0f;
     game->player.knockback_dy = 0.0f;
     game->player.knockback_timer = 0;
+    init_body(&game->player, PHYS_LAYER_PLAYER, PHYS_LAYER_TERRAIN | PHYS_LAYER_HAZARD | PHYS_LAYER_ENEMY,
+              GRAVITY, PLAYER_KNOCKBACK_DECAY, true);
     
     // Reset star progress for the level
     reset_current_level_progress(game);
@@ -339,54 +524,22 @@ void reset_player_and_level(Game* game, int level_idx) {
     // We need the original level_number (1, 2, or 3) not the index (0, 1, 2).
     // We added 'id' to the Level struct for this purpose.
     if (game->current_level_data) {
-        // Before re-initializing content, free existing dynamic content within the level
-        // to prevent memory leaks if init_level_content reallocates.
-        if (game->current_level_data->platforms) free(game->current_level_data->platforms);
-        game->current_level_data->platforms = NULL;
-        game->current_level_data->num_platforms = 0;
-
-        if (game->current_level_data->enemies) free(game->current_level_data->enemies);
-        game->current_level_data->enemies = NULL;
-        game->current_level_data->num_enemies = 0;
-
-        if (game->current_level_data->glucose_items) free(game->current_level_data->glucose_items);
-        game->current_level_data->glucose_items = NULL;
-        game->current_level_data->num_glucose_items = 0;
-
-        // Reset projectiles
-        if (game->current_level_data->projectiles) {
-            for (int i = 0; i < MAX_PROJECTILES; i++) {
-                game->current_level_data->projectiles[i].active = false;
-            }
-        }
-        game->current_level_data->num_projectiles = 0;
-        
-        // Reset particles
-        if (game->current_level_data->particles) {
-            for (int i = 0; i < MAX_PARTICLES; i++) {
-                game->current_level_data->particles[i].active = false;
-            }
-        }
-        game->current_level_data->num_particles = 0;
-        
-        // Portal and background are handled by init_levels and init_level_content, 
-        // but backgrounds are loaded once in init_levels. Portal is part of level struct.
-
-        init_level_content(game->current_level_data, game->current_level_data->id);
+        // Rewind the level arena to drop the old platforms, enemies, glucose items
+        // and pool chunks, then rebuild the content in the same memory.
+        // Background tiles are baked once in init_levels and are left untouched.
+        reset_level_content(game->current_level_data);
     } else {
         fprintf(stderr, "Error: current_level_data is NULL during reset_player_and_level\n");
     }
 
     // Reset scroll position
-    game->current_level_data->scroll_x = 0;
+    reset_camera(&game->camera);
 }
 
-// Original update_game function from main.c
-void update_game(Game* game) {
-    if (game->state != PLAYING) {
-        return;
-    }
-
+// Player input, jumps and timers; the physics stage moves the player
+static void update_player_task(void* data) {
+    Game* game = data;
+    
     // Enhanced jump system with coyote time and jump buffering
     
     // Handle jump buffering - store jump input for a few frames
@@ -471,157 +624,76 @@ void update_game(Game* game) {
         }
     }
     
-    // Update knockback effects for player
-    if (game->player.knockback_timer > 0) {
-        game->player.x += game->player.knockback_dx;
-        game->player.y += game->player.knockback_dy;
-        game->player.knockback_timer--;
-        
-        // Reduce knockback force over time
-        game->player.knockback_dx *= 0.9f;
-        game->player.knockback_dy *= 0.9f;
-        
-        if (game->player.knockback_timer <= 0) {
-            game->player.knockback_dx = 0.0f;
-            game->player.knockback_dy = 0.0f;
-        }
-    }
-    
     game->player.jump_requested = false; // Reset jump request flag
     
-    game->player.x += game->player.dx;
-    game->player.y += game->player.dy;
-    
-    game->player.dy += GRAVITY;
-    game->player.is_on_ground = false;
-    
-    for (int i = 0; i < game->current_level_data->num_platforms; i++) {
-        Platform* platform = &game->current_level_data->platforms[i];
-        if (game->player.x < platform->x + platform->width &&
-            game->player.x + game->player.width > platform->x &&
-            game->player.y < platform->y + platform->height &&
-            game->player.y + game->player.height > platform->y) {
-            
-            if (platform->is_deadly) {
-                game->player.health -= DEADLY_PLATFORM_DAMAGE; 
-                
-                // Play hit sound if enabled
-                if (game->settings.sound_enabled && game->hit_sound) {
-                    al_play_sample(game->hit_sound, 1.0, 0.0, 1.0, ALLEGRO_PLAYMODE_ONCE, NULL);
-                }
-                
-                if (game->player.health <= 0) {
-                    // Play death sound if enabled
-                    if (game->settings.sound_enabled && game->death_sound) {
-                        al_play_sample(game->death_sound, 1.0, 0.0, 1.0, ALLEGRO_PLAYMODE_ONCE, NULL);
-                    }
-                    game->state = GAME_OVER;
-                }
-                // Land on deadly platform too
-                game->player.y = platform->y - game->player.height;
-                game->player.dy = 0;
-                game->player.is_on_ground = true;
-            } else {
-                // Check vertical collision (landing on top or hitting bottom)
-                if (game->player.dy >= 0 && // Moving downwards or still
-                    game->player.y + game->player.height - game->player.dy <= platform->y + PLATFORM_JUMP_TOLERANCE && // Previous position was above or at platform top
-                    game->player.y + game->player.height > platform->y) { // Current position is intersecting or below platform top
-                    game->player.dy = 0;
-                    game->player.y = platform->y - game->player.height;
-                    game->player.is_on_ground = true;
-                } else if (game->player.dy < 0 && // Moving upwards
-                           game->player.y - game->player.dy >= platform->y + platform->height && // Previous position was below platform bottom
-                           game->player.y < platform->y + platform->height) { // Current position is intersecting or above platform bottom
-                    game->player.y = platform->y + platform->height;
-                    game->player.dy = 0; // Stop upward movement
-                }
-
-                // Check horizontal collision (hitting sides), including step-up logic
-                bool vertically_aligned_for_horizontal_check =
-                    (game->player.y < platform->y + platform->height) &&
-                    (game->player.y + game->player.height > platform->y);
-
-                if (vertically_aligned_for_horizontal_check) {
-                    // Moving right
-                    if (game->player.dx > 0 && // Player is moving right
-                        game->player.x + game->player.width - game->player.dx <= platform->x && // Previous right edge was left of or at platform's left edge
-                        game->player.x + game->player.width > platform->x) { // Current right edge is past platform's left edge
-
-                        float player_current_foot_y = game->player.y + game->player.height;
-                        float step_height = player_current_foot_y - platform->y; // Height of the step relative to player's feet
-
-                        // Condition for step-up:
-                        // 1. Platform top is above player's current foot level (step_height > 0).
-                        // 2. The step height is not too large (step_height <= MAX_STEP_UP_HEIGHT).
-                        // 3. Player is on the ground (meaning they have support).
-                        if (step_height > 0 && step_height <= MAX_STEP_UP_HEIGHT && game->player.is_on_ground) {
-                            // Perform step-up
-                            game->player.y = platform->y - game->player.height;
-                            game->player.dy = 0; // Stop any residual vertical movement
-                            game->player.is_on_ground = true; // Ensure player is considered on ground after step
-                            // Player's x position is already advanced by player.dx.
-                            // player.dx is not zeroed, allowing continued movement if key is held.
-                        } else {
-                            // Normal wall collision: stop and align
-                            game->player.x = platform->x - game->player.width;
-                            game->player.dx = 0;
-                            // Track wall contact for wall jumping
-                            game->player.wall_contact_right = WALL_JUMP_FRAMES;
-                        }
-                    }
-                    // Moving left
-                    else if (game->player.dx < 0 && // Player is moving left
-                               game->player.x - game->player.dx >= platform->x + platform->width && // Previous left edge was right of or at platform's right edge
-                               game->player.x < platform->x + platform->width) { // Current left edge is past platform's right edge
-
-                        float player_current_foot_y = game->player.y + game->player.height;
-                        float step_height = player_current_foot_y - platform->y;
-
-                        if (step_height > 0 && step_height <= MAX_STEP_UP_HEIGHT && game->player.is_on_ground) {
-                            // Perform step-up
-                            game->player.y = platform->y - game->player.height;
-                            game->player.dy = 0;
-                            game->player.is_on_ground = true;
-                        } else {
-                            // Normal wall collision: stop and align
-                            game->player.x = platform->x + platform->width;
-                            game->player.dx = 0;
-                            // Track wall contact for wall jumping
-                            game->player.wall_contact_left = WALL_JUMP_FRAMES;
-                        }
-                    }
-                } // End of horizontal collision check
-            }
-        }
-    }
+    // The physics stage moves the player and resolves the platforms
+    move_body(&game->player, game->player.dx, game->player.dy);
     
-    for (int i = 0; i < game->current_level_data->num_enemies; i++) {
-        if (game->current_level_data->enemies[i].active) {
-            update_enemy(&game->current_level_data->enemies[i], game);
-        }
+    // Attack momentum - boost player speed when attacking in movement direction.
+    // Queued here so it moves with this tick; the attack stage runs after physics.
+    if (game->player.state == ATTACKING && game->player.dx != 0) {
+        float momentum_boost = (game->player.dx > 0) ? ATTACK_MOMENTUM_BOOST : -ATTACK_MOMENTUM_BOOST;
+        move_body(&game->player, momentum_boost, 0.0f);
     }
+}
+
+// Dead enemies free their slots and due waves come in, before anything
+// else looks at the enemies this update
+static void spawner_task(void* data) {
+    Game* game = data;
+    update_spawner(game->current_level_data, game->player.x);
+}
+
+// Enemy AI; may fire projectiles and hurt the player
+static void update_enemies_task(void* data) {
+    Game* game = data;
+    update_enemies(game);
+}
+
+// Move every body, then react to what the player touched
+static void physics_task(void* data) {
+    Game* game = data;
+    step_physics(game->current_level_data, &game->player);
     
-    // Update projectiles
+    // Hazard damage comes from the level's triggers (contacts_task)
+    unsigned int contacts = game->player.body.contacts;
+    // Track wall contact for wall jumping
+    if (contacts & PHYS_CONTACT_WALL_RIGHT) game->player.wall_contact_right = WALL_JUMP_FRAMES;
+    if (contacts & PHYS_CONTACT_WALL_LEFT) game->player.wall_contact_left = WALL_JUMP_FRAMES;
+}
+
+static void update_projectiles_task(void* data) {
+    Game* game = data;
     update_projectiles(game->current_level_data, game);
-    check_projectile_collisions(game->current_level_data, game);
-    
-    // Update particles
+}
+
+// Only touches existing particles, so it can run alongside the stages above
+static void update_particles_task(void* data) {
+    Game* game = data;
     update_particles(game->current_level_data);
-    
-    // Update screen shake
-    update_screen_shake(game);
+}
+
+// Join point: particles spawned by the concurrent stages enter the pool here
+static void projectile_collisions_task(void* data) {
+    Game* game = data;
+    flush_deferred_particles(game->current_level_data);
+    check_projectile_collisions(game->current_level_data, game);
+}
+
+static void screen_shake_task(void* data) {
+    update_screen_shake(data);
+}
+
+// Melee attack and weapon cooldowns
+static void player_attack_task(void* data) {
+    Game* game = data;
     
     // Handle player attack with enhanced combat system
     if (game->player.state == ATTACKING) {
-        // Apply attack momentum - boost player speed when attacking in movement direction
-        if (game->player.dx != 0) {
-            float momentum_boost = (game->player.dx > 0) ? ATTACK_MOMENTUM_BOOST : -ATTACK_MOMENTUM_BOOST;
-            game->player.x += momentum_boost;
-        }
-        
         // Check for enemies in attack range
-        for (int i = 0; i < game->current_level_data->num_enemies; i++) {
-            Entity* enemy = &game->current_level_data->enemies[i];
+        ChunkPool* enemies = &game->current_level_data->enemies;
+        for (int i = pool_first(enemies); i != POOL_SLOT_NONE; i = pool_next(enemies, i)) {
+            Entity* enemy = pool_at(enemies, i);
             if (!enemy->active) continue;
             
             float dx = enemy->x - game->player.x;
@@ -663,9 +735,7 @@ void update_game(Game* game) {
                     float knockback_dx = (dx / distance) * KNOCKBACK_FORCE;
                     float knockback_dy = (dy / distance) * KNOCKBACK_FORCE * 0.5f; // Less vertical knockback
                     
-                    enemy->knockback_dx = knockback_dx;
-                    enemy->knockback_dy = knockback_dy;
-                    enemy->knockback_timer = KNOCKBACK_DURATION;
+                    knock_body(enemy, knockback_dx, knockback_dy, KNOCKBACK_DURATION);
                 }
                 
                 // Enhanced visual feedback
@@ -717,40 +787,106 @@ void update_game(Game* game) {
     if (game->player.last_shot > 0) {
         game->player.last_shot--;
     }
+}
+
+// Sprite clips of the player and bosses, picked from the state they were
+// left in by the earlier stages
+static void animation_task(void* data) {
+    Game* game = data;
+    if (!game->animations) return;
+    
+    animate_player(game->animations, &game->player);
+    ChunkPool* enemies = &game->current_level_data->enemies;
+    for (int i = pool_first(enemies); i != POOL_SLOT_NONE; i = pool_next(enemies, i)) {
+        Entity* enemy = pool_at(enemies, i);
+        if (enemy->active && enemy->behavior == BEHAVIOR_BOSS) {
+            animate_boss(game->animations, enemy);
+        }
+    }
+}
+
+static void collect_glucose(Game* game, GlucoseItem* item) {
+    item->active = false; // Deactivate the item
+    game->player.health += GLUCOSE_HEALTH_RECOVERY;
+    if (game->player.health > game->player.max_health) {
+        game->player.health = game->player.max_health;
+    }
+    
+    // Create collection particle effect
+    create_particle_burst(game->current_level_data, 
+                        item->x + GLUCOSE_WIDTH/2, 
+                        item->y + GLUCOSE_HEIGHT/2, 
+                        al_map_rgb(255, 105, 180), 12);
+    
+    // Play collect sound if enabled
+    if (game->settings.sound_enabled && game->collect_sound) {
+        al_play_sample(game->collect_sound, 1.0, 0.0, 1.0, ALLEGRO_PLAYMODE_ONCE, NULL);
+    }
+    
+    // Visual feedback could be added here (particle effect, score popup)
+    printf("Glucose collected! Health: %.0f/%.0f\n", 
+           game->player.health, game->player.max_health);
+}
+
+static void touch_hazard(Game* game) {
+    game->player.health -= DEADLY_PLATFORM_DAMAGE;
+    
+    // Play hit sound if enabled
+    if (game->settings.sound_enabled && game->hit_sound) {
+        al_play_sample(game->hit_sound, 1.0, 0.0, 1.0, ALLEGRO_PLAYMODE_ONCE, NULL);
+    }
+    
+    if (game->player.health <= 0) {
+        // Play death sound if enabled
+        if (game->settings.sound_enabled && game->death_sound) {
+            al_play_sample(game->death_sound, 1.0, 0.0, 1.0, ALLEGRO_PLAYMODE_ONCE, NULL);
+        }
+        game->state = GAME_OVER;
+    }
+}
+
+// Enemy contact damage, then the triggers the player is in: glucose
+// pickups, hazards and the portal. Hazards hurt once per update however
+// many of them the player touches.
+static void contacts_task(void* data) {
+    Game* game = data;
+    Level* level = game->current_level_data;
+    Entity* player = &game->player;
     
     handle_collisions(game);
     
-    // Check for collision with glucose items
-    for (int i = 0; i < game->current_level_data->num_glucose_items; i++) {
-        GlucoseItem* item = &game->current_level_data->glucose_items[i];
-        if (item->active &&
-            game->player.x < item->x + GLUCOSE_WIDTH &&
-            game->player.x + game->player.width > item->x &&
-            game->player.y < item->y + GLUCOSE_HEIGHT &&
-            game->player.y + game->player.height > item->y) {
-            
-            item->active = false; // Deactivate the item
-            game->player.health += GLUCOSE_HEALTH_RECOVERY;
-            if (game->player.health > game->player.max_health) {
-                game->player.health = game->player.max_health;
+    int first, last;
+    bool hurt = false, finished = false;
+    seek_triggers(&level->triggers, player->x, player->x + player->width, &first, &last);
+    for (int i = first; i < last; i++) {
+        const Trigger* trigger = &level->triggers.triggers[i];
+        if (!trigger_overlaps(trigger, player->x, player->y, player->width, player->height)) continue;
+        switch (trigger->kind) {
+            case TRIGGER_GLUCOSE: {
+                GlucoseItem* item = &level->glucose_items[trigger->item];
+                if (item->active) collect_glucose(game, item);
+                break;
             }
-            
-            // Create collection particle effect
-            create_particle_burst(game->current_level_data, 
-                                item->x + GLUCOSE_WIDTH/2, 
-                                item->y + GLUCOSE_HEIGHT/2, 
-                                al_map_rgb(255, 105, 180), 12);
-            
-            // Play collect sound if enabled
-            if (game->settings.sound_enabled && game->collect_sound) {
-                al_play_sample(game->collect_sound, 1.0, 0.0, 1.0, ALLEGRO_PLAYMODE_ONCE, NULL);
-            }
-            
-            // Visual feedback could be added here (particle effect, score popup)
-            printf("Glucose collected! Health: %.0f/%.0f\n", 
-                   game->player.health, game->player.max_health);
+            case TRIGGER_HAZARD:
+                hurt = true;
+                break;
+            case TRIGGER_PORTAL:
+                finished = level->portal.is_active;
+                break;
         }
     }
+    if (hurt) touch_hazard(game);
+    if (finished && game->state == PLAYING) {
+        game->state = LEVEL_COMPLETE;
+        
+        // Finalize stars for completed level
+        finalize_level_stars(game);
+    }
+}
+
+// Level bounds and camera scroll
+static void update_world_task(void* data) {
+    Game* game = data;
     
     if (game->player.x < 0) game->player.x = 0;
     if (game->player.x > game->current_level_data->level_width - game->player.width) {
@@ -769,61 +905,67 @@ void update_game(Game* game) {
         game->player.dy = 0;
     }
     
-    game->current_level_data->scroll_x = game->player.x - SCREEN_WIDTH * SCROLL_X_PLAYER_OFFSET_FACTOR;
-    if (game->current_level_data->scroll_x < 0) {
-        game->current_level_data->scroll_x = 0;
-    }
-    if (game->current_level_data->level_width > SCREEN_WIDTH && // Only scroll if level is wider than screen
-        game->current_level_data->scroll_x > game->current_level_data->level_width - SCREEN_WIDTH) {
-        game->current_level_data->scroll_x = game->current_level_data->level_width - SCREEN_WIDTH;
-    }
-    if (game->current_level_data->level_width <= SCREEN_WIDTH) { // Don't scroll if level fits on screen
-        game->current_level_data->scroll_x = 0;
-    }
+    follow_camera(&game->camera, game->player.x, game->current_level_data->level_width);
+}
 
-    Portal* portal = &game->current_level_data->portal;
-    if (portal->is_active && 
-        game->player.x < portal->x + portal->width &&
-        game->player.x + game->player.width > portal->x &&
-        game->player.y < portal->y + portal->height &&
-        game->player.y + game->player.height > portal->y) {
-        game->state = LEVEL_COMPLETE;
-        
-        // Finalize stars for completed level
-        finalize_level_stars(game);
+// Declare the update_game stages and the order they depend on. Particle
+// integration is independent of the player/enemy/projectile chain and runs
+// alongside it; everything from projectile collisions on runs in order.
+static void build_update_graph(Game* game) {
+    TaskGraph* graph = &game->update_graph;
+    init_task_graph(graph);
+    
+    int player = add_task(graph, "player", update_player_task, game);
+    int spawner = add_task(graph, "spawner", spawner_task, game);
+    int enemies = add_task(graph, "enemies", update_enemies_task, game);
+    int physics = add_task(graph, "physics", physics_task, game);
+    int projectiles = add_task(graph, "projectiles", update_projectiles_task, game);
+    int particles = add_task(graph, "particles", update_particles_task, game);
+    int collisions = add_task(graph, "projectile collisions", projectile_collisions_task, game);
+    int shake = add_task(graph, "screen shake", screen_shake_task, game);
+    int animation = add_task(graph, "animation", animation_task, game);
+    int attack = add_task(graph, "player attack", player_attack_task, game);
+    int contacts = add_task(graph, "contacts", contacts_task, game);
+    int world = add_task(graph, "world", update_world_task, game);
+    
+    add_task_dependency(graph, spawner, player);
+    add_task_dependency(graph, enemies, spawner);
+    add_task_dependency(graph, physics, enemies);
+    add_task_dependency(graph, projectiles, physics);
+    add_task_dependency(graph, collisions, projectiles);
+    add_task_dependency(graph, collisions, particles);
+    add_task_dependency(graph, shake, collisions);
+    // Attack state is cleared by the attack stage, so clips are picked before it
+    add_task_dependency(graph, animation, shake);
+    add_task_dependency(graph, attack, animation);
+    add_task_dependency(graph, contacts, attack);
+    add_task_dependency(graph, world, contacts);
+}
+
+// Original update_game function from main.c
+void update_game(Game* game) {
+    if (game->state != PLAYING) {
+        return;
     }
+
+    // Particles spawned before the join are queued, so the particle pool is
+    // only ever touched by the particle stage while stages run concurrently.
+    // The serial fallback queues them too and so behaves the same.
+    game->current_level_data->defer_particles = true;
+    run_task_graph(&game->jobs, &game->update_graph);
 }
 
 // Screen shake effect functions
 void create_screen_shake(Game* game, float intensity, int duration) {
     if (!game) return;
     
-    // Only apply if new shake is stronger or current shake is ending
-    if (intensity > game->screen_shake.intensity || game->screen_shake.duration < 10) {
-        game->screen_shake.intensity = intensity;
-        game->screen_shake.duration = duration;
-    }
+    shake_camera(&game->camera, intensity, duration);
 }
 
 void update_screen_shake(Game* game) {
     if (!game) return;
     
-    if (game->screen_shake.duration > 0) {
-        // Calculate random offset based on intensity
-        float max_offset = game->screen_shake.intensity;
-        game->screen_shake.offset_x = ((rand() % 200) - 100) / 100.0f * max_offset;
-        game->screen_shake.offset_y = ((rand() % 200) - 100) / 100.0f * max_offset;
-        
-        // Gradually reduce intensity and duration
-        game->screen_shake.duration--;
-        game->screen_shake.intensity *= 0.95f; // Gradual fade
-        
-        if (game->screen_shake.duration <= 0) {
-            game->screen_shake.intensity = 0;
-            game->screen_shake.offset_x = 0;
-            game->screen_shake.offset_y = 0;
-        }
-    }
+    update_camera_shake(&game->camera);
 }
 
 // Original cleanup_menus function from main.c
@@ -847,6 +989,11 @@ void cleanup_menus(Game* game) {
 
 // Original cleanup_game function from main.c
 void cleanup_game(Game* game) {
+    // Stop drawing before anything the renderer uses is destroyed
+    cleanup_renderer(game);
+    cleanup_drawing(game);
+    report_task_graph(&game->jobs, &game->update_graph);
+    cleanup_job_system(&game->jobs);
     cleanup_menus(game);
     cleanup_levels(game); // This is now in level.c but called from here
     
@@ -866,16 +1013,22 @@ void cleanup_game(Game* game) {
         if (game->star_filled[i]) al_destroy_bitmap(game->star_filled[i]);
     }
     
+    // Entity sprites point into the animation atlas
+    if (game->animations) {
+        destroy_animations(game->animations);
+        free(game->animations);
+        game->animations = NULL;
+    }
+    
     // Allegro addons are shutdown by al_uninstall_system() implicitly if initialized
     // but specific resource destruction is good practice.
 
     if (game->event_queue) al_destroy_event_queue(game->event_queue);
     if (game->timer) al_destroy_timer(game->timer);
+    if (game->menu_timer) al_destroy_timer(game->menu_timer);
+    if (game->pause_frame) al_destroy_bitmap(game->pause_frame);
     if (game->display) al_destroy_display(game->display);
-
-    // Player sprites are not currently loaded, but if they were:
-    // if (game->player.sprite) al_destroy_bitmap(game->player.sprite);
-    // if (game->player.sprite_sheet) al_destroy_bitmap(game->player.sprite_sheet);
+    close_asset_pack(); // Nothing loaded from it is still reading
 
     // Consider al_shutdown_primitives_addon(), al_shutdown_font_addon(), etc.
     // if not relying on al_uninstall_system(). For now, al_uninstall_system() in main is fine.
@@ -925,12 +1078,12 @@ void update_stars_on_enemy_kill(Game* game, Entity* enemy) {
         printf("Normal enemy defeated! Star progress updated.\n");
     }
     
-    // Check if all enemies are now defeated
-    bool all_enemies_dead = true;
-    for (int i = 0; i < game->current_level_data->num_enemies; i++) {
-        if (game->current_level_data->enemies[i].active) {
+    // Check if all enemies are now defeated, including waves still to come
+    bool all_enemies_dead = all_waves_spawned(game->current_level_data);
+    ChunkPool* enemies = &game->current_level_data->enemies;
+    for (int i = pool_first(enemies); i != POOL_SLOT_NONE && all_enemies_dead; i = pool_next(enemies, i)) {
+        if (((Entity*)pool_at(enemies, i))->active) {
             all_enemies_dead = false;
-            break;
         }
     }
     
@@ -99,7 +99,15 @@ void handle_menu_input(Game* game, ALLEGRO_EVENT* event) {
                                     sprintf(current_menu->items[2].text, "Music: %s",
                                         game->settings.music_enabled ? "On" : "Off");
                                     break;
-                                case 3: game->state = MAIN_MENU; break;
+                                case 3: // Render scale, 100% down to RENDER_SCALE_MIN and around again
+                                    game->settings.render_scale -= RENDER_SCALE_STEP;
+                                    if (game->settings.render_scale < RENDER_SCALE_MIN) {
+                                        game->settings.render_scale = 100;
+                                    }
+                                    sprintf(current_menu->items[3].text, "Render Scale: %d%%",
+                                        game->settings.render_scale);
+                                    break;
+                                case 4: game->state = MAIN_MENU; break;
                             }
                             break;
                         default: break;
@@ -117,6 +125,12 @@ void handle_menu_input(Game* game, ALLEGRO_EVENT* event) {
 
 // Original handle_input function from main.c
 void handle_input(Game* game, ALLEGRO_EVENT* event) {
+    // Debug views work on every screen
+    if (event->type == ALLEGRO_EVENT_KEY_DOWN && event->keyboard.keycode == OVERDRAW_VIEW_KEY) {
+        game->show_overdraw = !game->show_overdraw;
+        return;
+    }
+
     if (game->state == WELCOME_SCREEN || game->state == MAIN_MENU || 
         game->state == LEVEL_SELECT || game->state == SETTINGS || game->state == VICTORY) {
         handle_menu_input(game, event);
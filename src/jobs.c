@@ -0,0 +1,287 @@
+#include "../include/jobs.h"
+#include <stdio.h>   // For printf, fprintf
+#include <string.h>  // For memset
+
+static void push_task(TaskQueue* queue, int task) {
+    al_lock_mutex(queue->lock);
+    queue->items[queue->bottom % TASK_GRAPH_MAX_TASKS] = task;
+    queue->bottom++;
+    al_unlock_mutex(queue->lock);
+}
+
+// Owner side: newest task first, which keeps a chain of tasks on one thread
+static int pop_task(TaskQueue* queue) {
+    int task = -1;
+    al_lock_mutex(queue->lock);
+    if (queue->bottom > queue->top) {
+        queue->bottom--;
+        task = queue->items[queue->bottom % TASK_GRAPH_MAX_TASKS];
+    }
+    al_unlock_mutex(queue->lock);
+    return task;
+}
+
+// Thief side: oldest task first
+static int steal_task(TaskQueue* queue) {
+    int task = -1;
+    al_lock_mutex(queue->lock);
+    if (queue->bottom > queue->top) {
+        task = queue->items[queue->top % TASK_GRAPH_MAX_TASKS];
+        queue->top++;
+    }
+    al_unlock_mutex(queue->lock);
+    return task;
+}
+
+// Queue a ready task on the given thread's queue and wake a sleeper. The
+// count goes up under the lock before the push, so a thief taking the task
+// at once never brings it below zero.
+static void queue_task(JobSystem* jobs, int index, int task) {
+    al_lock_mutex(jobs->lock);
+    jobs->queued++;
+    push_task(&jobs->queues[index], task);
+    al_broadcast_cond(jobs->wake);
+    al_unlock_mutex(jobs->lock);
+}
+
+static int take_task(JobSystem* jobs, int index) {
+    int task = pop_task(&jobs->queues[index]);
+    bool stolen = false;
+    for (int i = 1; task < 0 && i <= jobs->num_threads; i++) {
+        task = steal_task(&jobs->queues[(index + i) % (jobs->num_threads + 1)]);
+        stolen = task >= 0;
+    }
+    if (task >= 0) {
+        al_lock_mutex(jobs->lock);
+        jobs->queued--;
+        if (stolen) jobs->steals++;
+        al_unlock_mutex(jobs->lock);
+    }
+    return task;
+}
+
+static void execute_task(TaskGraph* graph, int index, int task_index) {
+    Task* task = &graph->tasks[task_index];
+    double start = al_get_time();
+    task->func(task->data);
+    double elapsed = al_get_time() - start;
+
+    task->last_time = elapsed;
+    task->total_time += elapsed;
+    if (elapsed > task->max_time) task->max_time = elapsed;
+    task->runs++;
+    task->last_thread = index;
+}
+
+// Run a task, then release the tasks waiting on it
+static void run_task(JobSystem* jobs, int index, int task_index) {
+    TaskGraph* graph = jobs->graph;
+    Task* task = &graph->tasks[task_index];
+    execute_task(graph, index, task_index);
+
+    int ready[TASK_MAX_DEPENDENTS];
+    int num_ready = 0;
+    al_lock_mutex(jobs->lock);
+    for (int i = 0; i < task->num_dependents; i++) {
+        Task* dependent = &graph->tasks[task->dependents[i]];
+        if (--dependent->pending == 0) {
+            ready[num_ready++] = task->dependents[i];
+        }
+    }
+    jobs->remaining--;
+    if (jobs->remaining == 0) {
+        al_broadcast_cond(jobs->wake);
+    }
+    al_unlock_mutex(jobs->lock);
+
+    for (int i = 0; i < num_ready; i++) {
+        queue_task(jobs, index, ready[i]);
+    }
+}
+
+// Work until told to quit (workers) or until the graph is done (caller)
+static void work(JobSystem* jobs, int index) {
+    bool caller = index == 0;
+    while (true) {
+        int task = take_task(jobs, index);
+        if (task >= 0) {
+            run_task(jobs, index, task);
+            continue;
+        }
+
+        al_lock_mutex(jobs->lock);
+        bool done = caller ? jobs->remaining == 0 : jobs->quit;
+        if (!done && jobs->queued == 0) {
+            al_wait_cond(jobs->wake, jobs->lock);
+        }
+        al_unlock_mutex(jobs->lock);
+        if (done) return;
+    }
+}
+
+static void* worker_thread(ALLEGRO_THREAD* thread, void* arg) {
+    JobWorker* worker = arg;
+    work(worker->system, worker->index);
+    return NULL;
+}
+
+bool init_job_system(JobSystem* jobs, int num_threads) {
+    memset(jobs, 0, sizeof(*jobs));
+    if (num_threads > JOB_MAX_WORKERS) num_threads = JOB_MAX_WORKERS;
+    if (num_threads <= 0) return true; // Serial mode needs no threads or locks
+
+    jobs->lock = al_create_mutex();
+    jobs->wake = al_create_cond();
+    if (!jobs->lock || !jobs->wake) {
+        fprintf(stderr, "Failed to create job system locks, running tasks serially\n");
+        cleanup_job_system(jobs);
+        return false;
+    }
+    for (int i = 0; i <= num_threads; i++) {
+        jobs->queues[i].lock = al_create_mutex();
+        if (!jobs->queues[i].lock) {
+            fprintf(stderr, "Failed to create job queue lock, running tasks serially\n");
+            cleanup_job_system(jobs);
+            return false;
+        }
+        jobs->workers[i].system = jobs;
+        jobs->workers[i].index = i;
+    }
+
+    // Queues exist for every worker before the first one starts stealing
+    jobs->num_threads = num_threads;
+    for (int i = 0; i < num_threads; i++) {
+        jobs->threads[i] = al_create_thread(worker_thread, &jobs->workers[i + 1]);
+        if (!jobs->threads[i]) {
+            fprintf(stderr, "Failed to create job worker thread, running tasks serially\n");
+            cleanup_job_system(jobs);
+            return false;
+        }
+        al_start_thread(jobs->threads[i]);
+    }
+    return true;
+}
+
+void cleanup_job_system(JobSystem* jobs) {
+    if (jobs->lock) {
+        al_lock_mutex(jobs->lock);
+        jobs->quit = true;
+        if (jobs->wake) al_broadcast_cond(jobs->wake);
+        al_unlock_mutex(jobs->lock);
+    }
+    for (int i = 0; i < JOB_MAX_WORKERS; i++) {
+        if (jobs->threads[i]) {
+            al_join_thread(jobs->threads[i], NULL);
+            al_destroy_thread(jobs->threads[i]);
+            jobs->threads[i] = NULL;
+        }
+    }
+    for (int i = 0; i <= JOB_MAX_WORKERS; i++) {
+        if (jobs->queues[i].lock) al_destroy_mutex(jobs->queues[i].lock);
+        jobs->queues[i].lock = NULL;
+    }
+    if (jobs->wake) al_destroy_cond(jobs->wake);
+    if (jobs->lock) al_destroy_mutex(jobs->lock);
+    jobs->wake = NULL;
+    jobs->lock = NULL;
+    jobs->num_threads = 0;
+}
+
+void init_task_graph(TaskGraph* graph) {
+    memset(graph, 0, sizeof(*graph));
+}
+
+int add_task(TaskGraph* graph, const char* name, TaskFunc func, void* data) {
+    if (graph->num_tasks >= TASK_GRAPH_MAX_TASKS) {
+        fprintf(stderr, "Task graph is full, cannot add task %s\n", name);
+        return -1;
+    }
+    Task* task = &graph->tasks[graph->num_tasks];
+    memset(task, 0, sizeof(*task));
+    task->name = name;
+    task->func = func;
+    task->data = data;
+    return graph->num_tasks++;
+}
+
+bool add_task_dependency(TaskGraph* graph, int task, int dependency) {
+    if (task < 0 || dependency < 0 || task >= graph->num_tasks || dependency >= graph->num_tasks) {
+        return false;
+    }
+    Task* before = &graph->tasks[dependency];
+    if (before->num_dependents >= TASK_MAX_DEPENDENTS) {
+        fprintf(stderr, "Too many tasks depend on %s\n", before->name);
+        return false;
+    }
+    before->dependents[before->num_dependents++] = task;
+    graph->tasks[task].num_deps++;
+    return true;
+}
+
+// Deterministic fallback: repeatedly run the first ready task in the order
+// the tasks were added
+static void run_task_graph_serial(TaskGraph* graph) {
+    bool done[TASK_GRAPH_MAX_TASKS] = { false };
+    int finished = 0;
+    while (finished < graph->num_tasks) {
+        int next = -1;
+        for (int i = 0; i < graph->num_tasks; i++) {
+            if (!done[i] && graph->tasks[i].pending == 0) {
+                next = i;
+                break;
+            }
+        }
+        if (next < 0) {
+            fprintf(stderr, "Task graph has a dependency cycle\n");
+            return;
+        }
+
+        execute_task(graph, 0, next);
+        done[next] = true;
+        finished++;
+        for (int i = 0; i < graph->tasks[next].num_dependents; i++) {
+            graph->tasks[graph->tasks[next].dependents[i]].pending--;
+        }
+    }
+}
+
+void run_task_graph(JobSystem* jobs, TaskGraph* graph) {
+    // Find the roots before queueing any: once the first one is queued,
+    // workers start lowering the pending counts of the other tasks
+    int roots[TASK_GRAPH_MAX_TASKS];
+    int num_roots = 0;
+    for (int i = 0; i < graph->num_tasks; i++) {
+        graph->tasks[i].pending = graph->tasks[i].num_deps;
+        if (graph->tasks[i].pending == 0) roots[num_roots++] = i;
+    }
+
+    if (jobs->num_threads == 0) {
+        run_task_graph_serial(graph);
+        return;
+    }
+
+    al_lock_mutex(jobs->lock);
+    jobs->graph = graph;
+    jobs->remaining = graph->num_tasks;
+    al_unlock_mutex(jobs->lock);
+
+    for (int i = 0; i < num_roots; i++) {
+        queue_task(jobs, 0, roots[i]);
+    }
+    work(jobs, 0);
+
+    al_lock_mutex(jobs->lock);
+    jobs->graph = NULL;
+    al_unlock_mutex(jobs->lock);
+}
+
+void report_task_graph(const JobSystem* jobs, const TaskGraph* graph) {
+    printf("Task graph: %d tasks on %d threads, %d steals\n",
+           graph->num_tasks, jobs->num_threads + 1, jobs->steals);
+    for (int i = 0; i < graph->num_tasks; i++) {
+        const Task* task = &graph->tasks[i];
+        double average = task->runs > 0 ? task->total_time / task->runs : 0.0;
+        printf("  %-20s %6d runs, avg %.3f ms, max %.3f ms\n", task->name, task->runs,
+               average * 1000.0, task->max_time * 1000.0);
+    }
+}
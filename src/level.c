@@ -1,58 +1,136 @@
 #include "../include/level.h"
 #include "../include/game.h" // For Game, Level, Platform, Entity, Portal types, constants
-#include <stdio.h>    // For sprintf, fprintf
+#include "../include/texture_format.h" // For find_scene_variant
+#include "../include/spawner.h"  // For init_spawner, report_spawner
+#include "../include/enemy_batch.h" // For init_enemy_batches, clear_enemy_batches
+#include <stdio.h>    // For sprintf, snprintf, fprintf
 #include <stdlib.h>   // For malloc, free
-#include <string.h>   // For strdup
 #include <math.h>     // For sin in level generation
+#include <string.h>   // For memset
+
+static void init_level_geometry(Level* level);
 
 // Original init_level function from main.c
 void init_level(Level* level, const char* name, const char* description, float width, int id) { // Added id parameter
+    // All level-owned memory comes from the level's arena
+    if (!arena_init(&level->arena, LEVEL_ARENA_BLOCK_BYTES)) {
+        fprintf(stderr, "Failed to create memory arena for level %d\n", id);
+    }
+    
     level->platforms = NULL;
-    level->enemies = NULL;
     level->glucose_items = NULL; // Initialize glucose_items
-    level->projectiles = NULL;   // Initialize projectiles
-    level->particles = NULL;     // Initialize particles
     level->num_platforms = 0;
-    level->num_enemies = 0;
     level->num_glucose_items = 0; // Initialize num_glucose_items
-    level->num_projectiles = 0;   // Initialize num_projectiles
-    level->num_particles = 0;     // Initialize num_particles
     level->background = NULL;
     // Initialize multi-background fields
-    for (int i = 0; i < 4; i++) {
-        level->backgrounds[i] = NULL;
-    }
     level->num_backgrounds = 0;
-    level->background_positions = NULL;
-    level->scroll_x = 0;
+    level->background_positions = arena_calloc(&level->arena, 4, sizeof(float));
+    init_background_tiles(&level->background_tiles, &level->arena, BACKGROUND_TILE_BUDGET);
+    memset(&level->tilemap, 0, sizeof(level->tilemap));
+    memset(&level->triggers, 0, sizeof(level->triggers));
+    init_static_chunks(&level->static_chunks);
+    level->pool_budget.used = 0;
+    level->pool_budget.peak = 0;
     level->level_width = width;
-    level->level_name = strdup(name);
-    level->level_description = strdup(description);
+    level->level_height = SCREEN_HEIGHT;
+    level->level_name = arena_strdup(&level->arena, name);
+    level->level_description = arena_strdup(&level->arena, description);
     level->id = id; // Store the level id
     
-    // Allocate projectile array
-    level->projectiles = (Projectile*)malloc(sizeof(Projectile) * MAX_PROJECTILES);
-    if (level->projectiles) {
-        // Initialize all projectiles as inactive
-        for (int i = 0; i < MAX_PROJECTILES; i++) {
-            level->projectiles[i].active = false;
-        }
-    } else {
-        fprintf(stderr, "Failed to allocate memory for projectiles in level %d\n", id);
-    }
+    // Projectile and particle pools start empty and grow in chunks on demand.
+    // Both recycle their oldest element once the level budget is exhausted,
+    // so a new shot is never dropped.
+    pool_init(&level->projectiles, "projectiles", sizeof(Projectile), PROJECTILE_POOL_CHUNK,
+              0, POOL_OVERFLOW_EVICT_OLDEST, &level->pool_budget, &level->arena);
+    pool_init(&level->particles, "particles", sizeof(Particle), PARTICLE_POOL_CHUNK,
+              0, POOL_OVERFLOW_EVICT_OLDEST, &level->pool_budget, &level->arena);
+    // Enemy slots are reserved by init_spawner for the level's waves. A
+    // full pool turns spawns away rather than replacing a live enemy.
+    pool_init(&level->enemies, "enemies", sizeof(Entity), ENEMY_POOL_CHUNK,
+              (sizeof(PoolLink) + sizeof(Entity)) * LEVEL_MAX_ENEMIES, POOL_OVERFLOW_REJECT,
+              NULL, &level->arena);
+    init_enemy_batches(&level->batches, &level->arena, LEVEL_MAX_ENEMIES);
+    pool_init(&level->particle_spawns, "particle spawns", sizeof(Particle), PARTICLE_POOL_CHUNK,
+              0, POOL_OVERFLOW_EVICT_OLDEST, &level->pool_budget, &level->arena);
+    level->defer_particles = false;
+    set_level_pool_budget(level, LEVEL_POOL_BUDGET_BYTES);
     
-    // Allocate particle array
-    level->particles = (Particle*)malloc(sizeof(Particle) * MAX_PARTICLES);
-    if (level->particles) {
-        // Initialize all particles as inactive
-        for (int i = 0; i < MAX_PARTICLES; i++) {
-            level->particles[i].active = false;
+    // Portal is initialized in init_level_content
+}
+
+// Rebuild a level's content in place. Enemies, glucose items and pool
+// chunks are all released by rewinding the arena to the content mark.
+void reset_level_content(Level* level) {
+    pool_destroy(&level->enemies);
+    clear_enemy_batches(&level->batches);
+    pool_destroy(&level->projectiles);
+    pool_destroy(&level->particles);
+    pool_destroy(&level->particle_spawns);
+    level->defer_particles = false;
+    arena_rewind(&level->arena, level->content_mark);
+    
+    level->glucose_items = NULL;
+    level->num_glucose_items = 0;
+    
+    init_level_content(level, level->id);
+}
+
+// Set the pool memory budget of a level. Particles are purely cosmetic and
+// may only claim PARTICLE_BUDGET_SHARE of it, which keeps the rest free for
+// projectiles. The live particles and the spawns deferred during an update
+// split that one share.
+void set_level_pool_budget(Level* level, size_t bytes) {
+    size_t particle_bytes = (size_t)(bytes * PARTICLE_BUDGET_SHARE);
+    level->pool_budget.limit = bytes;
+    level->particle_spawns.max_bytes = (size_t)(particle_bytes * PARTICLE_SPAWN_SHARE);
+    level->particles.max_bytes = particle_bytes - level->particle_spawns.max_bytes;
+}
+
+// Print pool high-water marks and overflow counts for a level
+void report_level_pools(Level* level) {
+    printf("Level %d pool budget: %zu/%zu bytes used, peak %zu\n", level->id,
+           level->pool_budget.used, level->pool_budget.limit, level->pool_budget.peak);
+    pool_report(&level->projectiles);
+    pool_report(&level->particles);
+    pool_report(&level->particle_spawns);
+    report_spawner(level);
+}
+
+// Scene backgrounds of each level, left to right. Each background covers
+// SCREEN_WIDTH x SCREEN_HEIGHT of the level.
+static const char* level_scene_files[3][4] = {
+    {"scene_11", "scene_12", "scene_13", "scene_14_1"},
+    {"scene_21", "scene_22", "scene_23_1", NULL},
+    {"scene_31", "scene_32", "scene_33", "scene_34_1"}
+};
+
+void queue_level_preloads(void) {
+    char name[256];
+    char path[256];
+    for (int level = 0; level < 3; level++) {
+        for (int i = 0; i < 4 && level_scene_files[level][i]; i++) {
+            snprintf(name, sizeof(name), "resources/sprites/%s", level_scene_files[level][i]);
+            find_scene_variant(path, sizeof(path), name, SCREEN_WIDTH);
+            queue_background_preload(path, SCREEN_WIDTH, SCREEN_HEIGHT);
         }
-    } else {
-        fprintf(stderr, "Failed to allocate memory for particles in level %d\n", id);
     }
+}
+
+// Split a level's scene backgrounds into streamed tiles
+static void load_level_backgrounds(Level* level, const char* scene_files[4]) {
+    char name[256];
+    char path[256];
     
-    // Portal is initialized in init_level_content
+    level->num_backgrounds = 0;
+    for (int i = 0; i < 4 && scene_files[i]; i++) {
+        level->background_positions[i] = i * (float)SCREEN_WIDTH;
+        level->num_backgrounds++;
+        
+        snprintf(name, sizeof(name), "resources/sprites/%s", scene_files[i]);
+        find_scene_variant(path, sizeof(path), name, SCREEN_WIDTH);
+        add_background_tiles(&level->background_tiles, path, level->background_positions[i], 0.0f,
+                             SCREEN_WIDTH, SCREEN_HEIGHT);
+    }
 }
 
 // Original init_levels function from main.c
@@ -67,110 +145,158 @@ void init_levels(Game* game) {
     // Level ONE (multi-background system)
     init_level(&game->levels[0], "level ONE",
         "Journey through evolving cellular environments", 4800, 1); // Pass id 1, wider level
-    init_level_content(&game->levels[0], 1);
 
     // Level TWO (multi-background system)
     init_level(&game->levels[1], "level TWO", 
         "Navigate through the blood stream", 4800, 2); // Pass id 2, wider level
-    init_level_content(&game->levels[1], 2);
 
     // Level THREE (multi-background system)
     init_level(&game->levels[2], "level THREE",
         "Face the final cellular challenge", 5120, 3); // Pass id 3, wider level (4 backgrounds)
-    init_level_content(&game->levels[2], 3);
+    set_level_pool_budget(&game->levels[2], LEVEL_POOL_BUDGET_BOSS_BYTES); // Final battle bullet patterns
+
+    for (int i = 0; i < game->num_levels; i++) {
+        Level* level = &game->levels[i];
+        load_level_backgrounds(level, level_scene_files[i]);
+        init_level_geometry(level);
+        
+        // Everything allocated after this mark (content and pool chunks) is
+        // dropped when the level is reset; background tiles and geometry are kept
+        level->content_mark = arena_mark(&level->arena);
+        init_level_content(level, level->id);
+    }
 
     game->current_level_data = &game->levels[0];
-    
-    char path[256];
-    
-    // Load multi-backgrounds for level ONE (index 0)
-    Level* level_one = &game->levels[0];
-    level_one->num_backgrounds = 4;
-    level_one->background_positions = (float*)malloc(sizeof(float) * 4);
-    
-    // Set up background transition positions (each background covers 1280 pixels for 1280x720 screen)
-    level_one->background_positions[0] = 0.0f;     // scene_11_scaled.png from 0-1280
-    level_one->background_positions[1] = 1280.0f;  // scene_12_scaled.png from 1280-2560
-    level_one->background_positions[2] = 2560.0f;  // scene_13_scaled.png from 2560-3840
-    level_one->background_positions[3] = 3840.0f;  // scene_14_1_scaled.png from 3840-5120
-    
-    // Load the scaled scene backgrounds (1280x720) for level ONE
-    const char* scene_files_level1[] = {"scene_11_scaled.png", "scene_12_scaled.png", "scene_13_scaled.png", "scene_14_1_scaled.png"};
-    for (int i = 0; i < 4; i++) {
-        sprintf(path, "resources/sprites/%s", scene_files_level1[i]);
-        level_one->backgrounds[i] = al_load_bitmap(path);
-        if (!level_one->backgrounds[i]) {
-            fprintf(stderr, "Failed to load scene background: %s\n", path);
+}
+
+static int compare_platforms_by_x(const void* a, const void* b) {
+    float ax = ((const Platform*)a)->x;
+    float bx = ((const Platform*)b)->x;
+    return (ax > bx) - (ax < bx);
+}
+
+static int compare_glucose_by_x(const void* a, const void* b) {
+    float ax = ((const GlucoseItem*)a)->x;
+    float bx = ((const GlucoseItem*)b)->x;
+    return (ax > bx) - (ax < bx);
+}
+
+// Platforms and glucose items never move, so they are sorted once by x and
+// the camera finds the visible ones by binary search (see camera.h)
+static void sort_level_platforms(Level* level) {
+    level->max_platform_width = 0.0f;
+    if (level->platforms) {
+        qsort(level->platforms, level->num_platforms, sizeof(Platform), compare_platforms_by_x);
+        for (int i = 0; i < level->num_platforms; i++) {
+            if (level->platforms[i].width > level->max_platform_width) {
+                level->max_platform_width = level->platforms[i].width;
+            }
         }
     }
+}
 
-    // Load multi-backgrounds for level TWO (index 1)
-    Level* level_two = &game->levels[1];
-    level_two->num_backgrounds = 3;
-    level_two->background_positions = (float*)malloc(sizeof(float) * 3);
-    
-    // Set up background transition positions for level TWO
-    level_two->background_positions[0] = 0.0f;     // scene_21_scaled.png from 0-1280
-    level_two->background_positions[1] = 1280.0f;  // scene_22_scaled.png from 1280-2560
-    level_two->background_positions[2] = 2560.0f;  // scene_23_1_scaled.png from 2560-3840
-    
-    // Load the scaled scene backgrounds for level TWO
-    const char* scene_files_level2[] = {"scene_21_scaled.png", "scene_22_scaled.png", "scene_23_1_scaled.png"};
-    for (int i = 0; i < 3; i++) {
-        sprintf(path, "resources/sprites/%s", scene_files_level2[i]);
-        level_two->backgrounds[i] = al_load_bitmap(path);
-        if (!level_two->backgrounds[i]) {
-            fprintf(stderr, "Failed to load scene background: %s\n", path);
+static void sort_level_content(Level* level) {
+    level->max_glucose_width = 0.0f;
+    if (level->glucose_items) {
+        qsort(level->glucose_items, level->num_glucose_items, sizeof(GlucoseItem), compare_glucose_by_x);
+        for (int i = 0; i < level->num_glucose_items; i++) {
+            if (level->glucose_items[i].width > level->max_glucose_width) {
+                level->max_glucose_width = level->glucose_items[i].width;
+            }
         }
     }
+}
 
-    // Load multi-backgrounds for level THREE (index 2)
-    Level* level_three = &game->levels[2];
-    level_three->num_backgrounds = 4;
-    level_three->background_positions = (float*)malloc(sizeof(float) * 4);
-    
-    // Set up background transition positions for level THREE
-    level_three->background_positions[0] = 0.0f;     // scene_31_scaled.png from 0-1280
-    level_three->background_positions[1] = 1280.0f;  // scene_32_scaled.png from 1280-2560
-    level_three->background_positions[2] = 2560.0f;  // scene_33_scaled.png from 2560-3840
-    level_three->background_positions[3] = 3840.0f;  // scene_34_1_scaled.png from 3840-5120
-    
-    // Load the scaled scene backgrounds for level THREE
-    const char* scene_files_level3[] = {"scene_31_scaled.png", "scene_32_scaled.png", "scene_33_scaled.png", "scene_34_1_scaled.png"};
-    for (int i = 0; i < 4; i++) {
-        sprintf(path, "resources/sprites/%s", scene_files_level3[i]);
-        level_three->backgrounds[i] = al_load_bitmap(path);
-        if (!level_three->backgrounds[i]) {
-            fprintf(stderr, "Failed to load scene background: %s\n", path);
+// Platforms and the tile layer. They are built once, before the content
+// mark, so a reset keeps them and the drawing thread can bake them.
+static void init_level_geometry(Level* level) {
+    // Just a simple ground platform for the player to walk on
+    level->num_platforms = 1;
+    level->platforms = arena_alloc(&level->arena, sizeof(Platform) * level->num_platforms);
+    if (!level->platforms) {
+        fprintf(stderr, "Failed to allocate platforms for level %d\n", level->id);
+        level->num_platforms = 0;
+        return;
+    }
+
+    // Single long ground platform across the entire level
+    level->platforms[0] = (Platform){
+        .x = 0.0f,
+        .y = SCREEN_HEIGHT - 40.0f,
+        .width = level->level_width, // Full level width
+        .height = 40.0f,
+        .color = al_map_rgb(139, 69, 19), // Brown ground
+        .is_deadly = false
+    };
+
+    // No shipped level has a tile layer; init_tilemap here adds one
+    sort_level_platforms(level);
+}
+
+// Runs of adjacent hazard tiles in a row, each added to 'index' as one
+// trigger unless 'index' is NULL; returns the pieces they take
+static int add_hazard_tile_runs(const Tilemap* map, TriggerIndex* index, float margin) {
+    int pieces = 0;
+    float size = (float)map->tile_size;
+    for (int row = 0; row < map->rows; row++) {
+        for (int col = 0; col < map->cols; ) {
+            const TileDef* def = get_tile_def(map, get_tile(map, col, row));
+            if (!def || !(def->layer & PHYS_LAYER_HAZARD)) {
+                col++;
+                continue;
+            }
+            int end = col + 1;
+            while ((def = get_tile_def(map, get_tile(map, end, row))) && (def->layer & PHYS_LAYER_HAZARD)) end++;
+            float width = (end - col) * size + 2 * margin;
+            if (index) {
+                add_trigger(index, TRIGGER_HAZARD, -1, map->x + col * size - margin, map->y + row * size - margin,
+                            width, size + 2 * margin);
+            }
+            pieces += count_trigger_pieces(width);
+            col = end;
         }
     }
+    return pieces;
+}
+
+// Pickups, the portal and every hazard as trigger volumes. Hazards are
+// grown by HAZARD_TRIGGER_MARGIN since physics keeps bodies on their
+// surface.
+static void build_level_triggers(Level* level) {
+    const float margin = HAZARD_TRIGGER_MARGIN;
+    const Portal* portal = &level->portal;
+    int count = level->num_glucose_items * count_trigger_pieces(GLUCOSE_WIDTH);
+    if (portal->is_active) count += count_trigger_pieces(portal->width);
+    for (int i = 0; i < level->num_platforms; i++) {
+        if (level->platforms[i].is_deadly) count += count_trigger_pieces(level->platforms[i].width + 2 * margin);
+    }
+    count += add_hazard_tile_runs(&level->tilemap, NULL, margin);
+    if (!init_trigger_index(&level->triggers, &level->arena, count)) return;
+
+    for (int i = 0; i < level->num_glucose_items; i++) {
+        const GlucoseItem* item = &level->glucose_items[i];
+        add_trigger(&level->triggers, TRIGGER_GLUCOSE, i, item->x, item->y, GLUCOSE_WIDTH, GLUCOSE_HEIGHT);
+    }
+    if (portal->is_active) {
+        add_trigger(&level->triggers, TRIGGER_PORTAL, 0, portal->x, portal->y, portal->width, portal->height);
+    }
+
+    for (int i = 0; i < level->num_platforms; i++) {
+        const Platform* p = &level->platforms[i];
+        if (!p->is_deadly) continue;
+        add_trigger(&level->triggers, TRIGGER_HAZARD, i, p->x - margin, p->y - margin,
+                    p->width + 2 * margin, p->height + 2 * margin);
+    }
+    add_hazard_tile_runs(&level->tilemap, &level->triggers, margin);
+    sort_triggers(&level->triggers);
 }
 
 // Original init_level_content function from main.c
 void init_level_content(Level* level, int level_number) {
     switch (level_number) {
         case 1: // level ONE - Multi-background transitioning level (clean, no obstacles)
-            // Just a simple ground platform for the player to walk on
-            level->num_platforms = 1;
-            level->platforms = malloc(sizeof(Platform) * level->num_platforms);
-            if (!level->platforms) { 
-                fprintf(stderr, "Failed to allocate platforms for level ONE\n"); 
-                return; 
-            }
-            
-            // Single long ground platform across the entire level
-            level->platforms[0] = (Platform){
-                .x = 0.0f,
-                .y = SCREEN_HEIGHT - 40.0f,
-                .width = 4800.0f, // Full level width
-                .height = 40.0f,
-                .color = al_map_rgb(139, 69, 19), // Brown ground
-                .is_deadly = false
-            };
-            
             // No enemies - just background viewing
-            level->num_enemies = 0;
-            level->enemies = NULL;
+            init_spawner(level, NULL, 0, NULL, 0);
             
             // No glucose items - just pure background experience
             level->num_glucose_items = 0;
@@ -184,27 +310,8 @@ void init_level_content(Level* level, int level_number) {
             break;
 
         case 2: // level TWO - Blood stream navigation (background viewing)
-            // Just a simple ground platform for the player to walk on
-            level->num_platforms = 1;
-            level->platforms = malloc(sizeof(Platform) * level->num_platforms);
-            if (!level->platforms) { 
-                fprintf(stderr, "Failed to allocate platforms for level TWO\n"); 
-                return; 
-            }
-            
-            // Single long ground platform across the entire level
-            level->platforms[0] = (Platform){
-                .x = 0.0f,
-                .y = SCREEN_HEIGHT - 40.0f,
-                .width = 4800.0f, // Full level width
-                .height = 40.0f,
-                .color = al_map_rgb(139, 69, 19), // Brown ground
-                .is_deadly = false
-            };
-            
             // No enemies - just background viewing
-            level->num_enemies = 0;
-            level->enemies = NULL;
+            init_spawner(level, NULL, 0, NULL, 0);
             
             // No glucose items - just pure background experience
             level->num_glucose_items = 0;
@@ -218,27 +325,8 @@ void init_level_content(Level* level, int level_number) {
             break;
 
         case 3: // level THREE - Final cellular challenge (background viewing)
-            // Just a simple ground platform for the player to walk on
-            level->num_platforms = 1;
-            level->platforms = malloc(sizeof(Platform) * level->num_platforms);
-            if (!level->platforms) { 
-                fprintf(stderr, "Failed to allocate platforms for level THREE\n"); 
-                return; 
-            }
-            
-            // Single long ground platform across the entire level
-            level->platforms[0] = (Platform){
-                .x = 0.0f,
-                .y = SCREEN_HEIGHT - 40.0f,
-                .width = 5120.0f, // Full level width
-                .height = 40.0f,
-                .color = al_map_rgb(139, 69, 19), // Brown ground
-                .is_deadly = false
-            };
-            
             // No enemies - just background viewing
-            level->num_enemies = 0;
-            level->enemies = NULL;
+            init_spawner(level, NULL, 0, NULL, 0);
             
             // No glucose items - just pure background experience
             level->num_glucose_items = 0;
@@ -255,39 +343,37 @@ void init_level_content(Level* level, int level_number) {
             fprintf(stderr, "Invalid level number: %d\n", level_number);
             break;
     }
+
+    sort_level_content(level);
+    build_level_triggers(level);
 }
 
 // Original cleanup_level function from main.c
 void cleanup_level(Level* level) {
-    if (level->platforms) free(level->platforms);
-    if (level->enemies) free(level->enemies);
-    if (level->glucose_items) free(level->glucose_items); // Free glucose_items
-    if (level->projectiles) free(level->projectiles);     // Free projectiles
-    if (level->particles) free(level->particles);         // Free particles
+    report_level_pools(level);
+    pool_destroy(&level->enemies);
+    pool_destroy(&level->projectiles);
+    pool_destroy(&level->particles);
+    pool_destroy(&level->particle_spawns);
     if (level->background) al_destroy_bitmap(level->background);
     
     // Cleanup multi-backgrounds
-    for (int i = 0; i < 4; i++) {
-        if (level->backgrounds[i]) {
-            al_destroy_bitmap(level->backgrounds[i]);
-        }
-    }
-    if (level->background_positions) free(level->background_positions);
+    report_background_tiles(&level->background_tiles, level->level_name);
+    destroy_background_tiles(&level->background_tiles);
+    report_static_chunks(&level->static_chunks, level->level_name);
+    destroy_static_chunks(&level->static_chunks);
     
-    if (level->level_name) free(level->level_name);
-    if (level->level_description) free(level->level_description);
+    // Platforms, enemies, glucose items, pool chunks, names, background
+    // positions and tiles all go back with the arena
+    arena_release(&level->arena);
     // Set pointers to NULL after freeing to prevent double free issues
     level->platforms = NULL;
-    level->enemies = NULL;
     level->glucose_items = NULL; // Set glucose_items to NULL
-    level->projectiles = NULL;   // Set projectiles to NULL
-    level->particles = NULL;     // Set particles to NULL
+    memset(&level->triggers, 0, sizeof(level->triggers));
+    memset(&level->batches, 0, sizeof(level->batches));
     level->background = NULL;
     
     // Reset multi-background fields
-    for (int i = 0; i < 4; i++) {
-        level->backgrounds[i] = NULL;
-    }
     level->background_positions = NULL;
     level->num_backgrounds = 0;
     
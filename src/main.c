@@ -1,12 +1,32 @@
 #include "../include/game.h"      // Core game definitions, Allegro setup
 #include "../include/game_logic.h" // For init_game, update_game, cleanup_game
 #include "../include/input.h"    // For handle_input
-#include "../include/drawing.h"  // For draw_game
+#include "../include/render.h"   // For publish_render_snapshot
+#include "../include/render_bench.h" // For the headless bench and golden checks
+#include "../include/asset_pack.h"   // For building the asset pack
+#include "../include/preload.h"      // For --preload
+#include "../include/self_check.h"   // For --check
 
 int main(int argc, char **argv) {
     Game game;
     bool redraw = true; // Flag to manage redrawing efficiently
 
+    // --bench and --golden draw into memory bitmaps instead of running the game
+    if (is_render_bench_command(argc, argv)) {
+        return run_render_bench(argc, argv);
+    }
+    if (is_asset_pack_command(argc, argv)) {
+        return run_asset_pack_command(argc, argv);
+    }
+    if (is_self_check_command(argc, argv)) {
+        return run_self_check(argc, argv);
+    }
+
+    // The startup timeline with decoding on worker threads, for comparison
+    if (is_preload_command(argc, argv)) {
+        enable_preload();
+    }
+
     // Initialize all game components, display, timer, player, levels, etc.
     // init_game now resides in game_logic.c
     if (!init_game(&game)) {
@@ -14,7 +34,7 @@ int main(int argc, char **argv) {
         return -1; // Exit if initialization fails
     }
 
-    // The timer is started within init_game.
+    // The timers are started within init_game.
 
     // Main game loop
     while (game.running) {
@@ -29,19 +49,34 @@ int main(int argc, char **argv) {
         if (event.type == ALLEGRO_EVENT_TIMER) {
             // Timer event: update game state
             // update_game (from game_logic.c) handles player movement, physics, AI, etc.
-            update_game(&game);
+            // Menu timer ticks only animate the screen.
+            if (event.timer.source == game.timer) {
+                update_game(&game);
+            }
             redraw = true; // Signal that a redraw is needed
         } else if (event.type == ALLEGRO_EVENT_DISPLAY_CLOSE) {
             // Display close event: exit the game loop
             game.running = false;
+        } else if (!al_get_timer_started(game.timer) &&
+                   (event.type == ALLEGRO_EVENT_KEY_DOWN ||
+                    event.type == ALLEGRO_EVENT_DISPLAY_EXPOSE ||
+                    event.type == ALLEGRO_EVENT_DISPLAY_SWITCH_IN)) {
+            // Idle screens only redraw when input or the window may have changed them
+            redraw = true;
+        }
+
+        // Start or stop the timers when the state changes
+        if (game.state != game.timer_state) {
+            update_state_timers(&game);
+            redraw = true;
         }
 
         // Redraw the screen if needed and the event queue is empty
         if (redraw && al_is_event_queue_empty(game.event_queue)) {
             redraw = false;
-            // draw_game (from drawing.c) handles all rendering for the current game state
-            // This function also calls al_flip_display()
-            draw_game(&game);
+            // Hand the current state to the renderer (render.c), which draws it
+            // with draw_game on the render thread
+            publish_render_snapshot(&game);
         }
     }
 
@@ -0,0 +1,130 @@
+#include "../include/overdraw.h"
+#include <math.h>    // For floorf, sqrtf
+#include <stdio.h>   // For fprintf
+#include <stdlib.h>  // For calloc, free
+#include <string.h>  // For memset
+
+// Heat colours by count, 0 to OVERDRAW_HEAT_MAX
+static const unsigned char heat_colors[OVERDRAW_HEAT_MAX + 1][3] = {
+    {0, 0, 0},          // Never drawn
+    {0, 0, 255},        // Drawn once
+    {0, 200, 255},
+    {0, 255, 0},
+    {255, 255, 0},
+    {255, 128, 0},
+    {255, 0, 0}         // OVERDRAW_HEAT_MAX or more
+};
+
+bool init_overdraw_map(OverdrawMap* map, int width, int height) {
+    memset(map, 0, sizeof(*map));
+    map->counts = calloc((size_t)width * height, 1);
+    if (!map->counts) {
+        fprintf(stderr, "Failed to allocate %dx%d overdraw map!\n", width, height);
+        return false;
+    }
+    map->width = width;
+    map->height = height;
+    return true;
+}
+
+void free_overdraw_map(OverdrawMap* map) {
+    free(map->counts);
+    if (map->heatmap) al_destroy_bitmap(map->heatmap);
+    memset(map, 0, sizeof(*map));
+}
+
+void clear_overdraw_map(OverdrawMap* map) {
+    if (!map->counts) return;
+    memset(map->counts, 0, (size_t)map->width * map->height);
+    map->total = 0;
+    map->max = 0;
+}
+
+// Pixels whose centres lie in [x1, x2) of row y
+static void add_span(OverdrawMap* map, int y, float x1, float x2) {
+    if (y < 0 || y >= map->height) return;
+    int first = (int)floorf(x1 + 0.5f);
+    int last = (int)floorf(x2 + 0.5f);
+    if (first < 0) first = 0;
+    if (last > map->width) last = map->width;
+
+    unsigned char* row = map->counts + (size_t)y * map->width;
+    for (int x = first; x < last; x++) {
+        if (row[x] < 255) row[x]++;
+    }
+    if (last > first) map->total += last - first;
+}
+
+void add_overdraw_rect(OverdrawMap* map, float x1, float y1, float x2, float y2) {
+    if (!map->counts) return;
+    if (x1 > x2) { float t = x1; x1 = x2; x2 = t; }
+    if (y1 > y2) { float t = y1; y1 = y2; y2 = t; }
+    int first = (int)floorf(y1 + 0.5f);
+    int last = (int)floorf(y2 + 0.5f);
+    if (first < 0) first = 0;
+    if (last > map->height) last = map->height;
+    for (int y = first; y < last; y++) {
+        add_span(map, y, x1, x2);
+    }
+}
+
+void add_overdraw_ring(OverdrawMap* map, float cx, float cy, float inner, float outer) {
+    if (!map->counts || outer <= 0.0f) return;
+    int first = (int)floorf(cy - outer);
+    int last = (int)floorf(cy + outer) + 1;
+    if (first < 0) first = 0;
+    if (last > map->height) last = map->height;
+
+    for (int y = first; y < last; y++) {
+        float dy = y + 0.5f - cy;
+        if (dy * dy >= outer * outer) continue;
+        float outer_half = sqrtf(outer * outer - dy * dy);
+        float inner_half = dy * dy < inner * inner ? sqrtf(inner * inner - dy * dy) : 0.0f;
+        if (inner_half <= 0.0f) {
+            add_span(map, y, cx - outer_half, cx + outer_half);
+        } else {
+            add_span(map, y, cx - outer_half, cx - inner_half);
+            add_span(map, y, cx + inner_half, cx + outer_half);
+        }
+    }
+}
+
+void draw_overdraw_heatmap(OverdrawMap* map) {
+    if (!map->counts) return;
+    if (!map->heatmap) {
+        map->heatmap = al_create_bitmap(map->width, map->height);
+        if (!map->heatmap) {
+            fprintf(stderr, "Failed to create overdraw heatmap bitmap!\n");
+            return;
+        }
+    }
+
+    ALLEGRO_LOCKED_REGION* region = al_lock_bitmap(map->heatmap, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE,
+                                                   ALLEGRO_LOCK_WRITEONLY);
+    if (!region) return;
+    int max = 0;
+    for (int y = 0; y < map->height; y++) {
+        const unsigned char* counts = map->counts + (size_t)y * map->width;
+        unsigned char* pixels = (unsigned char*)region->data + y * region->pitch;
+        for (int x = 0; x < map->width; x++) {
+            int count = counts[x];
+            if (count > max) max = count;
+            const unsigned char* color = heat_colors[count < OVERDRAW_HEAT_MAX ? count : OVERDRAW_HEAT_MAX];
+            pixels[x * 4 + 0] = color[0];
+            pixels[x * 4 + 1] = color[1];
+            pixels[x * 4 + 2] = color[2];
+            pixels[x * 4 + 3] = 255;
+        }
+    }
+    al_unlock_bitmap(map->heatmap);
+    map->max = max;
+
+    al_draw_scaled_bitmap(map->heatmap, 0, 0, map->width, map->height,
+                          0, 0, al_get_bitmap_width(al_get_target_bitmap()),
+                          al_get_bitmap_height(al_get_target_bitmap()), 0);
+}
+
+double get_average_overdraw(const OverdrawMap* map) {
+    if (!map->counts) return 0.0;
+    return (double)map->total / ((double)map->width * map->height);
+}
@@ -0,0 +1,190 @@
+#include "../include/physics.h"
+#include "../include/camera.h" // For find_visible_range
+#include <stddef.h>  // For offsetof
+#include <string.h>  // For memset
+
+void init_body(Entity* entity, unsigned int layer, unsigned int mask, float gravity,
+               float knockback_decay, bool step_up) {
+    PhysicsBody* body = &entity->body;
+    memset(body, 0, sizeof(*body));
+    body->layer = layer;
+    body->mask = mask;
+    body->gravity = gravity;
+    body->knockback_decay = knockback_decay;
+    body->step_up = step_up;
+}
+
+void wake_body(Entity* entity) {
+    entity->body.asleep = false;
+    entity->body.rest_ticks = 0;
+}
+
+void move_body(Entity* entity, float dx, float dy) {
+    if (dx == 0.0f && dy == 0.0f) return;
+    entity->body.move_x += dx;
+    entity->body.move_y += dy;
+    wake_body(entity);
+}
+
+void knock_body(Entity* entity, float dx, float dy, int ticks) {
+    entity->knockback_dx = dx;
+    entity->knockback_dy = dy;
+    entity->knockback_timer = ticks;
+    wake_body(entity);
+}
+
+bool bodies_interact(const Entity* a, const Entity* b) {
+    return (a->body.mask & b->body.layer) != 0;
+}
+
+static unsigned int platform_layer(const Platform* platform) {
+    return platform->is_deadly ? PHYS_LAYER_HAZARD : PHYS_LAYER_TERRAIN;
+}
+
+// Land on, bump into or stop against one overlapping platform. The checks
+// compare where the body was before this step's move with where it is now,
+// so only an edge crossed during the step pushes it back. Hazards are solid
+// like terrain; the damage they do comes from the level's hazard triggers.
+static void resolve_platform(Entity* e, const Platform* p, float move_x, float move_y) {
+    PhysicsBody* body = &e->body;
+
+    // Landing on top or hitting the bottom
+    if (move_y >= 0 &&
+        e->y + e->height - move_y <= p->y + PLATFORM_JUMP_TOLERANCE &&
+        e->y + e->height > p->y) {
+        e->dy = 0;
+        e->y = p->y - e->height;
+        e->is_on_ground = true;
+        body->contacts |= PHYS_CONTACT_GROUND;
+    } else if (move_y < 0 &&
+               e->y - move_y >= p->y + p->height &&
+               e->y < p->y + p->height) {
+        e->y = p->y + p->height;
+        e->dy = 0;
+        body->contacts |= PHYS_CONTACT_CEILING;
+    }
+
+    // Sides, unless the body was pushed clear above
+    if (e->y >= p->y + p->height || e->y + e->height <= p->y) return;
+    float step_height = e->y + e->height - p->y;
+    bool can_step = body->step_up && e->is_on_ground &&
+                    step_height > 0 && step_height <= MAX_STEP_UP_HEIGHT;
+    if (move_x > 0 &&
+        e->x + e->width - move_x <= p->x &&
+        e->x + e->width > p->x) {
+        if (can_step) {
+            e->y = p->y - e->height;
+            e->dy = 0;
+        } else {
+            e->x = p->x - e->width;
+            e->dx = 0;
+            body->contacts |= PHYS_CONTACT_WALL_RIGHT;
+        }
+    } else if (move_x < 0 &&
+               e->x - move_x >= p->x + p->width &&
+               e->x < p->x + p->width) {
+        if (can_step) {
+            e->y = p->y - e->height;
+            e->dy = 0;
+        } else {
+            e->x = p->x + p->width;
+            e->dx = 0;
+            body->contacts |= PHYS_CONTACT_WALL_LEFT;
+        }
+    }
+}
+
+static void step_body(Level* level, Entity* e) {
+    PhysicsBody* body = &e->body;
+    PhysicsStats* stats = &level->physics;
+    if (body->asleep) {
+        stats->sleeping++;
+        return;
+    }
+    stats->stepped++;
+
+    float move_x = body->move_x;
+    float move_y = body->move_y;
+    body->move_x = 0.0f;
+    body->move_y = 0.0f;
+    if (e->knockback_timer > 0) {
+        move_x += e->knockback_dx;
+        move_y += e->knockback_dy;
+        e->knockback_dx *= body->knockback_decay;
+        e->knockback_dy *= body->knockback_decay;
+        if (--e->knockback_timer <= 0) {
+            e->knockback_dx = 0.0f;
+            e->knockback_dy = 0.0f;
+        }
+    }
+
+    e->x += move_x;
+    e->y += move_y;
+    e->dy += body->gravity;
+    e->is_on_ground = false;
+    body->contacts = 0;
+
+    // Platforms the body's box can overlap after the move
+    int first, last;
+    find_visible_range(level->platforms, level->num_platforms, sizeof(Platform), offsetof(Platform, x),
+                       level->max_platform_width, e->x, e->x + e->width, &first, &last);
+    for (int i = first; i < last; i++) {
+        const Platform* p = &level->platforms[i];
+        if (!(body->mask & platform_layer(p))) {
+            stats->layer_skips++;
+            continue;
+        }
+        stats->platform_tests++;
+        if (e->x < p->x + p->width && e->x + e->width > p->x &&
+            e->y < p->y + p->height && e->y + e->height > p->y) {
+            resolve_platform(e, p, move_x, move_y);
+        }
+    }
+
+    // Solid cells of the tile layer under the body, each taken as a
+    // one-cell platform
+    const Tilemap* map = &level->tilemap;
+    int col0, row0, col1, row1;
+    if (find_tile_range(map, e->x, e->y, e->x + e->width, e->y + e->height, &col0, &row0, &col1, &row1)) {
+        float size = (float)map->tile_size;
+        for (int row = row0; row <= row1; row++) {
+            for (int col = col0; col <= col1; col++) {
+                const TileDef* def = get_tile_def(map, get_tile(map, col, row));
+                if (!def || !def->layer) continue;
+                if (!(body->mask & def->layer)) {
+                    stats->layer_skips++;
+                    continue;
+                }
+                stats->tile_tests++;
+                Platform cell = {
+                    .x = map->x + col * size, .y = map->y + row * size,
+                    .width = size, .height = size,
+                    .is_deadly = (def->layer & PHYS_LAYER_HAZARD) != 0
+                };
+                if (e->x < cell.x + cell.width && e->x + e->width > cell.x &&
+                    e->y < cell.y + cell.height && e->y + e->height > cell.y) {
+                    resolve_platform(e, &cell, move_x, move_y);
+                }
+            }
+        }
+    }
+
+    // Falling bodies are never at rest, floating ones whenever they keep still
+    bool resting = move_x == 0.0f && move_y == 0.0f && (body->gravity == 0.0f || e->is_on_ground);
+    if (!resting) {
+        body->rest_ticks = 0;
+    } else if (++body->rest_ticks >= PHYSICS_SLEEP_TICKS) {
+        body->asleep = true;
+    }
+}
+
+void step_physics(Level* level, Entity* player) {
+    memset(&level->physics, 0, sizeof(level->physics));
+    step_body(level, player);
+
+    ChunkPool* enemies = &level->enemies;
+    for (int i = pool_first(enemies); i != POOL_SLOT_NONE; i = pool_next(enemies, i)) {
+        Entity* enemy = pool_at(enemies, i);
+        if (enemy->active) step_body(level, enemy);
+    }
+}
@@ -0,0 +1,283 @@
+#include "../include/pixel_kernels.h"
+#include <math.h>    // For floorf, sqrtf
+#include <string.h>  // For memcpy
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define KERNEL_AVX2 1
+#endif
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define KERNEL_SSE2 1
+#endif
+
+static bool kernels_enabled = true;
+
+// x / 255, rounded, for x up to 255 * 255
+static inline unsigned int div255(unsigned int x) {
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+static inline uint32_t blend_one(uint32_t dst, uint32_t src, unsigned int inv_alpha) {
+    uint32_t out = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        unsigned int c = ((src >> shift) & 0xFF) + div255(((dst >> shift) & 0xFF) * inv_alpha);
+        out |= (c > 255 ? 255 : c) << shift;
+    }
+    return out;
+}
+
+#ifdef KERNEL_SSE2
+// Four pixels unpacked to 16 bits per channel, times inv / 255
+static inline __m128i scale_sse2(__m128i d16, __m128i inv) {
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(d16, inv), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+// Alpha of each pixel copied to its four channels
+static inline __m128i spread_alpha_sse2(__m128i s16) {
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(s16, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+}
+#endif
+
+#ifdef KERNEL_AVX2
+static inline __m256i scale_avx2(__m256i d16, __m256i inv) {
+    __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(d16, inv), _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+static inline __m256i spread_alpha_avx2(__m256i s16) {
+    return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s16, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+}
+#endif
+
+void fill_pixels(uint32_t* dst, int count, uint32_t pixel) {
+    int i = 0;
+#if defined(KERNEL_AVX2)
+    __m256i p8 = _mm256_set1_epi32((int)pixel);
+    for (; i + 8 <= count; i += 8) _mm256_storeu_si256((__m256i*)(dst + i), p8);
+#elif defined(KERNEL_SSE2)
+    __m128i p4 = _mm_set1_epi32((int)pixel);
+    for (; i + 4 <= count; i += 4) _mm_storeu_si128((__m128i*)(dst + i), p4);
+#endif
+    for (; i < count; i++) dst[i] = pixel;
+}
+
+void blend_fill_pixels(uint32_t* dst, int count, uint32_t pixel) {
+    unsigned int inv_alpha = 255 - (pixel >> 24);
+    if (inv_alpha == 0) {
+        fill_pixels(dst, count, pixel);
+        return;
+    }
+    int i = 0;
+#if defined(KERNEL_AVX2)
+    __m256i zero8 = _mm256_setzero_si256();
+    __m256i inv8 = _mm256_set1_epi16((short)inv_alpha);
+    __m256i src8 = _mm256_set1_epi32((int)pixel);
+    for (; i + 8 <= count; i += 8) {
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+        __m256i lo = scale_avx2(_mm256_unpacklo_epi8(d, zero8), inv8);
+        __m256i hi = scale_avx2(_mm256_unpackhi_epi8(d, zero8), inv8);
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_adds_epu8(_mm256_packus_epi16(lo, hi), src8));
+    }
+#endif
+#if defined(KERNEL_SSE2)
+    __m128i zero = _mm_setzero_si128();
+    __m128i inv = _mm_set1_epi16((short)inv_alpha);
+    __m128i src = _mm_set1_epi32((int)pixel);
+    for (; i + 4 <= count; i += 4) {
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i lo = scale_sse2(_mm_unpacklo_epi8(d, zero), inv);
+        __m128i hi = scale_sse2(_mm_unpackhi_epi8(d, zero), inv);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_adds_epu8(_mm_packus_epi16(lo, hi), src));
+    }
+#endif
+    for (; i < count; i++) dst[i] = blend_one(dst[i], pixel, inv_alpha);
+}
+
+void copy_pixels(uint32_t* dst, const uint32_t* src, int count) {
+    // The C library's copy is already vectorised
+    memcpy(dst, src, (size_t)count * sizeof(uint32_t));
+}
+
+void blend_pixels(uint32_t* dst, const uint32_t* src, int count) {
+    int i = 0;
+#if defined(KERNEL_AVX2)
+    __m256i zero8 = _mm256_setzero_si256();
+    __m256i full8 = _mm256_set1_epi16(255);
+    for (; i + 8 <= count; i += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+        __m256i inv_lo = _mm256_sub_epi16(full8, spread_alpha_avx2(_mm256_unpacklo_epi8(s, zero8)));
+        __m256i inv_hi = _mm256_sub_epi16(full8, spread_alpha_avx2(_mm256_unpackhi_epi8(s, zero8)));
+        __m256i lo = scale_avx2(_mm256_unpacklo_epi8(d, zero8), inv_lo);
+        __m256i hi = scale_avx2(_mm256_unpackhi_epi8(d, zero8), inv_hi);
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_adds_epu8(_mm256_packus_epi16(lo, hi), s));
+    }
+#endif
+#if defined(KERNEL_SSE2)
+    __m128i zero = _mm_setzero_si128();
+    __m128i full = _mm_set1_epi16(255);
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i inv_lo = _mm_sub_epi16(full, spread_alpha_sse2(_mm_unpacklo_epi8(s, zero)));
+        __m128i inv_hi = _mm_sub_epi16(full, spread_alpha_sse2(_mm_unpackhi_epi8(s, zero)));
+        __m128i lo = scale_sse2(_mm_unpacklo_epi8(d, zero), inv_lo);
+        __m128i hi = scale_sse2(_mm_unpackhi_epi8(d, zero), inv_hi);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_adds_epu8(_mm_packus_epi16(lo, hi), s));
+    }
+#endif
+    for (; i < count; i++) dst[i] = blend_one(dst[i], src[i], 255 - (src[i] >> 24));
+}
+
+uint32_t blend_pixel(uint32_t dst, uint32_t src) {
+    return blend_one(dst, src, 255 - (src >> 24));
+}
+
+const char* get_pixel_kernel_name(void) {
+#if defined(KERNEL_AVX2)
+    return "AVX2";
+#elif defined(KERNEL_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+bool pack_pixel(int format, ALLEGRO_COLOR color, uint32_t* pixel) {
+    unsigned char r, g, b, a;
+    al_unmap_rgba(color, &r, &g, &b, &a);
+    switch (format) {
+        case ALLEGRO_PIXEL_FORMAT_ARGB_8888:
+            *pixel = (uint32_t)a << 24 | (uint32_t)r << 16 | (uint32_t)g << 8 | b;
+            return true;
+        case ALLEGRO_PIXEL_FORMAT_ABGR_8888:
+        case ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE:
+            *pixel = (uint32_t)a << 24 | (uint32_t)b << 16 | (uint32_t)g << 8 | r;
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool is_kernel_format(int format) {
+    ALLEGRO_COLOR probe = al_map_rgba(0, 0, 0, 0);
+    uint32_t pixel;
+    return pack_pixel(format, probe, &pixel);
+}
+
+void set_pixel_kernels_enabled(bool enabled) {
+    kernels_enabled = enabled;
+}
+
+bool begin_kernel_target(KernelTarget* target, ALLEGRO_BITMAP* bitmap) {
+    target->bitmap = bitmap;
+    target->region = NULL;
+    target->format = al_get_bitmap_format(bitmap);
+    if (!kernels_enabled || !(al_get_bitmap_flags(bitmap) & ALLEGRO_MEMORY_BITMAP) ||
+        !is_kernel_format(target->format)) {
+        return false;
+    }
+    int x, y, w, h;
+    al_get_clipping_rectangle(&x, &y, &w, &h);
+    target->clip_x1 = x;
+    target->clip_y1 = y;
+    target->clip_x2 = x + w;
+    target->clip_y2 = y + h;
+    return true;
+}
+
+// Locking a memory bitmap in its own format hands out its pixels directly
+static uint32_t* get_row(KernelTarget* target, int y) {
+    if (!target->region) {
+        target->region = al_lock_bitmap(target->bitmap, target->format, ALLEGRO_LOCK_READWRITE);
+        if (!target->region) return NULL;
+    }
+    return (uint32_t*)((char*)target->region->data + y * target->region->pitch);
+}
+
+void end_kernel_drawing(KernelTarget* target) {
+    if (target->region) {
+        al_unlock_bitmap(target->bitmap);
+        target->region = NULL;
+    }
+}
+
+// First pixel whose centre is at or right of 'x'
+static int pixel_edge(float x) {
+    return (int)floorf(x + 0.5f);
+}
+
+static void fill_span(KernelTarget* target, int y, int x1, int x2, uint32_t pixel) {
+    if (y < target->clip_y1 || y >= target->clip_y2) return;
+    if (x1 < target->clip_x1) x1 = target->clip_x1;
+    if (x2 > target->clip_x2) x2 = target->clip_x2;
+    if (x2 <= x1) return;
+    uint32_t* row = get_row(target, y);
+    if (!row) return;
+    blend_fill_pixels(row + x1, x2 - x1, pixel);
+}
+
+void kernel_clear(KernelTarget* target, ALLEGRO_COLOR color) {
+    uint32_t pixel;
+    if (!pack_pixel(target->format, color, &pixel)) return;
+    // Clearing replaces pixels instead of blending
+    for (int y = target->clip_y1; y < target->clip_y2; y++) {
+        uint32_t* row = get_row(target, y);
+        if (!row) return;
+        fill_pixels(row + target->clip_x1, target->clip_x2 - target->clip_x1, pixel);
+    }
+}
+
+void kernel_filled_rectangle(KernelTarget* target, float x1, float y1, float x2, float y2,
+                             ALLEGRO_COLOR color) {
+    uint32_t pixel;
+    if (!pack_pixel(target->format, color, &pixel)) return;
+    if (x1 > x2) { float t = x1; x1 = x2; x2 = t; }
+    if (y1 > y2) { float t = y1; y1 = y2; y2 = t; }
+    int left = pixel_edge(x1), right = pixel_edge(x2);
+    for (int y = pixel_edge(y1); y < pixel_edge(y2); y++) {
+        fill_span(target, y, left, right, pixel);
+    }
+}
+
+void kernel_filled_circle(KernelTarget* target, float cx, float cy, float radius, ALLEGRO_COLOR color) {
+    uint32_t pixel;
+    if (radius <= 0.0f || !pack_pixel(target->format, color, &pixel)) return;
+    int first = (int)floorf(cy - radius);
+    int last = (int)floorf(cy + radius) + 1;
+    for (int y = first; y < last; y++) {
+        float dy = y + 0.5f - cy;
+        if (dy * dy >= radius * radius) continue;
+        float half = sqrtf(radius * radius - dy * dy);
+        fill_span(target, y, pixel_edge(cx - half), pixel_edge(cx + half), pixel);
+    }
+}
+
+bool kernel_draw_bitmap(KernelTarget* target, ALLEGRO_BITMAP* bitmap, int x, int y, bool opaque) {
+    if (!(al_get_bitmap_flags(bitmap) & ALLEGRO_MEMORY_BITMAP) ||
+        al_get_bitmap_format(bitmap) != target->format) {
+        return false;
+    }
+    int width = al_get_bitmap_width(bitmap);
+    int height = al_get_bitmap_height(bitmap);
+    int x1 = x > target->clip_x1 ? x : target->clip_x1;
+    int x2 = x + width < target->clip_x2 ? x + width : target->clip_x2;
+    int y1 = y > target->clip_y1 ? y : target->clip_y1;
+    int y2 = y + height < target->clip_y2 ? y + height : target->clip_y2;
+    if (x2 <= x1 || y2 <= y1) return true;
+
+    ALLEGRO_LOCKED_REGION* src = al_lock_bitmap(bitmap, target->format, ALLEGRO_LOCK_READONLY);
+    if (!src) return false;
+    for (int row = y1; row < y2; row++) {
+        uint32_t* dst = get_row(target, row);
+        if (!dst) break;
+        const uint32_t* src_row = (const uint32_t*)((const char*)src->data + (row - y) * src->pitch);
+        if (opaque) copy_pixels(dst + x1, src_row + (x1 - x), x2 - x1);
+        else blend_pixels(dst + x1, src_row + (x1 - x), x2 - x1);
+    }
+    al_unlock_bitmap(bitmap);
+    return true;
+}
@@ -0,0 +1,174 @@
+#include "../include/pool.h"
+#include <stdio.h>   // For printf, fprintf
+#include <stdlib.h>  // For malloc, free
+#include <string.h>  // For memset
+
+#define POOL_SLOT_FREE -2 // 'prev' value marking a slot on the free list
+
+static PoolLink* slot_link(const ChunkPool* pool, int slot) {
+    return &pool->chunks[slot / pool->chunk_capacity].links[slot % pool->chunk_capacity];
+}
+
+void pool_init(ChunkPool* pool, const char* name, size_t element_size, int chunk_capacity,
+               size_t max_bytes, PoolOverflowPolicy policy, MemoryBudget* budget, Arena* arena) {
+    memset(pool, 0, sizeof(*pool));
+    pool->name = name;
+    pool->element_size = element_size;
+    pool->chunk_capacity = chunk_capacity > 0 ? chunk_capacity : 1;
+    pool->max_bytes = max_bytes;
+    pool->policy = policy;
+    pool->budget = budget;
+    pool->arena = arena;
+    pool->free_head = POOL_SLOT_NONE;
+    pool->live_head = POOL_SLOT_NONE;
+    pool->live_tail = POOL_SLOT_NONE;
+}
+
+// Add one chunk and put all of its slots on the free list
+static bool pool_grow(ChunkPool* pool) {
+    if (pool->num_chunks >= POOL_MAX_CHUNKS) return false;
+
+    size_t links_bytes = sizeof(PoolLink) * pool->chunk_capacity;
+    size_t bytes = links_bytes + pool->element_size * pool->chunk_capacity;
+
+    if (pool->max_bytes > 0 && pool->bytes + bytes > pool->max_bytes) return false;
+    if (pool->budget && pool->budget->limit > 0 &&
+        pool->budget->used + bytes > pool->budget->limit) {
+        return false;
+    }
+
+    unsigned char* block = pool->arena ? arena_alloc(pool->arena, bytes) : malloc(bytes);
+    if (!block) {
+        fprintf(stderr, "Failed to allocate chunk for pool %s\n", pool->name);
+        return false;
+    }
+
+    PoolChunk* chunk = &pool->chunks[pool->num_chunks];
+    chunk->links = (PoolLink*)block;
+    chunk->data = block + links_bytes;
+
+    // Chain new slots in ascending order so they are handed out front to back
+    int base = pool->num_chunks * pool->chunk_capacity;
+    for (int i = 0; i < pool->chunk_capacity; i++) {
+        chunk->links[i].prev = POOL_SLOT_FREE;
+        chunk->links[i].next = (i + 1 < pool->chunk_capacity) ? base + i + 1 : pool->free_head;
+    }
+    pool->free_head = base;
+    pool->num_chunks++;
+
+    pool->bytes += bytes;
+    if (pool->budget) {
+        pool->budget->used += bytes;
+        if (pool->budget->used > pool->budget->peak) {
+            pool->budget->peak = pool->budget->used;
+        }
+    }
+    return true;
+}
+
+static void unlink_live(ChunkPool* pool, int slot) {
+    PoolLink* link = slot_link(pool, slot);
+    if (link->prev != POOL_SLOT_NONE) slot_link(pool, link->prev)->next = link->next;
+    else pool->live_head = link->next;
+    if (link->next != POOL_SLOT_NONE) slot_link(pool, link->next)->prev = link->prev;
+    else pool->live_tail = link->prev;
+}
+
+void* pool_acquire(ChunkPool* pool) {
+    int slot;
+
+    if (pool->free_head == POOL_SLOT_NONE && !pool_grow(pool)) {
+        if (pool->policy == POOL_OVERFLOW_EVICT_OLDEST && pool->live_head != POOL_SLOT_NONE) {
+            // Recycle the oldest element; the live count stays the same
+            slot = pool->live_head;
+            unlink_live(pool, slot);
+            pool->live--;
+            pool->evictions++;
+        } else {
+            pool->rejections++;
+            return NULL;
+        }
+    } else {
+        slot = pool->free_head;
+        pool->free_head = slot_link(pool, slot)->next;
+    }
+
+    // Append to the live list as the newest element
+    PoolLink* link = slot_link(pool, slot);
+    link->prev = pool->live_tail;
+    link->next = POOL_SLOT_NONE;
+    if (pool->live_tail != POOL_SLOT_NONE) slot_link(pool, pool->live_tail)->next = slot;
+    else pool->live_head = slot;
+    pool->live_tail = slot;
+
+    pool->live++;
+    if (pool->live > pool->high_water) {
+        pool->high_water = pool->live;
+    }
+
+    void* element = pool_at(pool, slot);
+    memset(element, 0, pool->element_size);
+    return element;
+}
+
+bool pool_reserve(ChunkPool* pool, int count) {
+    while (pool_capacity(pool) < count) {
+        if (!pool_grow(pool)) return false;
+    }
+    return true;
+}
+
+void pool_release(ChunkPool* pool, int slot) {
+    if (slot < 0 || slot >= pool_capacity(pool)) return;
+    PoolLink* link = slot_link(pool, slot);
+    if (link->prev == POOL_SLOT_FREE) return; // Already free
+
+    unlink_live(pool, slot);
+    link->prev = POOL_SLOT_FREE;
+    link->next = pool->free_head;
+    pool->free_head = slot;
+    pool->live--;
+}
+
+void pool_clear(ChunkPool* pool) {
+    int slot = pool->live_head;
+    while (slot != POOL_SLOT_NONE) {
+        int next = pool_next(pool, slot);
+        pool_release(pool, slot);
+        slot = next;
+    }
+}
+
+void pool_destroy(ChunkPool* pool) {
+    for (int i = 0; i < pool->num_chunks; i++) {
+        if (!pool->arena) {
+            free(pool->chunks[i].links); // Links are at the start of the chunk block
+        }
+        pool->chunks[i].links = NULL;
+        pool->chunks[i].data = NULL;
+    }
+    if (pool->budget) {
+        pool->budget->used -= pool->bytes;
+    }
+    pool->num_chunks = 0;
+    pool->bytes = 0;
+    pool->free_head = POOL_SLOT_NONE;
+    pool->live_head = POOL_SLOT_NONE;
+    pool->live_tail = POOL_SLOT_NONE;
+    pool->live = 0;
+}
+
+int pool_capacity(const ChunkPool* pool) {
+    return pool->num_chunks * pool->chunk_capacity;
+}
+
+void* pool_at(const ChunkPool* pool, int slot) {
+    const PoolChunk* chunk = &pool->chunks[slot / pool->chunk_capacity];
+    return chunk->data + (size_t)(slot % pool->chunk_capacity) * pool->element_size;
+}
+
+void pool_report(const ChunkPool* pool) {
+    printf("Pool %s: %d live, high-water %d, capacity %d (%d chunks, %zu bytes), %d evicted, %d rejected\n",
+           pool->name, pool->live, pool->high_water, pool_capacity(pool),
+           pool->num_chunks, pool->bytes, pool->evictions, pool->rejections);
+}
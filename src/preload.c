@@ -0,0 +1,174 @@
+#include "../include/preload.h"
+#include "../include/game.h"       // For PRELOAD_MAX_ASSETS
+#include "../include/asset_pack.h" // For use_asset_pack
+#include "../include/texture_format.h" // For resize_texture
+#include "../include/startup_timeline.h" // For add_startup_phase
+#include <allegro5/allegro_image.h> // For al_load_bitmap
+#include <stdio.h>   // For snprintf, printf
+#include <string.h>  // For memset, strcmp
+
+static PreloadAsset assets[PRELOAD_MAX_ASSETS];
+static int num_assets = 0;
+static bool started = false;
+static bool enabled = false;
+
+// Task i decodes assets i, i + num_tasks, ..., so every task of the graph
+// has work even when there are more assets than tasks
+static TaskGraph preload_graph;
+static int task_first[TASK_GRAPH_MAX_TASKS];
+static int num_tasks = 0;
+static JobSystem* preload_jobs = NULL;
+static ALLEGRO_THREAD* preload_thread = NULL;
+static double start_time, end_time;
+
+void enable_preload(void) {
+    enabled = true;
+}
+
+bool is_preload_command(int argc, char** argv) {
+    return argc > 1 && strcmp(argv[1], "--preload") == 0;
+}
+
+static PreloadAsset* add_preload(const char* path, PreloadKind kind) {
+    if (started || !enabled || num_assets >= PRELOAD_MAX_ASSETS) return NULL;
+    PreloadAsset* asset = &assets[num_assets++];
+    memset(asset, 0, sizeof(*asset));
+    snprintf(asset->path, sizeof(asset->path), "%s", path);
+    asset->kind = kind;
+    return asset;
+}
+
+bool queue_preload_bitmap(const char* path, int bitmap_flags, int fit_width, int fit_height) {
+    PreloadAsset* asset = add_preload(path, PRELOAD_BITMAP);
+    if (!asset) return false;
+    asset->bitmap_flags = bitmap_flags;
+    asset->fit_width = fit_width;
+    asset->fit_height = fit_height;
+    return true;
+}
+
+bool queue_preload_sample(const char* path) {
+    return add_preload(path, PRELOAD_SAMPLE) != NULL;
+}
+
+static void decode_asset(PreloadAsset* asset) {
+    double start = al_get_time();
+    if (asset->kind == PRELOAD_SAMPLE) {
+        asset->sample = al_load_sample(asset->path);
+    } else {
+        al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP | asset->bitmap_flags);
+        asset->bitmap = al_load_bitmap(asset->path);
+        if (asset->bitmap && asset->fit_width > 0 &&
+            (al_get_bitmap_width(asset->bitmap) != asset->fit_width ||
+             al_get_bitmap_height(asset->bitmap) != asset->fit_height)) {
+            asset->bitmap = resize_texture(asset->bitmap, asset->fit_width, asset->fit_height);
+        }
+    }
+    asset->time = al_get_time() - start;
+}
+
+static void decode_task(void* data) {
+    int first = *(int*)data;
+
+    // New bitmap flags and the file interface are per thread
+    int old_flags = al_get_new_bitmap_flags();
+    const ALLEGRO_FILE_INTERFACE* old_interface = al_get_new_file_interface();
+    use_asset_pack();
+    for (int i = first; i < num_assets; i += num_tasks) {
+        decode_asset(&assets[i]);
+    }
+    al_set_new_file_interface(old_interface);
+    al_set_new_bitmap_flags(old_flags);
+}
+
+static void* run_preload(ALLEGRO_THREAD* thread, void* arg) {
+    run_task_graph(preload_jobs, &preload_graph);
+    end_time = al_get_time();
+    return NULL;
+}
+
+void start_preload(JobSystem* jobs) {
+    if (started) return;
+    started = true;
+    preload_jobs = jobs;
+    start_time = end_time = al_get_time();
+    if (num_assets == 0) return;
+
+    init_task_graph(&preload_graph);
+    num_tasks = num_assets < TASK_GRAPH_MAX_TASKS ? num_assets : TASK_GRAPH_MAX_TASKS;
+    for (int i = 0; i < num_tasks; i++) {
+        task_first[i] = i;
+        add_task(&preload_graph, "decode assets", decode_task, &task_first[i]);
+    }
+
+    // The helper thread takes the caller's place in the job system, so the
+    // main thread is free until finish_preload
+    preload_thread = al_create_thread(run_preload, NULL);
+    if (preload_thread) {
+        al_start_thread(preload_thread);
+    } else {
+        fprintf(stderr, "Failed to start preload thread, decoding before continuing\n");
+        run_preload(NULL, NULL);
+    }
+}
+
+static void join_preload(void) {
+    if (!preload_thread) return;
+    al_join_thread(preload_thread, NULL);
+    al_destroy_thread(preload_thread);
+    preload_thread = NULL;
+}
+
+double finish_preload(void) {
+    join_preload();
+
+    int decoded = 0;
+    double decoding = 0.0;
+    for (int i = 0; i < num_assets; i++) {
+        if (assets[i].bitmap || assets[i].sample) decoded++;
+        decoding += assets[i].time;
+    }
+    if (num_assets > 0) {
+        add_startup_phase("decode (worker threads)", start_time, end_time);
+        printf("Preloaded %d of %d assets on %d threads in %.1f ms (%.1f ms of decoding)\n",
+               decoded, num_assets, preload_jobs ? preload_jobs->num_threads + 1 : 1,
+               (end_time - start_time) * 1000.0, decoding * 1000.0);
+    }
+    return end_time - start_time;
+}
+
+static PreloadAsset* find_preload(const char* path, PreloadKind kind) {
+    // Nothing is handed out while the workers may still be writing
+    if (preload_thread) return NULL;
+    for (int i = 0; i < num_assets; i++) {
+        if (assets[i].kind == kind && strcmp(assets[i].path, path) == 0) return &assets[i];
+    }
+    return NULL;
+}
+
+ALLEGRO_BITMAP* take_preloaded_bitmap(const char* path) {
+    PreloadAsset* asset = find_preload(path, PRELOAD_BITMAP);
+    if (!asset) return NULL;
+    ALLEGRO_BITMAP* bitmap = asset->bitmap;
+    asset->bitmap = NULL;
+    return bitmap;
+}
+
+ALLEGRO_SAMPLE* take_preloaded_sample(const char* path) {
+    PreloadAsset* asset = find_preload(path, PRELOAD_SAMPLE);
+    if (!asset) return NULL;
+    ALLEGRO_SAMPLE* sample = asset->sample;
+    asset->sample = NULL;
+    return sample;
+}
+
+void release_preload(void) {
+    join_preload();
+    for (int i = 0; i < num_assets; i++) {
+        if (assets[i].bitmap) al_destroy_bitmap(assets[i].bitmap);
+        if (assets[i].sample) al_destroy_sample(assets[i].sample);
+    }
+    num_assets = 0;
+    num_tasks = 0;
+    started = false;
+}
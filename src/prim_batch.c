@@ -0,0 +1,169 @@
+#include "../include/prim_batch.h"
+#include <math.h>    // For cosf, sinf, sqrtf
+#include <stdio.h>   // For fprintf
+#include <stdlib.h>  // For realloc, free
+#include <string.h>  // For memset
+
+// Unit-circle points of each level of detail, shared by every batch
+static float unit_circle[PRIM_CIRCLE_LODS][PRIM_CIRCLE_MAX_SEGMENTS][2];
+static bool unit_circle_ready = false;
+
+static void build_unit_circles(void) {
+    for (int lod = 0; lod < PRIM_CIRCLE_LODS; lod++) {
+        int segments = PRIM_CIRCLE_MIN_SEGMENTS << lod;
+        for (int i = 0; i < segments; i++) {
+            float angle = 2.0f * ALLEGRO_PI * i / segments;
+            unit_circle[lod][i][0] = cosf(angle);
+            unit_circle[lod][i][1] = sinf(angle);
+        }
+    }
+    unit_circle_ready = true;
+}
+
+// Roughly the segment count Allegro picks for a circle of this radius
+static int circle_lod(float radius) {
+    float wanted = 10.0f * sqrtf(radius);
+    int lod = 0;
+    while (lod < PRIM_CIRCLE_LODS - 1 && (PRIM_CIRCLE_MIN_SEGMENTS << lod) < wanted) lod++;
+    return lod;
+}
+
+void init_prim_batch(PrimBatch* batch) {
+    memset(batch, 0, sizeof(*batch));
+    if (!unit_circle_ready) build_unit_circles();
+}
+
+void free_prim_batch(PrimBatch* batch) {
+    free(batch->vertices);
+    free(batch->indices);
+    memset(batch, 0, sizeof(*batch));
+}
+
+void clear_prim_batch(PrimBatch* batch) {
+    batch->num_vertices = 0;
+    batch->num_indices = 0;
+}
+
+// Make room for 'vertices' more vertices and 'indices' more indices
+static bool reserve(PrimBatch* batch, int vertices, int indices) {
+    if (batch->num_vertices + vertices > batch->vertex_capacity) {
+        int capacity = batch->vertex_capacity > 0 ? batch->vertex_capacity : 1024;
+        while (capacity < batch->num_vertices + vertices) capacity *= 2;
+        ALLEGRO_VERTEX* grown = realloc(batch->vertices, capacity * sizeof(ALLEGRO_VERTEX));
+        if (!grown) {
+            fprintf(stderr, "Failed to grow primitive batch to %d vertices\n", capacity);
+            return false;
+        }
+        batch->vertices = grown;
+        batch->vertex_capacity = capacity;
+    }
+    if (batch->num_indices + indices > batch->index_capacity) {
+        int capacity = batch->index_capacity > 0 ? batch->index_capacity : 2048;
+        while (capacity < batch->num_indices + indices) capacity *= 2;
+        int* grown = realloc(batch->indices, capacity * sizeof(int));
+        if (!grown) {
+            fprintf(stderr, "Failed to grow primitive batch to %d indices\n", capacity);
+            return false;
+        }
+        batch->indices = grown;
+        batch->index_capacity = capacity;
+    }
+    return true;
+}
+
+static void add_vertex(PrimBatch* batch, float x, float y, ALLEGRO_COLOR color) {
+    ALLEGRO_VERTEX* v = &batch->vertices[batch->num_vertices++];
+    v->x = x;
+    v->y = y;
+    v->z = 0.0f;
+    v->u = 0.0f;
+    v->v = 0.0f;
+    v->color = color;
+}
+
+static void add_triangle(PrimBatch* batch, int a, int b, int c) {
+    batch->indices[batch->num_indices++] = a;
+    batch->indices[batch->num_indices++] = b;
+    batch->indices[batch->num_indices++] = c;
+}
+
+// Two triangles between rings of 'count' points starting at 'outer' and 'inner'
+static void add_ring(PrimBatch* batch, int outer, int inner, int count) {
+    for (int i = 0; i < count; i++) {
+        int j = (i + 1) % count;
+        add_triangle(batch, outer + i, outer + j, inner + j);
+        add_triangle(batch, outer + i, inner + j, inner + i);
+    }
+}
+
+void batch_filled_rectangle(PrimBatch* batch, float x1, float y1, float x2, float y2, ALLEGRO_COLOR color) {
+    if (!reserve(batch, 4, 6)) return;
+    int base = batch->num_vertices;
+    add_vertex(batch, x1, y1, color);
+    add_vertex(batch, x2, y1, color);
+    add_vertex(batch, x2, y2, color);
+    add_vertex(batch, x1, y2, color);
+    add_triangle(batch, base, base + 1, base + 2);
+    add_triangle(batch, base, base + 2, base + 3);
+}
+
+void batch_rectangle(PrimBatch* batch, float x1, float y1, float x2, float y2,
+                     ALLEGRO_COLOR color, float thickness) {
+    if (!reserve(batch, 8, 24)) return;
+    // Allegro centres the outline on the rectangle's edges
+    float half = (thickness > 0.0f ? thickness : 1.0f) / 2.0f;
+    int base = batch->num_vertices;
+    add_vertex(batch, x1 - half, y1 - half, color);
+    add_vertex(batch, x2 + half, y1 - half, color);
+    add_vertex(batch, x2 + half, y2 + half, color);
+    add_vertex(batch, x1 - half, y2 + half, color);
+    add_vertex(batch, x1 + half, y1 + half, color);
+    add_vertex(batch, x2 - half, y1 + half, color);
+    add_vertex(batch, x2 - half, y2 - half, color);
+    add_vertex(batch, x1 + half, y2 - half, color);
+    add_ring(batch, base, base + 4, 4);
+}
+
+void batch_filled_circle(PrimBatch* batch, float cx, float cy, float radius, ALLEGRO_COLOR color) {
+    if (radius <= 0.0f) return;
+    int lod = circle_lod(radius);
+    int segments = PRIM_CIRCLE_MIN_SEGMENTS << lod;
+    if (!reserve(batch, segments + 1, segments * 3)) return;
+
+    int centre = batch->num_vertices;
+    add_vertex(batch, cx, cy, color);
+    for (int i = 0; i < segments; i++) {
+        add_vertex(batch, cx + unit_circle[lod][i][0] * radius, cy + unit_circle[lod][i][1] * radius, color);
+    }
+    for (int i = 0; i < segments; i++) {
+        add_triangle(batch, centre, centre + 1 + i, centre + 1 + (i + 1) % segments);
+    }
+}
+
+void batch_circle(PrimBatch* batch, float cx, float cy, float radius, ALLEGRO_COLOR color, float thickness) {
+    if (radius <= 0.0f) return;
+    float half = (thickness > 0.0f ? thickness : 1.0f) / 2.0f;
+    float outer_radius = radius + half;
+    float inner_radius = radius > half ? radius - half : 0.0f;
+    int lod = circle_lod(outer_radius);
+    int segments = PRIM_CIRCLE_MIN_SEGMENTS << lod;
+    if (!reserve(batch, segments * 2, segments * 6)) return;
+
+    int outer = batch->num_vertices;
+    for (int i = 0; i < segments; i++) {
+        add_vertex(batch, cx + unit_circle[lod][i][0] * outer_radius, cy + unit_circle[lod][i][1] * outer_radius, color);
+    }
+    int inner = batch->num_vertices;
+    for (int i = 0; i < segments; i++) {
+        add_vertex(batch, cx + unit_circle[lod][i][0] * inner_radius, cy + unit_circle[lod][i][1] * inner_radius, color);
+    }
+    add_ring(batch, outer, inner, segments);
+}
+
+bool flush_prim_batch(PrimBatch* batch) {
+    if (batch->num_indices == 0) return false;
+    al_draw_indexed_prim(batch->vertices, NULL, NULL, batch->indices, batch->num_indices,
+                         ALLEGRO_PRIM_TRIANGLE_LIST);
+    clear_prim_batch(batch);
+    return true;
+}
@@ -1,106 +1,123 @@
 #include "../include/game.h"
 #include "../include/game_logic.h"  // For star system functions
+#include "../include/entity.h"      // For check_rect_collision
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+// Take a particle slot, from the spawn queue while spawns are deferred
+static Particle* acquire_particle(Level* level) {
+    return pool_acquire(level->defer_particles ? &level->particle_spawns : &level->particles);
+}
+
 // Create a new projectile
 void create_projectile(Level* level, float x, float y, float target_x, float target_y, EntityType source) {
-    if (!level || !level->projectiles) return;
+    if (!level) return;
     
-    // Find an inactive projectile slot
-    for (int i = 0; i < MAX_PROJECTILES; i++) {
-        if (!level->projectiles[i].active) {
-            Projectile* proj = &level->projectiles[i];
-            
-            // Set position
-            proj->x = x;
-            proj->y = y;
-            proj->width = PROJECTILE_WIDTH;
-            proj->height = PROJECTILE_HEIGHT;
-            
-            // Calculate direction and velocity
-            float dx = target_x - x;
-            float dy = target_y - y;
-            float distance = sqrt(dx * dx + dy * dy);
-            
-            if (distance > 0) {
-                proj->dx = (dx / distance) * PROJECTILE_SPEED;
-                proj->dy = (dy / distance) * PROJECTILE_SPEED;
-            } else {
-                // Default direction if target is exactly at source position
-                proj->dx = PROJECTILE_SPEED;
-                proj->dy = 0;
-            }
-            
-            // Set projectile properties
-            proj->active = true;
-            proj->lifetime = PROJECTILE_LIFETIME;
-            proj->damage = PROJECTILE_DAMAGE;
-            proj->source = source;
-            
-            // Increment active projectile count
-            level->num_projectiles++;
-            
-            printf("Created projectile from %.0f,%.0f to %.0f,%.0f\n", x, y, target_x, target_y);
-            return;
-        }
+    // Take a slot from the pool (grows on demand, recycles the oldest shot when over budget)
+    Projectile* proj = pool_acquire(&level->projectiles);
+    if (!proj) return;
+    
+    // Set position
+    proj->x = x;
+    proj->y = y;
+    proj->width = PROJECTILE_WIDTH;
+    proj->height = PROJECTILE_HEIGHT;
+    
+    // Calculate direction and velocity
+    float dx = target_x - x;
+    float dy = target_y - y;
+    float distance = sqrt(dx * dx + dy * dy);
+    
+    if (distance > 0) {
+        proj->dx = (dx / distance) * PROJECTILE_SPEED;
+        proj->dy = (dy / distance) * PROJECTILE_SPEED;
+    } else {
+        // Default direction if target is exactly at source position
+        proj->dx = PROJECTILE_SPEED;
+        proj->dy = 0;
     }
     
-    printf("Warning: No available projectile slots\n");
+    // Set projectile properties
+    proj->active = true;
+    proj->lifetime = PROJECTILE_LIFETIME;
+    proj->damage = PROJECTILE_DAMAGE;
+    proj->source = source;
+    proj->trail = true;
 }
 
 // Create a player projectile with direct velocity (for directional shooting)
 void create_player_projectile(Level* level, float x, float y, float dx, float dy) {
-    if (!level || !level->projectiles) return;
+    if (!level) return;
     
-    // Find an inactive projectile slot
-    for (int i = 0; i < MAX_PROJECTILES; i++) {
-        if (!level->projectiles[i].active) {
-            Projectile* proj = &level->projectiles[i];
-            
-            // Set position
-            proj->x = x;
-            proj->y = y;
-            proj->width = PROJECTILE_WIDTH;
-            proj->height = PROJECTILE_HEIGHT;
-            
-            // Set velocity directly
-            proj->dx = dx;
-            proj->dy = dy;
-            
-            // Set projectile properties
-            proj->active = true;
-            proj->lifetime = PROJECTILE_LIFETIME;
-            proj->damage = PLAYER_PROJECTILE_DAMAGE;
-            proj->source = CANCER_CELL; // Player is cancer cell
-            
-            // Increment active projectile count
-            level->num_projectiles++;
-            
-            printf("Created player projectile at %.0f,%.0f with velocity %.1f,%.1f\n", x, y, dx, dy);
-            return;
-        }
-    }
+    Projectile* proj = pool_acquire(&level->projectiles);
+    if (!proj) return;
     
-    printf("Warning: No available projectile slots for player\n");
+    // Set position
+    proj->x = x;
+    proj->y = y;
+    proj->width = PROJECTILE_WIDTH;
+    proj->height = PROJECTILE_HEIGHT;
+    
+    // Set velocity directly
+    proj->dx = dx;
+    proj->dy = dy;
+    
+    // Set projectile properties
+    proj->active = true;
+    proj->lifetime = PROJECTILE_LIFETIME;
+    proj->damage = PLAYER_PROJECTILE_DAMAGE;
+    proj->source = CANCER_CELL; // Player is cancer cell
+    proj->trail = true;
+}
+
+void create_projectile_volley(Level* level, float x, float y, float angle, float step, int count,
+                              float speed, EntityType source) {
+    if (!level) return;
+
+    // Turn one direction vector by 'step' per bullet instead of calling
+    // cos and sin for each
+    float dir_x = cosf(angle), dir_y = sinf(angle);
+    float step_cos = cosf(step), step_sin = sinf(step);
+    float half_width = PROJECTILE_WIDTH / 2, half_height = PROJECTILE_HEIGHT / 2;
+    for (int i = 0; i < count; i++) {
+        Projectile* proj = pool_acquire(&level->projectiles);
+        if (!proj) return;
+        proj->x = x - half_width;
+        proj->y = y - half_height;
+        proj->width = PROJECTILE_WIDTH;
+        proj->height = PROJECTILE_HEIGHT;
+        proj->dx = dir_x * speed;
+        proj->dy = dir_y * speed;
+        proj->active = true;
+        proj->lifetime = PROJECTILE_LIFETIME;
+        proj->damage = PROJECTILE_DAMAGE;
+        proj->source = source;
+        proj->trail = false;
+
+        float turned_x = dir_x * step_cos - dir_y * step_sin;
+        dir_y = dir_x * step_sin + dir_y * step_cos;
+        dir_x = turned_x;
+    }
 }
 
 // Update all projectiles
 void update_projectiles(Level* level, Game* game) {
-    if (!level || !level->projectiles) return;
+    if (!level) return;
     
-    for (int i = 0; i < MAX_PROJECTILES; i++) {
-        Projectile* proj = &level->projectiles[i];
-        
-        if (!proj->active) continue;
+    int next;
+    for (int i = pool_first(&level->projectiles); i != POOL_SLOT_NONE; i = next) {
+        next = pool_next(&level->projectiles, i);
+        Projectile* proj = pool_at(&level->projectiles, i);
         
         // Update position
         proj->x += proj->dx;
         proj->y += proj->dy;
         
         // Create trail effect for moving projectiles
-        create_projectile_trail(level, proj->x + proj->width/2, proj->y + proj->height/2, proj->source);
+        if (proj->trail) {
+            create_projectile_trail(level, proj->x + proj->width/2, proj->y + proj->height/2, proj->source);
+        }
         
         // Decrease lifetime
         proj->lifetime--;
@@ -139,31 +156,28 @@ void update_projectiles(Level* level, Game* game) {
         // Destroy projectile if needed
         if (should_destroy) {
             proj->active = false;
-            level->num_projectiles--;
+            pool_release(&level->projectiles, i);
         }
     }
 }
 
 // Check projectile collisions with player
 void check_projectile_collisions(Level* level, Game* game) {
-    if (!level || !level->projectiles || !game) return;
+    if (!level || !game) return;
     
-    for (int i = 0; i < MAX_PROJECTILES; i++) {
-        Projectile* proj = &level->projectiles[i];
-        
-        if (!proj->active) continue;
+    int next;
+    for (int i = pool_first(&level->projectiles); i != POOL_SLOT_NONE; i = next) {
+        next = pool_next(&level->projectiles, i);
+        Projectile* proj = pool_at(&level->projectiles, i);
         
         // Check player projectiles hitting enemies
         if (proj->source == CANCER_CELL) {
             // Player projectile - check collision with enemies
-            for (int e = 0; e < level->num_enemies; e++) {
-                Entity* enemy = &level->enemies[e];
+            for (int e = pool_first(&level->enemies); e != POOL_SLOT_NONE; e = pool_next(&level->enemies, e)) {
+                Entity* enemy = pool_at(&level->enemies, e);
                 if (!enemy->active) continue;
                 
-                if (proj->x < enemy->x + enemy->width &&
-                    proj->x + proj->width > enemy->x &&
-                    proj->y < enemy->y + enemy->height &&
-                    proj->y + proj->height > enemy->y) {
+                if (check_rect_collision(enemy, proj->x, proj->y, proj->width, proj->height)) {
                     
                     // Create hit particle effect
                     create_particle_burst(level, proj->x + proj->width/2, proj->y + proj->height/2, 
@@ -186,7 +200,7 @@ void check_projectile_collisions(Level* level, Game* game) {
                     
                     // Destroy projectile
                     proj->active = false;
-                    level->num_projectiles--;
+                    pool_release(&level->projectiles, i);
                     
                     printf("Player projectile hit enemy! Enemy health: %.0f\n", enemy->health);
                     break; // Exit enemy loop since projectile is destroyed
@@ -194,10 +208,7 @@ void check_projectile_collisions(Level* level, Game* game) {
             }
         } else {
             // Enemy projectile - check collision with player
-            if (proj->x < game->player.x + game->player.width &&
-                proj->x + proj->width > game->player.x &&
-                proj->y < game->player.y + game->player.height &&
-                proj->y + proj->height > game->player.y) {
+            if (check_rect_collision(&game->player, proj->x, proj->y, proj->width, proj->height)) {
                 
                 // Create hit particle effect
                 create_particle_burst(level, proj->x + proj->width/2, proj->y + proj->height/2, 
@@ -216,7 +227,7 @@ void check_projectile_collisions(Level* level, Game* game) {
                 
                 // Destroy projectile
                 proj->active = false;
-                level->num_projectiles--;
+                pool_release(&level->projectiles, i);
                 
                 printf("Player hit by projectile! Health: %.0f\n", game->player.health);
                 
@@ -238,35 +249,31 @@ void check_projectile_collisions(Level* level, Game* game) {
 
 // Create a burst of particles for visual effects
 void create_particle_burst(Level* level, float x, float y, ALLEGRO_COLOR color, int count) {
-    if (!level || !level->particles) return;
+    if (!level) return;
     
-    int particles_created = 0;
-    for (int i = 0; i < MAX_PARTICLES && particles_created < count; i++) {
-        if (!level->particles[i].active) {
-            Particle* p = &level->particles[i];
-            
-            // Random velocity for burst effect
-            float angle = (rand() % 360) * M_PI / 180.0f;
-            float speed = 1.0f + (rand() % 3); // Random speed 1-3
-            
-            p->x = x;
-            p->y = y;
-            p->dx = cos(angle) * speed;
-            p->dy = sin(angle) * speed - 1.0f; // Slight upward bias
-            p->color = color;
-            p->lifetime = PARTICLE_LIFETIME_SHORT + (rand() % PARTICLE_LIFETIME_SHORT);
-            p->max_lifetime = p->lifetime;
-            p->active = true;
-            
-            level->num_particles++;
-            particles_created++;
-        }
+    for (int n = 0; n < count; n++) {
+        // Oldest particles are recycled once the particle share of the budget is used up
+        Particle* p = acquire_particle(level);
+        if (!p) break;
+        
+        // Random velocity for burst effect
+        float angle = (rand() % 360) * M_PI / 180.0f;
+        float speed = 1.0f + (rand() % 3); // Random speed 1-3
+        
+        p->x = x;
+        p->y = y;
+        p->dx = cos(angle) * speed;
+        p->dy = sin(angle) * speed - 1.0f; // Slight upward bias
+        p->color = color;
+        p->lifetime = PARTICLE_LIFETIME_SHORT + (rand() % PARTICLE_LIFETIME_SHORT);
+        p->max_lifetime = p->lifetime;
+        p->active = true;
     }
 }
 
 // Create spectacular death effect for enemies
 void create_enemy_death_effect(Level* level, float x, float y, EntityType enemy_type) {
-    if (!level || !level->particles) return;
+    if (!level) return;
     
     // Choose colors based on enemy type
     ALLEGRO_COLOR primary_color, secondary_color;
@@ -292,35 +299,30 @@ void create_enemy_death_effect(Level* level, float x, float y, EntityType enemy_
             secondary_color = COLOR_LIGHT_GRAY;
     }
     
-    int particles_created = 0;
-    for (int i = 0; i < MAX_PARTICLES && particles_created < ENEMY_DEATH_PARTICLES; i++) {
-        if (!level->particles[i].active) {
-            Particle* p = &level->particles[i];
-            
-            // Create explosion-like effect
-            float angle = (rand() % 360) * M_PI / 180.0f;
-            float speed = 2.0f + (rand() % 4); // Random speed 2-5
-            
-            p->x = x;
-            p->y = y;
-            p->dx = cos(angle) * speed;
-            p->dy = sin(angle) * speed - 0.5f; // Slight upward bias
-            
-            // Alternate between primary and secondary colors
-            p->color = (particles_created % 2 == 0) ? primary_color : secondary_color;
-            p->lifetime = PARTICLE_LIFETIME_LONG + (rand() % PARTICLE_LIFETIME_MEDIUM);
-            p->max_lifetime = p->lifetime;
-            p->active = true;
-            
-            level->num_particles++;
-            particles_created++;
-        }
+    for (int n = 0; n < ENEMY_DEATH_PARTICLES; n++) {
+        Particle* p = acquire_particle(level);
+        if (!p) break;
+        
+        // Create explosion-like effect
+        float angle = (rand() % 360) * M_PI / 180.0f;
+        float speed = 2.0f + (rand() % 4); // Random speed 2-5
+        
+        p->x = x;
+        p->y = y;
+        p->dx = cos(angle) * speed;
+        p->dy = sin(angle) * speed - 0.5f; // Slight upward bias
+        
+        // Alternate between primary and secondary colors
+        p->color = (n % 2 == 0) ? primary_color : secondary_color;
+        p->lifetime = PARTICLE_LIFETIME_LONG + (rand() % PARTICLE_LIFETIME_MEDIUM);
+        p->max_lifetime = p->lifetime;
+        p->active = true;
     }
 }
 
 // Create subtle trail effect for projectiles
 void create_projectile_trail(Level* level, float x, float y, EntityType source) {
-    if (!level || !level->particles) return;
+    if (!level) return;
     
     // Only create trail occasionally to avoid overwhelming the screen
     if (rand() % 3 != 0) return;
@@ -332,33 +334,28 @@ void create_projectile_trail(Level* level, float x, float y, EntityType source)
         trail_color = al_map_rgba(255, 100, 100, 120); // Semi-transparent red for enemies
     }
     
-    for (int i = 0; i < MAX_PARTICLES; i++) {
-        if (!level->particles[i].active) {
-            Particle* p = &level->particles[i];
-            
-            p->x = x + (rand() % 6) - 3; // Small random offset
-            p->y = y + (rand() % 6) - 3;
-            p->dx = 0;
-            p->dy = 0.5f; // Gentle downward drift
-            p->color = trail_color;
-            p->lifetime = PARTICLE_LIFETIME_SHORT;
-            p->max_lifetime = p->lifetime;
-            p->active = true;
-            
-            level->num_particles++;
-            break; // Only create one trail particle per call
-        }
-    }
+    // Only create one trail particle per call
+    Particle* p = acquire_particle(level);
+    if (!p) return;
+    
+    p->x = x + (rand() % 6) - 3; // Small random offset
+    p->y = y + (rand() % 6) - 3;
+    p->dx = 0;
+    p->dy = 0.5f; // Gentle downward drift
+    p->color = trail_color;
+    p->lifetime = PARTICLE_LIFETIME_SHORT;
+    p->max_lifetime = p->lifetime;
+    p->active = true;
 }
 
 // Update all particles
 void update_particles(Level* level) {
-    if (!level || !level->particles) return;
+    if (!level) return;
     
-    for (int i = 0; i < MAX_PARTICLES; i++) {
-        Particle* p = &level->particles[i];
-        
-        if (!p->active) continue;
+    int next;
+    for (int i = pool_first(&level->particles); i != POOL_SLOT_NONE; i = next) {
+        next = pool_next(&level->particles, i);
+        Particle* p = pool_at(&level->particles, i);
         
         // Update position
         p->x += p->dx;
@@ -377,7 +374,22 @@ void update_particles(Level* level) {
         // Destroy particle if lifetime expired
         if (p->lifetime <= 0) {
             p->active = false;
-            level->num_particles--;
+            pool_release(&level->particles, i);
         }
     }
 }
+
+// Move particles queued while spawns were deferred into the particle pool
+// and stop deferring
+void flush_deferred_particles(Level* level) {
+    if (!level) return;
+    
+    level->defer_particles = false;
+    int next;
+    for (int i = pool_first(&level->particle_spawns); i != POOL_SLOT_NONE; i = next) {
+        next = pool_next(&level->particle_spawns, i);
+        Particle* p = pool_acquire(&level->particles);
+        if (p) *p = *(Particle*)pool_at(&level->particle_spawns, i);
+        pool_release(&level->particle_spawns, i);
+    }
+}
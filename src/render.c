@@ -0,0 +1,280 @@
+#include "../include/render.h"
+#include "../include/game_logic.h" // For calculate_stars
+#include "../include/drawing.h"    // For draw_game
+#include "../include/camera.h"     // For find_visible_range
+#include "../include/startup_timeline.h" // For finish_startup_timeline
+#include <stdio.h>   // For printf, fprintf
+#include <stdlib.h>  // For realloc, free
+#include <string.h>  // For memset, strncpy
+#include <stddef.h>  // For offsetof
+
+// Make room for 'count' elements in a snapshot array
+static bool reserve_items(void** items, int* capacity, int count, size_t size) {
+    if (count <= *capacity) return true;
+    int new_capacity = *capacity > 0 ? *capacity : 16;
+    while (new_capacity < count) new_capacity *= 2;
+    void* grown = realloc(*items, new_capacity * size);
+    if (!grown) {
+        fprintf(stderr, "Failed to grow render snapshot to %d items\n", new_capacity);
+        return false;
+    }
+    *items = grown;
+    *capacity = new_capacity;
+    return true;
+}
+
+static bool is_visible(float x, float width, float left, float right) {
+    return x + width >= left && x <= right;
+}
+
+static void capture_menu(const Menu* menu, RenderMenu* out) {
+    out->num_items = menu->num_items < RENDER_MENU_ITEMS ? menu->num_items : RENDER_MENU_ITEMS;
+    out->selected_index = menu->selected_index;
+    for (int i = 0; i < out->num_items; i++) {
+        strncpy(out->text[i], menu->items[i].text, MAX_MENU_TEXT - 1);
+        out->text[i][MAX_MENU_TEXT - 1] = '\0';
+        out->enabled[i] = menu->items[i].enabled;
+    }
+}
+
+static void capture_scene(const Game* game, RenderSnapshot* snap) {
+    Level* level = game->current_level_data;
+    float left = game->camera.x - RENDER_CULL_MARGIN;
+    float right = game->camera.x + game->camera.width + RENDER_CULL_MARGIN;
+    int first, last;
+
+    snap->has_scene = true;
+    snap->level = level;
+    snap->camera = game->camera;
+    snap->portal = level->portal;
+
+    const Entity* player = &game->player;
+    snap->player = (RenderPlayer){
+        .x = player->x, .y = player->y, .width = player->width, .height = player->height,
+        .state = player->state,
+        .last_shot = player->last_shot,
+        .last_attack = player->last_attack,
+        .combo_count = player->combo_count,
+        .combo_timer = player->combo_timer,
+        .health = player->health, .max_health = player->max_health,
+        .sprite = player->sprite, .facing_left = player->facing_left
+    };
+
+    // Platforms and glucose items are sorted by x, so only the visible
+    // slice of them is looked at
+    snap->num_platforms = 0;
+    find_visible_range(level->platforms, level->num_platforms, sizeof(Platform), offsetof(Platform, x),
+                       level->max_platform_width, left, right, &first, &last);
+    if (reserve_items((void**)&snap->platforms, &snap->platform_capacity,
+                      last - first, sizeof(Platform))) {
+        for (int i = first; i < last; i++) {
+            const Platform* p = &level->platforms[i];
+            if (is_visible(p->x, p->width, left, right)) {
+                snap->platforms[snap->num_platforms++] = *p;
+            }
+        }
+    }
+
+    snap->num_enemies = 0;
+    if (reserve_items((void**)&snap->enemies, &snap->enemy_capacity,
+                      level->enemies.live, sizeof(RenderEnemy))) {
+        for (int i = pool_first(&level->enemies); i != POOL_SLOT_NONE; i = pool_next(&level->enemies, i)) {
+            const Entity* e = pool_at(&level->enemies, i);
+            if (!e->active || !is_visible(e->x, e->width, left, right)) continue;
+            snap->enemies[snap->num_enemies++] = (RenderEnemy){
+                e->x, e->y, e->width, e->height, e->type, e->health, e->max_health,
+                e->sprite, e->facing_left
+            };
+        }
+    }
+
+    snap->num_projectiles = 0;
+    if (reserve_items((void**)&snap->projectiles, &snap->projectile_capacity,
+                      level->projectiles.live, sizeof(RenderProjectile))) {
+        for (int i = pool_first(&level->projectiles); i != POOL_SLOT_NONE; i = pool_next(&level->projectiles, i)) {
+            const Projectile* p = pool_at(&level->projectiles, i);
+            if (!is_visible(p->x, p->width, left, right)) continue;
+            snap->projectiles[snap->num_projectiles++] = (RenderProjectile){
+                p->x, p->y, p->width, p->height, p->source
+            };
+        }
+    }
+
+    snap->num_particles = 0;
+    if (reserve_items((void**)&snap->particles, &snap->particle_capacity,
+                      level->particles.live, sizeof(RenderParticle))) {
+        for (int i = pool_first(&level->particles); i != POOL_SLOT_NONE; i = pool_next(&level->particles, i)) {
+            const Particle* p = pool_at(&level->particles, i);
+            if (!is_visible(p->x, 0.0f, left, right)) continue;
+            snap->particles[snap->num_particles++] = (RenderParticle){ p->x, p->y, p->color };
+        }
+    }
+
+    snap->num_glucose_items = 0;
+    find_visible_range(level->glucose_items, level->num_glucose_items, sizeof(GlucoseItem),
+                       offsetof(GlucoseItem, x), level->max_glucose_width, left, right, &first, &last);
+    if (reserve_items((void**)&snap->glucose_items, &snap->glucose_capacity,
+                      last - first, sizeof(RenderGlucose))) {
+        for (int i = first; i < last; i++) {
+            const GlucoseItem* g = &level->glucose_items[i];
+            if (!g->active || !is_visible(g->x, g->width, left, right)) continue;
+            snap->glucose_items[snap->num_glucose_items++] = (RenderGlucose){
+                g->x, g->y, g->width, g->height
+            };
+        }
+    }
+}
+
+void capture_render_snapshot(const Game* game, RenderSnapshot* snap) {
+    snap->state = game->state;
+    snap->time = al_get_time();
+    snap->show_overdraw = game->show_overdraw;
+    snap->render_scale = game->settings.render_scale;
+    snap->current_level = game->current_level;
+    snap->total_stars = game->total_stars;
+    snap->level_progress_stars = calculate_stars(&game->current_level_progress);
+    for (int i = 0; i < TOTAL_LEVELS; i++) {
+        snap->level_stars[i] = game->level_stars[i].stars_earned;
+    }
+
+    switch (game->state) {
+        case MAIN_MENU: capture_menu(&game->main_menu, &snap->menu); break;
+        case LEVEL_SELECT: capture_menu(&game->level_menu, &snap->menu); break;
+        case SETTINGS: capture_menu(&game->settings_menu, &snap->menu); break;
+        default: snap->menu.num_items = 0; break;
+    }
+
+    // The scene is only needed while playing or paused over it
+    snap->has_scene = false;
+    if ((game->state == PLAYING || game->state == PAUSED) && game->current_level_data) {
+        capture_scene(game, snap);
+    }
+}
+
+// Background tiles and static chunks are made by whichever thread draws,
+// so only that thread may drop them when the level changes
+static void draw_snapshot(Game* game, Renderer* renderer, const RenderSnapshot* snap) {
+    if (snap->has_scene && snap->level != renderer->drawn_level) {
+        if (renderer->drawn_level) {
+            evict_background_tiles(&renderer->drawn_level->background_tiles);
+            destroy_static_chunks(&renderer->drawn_level->static_chunks);
+        }
+        renderer->drawn_level = snap->level;
+        // The first frame of a level waits for its tiles; later ones stream
+        load_background_tiles(&snap->level->background_tiles, snap->camera.x,
+                              snap->camera.x + snap->camera.width);
+    }
+    draw_game(game, snap);
+    if (renderer->drawn_count == 0) finish_startup_timeline();
+    renderer->drawn_count++;
+}
+
+static void* render_thread(ALLEGRO_THREAD* thread, void* arg) {
+    Game* game = arg;
+    Renderer* renderer = game->renderer;
+    al_set_target_backbuffer(game->display);
+
+    while (true) {
+        al_lock_mutex(renderer->lock);
+        while (!renderer->fresh && !renderer->quit) {
+            al_wait_cond(renderer->published, renderer->lock);
+        }
+        if (renderer->quit) {
+            al_unlock_mutex(renderer->lock);
+            break;
+        }
+        // Take the newest snapshot; the one drawn last becomes the spare
+        int read = renderer->ready_index;
+        renderer->ready_index = renderer->read_index;
+        renderer->read_index = read;
+        renderer->fresh = false;
+        al_unlock_mutex(renderer->lock);
+
+        draw_snapshot(game, renderer, &renderer->buffers[read]);
+    }
+
+    // Release the display so the main thread can clean up
+    al_set_target_bitmap(NULL);
+    return NULL;
+}
+
+bool init_renderer(Game* game) {
+    Renderer* renderer = calloc(1, sizeof(Renderer));
+    if (!renderer) {
+        fprintf(stderr, "Failed to allocate renderer!\n");
+        return false;
+    }
+    renderer->write_index = 0;
+    renderer->ready_index = 1;
+    renderer->read_index = 2;
+    game->renderer = renderer;
+
+    if (!RENDER_THREAD) return true;
+
+    renderer->lock = al_create_mutex();
+    renderer->published = al_create_cond();
+    renderer->thread = renderer->lock && renderer->published ?
+                       al_create_thread(render_thread, game) : NULL;
+    if (!renderer->thread) {
+        fprintf(stderr, "Failed to start render thread, drawing on the main thread\n");
+        return true;
+    }
+
+    // The display can only be current on one thread at a time
+    al_set_target_bitmap(NULL);
+    al_start_thread(renderer->thread);
+    return true;
+}
+
+void publish_render_snapshot(Game* game) {
+    Renderer* renderer = game->renderer;
+    RenderSnapshot* snap = &renderer->buffers[renderer->write_index];
+    snap->sequence = renderer->published_count++;
+    capture_render_snapshot(game, snap);
+
+    if (!renderer->thread) {
+        draw_snapshot(game, renderer, snap);
+        return;
+    }
+
+    // Swap the filled buffer with the ready one. If the renderer has not
+    // taken the previous snapshot yet, that snapshot is simply skipped.
+    al_lock_mutex(renderer->lock);
+    int ready = renderer->ready_index;
+    renderer->ready_index = renderer->write_index;
+    renderer->write_index = ready;
+    renderer->fresh = true;
+    al_signal_cond(renderer->published);
+    al_unlock_mutex(renderer->lock);
+}
+
+void cleanup_renderer(Game* game) {
+    Renderer* renderer = game->renderer;
+    if (!renderer) return;
+
+    if (renderer->thread) {
+        al_lock_mutex(renderer->lock);
+        renderer->quit = true;
+        al_signal_cond(renderer->published);
+        al_unlock_mutex(renderer->lock);
+        al_join_thread(renderer->thread, NULL);
+        al_destroy_thread(renderer->thread);
+        al_set_target_backbuffer(game->display);
+    }
+    if (renderer->published) al_destroy_cond(renderer->published);
+    if (renderer->lock) al_destroy_mutex(renderer->lock);
+
+    printf("Renderer: %u snapshots published, %u drawn\n",
+           renderer->published_count, renderer->drawn_count);
+
+    for (int i = 0; i < 3; i++) {
+        RenderSnapshot* snap = &renderer->buffers[i];
+        free(snap->platforms);
+        free(snap->enemies);
+        free(snap->projectiles);
+        free(snap->particles);
+        free(snap->glucose_items);
+    }
+    free(renderer);
+    game->renderer = NULL;
+}
@@ -0,0 +1,486 @@
+#include "../include/render_bench.h"
+#include "../include/game.h"       // For Game, GameState, constants
+#include "../include/game_logic.h" // For init_game_headless, update_game, reset_player_and_level
+#include "../include/drawing.h"    // For draw_game, set_draw_timings, DrawContext
+#include "../include/render.h"     // For capture_render_snapshot
+#include "../include/spawner.h"    // For spawn_enemy, init_spawner
+#include "../include/static_chunks.h" // For destroy_static_chunks
+#include <allegro5/allegro_primitives.h> // For drawing the tile atlas
+#include <allegro5/allegro_image.h> // For al_save_bitmap, PNG loading
+#include <stdio.h>   // For printf, fprintf, snprintf
+#include <stdlib.h>  // For srand, atoi
+#include <string.h>  // For strcmp, memset
+
+typedef enum {
+    BENCH_TIME,
+    BENCH_GOLDEN_CHECK,
+    BENCH_GOLDEN_UPDATE
+} BenchMode;
+
+typedef struct {
+    const char* name;           // Also the name of the golden image
+    GameState state;            // State drawn
+    int level;                  // Level loaded first (1-based)
+    int ticks;                  // update_game calls before drawing
+    float move;                 // Player dx held during those ticks
+    void (*setup)(Game* game);  // Adds objects after the ticks, may be NULL
+} BenchScenario;
+
+// Enemies of every type, shots in both directions and a few particle bursts
+static void setup_combat(Game* game) {
+    static const EntityType types[] = { T_CELL, MACROPHAGE, B_CELL, NK_CELL };
+    const int count = sizeof(types) / sizeof(types[0]);
+    Level* level = game->current_level_data;
+
+    // The next reset empties the enemy pool again
+    for (int i = 0; i < count; i++) {
+        Entity* e = spawn_enemy(level, types[i], BEHAVIOR_NONE,
+                                game->camera.x + SCREEN_WIDTH * 0.45f + i * 110.0f,
+                                SCREEN_HEIGHT * 0.6f - i * 40.0f, 100.0f);
+        if (!e) return;
+        e->health = 100.0f - i * 30.0f; // Full and damaged health bars
+        create_projectile(level, e->x, e->y + 20.0f, game->player.x, game->player.y, types[i]);
+        create_particle_burst(level, e->x + 20.0f, e->y + 20.0f, al_map_rgb(255, 80, 80), 12);
+    }
+
+    create_player_projectile(level, game->player.x + game->player.width, game->player.y + 20.0f,
+                             PLAYER_PROJECTILE_SPEED, 0.0f);
+    game->player.combo_count = 3;
+    game->player.combo_timer = 30;
+}
+
+// Stars for the level complete, game over and victory screens
+static void setup_results(Game* game) {
+    for (int i = 0; i < TOTAL_LEVELS; i++) {
+        game->level_stars[i].stars_earned = TOTAL_LEVELS - i;
+    }
+    game->current_level_progress.killed_normal_enemy = true;
+    game->current_level_progress.killed_all_enemies = true;
+    game->total_stars = calculate_total_stars(game);
+}
+
+// Hundreds of enemies from four waves, fighting for half a second
+static void setup_horde(Game* game) {
+    static SpawnPoint points[4];
+    static const SpawnWave waves[] = {
+        { SPAWN_AT_TIME, 0.0f, 0, T_CELL,     BEHAVIOR_CHASE,    64, 0, 44.0f, 60.0f },
+        { SPAWN_AT_TIME, 0.0f, 1, MACROPHAGE, BEHAVIOR_PATROL,   64, 0, 44.0f, 80.0f },
+        { SPAWN_AT_TIME, 0.0f, 2, B_CELL,     BEHAVIOR_SHOOT,    64, 0, 44.0f, 60.0f },
+        { SPAWN_AT_TIME, 0.0f, 3, NK_CELL,    BEHAVIOR_SURROUND, 64, 0, 44.0f, 40.0f },
+    };
+    for (int i = 0; i < 4; i++) {
+        points[i] = (SpawnPoint){ game->camera.x + (i % 2 ? SCREEN_WIDTH * 0.55f : 20.0f),
+                                  i < 2 ? SCREEN_HEIGHT * 0.45f : SCREEN_HEIGHT - 90.0f };
+    }
+    init_spawner(game->current_level_data, points, 4, waves, 4);
+    for (int i = 0; i < 30 && game->state == PLAYING; i++) {
+        update_game(game);
+    }
+}
+
+// Bosses in their second phase filling the screen with pattern bullets.
+// The player can't die, so every tick keeps firing.
+static void setup_bullet_hell(Game* game) {
+    Level* level = game->current_level_data;
+    for (int i = 0; i < RENDER_BENCH_BOSSES; i++) {
+        Entity* boss = spawn_enemy(level, MACROPHAGE, BEHAVIOR_BOSS,
+                                   game->camera.x + SCREEN_WIDTH * (i + 1) / (RENDER_BENCH_BOSSES + 1),
+                                   SCREEN_HEIGHT * 0.3f, 200.0f);
+        if (!boss) break;
+        boss->health = boss->max_health * ENEMY_BOSS_PHASE_HEALTH * 0.5f;
+    }
+    game->player.max_health = game->player.health = 1.0e9f;
+    for (int i = 0; i < 240 && game->state == PLAYING; i++) {
+        update_game(game);
+    }
+}
+
+// No shipped level has a tile layer, so the bench lays one over level 1:
+// ledges the player drops onto and walks along, a hazard run and a few
+// decorations, with an atlas drawn here. The map and atlas live until the
+// next scenario is prepared.
+static const TileDef bench_tile_defs[] = {
+    { 0, { 0 }, PHYS_LAYER_TERRAIN },                   // '#'
+    { 1, { 0 }, PHYS_LAYER_TERRAIN },                   // '='
+    { 2, { 0 }, PHYS_LAYER_HAZARD },                    // '^'
+    { -1, { 0.3f, 0.6f, 0.3f, 1.0f }, 0 },              // '.', a plain colour
+};
+static const char* const bench_tile_rows[] = {
+    "                         ..    ==       ",
+    "                              ====      ",
+    "   ..                                   ",
+    "   ############^^^^#######       ####   ",
+    "   #######                    ########  ",
+};
+#define BENCH_TILE_ROWS ((int)(sizeof(bench_tile_rows) / sizeof(bench_tile_rows[0])))
+
+static Arena bench_tile_arena;
+static ALLEGRO_BITMAP* bench_tile_atlas = NULL;
+static Level* bench_tile_level = NULL;
+
+static ALLEGRO_BITMAP* create_bench_atlas(void) {
+    static const unsigned char colors[][3] = { { 120, 90, 60 }, { 90, 110, 150 }, { 200, 40, 40 } };
+    const int count = sizeof(colors) / sizeof(colors[0]);
+    ALLEGRO_BITMAP* atlas = al_create_bitmap(TILEMAP_TILE_SIZE * count, TILEMAP_TILE_SIZE);
+    if (!atlas) return NULL;
+    ALLEGRO_BITMAP* old_target = al_get_target_bitmap();
+    al_set_target_bitmap(atlas);
+    for (int i = 0; i < count; i++) {
+        float x = (float)(i * TILEMAP_TILE_SIZE);
+        al_draw_filled_rectangle(x, 0, x + TILEMAP_TILE_SIZE, TILEMAP_TILE_SIZE,
+                                 al_map_rgb(colors[i][0], colors[i][1], colors[i][2]));
+        al_draw_rectangle(x + 1.5f, 1.5f, x + TILEMAP_TILE_SIZE - 1.5f, TILEMAP_TILE_SIZE - 1.5f,
+                          al_map_rgb(colors[i][0] / 2, colors[i][1] / 2, colors[i][2] / 2), 2.0f);
+    }
+    al_set_target_bitmap(old_target);
+    return atlas;
+}
+
+// Take the tile layer off again; its chunks are baked anew without it
+static void remove_bench_tiles(void) {
+    if (!bench_tile_level) return;
+    memset(&bench_tile_level->tilemap, 0, sizeof(bench_tile_level->tilemap));
+    destroy_static_chunks(&bench_tile_level->static_chunks);
+    arena_release(&bench_tile_arena);
+    if (bench_tile_atlas) al_destroy_bitmap(bench_tile_atlas);
+    bench_tile_atlas = NULL;
+    bench_tile_level = NULL;
+}
+
+static void setup_tiles(Game* game) {
+    Level* level = game->current_level_data;
+    int cols = (int)strlen(bench_tile_rows[0]);
+    float x = game->player.x + TILEMAP_TILE_SIZE;
+    float y = SCREEN_HEIGHT - 40.0f - BENCH_TILE_ROWS * TILEMAP_TILE_SIZE;
+    if (!arena_init(&bench_tile_arena, 4096)) return;
+    if (!init_tilemap(&level->tilemap, &bench_tile_arena, TILEMAP_TILE_SIZE, x, y, cols, BENCH_TILE_ROWS,
+                      bench_tile_defs, (int)(sizeof(bench_tile_defs) / sizeof(bench_tile_defs[0])))) {
+        arena_release(&bench_tile_arena);
+        return;
+    }
+    set_tilemap_rows(&level->tilemap, bench_tile_rows, BENCH_TILE_ROWS, "#=^.");
+    bench_tile_atlas = create_bench_atlas();
+    level->tilemap.atlas = bench_tile_atlas;
+    bench_tile_level = level;
+    // The next draw bakes the chunks with the tiles
+    destroy_static_chunks(&level->static_chunks);
+
+    // Drop onto the first ledge, then walk over the hazards
+    Entity* player = &game->player;
+    player->x = x + 4 * TILEMAP_TILE_SIZE;
+    player->y = y - 150.0f;
+    player->max_health = player->health = 1.0e9f;
+    for (int i = 0; i < 60 && game->state == PLAYING && !player->is_on_ground; i++) {
+        player->dx = 0.0f;
+        update_game(game);
+    }
+    if (!(get_tile_layer_at(&level->tilemap, player->x + player->width / 2, player->y + player->height + 1.0f) &
+          PHYS_LAYER_TERRAIN)) {
+        fprintf(stderr, "Tile scenario: the player did not land on the tile layer\n");
+    }
+    for (int i = 0; i < 90 && game->state == PLAYING; i++) {
+        player->dx = MOVE_SPEED;
+        update_game(game);
+    }
+}
+
+// Same fight drawn at the lowest render scale
+static void setup_combat_low_res(Game* game) {
+    setup_combat(game);
+    game->settings.render_scale = RENDER_SCALE_MIN;
+}
+
+static const BenchScenario scenarios[] = {
+    { "welcome",        WELCOME_SCREEN, 1,   0, 0.0f,       NULL },
+    { "main_menu",      MAIN_MENU,      1,   0, 0.0f,       NULL },
+    { "level_select",   LEVEL_SELECT,   1,   0, 0.0f,       NULL },
+    { "settings",       SETTINGS,       1,   0, 0.0f,       NULL },
+    { "level1_start",   PLAYING,        1,   0, 0.0f,       NULL },
+    { "level1_run",     PLAYING,        1, 180, MOVE_SPEED, NULL },
+    { "level1_tiles",   PLAYING,        1,   0, 0.0f,       setup_tiles },
+    { "level2_combat",  PLAYING,        2,  60, MOVE_SPEED, setup_combat },
+    { "level2_low_res", PLAYING,        2,  60, MOVE_SPEED, setup_combat_low_res },
+    { "level2_horde",   PLAYING,        2,  60, MOVE_SPEED, setup_horde },
+    { "level3_run",     PLAYING,        3, 240, MOVE_SPEED, NULL },
+    { "level3_bullets", PLAYING,        3,  60, 0.0f,       setup_bullet_hell },
+    { "level3_paused",  PAUSED,         3, 120, MOVE_SPEED, setup_combat },
+    { "game_over",      GAME_OVER,      2,   0, 0.0f,       setup_results },
+    { "level_complete", LEVEL_COMPLETE, 2,   0, 0.0f,       setup_results },
+    { "victory",        VICTORY,        3,   0, 0.0f,       setup_results },
+};
+#define NUM_SCENARIOS ((int)(sizeof(scenarios) / sizeof(scenarios[0])))
+
+// Put the game in the scenario's state, the same way on every run
+static void prepare_scenario(Game* game, const BenchScenario* scenario) {
+    remove_bench_tiles();
+    srand(RENDER_BENCH_SEED);
+    init_star_system(game);
+    game->settings.render_scale = RENDER_SCALE_DEFAULT;
+    reset_player_and_level(game, scenario->level - 1);
+
+    game->state = PLAYING;
+    for (int i = 0; i < scenario->ticks && game->state == PLAYING; i++) {
+        game->player.dx = scenario->move; // What handle_input does for a held key
+        update_game(game);
+    }
+    if (scenario->setup) {
+        scenario->setup(game);
+    }
+    game->state = scenario->state;
+    game->pause_frame_valid = false;
+}
+
+static void draw_frame(Game* game, const RenderSnapshot* snap, ALLEGRO_BITMAP* frame) {
+    al_set_target_bitmap(frame);
+    // End screens draw over the previous frame, so start from a known one
+    al_clear_to_color(al_map_rgb(0, 0, 0));
+    draw_game(game, snap);
+}
+
+// Fraction of pixels where some channel differs from the golden by more
+// than GOLDEN_CHANNEL_TOLERANCE, or -1 if the images cannot be compared
+static double compare_with_golden(ALLEGRO_BITMAP* frame, ALLEGRO_BITMAP* golden) {
+    int width = al_get_bitmap_width(frame);
+    int height = al_get_bitmap_height(frame);
+    if (al_get_bitmap_width(golden) != width || al_get_bitmap_height(golden) != height) {
+        return -1.0;
+    }
+
+    ALLEGRO_LOCKED_REGION* actual = al_lock_bitmap(frame, ALLEGRO_PIXEL_FORMAT_ABGR_8888, ALLEGRO_LOCK_READONLY);
+    ALLEGRO_LOCKED_REGION* expected = al_lock_bitmap(golden, ALLEGRO_PIXEL_FORMAT_ABGR_8888, ALLEGRO_LOCK_READONLY);
+    if (!actual || !expected) {
+        if (actual) al_unlock_bitmap(frame);
+        if (expected) al_unlock_bitmap(golden);
+        return -1.0;
+    }
+
+    long differing = 0;
+    for (int y = 0; y < height; y++) {
+        const unsigned char* a = (const unsigned char*)actual->data + y * actual->pitch;
+        const unsigned char* b = (const unsigned char*)expected->data + y * expected->pitch;
+        for (int x = 0; x < width * 4; x += 4) {
+            for (int c = 0; c < 4; c++) {
+                int diff = a[x + c] - b[x + c];
+                if (diff > GOLDEN_CHANNEL_TOLERANCE || diff < -GOLDEN_CHANNEL_TOLERANCE) {
+                    differing++;
+                    break;
+                }
+            }
+        }
+    }
+    al_unlock_bitmap(frame);
+    al_unlock_bitmap(golden);
+    return (double)differing / ((double)width * height);
+}
+
+// Returns true if the frame matches its golden (or the golden was written)
+static bool check_golden(const BenchScenario* scenario, ALLEGRO_BITMAP* frame, BenchMode mode) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s.png", GOLDEN_IMAGE_DIR, scenario->name);
+
+    if (mode == BENCH_GOLDEN_UPDATE) {
+        if (!al_save_bitmap(path, frame)) {
+            fprintf(stderr, "Failed to save golden image %s\n", path);
+            return false;
+        }
+        printf("  %-16s saved %s\n", scenario->name, path);
+        return true;
+    }
+
+    ALLEGRO_BITMAP* golden = al_load_bitmap(path);
+    if (!golden) {
+        fprintf(stderr, "  %-16s missing golden image %s\n", scenario->name, path);
+        return false;
+    }
+    double mismatch = compare_with_golden(frame, golden);
+    al_destroy_bitmap(golden);
+
+    bool passed = mismatch >= 0.0 && mismatch <= GOLDEN_PIXEL_TOLERANCE;
+    if (passed) {
+        printf("  %-16s ok (%.4f%% of pixels differ)\n", scenario->name, mismatch * 100.0);
+        return true;
+    }
+
+    // Keep the frame that failed next to the golden for inspection
+    char actual_path[256];
+    snprintf(actual_path, sizeof(actual_path), "%s/%s.actual.png", GOLDEN_IMAGE_DIR, scenario->name);
+    al_save_bitmap(actual_path, frame);
+    if (mismatch < 0.0) {
+        fprintf(stderr, "  %-16s FAILED: golden is not %dx%d, frame saved to %s\n",
+                scenario->name, SCREEN_WIDTH, SCREEN_HEIGHT, actual_path);
+    } else {
+        fprintf(stderr, "  %-16s FAILED: %.4f%% of pixels differ (limit %.4f%%), frame saved to %s\n",
+                scenario->name, mismatch * 100.0, GOLDEN_PIXEL_TOLERANCE * 100.0, actual_path);
+    }
+    return false;
+}
+
+static void report_timings(const BenchScenario* scenario, const DrawTimings* timings,
+                           const DrawStats* stats, double frame_total, double frame_max, int iterations) {
+    printf("  %-16s avg %7.3f ms, max %7.3f ms, %d commands, %d draw calls, %d state switches, %d elided, "
+           "%d kernel draws\n", scenario->name, frame_total / iterations * 1000.0, frame_max * 1000.0,
+           stats->commands, stats->draw_calls, stats->state_switches, stats->elided, stats->kernel_draws);
+    for (int i = 0; i < DRAW_SECTION_COUNT; i++) {
+        if (timings->samples[i] == 0) continue;
+        printf("      %-12s avg %7.3f ms, max %7.3f ms\n", draw_section_names[i],
+               timings->total[i] / timings->samples[i] * 1000.0, timings->max[i] * 1000.0);
+    }
+}
+
+// Simulation cost of the scenario, after its frame was captured
+static void time_updates(Game* game, int ticks) {
+    double total = 0.0, max = 0.0;
+    int done = 0;
+    game->player.dx = 0.0f;
+    for (; done < ticks && game->state == PLAYING; done++) {
+        double start = al_get_time();
+        update_game(game);
+        double elapsed = al_get_time() - start;
+        total += elapsed;
+        if (elapsed > max) max = elapsed;
+    }
+    if (done == 0) return;
+    Level* level = game->current_level_data;
+    printf("      %-12s avg %7.3f ms, max %7.3f ms, %d projectiles, %d enemies, %d changed behavior\n",
+           "update", total / done * 1000.0, max * 1000.0, level->projectiles.live, level->enemies.live,
+           level->batches.moves);
+    printf("      %-12s %d bodies stepped, %d asleep, %d platform tests, %d tile tests, %d skipped by layer\n",
+           "physics", level->physics.stepped, level->physics.sleeping, level->physics.platform_tests,
+           level->physics.tile_tests, level->physics.layer_skips);
+    printf("      %-12s %d of %d tested, cursor moved %d\n", "triggers",
+           level->triggers.candidates, level->triggers.count, level->triggers.steps);
+    printf("      %-12s level %d peak %zu bytes\n", "arena", level->id, level->arena.peak);
+    printf("      %-12s %d bakes, last %.3f ms, %zu KB\n", "chunks", level->static_chunks.bakes,
+           level->static_chunks.bake_time * 1000.0, level->static_chunks.bytes / 1024);
+}
+
+bool is_render_bench_command(int argc, char** argv) {
+    return argc > 1 && (strcmp(argv[1], "--bench") == 0 ||
+                        strcmp(argv[1], "--golden") == 0 ||
+                        strcmp(argv[1], "--golden-update") == 0);
+}
+
+int run_render_bench(int argc, char** argv) {
+    BenchMode mode = BENCH_TIME;
+    int iterations = RENDER_BENCH_ITERATIONS;
+    if (strcmp(argv[1], "--golden") == 0) {
+        mode = BENCH_GOLDEN_CHECK;
+    } else if (strcmp(argv[1], "--golden-update") == 0) {
+        mode = BENCH_GOLDEN_UPDATE;
+    } else if (argc > 2 && atoi(argv[2]) > 0) {
+        iterations = atoi(argv[2]);
+    }
+
+    Game game;
+    memset(&game, 0, sizeof(game));
+    if (!init_game_headless(&game)) {
+        cleanup_game(&game);
+        return 1;
+    }
+
+    ALLEGRO_BITMAP* frame = al_create_bitmap(SCREEN_WIDTH, SCREEN_HEIGHT);
+    if (!frame) {
+        fprintf(stderr, "Failed to create %dx%d memory bitmap!\n", SCREEN_WIDTH, SCREEN_HEIGHT);
+        cleanup_game(&game);
+        return 1;
+    }
+    if (mode == BENCH_GOLDEN_UPDATE) {
+        al_make_directory(GOLDEN_IMAGE_DIR);
+    }
+
+    RenderSnapshot snap;
+    memset(&snap, 0, sizeof(snap));
+    Level* drawn_level = NULL;
+    int failures = 0;
+
+    if (mode == BENCH_TIME) {
+        printf("Render bench: %d draws of each scenario into a %dx%d memory bitmap, %s pixel kernels\n",
+               iterations, SCREEN_WIDTH, SCREEN_HEIGHT, get_pixel_kernel_name());
+    } else {
+        printf("Golden images in %s (channel tolerance %d, pixel tolerance %.4f%%)\n",
+               GOLDEN_IMAGE_DIR, GOLDEN_CHANNEL_TOLERANCE, GOLDEN_PIXEL_TOLERANCE * 100.0);
+    }
+
+    for (int s = 0; s < NUM_SCENARIOS; s++) {
+        const BenchScenario* scenario = &scenarios[s];
+        prepare_scenario(&game, scenario);
+        capture_render_snapshot(&game, &snap);
+        snap.time = RENDER_BENCH_CLOCK;
+
+        // Same rule as the render thread: tiles of the previous level go
+        // before another level is drawn
+        if (snap.has_scene && snap.level != drawn_level) {
+            if (drawn_level) {
+                evict_background_tiles(&drawn_level->background_tiles);
+                destroy_static_chunks(&drawn_level->static_chunks);
+            }
+            drawn_level = snap.level;
+        }
+        // Scenarios jump the camera, so every one starts with its tiles resident
+        if (snap.has_scene) {
+            load_background_tiles(&snap.level->background_tiles, snap.camera.x,
+                                  snap.camera.x + snap.camera.width);
+        }
+
+        if (mode != BENCH_TIME) {
+            draw_frame(&game, &snap, frame);
+            if (!check_golden(scenario, frame, mode)) failures++;
+            continue;
+        }
+
+        // The first draw queues the margin tiles and fills the pause frame
+        draw_frame(&game, &snap, frame);
+
+        DrawTimings timings;
+        memset(&timings, 0, sizeof(timings));
+        set_draw_timings(&timings);
+        double frame_total = 0.0;
+        double frame_max = 0.0;
+        for (int i = 0; i < iterations; i++) {
+            double start = al_get_time();
+            draw_frame(&game, &snap, frame);
+            double elapsed = al_get_time() - start;
+            frame_total += elapsed;
+            if (elapsed > frame_max) frame_max = elapsed;
+        }
+        set_draw_timings(NULL);
+        report_timings(scenario, &timings, &game.draw_context->last, frame_total, frame_max, iterations);
+
+        // The same draws through Allegro's own software blender
+        set_pixel_kernels_enabled(false);
+        double stock_total = 0.0;
+        for (int i = 0; i < iterations; i++) {
+            double start = al_get_time();
+            draw_frame(&game, &snap, frame);
+            stock_total += al_get_time() - start;
+        }
+        set_pixel_kernels_enabled(true);
+        printf("      %-12s avg %7.3f ms (%.2fx)\n", "no kernels", stock_total / iterations * 1000.0,
+               frame_total > 0.0 ? stock_total / frame_total : 0.0);
+
+        // One more draw through the overdraw view for the fill rate
+        snap.show_overdraw = true;
+        draw_frame(&game, &snap, frame);
+        snap.show_overdraw = false;
+        printf("      %-12s avg %7.2f, max %d\n", "overdraw",
+               get_average_overdraw(&game.draw_context->overdraw), game.draw_context->overdraw.max);
+
+        if (scenario->state == PLAYING) {
+            time_updates(&game, RENDER_BENCH_UPDATE_TICKS);
+        }
+    }
+
+    if (mode == BENCH_GOLDEN_CHECK) {
+        printf("%d of %d scenarios match their golden images\n", NUM_SCENARIOS - failures, NUM_SCENARIOS);
+    }
+
+    remove_bench_tiles();
+    free(snap.platforms);
+    free(snap.enemies);
+    free(snap.projectiles);
+    free(snap.particles);
+    free(snap.glucose_items);
+    al_destroy_bitmap(frame);
+    cleanup_game(&game);
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,118 @@
+#include "../include/scroll_cache.h"
+#include <math.h>    // For floorf
+#include <stdio.h>   // For printf, fprintf
+#include <stdlib.h>  // For abs
+#include <string.h>  // For memset, memmove
+
+void init_scroll_cache(ScrollCache* cache) {
+    memset(cache, 0, sizeof(*cache));
+}
+
+void destroy_scroll_cache(ScrollCache* cache) {
+    if (cache->bitmap) al_destroy_bitmap(cache->bitmap);
+    init_scroll_cache(cache);
+}
+
+void report_scroll_cache(const ScrollCache* cache) {
+    unsigned int frames = cache->full_redraws + cache->strip_redraws + cache->reuses + cache->bypasses;
+    if (frames == 0) return;
+    printf("Scroll cache: %u frames, %u full redraws, %u strips, %u reused, %u bypassed\n",
+           frames, cache->full_redraws, cache->strip_redraws, cache->reuses, cache->bypasses);
+}
+
+// Whether the composite, drawn at whole pixels without shake or scale,
+// looks exactly like drawing the static layers straight to 'target'
+static bool can_cache(const Camera* camera, ALLEGRO_BITMAP* target) {
+    return (al_get_bitmap_flags(target) & ALLEGRO_MEMORY_BITMAP) &&
+           camera->scale == 1.0f &&
+           camera->shake.offset_x == 0.0f && camera->shake.offset_y == 0.0f &&
+           camera->x == floorf(camera->x);
+}
+
+// A memory bitmap matching the target's size and format
+static bool prepare_bitmap(ScrollCache* cache, ALLEGRO_BITMAP* target) {
+    int width = al_get_bitmap_width(target);
+    int height = al_get_bitmap_height(target);
+    int format = al_get_bitmap_format(target);
+    if (cache->bitmap && al_get_bitmap_width(cache->bitmap) == width &&
+        al_get_bitmap_height(cache->bitmap) == height &&
+        al_get_bitmap_format(cache->bitmap) == format) {
+        return true;
+    }
+    if (cache->bitmap) al_destroy_bitmap(cache->bitmap);
+    cache->valid = false;
+
+    int old_flags = al_get_new_bitmap_flags();
+    int old_format = al_get_new_bitmap_format();
+    al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+    al_set_new_bitmap_format(format);
+    cache->bitmap = al_create_bitmap(width, height);
+    al_set_new_bitmap_format(old_format);
+    al_set_new_bitmap_flags(old_flags);
+    if (!cache->bitmap) {
+        fprintf(stderr, "Failed to create %dx%d scroll cache\n", width, height);
+        return false;
+    }
+    return true;
+}
+
+// Move the composite 'dx' pixels left (right when negative)
+static bool shift_pixels(ALLEGRO_BITMAP* bitmap, int dx) {
+    ALLEGRO_LOCKED_REGION* region = al_lock_bitmap(bitmap, ALLEGRO_PIXEL_FORMAT_ANY, ALLEGRO_LOCK_READWRITE);
+    if (!region) return false;
+    int width = al_get_bitmap_width(bitmap);
+    int height = al_get_bitmap_height(bitmap);
+    int kept = (width - abs(dx)) * region->pixel_size;
+    int offset = abs(dx) * region->pixel_size;
+    for (int y = 0; y < height; y++) {
+        char* row = (char*)region->data + y * region->pitch;
+        if (dx > 0) memmove(row, row + offset, kept);
+        else memmove(row + offset, row, kept);
+    }
+    al_unlock_bitmap(bitmap);
+    return true;
+}
+
+bool draw_scroll_cache(ScrollCache* cache, DrawList* list, const Camera* camera, const void* owner) {
+    ALLEGRO_BITMAP* target = al_get_target_bitmap();
+    if (!can_cache(camera, target) || !prepare_bitmap(cache, target)) {
+        cache->valid = false;
+        cache->bypasses++;
+        return false;
+    }
+
+    int width = al_get_bitmap_width(cache->bitmap);
+    int x = (int)camera->x;
+    int dx = x - cache->x;
+    al_set_target_bitmap(cache->bitmap);
+    if (!cache->valid || cache->owner != owner || abs(dx) >= width || (dx != 0 && !shift_pixels(cache->bitmap, dx))) {
+        submit_draw_layers(list, camera, 0, DRAW_LAYER_LAST_STATIC);
+        cache->full_redraws++;
+    } else if (dx != 0) {
+        // Only the strip scrolled into view is drawn
+        int strip_x = dx > 0 ? width - dx : 0;
+        al_set_clipping_rectangle(strip_x, 0, abs(dx), al_get_bitmap_height(cache->bitmap));
+        submit_draw_layers(list, camera, 0, DRAW_LAYER_LAST_STATIC);
+        al_reset_clipping_rectangle();
+        cache->strip_redraws++;
+    } else {
+        cache->reuses++;
+    }
+    cache->owner = owner;
+    cache->x = x;
+    cache->valid = true;
+
+    // A straight copy, not a blend
+    al_set_target_bitmap(target);
+    use_screen_transform(NULL);
+    KernelTarget kernels;
+    if (begin_kernel_target(&kernels, target)) {
+        bool copied = kernel_draw_bitmap(&kernels, cache->bitmap, 0, 0, true);
+        end_kernel_drawing(&kernels);
+        if (copied) return true;
+    }
+    al_set_blender(ALLEGRO_ADD, ALLEGRO_ONE, ALLEGRO_ZERO);
+    al_draw_bitmap(cache->bitmap, 0, 0, 0);
+    al_set_blender(ALLEGRO_ADD, ALLEGRO_ONE, ALLEGRO_INVERSE_ALPHA);
+    return true;
+}
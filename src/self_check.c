@@ -0,0 +1,534 @@
+#include "../include/self_check.h"
+#include "../include/collision_mask.h" // For masks_overlap, mask_overlaps_rect
+#include "../include/enemy_batch.h" // For add_batched_enemy, set_enemy_behavior, rebucket_enemies
+#include "../include/arena.h" // For arena_init, arena_release
+#include "../include/pixel_kernels.h" // For blend_pixels, blend_fill_pixels, blend_pixel
+#include <allegro5/allegro_primitives.h> // For al_draw_filled_rectangle
+#include <stdio.h>   // For printf, fprintf
+#include <stdlib.h>  // For calloc
+#include <string.h>  // For strcmp, memset
+
+static int checks_run = 0;
+static int checks_failed = 0;
+
+static void expect(bool actual, bool expected, const char* what) {
+    checks_run++;
+    if (actual != expected) {
+        checks_failed++;
+        fprintf(stderr, "  FAILED: %s is %s, expected %s\n", what,
+                actual ? "true" : "false", expected ? "true" : "false");
+    }
+}
+
+static unsigned int check_seed = 12345;
+
+// Same numbers on every machine, unlike rand
+static int next_random(int below) {
+    check_seed = check_seed * 1103515245u + 12345u;
+    return (int)((check_seed >> 16) % (unsigned int)below);
+}
+
+// Collision masks
+
+// An empty width x height mask laid out as build_collision_mask lays it out
+static bool make_mask(CollisionMask* mask, int width, int height) {
+    memset(mask, 0, sizeof(*mask));
+    int words_per_row = (width + 63) / 64;
+    size_t words = (size_t)words_per_row * height;
+    uint64_t* rows = calloc(words * 2, sizeof(uint64_t));
+    if (!rows) {
+        fprintf(stderr, "Failed to allocate a %dx%d check mask\n", width, height);
+        return false;
+    }
+    mask->width = width;
+    mask->height = height;
+    mask->words_per_row = words_per_row;
+    mask->rows = rows;
+    mask->flipped_rows = rows + words;
+    return true;
+}
+
+static void set_mask_pixel(CollisionMask* mask, int x, int y) {
+    int mirrored = mask->width - 1 - x;
+    mask->rows[y * mask->words_per_row + (x >> 6)] |= 1ull << (x & 63);
+    mask->flipped_rows[y * mask->words_per_row + (mirrored >> 6)] |= 1ull << (mirrored & 63);
+    mask->pixels++;
+}
+
+static bool mask_pixel(const CollisionMask* mask, bool flip, int x, int y) {
+    if (x < 0 || y < 0 || x >= mask->width || y >= mask->height) return false;
+    const uint64_t* rows = flip ? mask->flipped_rows : mask->rows;
+    return (rows[y * mask->words_per_row + (x >> 6)] >> (x & 63)) & 1;
+}
+
+// What masks_overlap has to answer, one pixel at a time
+static bool masks_overlap_slowly(const CollisionMask* a, int ax, int ay, bool flip_a,
+                                 const CollisionMask* b, int bx, int by, bool flip_b) {
+    for (int y = 0; y < a->height; y++) {
+        for (int x = 0; x < a->width; x++) {
+            if (mask_pixel(a, flip_a, x, y) && mask_pixel(b, flip_b, ax + x - bx, ay + y - by)) return true;
+        }
+    }
+    return false;
+}
+
+static void check_collision_masks(void) {
+    // 130 pixels wide, so rows take three words. Row 0 has pixels on both
+    // sides of the first word boundary, row 1 on both sides of the second
+    // and the last pixel of the row.
+    CollisionMask wide, dot, edge, pattern;
+    if (!make_mask(&wide, 130, 2) || !make_mask(&dot, 1, 1) ||
+        !make_mask(&edge, 70, 2) || !make_mask(&pattern, 67, 3)) {
+        checks_failed++;
+        return;
+    }
+    set_mask_pixel(&wide, 63, 0);
+    set_mask_pixel(&wide, 64, 0);
+    set_mask_pixel(&wide, 127, 1);
+    set_mask_pixel(&wide, 128, 1);
+    set_mask_pixel(&wide, 129, 1);
+    set_mask_pixel(&dot, 0, 0);
+    set_mask_pixel(&edge, 0, 0);    // Column 69 when flipped
+    for (int y = 0; y < pattern.height; y++) {
+        for (int x = 0; x < pattern.width; x++) {
+            if ((x * 7 + y * 3) % 5 == 0) set_mask_pixel(&pattern, x, y);
+        }
+    }
+    const int x = 5, y = 7;
+
+    // A single pixel read at offsets just before, on and after the word boundaries
+    expect(masks_overlap(&wide, x, y, false, &dot, x + 62, y, false), false, "pixel 62 of row 0");
+    expect(masks_overlap(&wide, x, y, false, &dot, x + 63, y, false), true, "pixel 63 of row 0");
+    expect(masks_overlap(&wide, x, y, false, &dot, x + 64, y, false), true, "pixel 64 of row 0");
+    expect(masks_overlap(&wide, x, y, false, &dot, x + 65, y, false), false, "pixel 65 of row 0");
+    expect(masks_overlap(&wide, x, y, false, &dot, x + 126, y + 1, false), false, "pixel 126 of row 1");
+    expect(masks_overlap(&wide, x, y, false, &dot, x + 128, y + 1, false), true, "pixel 128 of row 1");
+    expect(masks_overlap(&wide, x, y, false, &dot, x + 129, y + 1, false), true, "last pixel of row 1");
+    expect(masks_overlap(&wide, x, y, false, &dot, x + 130, y + 1, false), false, "pixel past row 1");
+
+    // A second mask whose words start at an odd column of the first
+    expect(masks_overlap(&wide, x, y, false, &edge, x + 64, y, false), true, "mask at column 64");
+    expect(masks_overlap(&wide, x, y, false, &edge, x + 65, y, false), false, "mask at column 65");
+    expect(masks_overlap(&wide, x, y, false, &edge, x + 60, y + 1, true), true, "flipped mask at column 60");
+    expect(masks_overlap(&wide, x, y, false, &edge, x + 60, y + 1, false), false, "unflipped mask at column 60");
+
+    // Flipped, pixel 63 of row 0 moves to 66 and the last pixel of row 1 to 0
+    expect(masks_overlap(&wide, x, y, true, &dot, x + 66, y, false), true, "flipped pixel 66 of row 0");
+    expect(masks_overlap(&wide, x, y, true, &dot, x + 63, y, false), false, "flipped pixel 63 of row 0");
+    expect(masks_overlap(&wide, x, y, true, &dot, x, y + 1, false), true, "flipped pixel 0 of row 1");
+
+    // Rectangles reaching only up to a pixel or clipped away from it
+    expect(mask_overlaps_rect(&wide, x, y, false, x + 60, y, x + 63, y + 1), false, "rect ending at pixel 63");
+    expect(mask_overlaps_rect(&wide, x, y, false, x + 60, y, x + 63.5f, y + 1), true, "rect into pixel 63");
+    expect(mask_overlaps_rect(&wide, x, y, false, x + 65, y - 5, x + 127, y + 5), false,
+           "rect between the pixels across a word boundary");
+    expect(mask_overlaps_rect(&wide, x, y, false, x + 65, y - 5, x + 128, y + 5), true, "rect ending past pixel 127");
+    expect(mask_overlaps_rect(&wide, x, y, false, x - 10, y, x, y + 2), false, "rect touching the left edge");
+    expect(mask_overlaps_rect(&wide, x, y, false, x + 130, y, x + 140, y + 2), false, "rect touching the right edge");
+    expect(mask_overlaps_rect(&wide, x, y, false, x + 128.5f, y + 1, x + 200, y + 2), true, "rect clipped at the right");
+    expect(mask_overlaps_rect(&wide, x, y, false, x + 60, y - 5, x + 70, y), false, "rect touching the top edge");
+    expect(mask_overlaps_rect(&wide, x, y, true, x, y + 1, x + 1, y + 2), true, "rect on flipped pixel 0 of row 1");
+    expect(mask_overlaps_rect(&wide, x, y, false, x, y + 1, x + 1, y + 2), false, "rect on unflipped pixel 0 of row 1");
+
+    // Every placement of the pattern around the wide mask, in all flips,
+    // against the pixel by pixel answer
+    int mismatches = 0;
+    for (int flips = 0; flips < 4; flips++) {
+        for (int dy = -3; dy <= 2; dy++) {
+            for (int dx = -70; dx <= 135; dx++) {
+                bool fast = masks_overlap(&wide, x, y, flips & 1, &pattern, x + dx, y + dy, flips & 2);
+                bool slow = masks_overlap_slowly(&wide, x, y, flips & 1, &pattern, x + dx, y + dy, flips & 2);
+                if (fast != slow) mismatches++;
+            }
+        }
+    }
+    expect(mismatches == 0, true, "pattern sweep agreeing with pixel by pixel");
+    if (mismatches) fprintf(stderr, "  %d placements of the pattern disagree\n", mismatches);
+
+    destroy_collision_mask(&wide);
+    destroy_collision_mask(&dot);
+    destroy_collision_mask(&edge);
+    destroy_collision_mask(&pattern);
+}
+
+// Enemy batches
+
+#define CHECK_ENEMIES 64
+#define CHECK_BATCH_CAPACITY 48 // Fewer than the enemies, so some spawns are refused
+
+// Counts the ways the batches disagree with the enemies filed in them.
+// Until rebucket_enemies runs, enemies may sit under an old behavior.
+static int count_batch_errors(const EnemyBatches* batches, const Entity* enemies,
+                              const bool* filed, bool rebucketed) {
+    int errors = 0;
+    int count = 0;
+    if (batches->start[0] != 0) errors++;
+    for (int b = 0; b < BEHAVIOR_COUNT; b++) {
+        if (batches->start[b + 1] < batches->start[b]) errors++;
+        for (int i = batches->start[b]; i < batches->start[b + 1]; i++) {
+            const Entity* enemy = batches->order[i];
+            if (enemy->batch_index != i) errors++;
+            if (rebucketed && (int)enemy->behavior != b) errors++;
+        }
+    }
+    for (int i = 0; i < CHECK_ENEMIES; i++) {
+        if (!filed[i]) continue;
+        count++;
+        int index = enemies[i].batch_index;
+        if (index < 0 || index >= batches->start[BEHAVIOR_COUNT] || batches->order[index] != &enemies[i]) errors++;
+    }
+    if (count != batches->start[BEHAVIOR_COUNT]) errors++;
+    return errors;
+}
+
+static void check_enemy_batches(void) {
+    Arena arena;
+    EnemyBatches batches;
+    if (!arena_init(&arena, 4096) || !init_enemy_batches(&batches, &arena, CHECK_BATCH_CAPACITY)) {
+        checks_failed++;
+        return;
+    }
+    Entity enemies[CHECK_ENEMIES];
+    bool filed[CHECK_ENEMIES];
+    memset(enemies, 0, sizeof(enemies));   // As pool_acquire leaves them
+    memset(filed, 0, sizeof(filed));
+
+    int errors = 0, refused_wrongly = 0, moves_wrong = 0, overflows = 0;
+    for (int round = 0; round < 400; round++) {
+        // Spawns, recycles and behavior changes in a random order. Every
+        // tenth round changes more behaviors than the queue holds.
+        int steps = round % 10 == 9 ? CHECK_BATCH_CAPACITY * 3 : 1 + next_random(12);
+        for (int step = 0; step < steps; step++) {
+            Entity* enemy = &enemies[next_random(CHECK_ENEMIES)];
+            int i = (int)(enemy - enemies);
+            EntityBehavior behavior = (EntityBehavior)next_random(BEHAVIOR_COUNT);
+            int action = round % 10 == 9 ? 2 : next_random(3);
+            if (action == 0 && !filed[i]) {
+                memset(enemy, 0, sizeof(*enemy));
+                enemy->behavior = behavior;
+                bool room = batches.start[BEHAVIOR_COUNT] < CHECK_BATCH_CAPACITY;
+                filed[i] = add_batched_enemy(&batches, enemy);
+                if (filed[i] != room) refused_wrongly++;
+            } else if (action == 1 && filed[i]) {
+                remove_batched_enemy(&batches, enemy);
+                filed[i] = false;
+            } else if (filed[i]) {
+                set_enemy_behavior(&batches, enemy, behavior);
+            }
+        }
+        errors += count_batch_errors(&batches, enemies, filed, false);
+        if (batches.pending_overflow) overflows++;
+
+        // Each move must be an enemy left under an old behavior
+        int misplaced = 0;
+        for (int b = 0; b < BEHAVIOR_COUNT; b++) {
+            for (int i = batches.start[b]; i < batches.start[b + 1]; i++) {
+                if ((int)batches.order[i]->behavior != b) misplaced++;
+            }
+        }
+        rebucket_enemies(&batches);
+        if (batches.moves != misplaced) moves_wrong++;
+        errors += count_batch_errors(&batches, enemies, filed, true);
+    }
+    expect(errors == 0, true, "batch starts and indices after every round");
+    if (errors) fprintf(stderr, "  %d disagreements between the batches and the enemies\n", errors);
+    expect(refused_wrongly == 0, true, "spawns refused only when the batches are full");
+    expect(moves_wrong == 0, true, "moves counting the enemies under an old behavior");
+    expect(overflows > 0, true, "full queue falling back to a scan");
+    arena_release(&arena);
+}
+
+// Patrollers started at each edge of a narrow level, heading out of it,
+// with the move the physics step would make applied after every kernel
+// call. Lanes 0 to 9 cover both vector widths and the scalar tail; the
+// last lane starts outside the level and must walk back in.
+#define CHECK_PATROLLERS 10
+#define CHECK_PATROL_WIDTH 200.0f
+
+static void check_patrol_edges(void) {
+    Arena arena;
+    EnemyBatches batches;
+    if (!arena_init(&arena, 4096) || !init_enemy_batches(&batches, &arena, CHECK_PATROLLERS)) {
+        checks_failed++;
+        return;
+    }
+    const float speed = ENEMY_PATROL_SPEED;
+    for (int i = 0; i < CHECK_PATROLLERS; i++) {
+        bool left = i % 2 == 0;
+        batches.width[i] = ENEMY_WIDTH;
+        batches.y[i] = 0.0f;
+        batches.dx[i] = left ? -speed : speed;
+        // Up to one move away from the edge, where the old test turned too late
+        float gap = speed * (i + 1) / (CHECK_PATROLLERS + 1);
+        batches.x[i] = left ? gap : CHECK_PATROL_WIDTH - ENEMY_WIDTH - gap;
+    }
+    int outside = CHECK_PATROLLERS - 1;
+    batches.x[outside] = CHECK_PATROL_WIDTH + 3.0f * speed;
+
+    int escapes = 0;
+    for (int tick = 0; tick < 400; tick++) {
+        // Far from the player, so none of them wants to chase
+        patrol_kernel(&batches, CHECK_PATROLLERS, -1.0e6f, -1.0e6f, CHECK_PATROL_WIDTH);
+        for (int i = 0; i < CHECK_PATROLLERS; i++) {
+            batches.x[i] += batches.dx[i];
+            bool inside = batches.x[i] > 0.0f && batches.x[i] + ENEMY_WIDTH < CHECK_PATROL_WIDTH;
+            if (i != outside && !inside) escapes++;
+        }
+    }
+    expect(escapes == 0, true, "patrollers at the edges staying in the level");
+    if (escapes) fprintf(stderr, "  %d moves left the level\n", escapes);
+    expect(batches.x[outside] > 0.0f && batches.x[outside] + ENEMY_WIDTH < CHECK_PATROL_WIDTH, true,
+           "patroller outside the level walking back in");
+    arena_release(&arena);
+}
+
+// Each kernel over random lanes, against the same kernel run one lane at
+// a time, which only takes its scalar loop. The first lane sits exactly
+// on the player, where the velocities must be left alone.
+#define CHECK_KERNEL_LANES 17
+#define CHECK_KERNEL_LEVEL_WIDTH 800.0f
+
+typedef enum { KERNEL_CHASE, KERNEL_PATROL, KERNEL_RETREAT, KERNEL_COUNT } CheckedKernel;
+
+static void run_checked_kernel(CheckedKernel kernel, EnemyBatches* batches, int count, float px, float py) {
+    switch (kernel) {
+        case KERNEL_CHASE: chase_kernel(batches, count, px, py); break;
+        case KERNEL_PATROL: patrol_kernel(batches, count, px, py, CHECK_KERNEL_LEVEL_WIDTH); break;
+        case KERNEL_RETREAT: retreat_kernel(batches, count, px, py); break;
+        case KERNEL_COUNT: break;
+    }
+}
+
+static float random_between(float low, float high) {
+    return low + (high - low) * next_random(10001) / 10000.0f;
+}
+
+static void check_enemy_kernels(void) {
+    static const char* const names[KERNEL_COUNT] = { "chase", "patrol", "retreat" };
+    Arena arena;
+    EnemyBatches batches, lane;
+    if (!arena_init(&arena, 4096) || !init_enemy_batches(&batches, &arena, CHECK_KERNEL_LANES)) {
+        checks_failed++;
+        return;
+    }
+    float* lanes[] = { batches.x, batches.y, batches.width, batches.dx, batches.dy, batches.flags };
+    const int num_lanes = sizeof(lanes) / sizeof(lanes[0]);
+    float start[6][CHECK_KERNEL_LANES], vector[6][CHECK_KERNEL_LANES];
+
+    for (int k = 0; k < KERNEL_COUNT; k++) {
+        int mismatches = 0, moved_on_player = 0;
+        for (int count = 1; count <= CHECK_KERNEL_LANES; count++) {
+            for (int round = 0; round < 20; round++) {
+                float px = random_between(0.0f, CHECK_KERNEL_LEVEL_WIDTH);
+                float py = random_between(0.0f, 600.0f);
+                for (int i = 0; i < count; i++) {
+                    // Around the player and the level edges, within range of every flag
+                    batches.x[i] = random_between(-20.0f, CHECK_KERNEL_LEVEL_WIDTH + 20.0f);
+                    batches.y[i] = py + random_between(-300.0f, 300.0f);
+                    batches.width[i] = ENEMY_WIDTH;
+                    batches.dx[i] = random_between(-4.0f, 4.0f);
+                    batches.dy[i] = random_between(-4.0f, 4.0f);
+                    batches.flags[i] = -1.0f;
+                }
+                batches.x[0] = px;
+                batches.y[0] = py;
+                for (int l = 0; l < num_lanes; l++) memcpy(start[l], lanes[l], sizeof(float) * count);
+
+                run_checked_kernel(k, &batches, count, px, py);
+                for (int l = 0; l < num_lanes; l++) memcpy(vector[l], lanes[l], sizeof(float) * count);
+                if (k != KERNEL_PATROL && (batches.dx[0] != start[3][0] || batches.dy[0] != start[4][0])) {
+                    moved_on_player++;
+                }
+
+                for (int l = 0; l < num_lanes; l++) memcpy(lanes[l], start[l], sizeof(float) * count);
+                for (int i = 0; i < count; i++) {
+                    lane = batches;
+                    lane.x += i;
+                    lane.y += i;
+                    lane.width += i;
+                    lane.dx += i;
+                    lane.dy += i;
+                    lane.flags += i;
+                    run_checked_kernel(k, &lane, 1, px, py);
+                }
+                for (int l = 0; l < num_lanes; l++) {
+                    for (int i = 0; i < count; i++) {
+                        if (lanes[l][i] != vector[l][i]) mismatches++;
+                    }
+                }
+            }
+        }
+        char what[64];
+        snprintf(what, sizeof(what), "%s kernel matching its scalar loop", names[k]);
+        expect(mismatches == 0, true, what);
+        if (mismatches) fprintf(stderr, "  %d %s lane values differ\n", mismatches, names[k]);
+        if (k != KERNEL_PATROL) {
+            snprintf(what, sizeof(what), "%s kernel leaving a lane on the player alone", names[k]);
+            expect(moved_on_player == 0, true, what);
+        }
+    }
+    arena_release(&arena);
+}
+
+// Pixel kernels
+
+#define CHECK_MAX_RUN (2 * 8 + 9)   // Two AVX2 groups and the longest tail checked
+#define CHECK_BLEND_ROWS 4
+
+static uint32_t random_pixel(void) {
+    uint32_t pixel = 0;
+    for (int i = 0; i < 4; i++) pixel = pixel << 8 | (uint32_t)next_random(256);
+    return pixel;
+}
+
+static uint32_t with_alpha(uint32_t pixel, int alpha) {
+    return (pixel & 0x00FFFFFF) | (uint32_t)alpha << 24;
+}
+
+// Pixels that differ between a kernel's run and blend_pixel over 'before',
+// counting the guard pixel either side, which must be left alone
+static int count_run_mismatches(const uint32_t* before, const uint32_t* after,
+                                const uint32_t* src, uint32_t fill, int count) {
+    int mismatches = 0;
+    for (int i = 0; i < count + 2; i++) {
+        uint32_t expected = before[i];
+        if (i >= 1 && i <= count) expected = blend_pixel(before[i], src ? src[i - 1] : fill);
+        if (after[i] != expected) mismatches++;
+    }
+    return mismatches;
+}
+
+// The vector paths against blend_pixel, for every alpha and for runs with
+// none, one and two groups of 8 pixels followed by tails of 0 to 9
+static void check_pixel_kernels(void) {
+    uint32_t before[CHECK_MAX_RUN + 2], after[CHECK_MAX_RUN + 2], src[CHECK_MAX_RUN];
+    int blend_mismatches = 0, fill_mismatches = 0;
+    for (int alpha = 0; alpha < 256; alpha++) {
+        for (int groups = 0; groups <= 2; groups++) {
+            for (int tail = 0; tail <= 9; tail++) {
+                int count = groups * 8 + tail;
+                for (int i = 0; i < count + 2; i++) before[i] = random_pixel();
+                // 37 is odd, so every lane sees every alpha over the loop
+                for (int i = 0; i < count; i++) src[i] = with_alpha(random_pixel(), (alpha + i * 37) & 255);
+                memcpy(after, before, sizeof(before));
+                blend_pixels(after + 1, src, count);
+                blend_mismatches += count_run_mismatches(before, after, src, 0, count);
+
+                uint32_t fill = with_alpha(random_pixel(), alpha);
+                memcpy(after, before, sizeof(before));
+                blend_fill_pixels(after + 1, count, fill);
+                fill_mismatches += count_run_mismatches(before, after, NULL, fill, count);
+            }
+        }
+    }
+    expect(blend_mismatches == 0, true, "blend_pixels matching blend_pixel");
+    if (blend_mismatches) fprintf(stderr, "  %d blended pixels differ\n", blend_mismatches);
+    expect(fill_mismatches == 0, true, "blend_fill_pixels matching blend_pixel");
+    if (fill_mismatches) fprintf(stderr, "  %d filled pixels differ\n", fill_mismatches);
+}
+
+static bool write_bitmap_pixels(ALLEGRO_BITMAP* bitmap, const uint32_t* pixels, int width, int height) {
+    ALLEGRO_LOCKED_REGION* region = al_lock_bitmap(bitmap, ALLEGRO_PIXEL_FORMAT_ARGB_8888, ALLEGRO_LOCK_WRITEONLY);
+    if (!region) return false;
+    for (int y = 0; y < height; y++) {
+        memcpy((char*)region->data + y * region->pitch, pixels + y * width, width * sizeof(uint32_t));
+    }
+    al_unlock_bitmap(bitmap);
+    return true;
+}
+
+// Pixels of 'bitmap' other than blend_pixel(dst, src), and the largest
+// channel difference among them; -1 if it can't be read
+static int count_blend_mismatches(ALLEGRO_BITMAP* bitmap, const uint32_t* dst, const uint32_t* src,
+                                  int width, int height, bool one_src_row, int* worst) {
+    ALLEGRO_LOCKED_REGION* region = al_lock_bitmap(bitmap, ALLEGRO_PIXEL_FORMAT_ARGB_8888, ALLEGRO_LOCK_READONLY);
+    if (!region) return -1;
+    int mismatches = 0;
+    for (int y = 0; y < height; y++) {
+        const uint32_t* row = (const uint32_t*)((const char*)region->data + y * region->pitch);
+        for (int x = 0; x < width; x++) {
+            uint32_t expected = blend_pixel(dst[y * width + x], src[(one_src_row ? 0 : y) * width + x]);
+            if (row[x] == expected) continue;
+            mismatches++;
+            for (int shift = 0; shift < 32; shift += 8) {
+                int diff = (int)((row[x] >> shift) & 0xFF) - (int)((expected >> shift) & 0xFF);
+                if (diff < 0) diff = -diff;
+                if (diff > *worst) *worst = diff;
+            }
+        }
+    }
+    al_unlock_bitmap(bitmap);
+    return mismatches;
+}
+
+// blend_pixel against Allegro's default blender drawing to memory bitmaps.
+// Column x of the source has alpha x, so every alpha is drawn.
+static void check_blending_against_allegro(void) {
+    if (!al_init() || !al_init_primitives_addon()) {
+        fprintf(stderr, "  Failed to initialize Allegro for the blending checks\n");
+        checks_failed++;
+        return;
+    }
+    al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+    al_set_new_bitmap_format(ALLEGRO_PIXEL_FORMAT_ARGB_8888);
+    ALLEGRO_BITMAP* target = al_create_bitmap(256, CHECK_BLEND_ROWS);
+    ALLEGRO_BITMAP* source = al_create_bitmap(256, CHECK_BLEND_ROWS);
+    static uint32_t dst[256 * CHECK_BLEND_ROWS], src[256 * CHECK_BLEND_ROWS];
+    for (int i = 0; i < 256 * CHECK_BLEND_ROWS; i++) {
+        dst[i] = random_pixel();
+        src[i] = with_alpha(random_pixel(), i % 256);
+    }
+    if (!target || !source || !write_bitmap_pixels(target, dst, 256, CHECK_BLEND_ROWS) ||
+        !write_bitmap_pixels(source, src, 256, CHECK_BLEND_ROWS)) {
+        fprintf(stderr, "  Failed to create the blending check bitmaps\n");
+        checks_failed++;
+        if (target) al_destroy_bitmap(target);
+        if (source) al_destroy_bitmap(source);
+        return;
+    }
+    al_set_target_bitmap(target);
+    al_set_blender(ALLEGRO_ADD, ALLEGRO_ONE, ALLEGRO_INVERSE_ALPHA);
+
+    int worst = 0;
+    al_draw_bitmap(source, 0, 0, 0);
+    int drawn = count_blend_mismatches(target, dst, src, 256, CHECK_BLEND_ROWS, false, &worst);
+    expect(drawn == 0, true, "al_draw_bitmap matching blend_pixel");
+
+    // One column per alpha, in the colour of the source's first row
+    write_bitmap_pixels(target, dst, 256, CHECK_BLEND_ROWS);
+    for (int x = 0; x < 256; x++) {
+        uint32_t p = src[x];
+        al_draw_filled_rectangle(x, 0, x + 1, CHECK_BLEND_ROWS,
+                                 al_map_rgba((p >> 16) & 0xFF, (p >> 8) & 0xFF, p & 0xFF, p >> 24));
+    }
+    int filled = count_blend_mismatches(target, dst, src, 256, CHECK_BLEND_ROWS, true, &worst);
+    expect(filled == 0, true, "al_draw_filled_rectangle matching blend_pixel");
+    if (drawn || filled) {
+        fprintf(stderr, "  %d drawn and %d filled pixels differ, by up to %d per channel\n", drawn, filled, worst);
+    }
+
+    al_set_target_bitmap(NULL);
+    al_destroy_bitmap(target);
+    al_destroy_bitmap(source);
+}
+
+bool is_self_check_command(int argc, char** argv) {
+    return argc > 1 && strcmp(argv[1], "--check") == 0;
+}
+
+int run_self_check(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    printf("Collision masks\n");
+    check_collision_masks();
+    printf("Enemy batches\n");
+    check_enemy_batches();
+    check_patrol_edges();
+    check_enemy_kernels();
+    printf("Pixel kernels (%s)\n", get_pixel_kernel_name());
+    check_pixel_kernels();
+    printf("Allegro blending\n");
+    check_blending_against_allegro();
+    printf("%d of %d checks passed\n", checks_run - checks_failed, checks_run);
+    return checks_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,132 @@
+#include "../include/spawner.h"
+#include "../include/animation.h" // For ANIM_NO_CLIP
+#include "../include/physics.h"   // For init_body
+#include "../include/enemy_batch.h" // For add_batched_enemy, remove_batched_enemy
+#include <stdio.h>   // For printf, fprintf
+#include <string.h>  // For memset
+
+void init_spawner(Level* level, const SpawnPoint* points, int num_points,
+                  const SpawnWave* waves, int num_waves) {
+    EnemySpawner* spawner = &level->spawner;
+    memset(spawner, 0, sizeof(*spawner));
+    if (num_waves > SPAWNER_MAX_WAVES) {
+        fprintf(stderr, "Level %d has %d enemy waves, only the first %d are used\n",
+                level->id, num_waves, SPAWNER_MAX_WAVES);
+        num_waves = SPAWNER_MAX_WAVES;
+    }
+    spawner->points = points;
+    spawner->num_points = num_points;
+    spawner->waves = waves;
+    spawner->num_waves = num_waves;
+
+    int total = 0;
+    for (int i = 0; i < num_waves; i++) total += waves[i].count;
+    if (total > LEVEL_MAX_ENEMIES) total = LEVEL_MAX_ENEMIES;
+    if (!pool_reserve(&level->enemies, total)) {
+        fprintf(stderr, "Reserved %d of %d enemy slots for level %d\n",
+                pool_capacity(&level->enemies), total, level->id);
+    }
+}
+
+Entity* spawn_enemy(Level* level, EntityType type, EntityBehavior behavior, float x, float y, float health) {
+    Entity* enemy = pool_acquire(&level->enemies);
+    if (!enemy) {
+        level->spawner.rejected++;
+        return NULL;
+    }
+    // pool_acquire zeroed the rest
+    enemy->x = x;
+    enemy->y = y;
+    enemy->width = ENEMY_WIDTH;
+    enemy->height = ENEMY_HEIGHT;
+    enemy->active = true;
+    enemy->type = type;
+    enemy->state = MOVING;
+    enemy->behavior = behavior;
+    enemy->backup_behavior = behavior;
+    enemy->health = health;
+    enemy->max_health = health;
+    enemy->attack_power = ENEMY_ATTACK_POWER;
+    enemy->dx = behavior == BEHAVIOR_PATROL ? -ENEMY_PATROL_SPEED : 0.0f;
+    enemy->ai_aggression = AI_AGGRESSION_BASE;
+    enemy->ai_timer = behavior == BEHAVIOR_AMBUSH ? AI_AMBUSH_WAIT_FRAMES : 0;
+    enemy->clip = ANIM_NO_CLIP;
+    enemy->facing_left = true;
+    init_body(enemy, PHYS_LAYER_ENEMY, PHYS_LAYER_TERRAIN | PHYS_LAYER_HAZARD | PHYS_LAYER_PLAYER,
+              0.0f, ENEMY_KNOCKBACK_DECAY, false);
+    add_batched_enemy(&level->batches, enemy);
+    level->spawner.spawned++;
+    return enemy;
+}
+
+// Slots of enemies killed during the last update go back to the pool
+static void recycle_dead_enemies(Level* level) {
+    ChunkPool* enemies = &level->enemies;
+    int next;
+    for (int i = pool_first(enemies); i != POOL_SLOT_NONE; i = next) {
+        next = pool_next(enemies, i);
+        Entity* enemy = pool_at(enemies, i);
+        if (!enemy->active) {
+            remove_batched_enemy(&level->batches, enemy);
+            pool_release(enemies, i);
+            level->spawner.recycled++;
+        }
+    }
+}
+
+static bool is_wave_due(const SpawnWave* wave, const EnemySpawner* spawner, float player_x) {
+    if (wave->trigger == SPAWN_AT_X) return player_x >= wave->at;
+    return spawner->ticks >= (int)(wave->at * FPS);
+}
+
+void update_spawner(Level* level, float player_x) {
+    EnemySpawner* spawner = &level->spawner;
+    recycle_dead_enemies(level);
+
+    for (int i = 0; i < spawner->num_waves; i++) {
+        const SpawnWave* wave = &spawner->waves[i];
+        SpawnWaveState* state = &spawner->waves_state[i];
+        if (state->spawned >= wave->count) continue;
+        if (!state->triggered) {
+            if (!is_wave_due(wave, spawner, player_x)) continue;
+            state->triggered = true;
+            state->cooldown = 0;
+        }
+        if (state->cooldown > 0) {
+            state->cooldown--;
+            continue;
+        }
+        if (wave->point < 0 || wave->point >= spawner->num_points) {
+            state->spawned = wave->count;
+            continue;
+        }
+
+        // Everything at once, or the next enemy of a staggered wave
+        const SpawnPoint* point = &spawner->points[wave->point];
+        int batch = wave->interval > 0 ? 1 : wave->count - state->spawned;
+        for (int j = 0; j < batch; j++) {
+            int n = state->spawned++;
+            float x = point->x + (n % SPAWN_ROW_LENGTH) * wave->spacing;
+            float y = point->y - (n / SPAWN_ROW_LENGTH) * wave->spacing;
+            spawn_enemy(level, wave->type, wave->behavior, x, y, wave->health);
+        }
+        state->cooldown = wave->interval;
+    }
+    spawner->ticks++;
+}
+
+bool all_waves_spawned(const Level* level) {
+    const EnemySpawner* spawner = &level->spawner;
+    for (int i = 0; i < spawner->num_waves; i++) {
+        if (spawner->waves_state[i].spawned < spawner->waves[i].count) return false;
+    }
+    return true;
+}
+
+void report_spawner(const Level* level) {
+    const EnemySpawner* spawner = &level->spawner;
+    if (spawner->spawned == 0) return;
+    printf("Level %d enemies: %d spawned, %d recycled, %d rejected, %d alive\n", level->id,
+           spawner->spawned, spawner->recycled, spawner->rejected, level->enemies.live);
+    pool_report(&level->enemies);
+}
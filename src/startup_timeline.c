@@ -0,0 +1,56 @@
+#include "../include/startup_timeline.h"
+#include "../include/game.h" // For STARTUP_MAX_PHASES
+#include <allegro5/allegro.h> // For al_get_time
+#include <stdbool.h>
+#include <stdio.h>   // For printf
+
+typedef struct {
+    const char* name;
+    double start, end;          // Seconds since the timeline started
+} StartupPhase;
+
+static StartupPhase phases[STARTUP_MAX_PHASES];
+static int num_phases = 0;
+static double timeline_start = 0.0;
+static bool running = false;
+
+void start_startup_timeline(void) {
+    timeline_start = al_get_time();
+    num_phases = 0;
+    running = true;
+}
+
+void add_startup_phase(const char* name, double start, double end) {
+    if (!running || num_phases >= STARTUP_MAX_PHASES) return;
+    StartupPhase* phase = &phases[num_phases++];
+    phase->name = name;
+    phase->start = start - timeline_start;
+    phase->end = end - timeline_start;
+}
+
+int begin_startup_phase(const char* name) {
+    if (!running || num_phases >= STARTUP_MAX_PHASES) return -1;
+    double now = al_get_time();
+    add_startup_phase(name, now, now);
+    return num_phases - 1;
+}
+
+void end_startup_phase(int phase) {
+    if (!running || phase < 0 || phase >= num_phases) return;
+    phases[phase].end = al_get_time() - timeline_start;
+}
+
+void finish_startup_timeline(void) {
+    if (!running) return;
+    running = false;
+    double first_frame = al_get_time() - timeline_start;
+
+    printf("Startup: first frame after %.1f ms\n", first_frame * 1000.0);
+    printf("  %-28s %9s %9s\n", "phase", "start ms", "length ms");
+    for (int i = 0; i < num_phases; i++) {
+        const StartupPhase* phase = &phases[i];
+        printf("  %-28s %9.1f %9.1f\n", phase->name, phase->start * 1000.0,
+               (phase->end - phase->start) * 1000.0);
+    }
+    printf("  %-28s %9.1f\n", "first frame", first_frame * 1000.0);
+}
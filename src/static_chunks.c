@@ -0,0 +1,154 @@
+#include "../include/static_chunks.h"
+#include "../include/game.h"       // For STATIC_CHUNK_WIDTH
+#include "../include/texture_format.h" // For get_texture_format, get_texture_bytes
+#include <allegro5/allegro_primitives.h> // For al_draw_filled_rectangle
+#include <math.h>    // For ceilf, floorf
+#include <stdio.h>   // For printf, fprintf
+#include <stdlib.h>  // For calloc, free
+#include <string.h>  // For memset
+
+void init_static_chunks(StaticChunkSet* set) {
+    memset(set, 0, sizeof(*set));
+}
+
+// Widen [*top, *bottom) to the rows of the chunk [left, right) that
+// anything static covers
+static void find_chunk_rows(const Platform* platforms, int num_platforms, const Tilemap* map,
+                            float left, float right, float* top, float* bottom) {
+    for (int i = 0; i < num_platforms; i++) {
+        const Platform* p = &platforms[i];
+        if (p->x >= right || p->x + p->width <= left) continue;
+        if (p->y < *top) *top = p->y;
+        if (p->y + p->height > *bottom) *bottom = p->y + p->height;
+    }
+
+    int col0, row0, col1, row1;
+    if (!find_tile_range(map, left, map->y, right, map->y + map->rows * map->tile_size,
+                         &col0, &row0, &col1, &row1)) {
+        return;
+    }
+    for (int row = row0; row <= row1; row++) {
+        for (int col = col0; col <= col1; col++) {
+            if (!get_tile(map, col, row)) continue;
+            float y = map->y + row * map->tile_size;
+            if (y < *top) *top = y;
+            if (y + map->tile_size > *bottom) *bottom = y + map->tile_size;
+        }
+    }
+}
+
+static void draw_chunk_content(const Platform* platforms, int num_platforms, const Tilemap* map,
+                               float left, float right) {
+    for (int i = 0; i < num_platforms; i++) {
+        const Platform* p = &platforms[i];
+        if (p->x >= right || p->x + p->width <= left) continue;
+        al_draw_filled_rectangle(p->x, p->y, p->x + p->width, p->y + p->height, p->color);
+    }
+
+    int col0, row0, col1, row1;
+    if (!find_tile_range(map, left, map->y, right, map->y + map->rows * map->tile_size,
+                         &col0, &row0, &col1, &row1)) {
+        return;
+    }
+    int size = map->tile_size;
+    int atlas_cols = map->atlas ? al_get_bitmap_width(map->atlas) / size : 0;
+    for (int row = row0; row <= row1; row++) {
+        for (int col = col0; col <= col1; col++) {
+            const TileDef* def = get_tile_def(map, get_tile(map, col, row));
+            if (!def) continue;
+            float x = map->x + col * size;
+            float y = map->y + row * size;
+            if (atlas_cols > 0 && def->atlas_index >= 0) {
+                al_draw_bitmap_region(map->atlas, (def->atlas_index % atlas_cols) * size,
+                                      (def->atlas_index / atlas_cols) * size, size, size, x, y, 0);
+            } else {
+                al_draw_filled_rectangle(x, y, x + size, y + size, def->color);
+            }
+        }
+    }
+}
+
+bool bake_static_chunks(StaticChunkSet* set, const Platform* platforms, int num_platforms,
+                        const Tilemap* map, float width) {
+    destroy_static_chunks(set);
+    set->baked = true;
+    set->bakes++;
+    double start = al_get_time();
+
+    set->num_chunks = (int)ceilf(width / STATIC_CHUNK_WIDTH);
+    if (set->num_chunks <= 0) return false;
+    set->chunks = calloc(set->num_chunks, sizeof(StaticChunk));
+    if (!set->chunks) {
+        fprintf(stderr, "Failed to allocate %d static chunks\n", set->num_chunks);
+        set->num_chunks = 0;
+        return false;
+    }
+
+    int old_format = al_get_new_bitmap_format();
+    al_set_new_bitmap_format(get_texture_format(TEXTURE_SPRITE));
+    ALLEGRO_BITMAP* old_target = al_get_target_bitmap();
+    set->complete = true;
+    for (int i = 0; i < set->num_chunks; i++) {
+        StaticChunk* chunk = &set->chunks[i];
+        float left = (float)i * STATIC_CHUNK_WIDTH;
+        float right = left + STATIC_CHUNK_WIDTH < width ? left + STATIC_CHUNK_WIDTH : width;
+        float top = 1e9f, bottom = -1e9f;
+        find_chunk_rows(platforms, num_platforms, map, left, right, &top, &bottom);
+        if (top >= bottom) continue;
+
+        chunk->x = left;
+        chunk->y = floorf(top);
+        chunk->bitmap = al_create_bitmap((int)ceilf(right - left), (int)ceilf(bottom - chunk->y));
+        if (!chunk->bitmap) {
+            fprintf(stderr, "Failed to create static chunk %d\n", i);
+            set->complete = false;
+            continue;
+        }
+
+        // Level coordinates, shifted so the chunk's corner is the origin
+        al_set_target_bitmap(chunk->bitmap);
+        al_clear_to_color(al_map_rgba(0, 0, 0, 0));
+        ALLEGRO_TRANSFORM transform;
+        al_identity_transform(&transform);
+        al_translate_transform(&transform, -chunk->x, -chunk->y);
+        al_use_transform(&transform);
+        draw_chunk_content(platforms, num_platforms, map, left, right);
+        set->bytes += get_texture_bytes(chunk->bitmap);
+    }
+    al_set_target_bitmap(old_target);
+    al_set_new_bitmap_format(old_format);
+
+    set->bake_time = al_get_time() - start;
+    return set->complete;
+}
+
+void record_static_chunks(const StaticChunkSet* set, DrawList* list, DrawLayer layer, int depth,
+                          float left, float right) {
+    if (set->num_chunks == 0) return;
+    int first = (int)floorf(left / STATIC_CHUNK_WIDTH);
+    int last = (int)floorf(right / STATIC_CHUNK_WIDTH);
+    if (first < 0) first = 0;
+    if (last >= set->num_chunks) last = set->num_chunks - 1;
+    for (int i = first; i <= last; i++) {
+        const StaticChunk* chunk = &set->chunks[i];
+        record_bitmap(list, layer, depth, chunk->bitmap, chunk->x, chunk->y, 0, 0);
+    }
+}
+
+void destroy_static_chunks(StaticChunkSet* set) {
+    for (int i = 0; i < set->num_chunks; i++) {
+        if (set->chunks[i].bitmap) al_destroy_bitmap(set->chunks[i].bitmap);
+    }
+    free(set->chunks);
+    set->chunks = NULL;
+    set->num_chunks = 0;
+    set->baked = false;
+    set->complete = false;
+    set->bytes = 0;
+}
+
+void report_static_chunks(const StaticChunkSet* set, const char* name) {
+    if (set->bakes == 0) return;
+    printf("Static chunks %s: %d baked %d times, last bake %.1f ms, %zu KB\n", name, set->num_chunks,
+           set->bakes, set->bake_time * 1000.0, set->bytes / 1024);
+}
@@ -0,0 +1,95 @@
+#include "../include/texture_format.h"
+#include "../include/game.h" // For TEXTURE_OPAQUE_FORMAT, SCENE_SCALED_WIDTH
+#include "../include/asset_pack.h" // For asset_exists
+#include "../include/preload.h"    // For take_preloaded_bitmap
+#include <allegro5/allegro_image.h> // For al_load_bitmap_flags
+#include <stdio.h>   // For snprintf, fprintf
+
+int get_texture_format(TextureUse use) {
+    // Software rendering blends straight from memory bitmaps; a format
+    // different from the target's would be converted on every draw
+    if (al_get_new_bitmap_flags() & ALLEGRO_MEMORY_BITMAP) return al_get_new_bitmap_format();
+    return use == TEXTURE_OPAQUE ? TEXTURE_OPAQUE_FORMAT : ALLEGRO_PIXEL_FORMAT_ANY_WITH_ALPHA;
+}
+
+ALLEGRO_BITMAP* load_texture(const char* path, TextureUse use) {
+    ALLEGRO_BITMAP* preloaded = take_preloaded_bitmap(path);
+    if (preloaded) return upload_texture(preloaded, use);
+
+    int old_format = al_get_new_bitmap_format();
+    al_set_new_bitmap_format(get_texture_format(use));
+    ALLEGRO_BITMAP* bitmap = al_load_bitmap_flags(path, 0);
+    al_set_new_bitmap_format(old_format);
+
+    // Drivers without the 16-bit format get the default one
+    if (!bitmap && use == TEXTURE_OPAQUE) bitmap = al_load_bitmap_flags(path, 0);
+    return bitmap;
+}
+
+ALLEGRO_BITMAP* upload_texture(ALLEGRO_BITMAP* bitmap, TextureUse use) {
+    // The driver picks the closest format it has; the opaque format, which
+    // it may not have, is then copied in by convert_texture
+    int old_format = al_get_new_bitmap_format();
+    if (use == TEXTURE_SPRITE) al_set_new_bitmap_format(get_texture_format(use));
+    al_convert_bitmap(bitmap);
+    al_set_new_bitmap_format(old_format);
+    return use == TEXTURE_OPAQUE ? convert_texture(bitmap, use) : bitmap;
+}
+
+ALLEGRO_BITMAP* convert_texture(ALLEGRO_BITMAP* bitmap, TextureUse use) {
+    // The ALLEGRO_PIXEL_FORMAT_ANY_* families leave the choice to Allegro
+    int format = get_texture_format(use);
+    if (format <= ALLEGRO_PIXEL_FORMAT_ANY_32_WITH_ALPHA || format == al_get_bitmap_format(bitmap)) {
+        return bitmap;
+    }
+
+    int old_format = al_get_new_bitmap_format();
+    al_set_new_bitmap_format(format);
+    ALLEGRO_BITMAP* converted = al_create_bitmap(al_get_bitmap_width(bitmap), al_get_bitmap_height(bitmap));
+    al_set_new_bitmap_format(old_format);
+    if (!converted) return bitmap;
+
+    // A straight copy, not a blend
+    ALLEGRO_BITMAP* old_target = al_get_target_bitmap();
+    al_set_target_bitmap(converted);
+    al_set_blender(ALLEGRO_ADD, ALLEGRO_ONE, ALLEGRO_ZERO);
+    al_draw_bitmap(bitmap, 0, 0, 0);
+    al_set_blender(ALLEGRO_ADD, ALLEGRO_ONE, ALLEGRO_INVERSE_ALPHA);
+    al_set_target_bitmap(old_target);
+    al_destroy_bitmap(bitmap);
+    return converted;
+}
+
+ALLEGRO_BITMAP* resize_texture(ALLEGRO_BITMAP* bitmap, int width, int height) {
+    int old_flags = al_get_new_bitmap_flags();
+    al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+    ALLEGRO_BITMAP* resized = al_create_bitmap(width, height);
+    al_set_new_bitmap_flags(old_flags);
+    if (!resized) {
+        al_destroy_bitmap(bitmap);
+        return NULL;
+    }
+
+    ALLEGRO_BITMAP* old_target = al_get_target_bitmap();
+    al_set_target_bitmap(resized);
+    al_set_blender(ALLEGRO_ADD, ALLEGRO_ONE, ALLEGRO_ZERO);
+    al_draw_scaled_bitmap(bitmap, 0, 0, al_get_bitmap_width(bitmap), al_get_bitmap_height(bitmap),
+                          0, 0, width, height, 0);
+    al_set_blender(ALLEGRO_ADD, ALLEGRO_ONE, ALLEGRO_INVERSE_ALPHA);
+    al_set_target_bitmap(old_target);
+    al_destroy_bitmap(bitmap);
+    return resized;
+}
+
+size_t get_texture_bytes(ALLEGRO_BITMAP* bitmap) {
+    return (size_t)al_get_bitmap_width(bitmap) * al_get_bitmap_height(bitmap) *
+           al_get_pixel_size(al_get_bitmap_format(bitmap));
+}
+
+void find_scene_variant(char* path, size_t size, const char* name, int width) {
+    if (width <= SCENE_SCALED_WIDTH) {
+        snprintf(path, size, "%s_scaled.png", name);
+        if (asset_exists(path)) return;
+    }
+    snprintf(path, size, "%s.png", name);
+}
@@ -0,0 +1,59 @@
+#include "../include/tilemap.h"
+#include <math.h>    // For floorf, ceilf
+#include <string.h>  // For memset, strchr, strlen
+
+bool init_tilemap(Tilemap* map, Arena* arena, int tile_size, float x, float y, int cols, int rows,
+                  const TileDef* defs, int num_defs) {
+    memset(map, 0, sizeof(*map));
+    if (tile_size <= 0 || cols <= 0 || rows <= 0) return false;
+    map->cells = arena_calloc(arena, (size_t)cols * rows, 1);
+    if (!map->cells) return false;
+    map->tile_size = tile_size;
+    map->cols = cols;
+    map->rows = rows;
+    map->x = x;
+    map->y = y;
+    map->defs = defs;
+    map->num_defs = num_defs;
+    return true;
+}
+
+void set_tile(Tilemap* map, int col, int row, int id) {
+    if (!map->cells || col < 0 || row < 0 || col >= map->cols || row >= map->rows) return;
+    if (id < 0 || id > map->num_defs) id = 0;
+    map->cells[row * map->cols + col] = (unsigned char)id;
+}
+
+void set_tilemap_rows(Tilemap* map, const char* const* rows, int num_rows, const char* legend) {
+    for (int row = 0; row < num_rows; row++) {
+        int length = (int)strlen(rows[row]);
+        for (int col = 0; col < length; col++) {
+            const char* found = rows[row][col] ? strchr(legend, rows[row][col]) : NULL;
+            set_tile(map, col, row, found ? (int)(found - legend) + 1 : 0);
+        }
+    }
+}
+
+unsigned int get_tile_layer_at(const Tilemap* map, float x, float y) {
+    if (!map->cells) return 0;
+    int col = (int)floorf((x - map->x) / map->tile_size);
+    int row = (int)floorf((y - map->y) / map->tile_size);
+    const TileDef* def = get_tile_def(map, get_tile(map, col, row));
+    return def ? def->layer : 0;
+}
+
+bool find_tile_range(const Tilemap* map, float left, float top, float right, float bottom,
+                     int* col0, int* row0, int* col1, int* row1) {
+    if (!map->cells) return false;
+    float size = (float)map->tile_size;
+    *col0 = (int)floorf((left - map->x) / size);
+    *row0 = (int)floorf((top - map->y) / size);
+    // Right and bottom edges are exclusive
+    *col1 = (int)ceilf((right - map->x) / size) - 1;
+    *row1 = (int)ceilf((bottom - map->y) / size) - 1;
+    if (*col0 < 0) *col0 = 0;
+    if (*row0 < 0) *row0 = 0;
+    if (*col1 >= map->cols) *col1 = map->cols - 1;
+    if (*row1 >= map->rows) *row1 = map->rows - 1;
+    return *col0 <= *col1 && *row0 <= *row1;
+}
@@ -0,0 +1,74 @@
+#include "../include/triggers.h"
+#include "../include/game.h" // For TRIGGER_MAX_WIDTH
+#include <math.h>    // For ceilf
+#include <stdio.h>   // For fprintf
+#include <stdlib.h>  // For qsort
+#include <string.h>  // For memset
+
+bool init_trigger_index(TriggerIndex* index, Arena* arena, int capacity) {
+    memset(index, 0, sizeof(*index));
+    if (capacity <= 0) return true;
+    index->triggers = arena_alloc(arena, sizeof(Trigger) * capacity);
+    if (!index->triggers) {
+        fprintf(stderr, "Failed to allocate %d triggers\n", capacity);
+        return false;
+    }
+    index->capacity = capacity;
+    return true;
+}
+
+int count_trigger_pieces(float width) {
+    int pieces = (int)ceilf(width / TRIGGER_MAX_WIDTH);
+    return pieces > 1 ? pieces : 1;
+}
+
+bool add_trigger(TriggerIndex* index, TriggerKind kind, int item,
+                 float x, float y, float width, float height) {
+    int pieces = count_trigger_pieces(width);
+    for (int i = 0; i < pieces; i++) {
+        if (index->count >= index->capacity) return false;
+        float left = x + i * TRIGGER_MAX_WIDTH;
+        float right = i + 1 < pieces ? left + TRIGGER_MAX_WIDTH : x + width;
+        index->triggers[index->count++] = (Trigger){
+            .x = left, .y = y, .width = right - left, .height = height, .kind = kind, .item = item
+        };
+    }
+    return true;
+}
+
+static int compare_triggers_by_x(const void* a, const void* b) {
+    float ax = ((const Trigger*)a)->x;
+    float bx = ((const Trigger*)b)->x;
+    return (ax > bx) - (ax < bx);
+}
+
+void sort_triggers(TriggerIndex* index) {
+    if (index->count > 1) qsort(index->triggers, index->count, sizeof(Trigger), compare_triggers_by_x);
+    index->max_width = 0.0f;
+    for (int i = 0; i < index->count; i++) {
+        if (index->triggers[i].width > index->max_width) index->max_width = index->triggers[i].width;
+    }
+    index->cursor = 0;
+}
+
+void seek_triggers(TriggerIndex* index, float left, float right, int* first, int* last) {
+    const Trigger* triggers = index->triggers;
+    float reach = left - index->max_width;
+    int cursor = index->cursor;
+    index->steps = 0;
+    while (cursor > 0 && triggers[cursor - 1].x >= reach) {
+        cursor--;
+        index->steps++;
+    }
+    while (cursor < index->count && triggers[cursor].x < reach) {
+        cursor++;
+        index->steps++;
+    }
+    index->cursor = cursor;
+
+    int end = cursor;
+    while (end < index->count && triggers[end].x < right) end++;
+    *first = cursor;
+    *last = end;
+    index->candidates = end - cursor;
+}